@@ -79,6 +79,16 @@ private:
       }
     }
 
+    if (config.has_runtime() && config.runtime().has_priority_load_shedder()) {
+      const auto &pls = config.runtime().priority_load_shedder();
+      uint64_t reserved = static_cast<uint64_t>(pls.critical().reserved()) +
+                          pls.normal().reserved() + pls.sheddable().reserved();
+      if (reserved > pls.max_concurrent_requests()) {
+        return "Invalid priority_load_shedder: reserved slots exceed "
+               "max_concurrent_requests";
+      }
+    }
+
     return std::nullopt;
   }
 };
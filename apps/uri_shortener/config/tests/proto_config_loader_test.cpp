@@ -130,6 +130,24 @@ TEST(ProtoConfigLoaderTest, AllowsValidTraceSampleRate) {
   ASSERT_TRUE(result.is_ok()) << result.error();
 }
 
+TEST(ProtoConfigLoaderTest, ValidatesPriorityLoadShedderReservations) {
+  const char *json = R"({
+        "schema_version": 1,
+        "runtime": {
+            "priority_load_shedder": {
+                "max_concurrent_requests": 10,
+                "critical": {"reserved": 8},
+                "normal": {"reserved": 4}
+            }
+        }
+    })";
+
+  auto result = ProtoConfigLoader::loadFromString(json);
+
+  EXPECT_TRUE(result.is_err());
+  EXPECT_NE(result.error().find("priority_load_shedder"), std::string::npos);
+}
+
 // =============================================================================
 // FILE LOADING TESTS
 // =============================================================================
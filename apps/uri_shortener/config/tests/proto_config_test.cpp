@@ -35,6 +35,7 @@ TEST(Http2ServerConfigTest, Defaults) {
   ::http2::ServerConfig server;
   EXPECT_EQ(server.uri(), "");
   EXPECT_EQ(server.thread_count(), 0);
+  EXPECT_EQ(server.max_request_body_bytes(), 0);
 }
 
 TEST(Http2ServerConfigTest, CanSetUri) {
@@ -49,6 +50,12 @@ TEST(Http2ServerConfigTest, CanSetThreadCount) {
   EXPECT_EQ(server.thread_count(), 4);
 }
 
+TEST(Http2ServerConfigTest, CanSetMaxRequestBodyBytes) {
+  ::http2::ServerConfig server;
+  server.set_max_request_body_bytes(65536);
+  EXPECT_EQ(server.max_request_body_bytes(), 65536);
+}
+
 // =============================================================================
 // LIBRARY CONFIG TESTS - ::http2::ClientConfig
 // =============================================================================
@@ -286,6 +293,20 @@ TEST(RuntimeConfigTest, CanSetLoadShedder) {
   EXPECT_EQ(runtime.load_shedder().max_concurrent_requests(), 10000);
 }
 
+TEST(RuntimeConfigTest, CanSetPriorityLoadShedder) {
+  uri_shortener::RuntimeConfig runtime;
+  auto *pls = runtime.mutable_priority_load_shedder();
+  pls->set_max_concurrent_requests(1000);
+  pls->mutable_critical()->set_reserved(500);
+  pls->mutable_critical()->set_borrowable(300);
+  pls->mutable_sheddable()->set_borrowable(100);
+
+  EXPECT_TRUE(runtime.has_priority_load_shedder());
+  EXPECT_EQ(runtime.priority_load_shedder().critical().reserved(), 500);
+  EXPECT_EQ(runtime.priority_load_shedder().sheddable().reserved(), 0);
+  EXPECT_EQ(runtime.priority_load_shedder().sheddable().borrowable(), 100);
+}
+
 // =============================================================================
 // APP CONFIG TESTS - Top-level Config
 // =============================================================================
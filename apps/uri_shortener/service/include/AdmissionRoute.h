@@ -0,0 +1,39 @@
+#pragma once
+
+#include "UriShortenerComponents.h"
+
+#include <Metrics.h>
+#include <memory>
+#include <resilience/policy/PriorityLoadShedderPolicy.h>
+
+namespace astra::router {
+class IRequest;
+class IResponse;
+} // namespace astra::router
+
+namespace uri_shortener {
+
+// Route handler for the link endpoints: admits a request through the load
+// shedder at `priority` and hands it to the request handler, or answers
+// 503 with Retry-After when it is shed. On a shard's io thread both are the
+// shard's own; otherwise the components' shared ones.
+class AdmissionRoute {
+public:
+  AdmissionRoute(UriShortenerComponents &components,
+                 astra::resilience::Priority priority);
+
+  void operator()(std::shared_ptr<astra::router::IRequest> req,
+                  std::shared_ptr<astra::router::IResponse> res) const;
+
+private:
+  // The shard of the calling thread, entering it when the request arrived
+  // before the thread was handed its shard; nullptr off shard io threads
+  Shard *shard() const;
+
+  UriShortenerComponents *m_components;
+  astra::resilience::Priority m_priority;
+  obs::Counter m_accepted;
+  obs::Counter m_rejected;
+};
+
+} // namespace uri_shortener
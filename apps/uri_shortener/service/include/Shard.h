@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+namespace astra::http2 {
+class Http2Client;
+}
+namespace astra::service_discovery {
+class IServiceResolver;
+}
+namespace astra::execution {
+class AffinityExecutor;
+class InlineExecutor;
+} // namespace astra::execution
+namespace astra::resilience {
+class PriorityLoadShedder;
+}
+
+namespace uri_shortener {
+
+namespace service {
+class IDataServiceAdapter;
+}
+class UriShortenerMessageHandler;
+class ObservableMessageHandler;
+class UriShortenerRequestHandler;
+class ObservableRequestHandler;
+
+// One core's slice of the service in the thread-per-core layout. A shard is
+// served by one server io thread with an SO_REUSEPORT listener of its own,
+// and that thread also owns the shard's data service connections. Requests
+// are handled there to completion, blocking work goes to the shard's own
+// lane, and admission is checked against the shard's share of the load
+// shedder budget. Nothing here is shared with other shards.
+struct Shard {
+  size_t index{0};
+
+  // Declared first so they outlive the handlers that call them
+  std::unique_ptr<astra::http2::Http2Client> http_client;
+  std::unique_ptr<astra::service_discovery::IServiceResolver> resolver;
+  std::shared_ptr<service::IDataServiceAdapter> data_adapter;
+
+  std::unique_ptr<UriShortenerMessageHandler> msg_handler;
+  std::unique_ptr<ObservableMessageHandler> obs_msg_handler;
+  std::unique_ptr<astra::execution::AffinityExecutor> lane;
+  std::unique_ptr<astra::execution::InlineExecutor> executor;
+  std::unique_ptr<UriShortenerRequestHandler> req_handler;
+  std::unique_ptr<ObservableRequestHandler> obs_req_handler;
+  std::unique_ptr<astra::resilience::PriorityLoadShedder> load_shedder;
+
+  explicit Shard(size_t index);
+  ~Shard();
+  Shard(const Shard &) = delete;
+  Shard &operator=(const Shard &) = delete;
+
+  // Makes this the calling thread's shard, optionally pinning the thread
+  // to CPU `index` (modulo the CPUs available). Run once on the shard's io
+  // thread.
+  void enter(bool pin_thread);
+
+  // The shard of the calling thread; nullptr on threads that are not a
+  // shard's io thread
+  static Shard *current() noexcept;
+};
+
+} // namespace uri_shortener
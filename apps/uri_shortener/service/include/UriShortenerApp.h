@@ -18,6 +18,8 @@ public:
   UriShortenerApp &operator=(const UriShortenerApp &) = delete;
 
 private:
+  void enterShards();
+
   UriShortenerComponents m_components;
 };
 
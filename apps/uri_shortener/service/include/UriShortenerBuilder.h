@@ -5,6 +5,8 @@
 #include "UriShortenerComponents.h"
 #include "uri_shortener.pb.h"
 
+#include <memory>
+#include <resilience/policy/PriorityLoadShedderPolicy.h>
 #include <string>
 
 namespace uri_shortener {
@@ -31,6 +33,7 @@ public:
   UriShortenerBuilder &backend();
   UriShortenerBuilder &messaging();
   UriShortenerBuilder &resilience();
+  UriShortenerBuilder &sharding();
 
   astra::outcome::Result<UriShortenerApp, BuilderError> build();
 
@@ -50,7 +53,16 @@ private:
 
   UriShortenerBuilder &loadShedder();
 
+  // Shards configured: each builds its own client, handlers and shedder,
+  // and the shared ones are left unset
+  bool sharded() const;
+  std::unique_ptr<astra::http2::Http2Client> makeHttpClient() const;
+  std::unique_ptr<astra::service_discovery::IServiceResolver>
+  makeServiceResolver() const;
+  astra::resilience::PriorityLoadShedderPolicy loadShedderPolicy() const;
+
   void initObservability();
+  astra::execution::IExecutor &requestExecutor();
 
   const Config &m_config;
   UriShortenerComponents m_components;
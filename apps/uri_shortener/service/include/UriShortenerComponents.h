@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 namespace astra::router {
 class Router;
@@ -14,9 +15,12 @@ class IServiceResolver;
 }
 namespace astra::execution {
 class AffinityExecutor;
-}
+class Backpressure;
+class IExecutor;
+class InlineExecutor;
+} // namespace astra::execution
 namespace astra::resilience {
-class AtomicLoadShedder;
+class PriorityLoadShedder;
 }
 
 namespace uri_shortener {
@@ -37,6 +41,7 @@ class UriShortenerMessageHandler;
 class ObservableMessageHandler;
 class UriShortenerRequestHandler;
 class ObservableRequestHandler;
+struct Shard;
 
 struct UriShortenerComponents {
   std::shared_ptr<domain::ILinkRepository> repo;
@@ -52,12 +57,20 @@ struct UriShortenerComponents {
   std::unique_ptr<UriShortenerMessageHandler> msg_handler;
   std::unique_ptr<ObservableMessageHandler> obs_msg_handler;
   std::unique_ptr<astra::execution::AffinityExecutor> executor;
+  std::shared_ptr<astra::execution::Backpressure> backpressure;
+  // Set in run-to-completion mode; offloads blocking work to `executor`
+  std::unique_ptr<astra::execution::InlineExecutor> inline_executor;
   std::unique_ptr<UriShortenerRequestHandler> req_handler;
   std::unique_ptr<ObservableRequestHandler> obs_req_handler;
+  // Thread-per-core layout only. Each shard then has its own data service
+  // client, handlers and load shedder, and the shared ones from http_client
+  // to obs_req_handler, and load_shedder, stay unset
+  std::vector<std::unique_ptr<Shard>> shards;
+  bool pin_shard_threads{false};
 
   std::unique_ptr<astra::router::Router> router;
   std::unique_ptr<astra::http2::Http2Server> server;
-  std::unique_ptr<astra::resilience::AtomicLoadShedder> load_shedder;
+  std::unique_ptr<astra::resilience::PriorityLoadShedder> load_shedder;
 
   UriShortenerComponents();
   ~UriShortenerComponents();
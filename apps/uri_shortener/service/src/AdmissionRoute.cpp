@@ -0,0 +1,96 @@
+#include "AdmissionRoute.h"
+
+#include "Http2Server.h"
+#include "ObservableRequestHandler.h"
+#include "Shard.h"
+
+#include <Http2Response.h>
+#include <IRequest.h>
+#include <IResponse.h>
+#include <Log.h>
+#include <boost/asio.hpp>
+#include <resilience/impl/PriorityLoadShedder.h>
+#include <string>
+
+namespace uri_shortener {
+
+namespace {
+
+void reject(astra::router::IResponse &res, const std::string &error) {
+  res.set_status(503);
+  res.set_header("Content-Type", "application/json");
+  res.set_header("Retry-After", "1");
+  res.write(R"({"error": ")" + error + R"("})");
+  res.close();
+}
+
+} // namespace
+
+AdmissionRoute::AdmissionRoute(UriShortenerComponents &components,
+                               astra::resilience::Priority priority)
+    : m_components(&components), m_priority(priority) {
+  std::string prefix =
+      std::string("load_shedder.") + astra::resilience::to_string(priority);
+  m_accepted = obs::register_counter(prefix + ".accepted");
+  m_rejected = obs::register_counter(prefix + ".rejected");
+}
+
+void AdmissionRoute::operator()(
+    std::shared_ptr<astra::router::IRequest> req,
+    std::shared_ptr<astra::router::IResponse> res) const {
+  auto *shard = this->shard();
+  auto *load_shedder =
+      shard ? shard->load_shedder.get() : m_components->load_shedder.get();
+  auto *req_handler = shard ? shard->obs_req_handler.get()
+                            : m_components->obs_req_handler.get();
+  if (!load_shedder || !req_handler) {
+    // Sharded, on a thread that serves no shard
+    obs::warn("No shard serves this thread");
+    reject(*res, "Service not configured");
+    return;
+  }
+
+  auto guard = load_shedder->try_acquire(m_priority);
+  if (!guard) {
+    m_rejected.inc();
+    obs::warn("Load shedder rejected request",
+              {{"priority", astra::resilience::to_string(m_priority)},
+               {"current", std::to_string(load_shedder->current_count())},
+               {"max", std::to_string(load_shedder->max_concurrent())}});
+    reject(*res, "Service overloaded");
+    return;
+  }
+
+  m_accepted.inc();
+
+  auto http_res = std::dynamic_pointer_cast<astra::http2::Http2Response>(res);
+  if (http_res) {
+    http_res->add_scoped_resource(
+        std::make_unique<astra::resilience::LoadShedderGuard>(
+            std::move(*guard)));
+  }
+
+  req_handler->handle(req, res);
+}
+
+Shard *AdmissionRoute::shard() const {
+  if (auto *shard = Shard::current()) {
+    return shard;
+  }
+  // The post that enters each shard may still be queued behind the first
+  // requests; the io_context running on this thread tells the shard
+  const auto &shards = m_components->shards;
+  if (shards.empty() || !m_components->server) {
+    return nullptr;
+  }
+  const auto &contexts = m_components->server->io_contexts();
+  for (size_t i = 0; i < contexts.size() && i < shards.size(); ++i) {
+    if (contexts[i]->get_executor().running_in_this_thread()) {
+      shards[i]->enter(m_components->pin_shard_threads);
+      return shards[i].get();
+    }
+  }
+  return nullptr;
+}
+
+} // namespace uri_shortener
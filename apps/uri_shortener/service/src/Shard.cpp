@@ -0,0 +1,64 @@
+#include "Shard.h"
+
+#include "Http2Client.h"
+#include "IDataServiceAdapter.h"
+#include "IServiceResolver.h"
+#include "ObservableMessageHandler.h"
+#include "ObservableRequestHandler.h"
+#include "UriShortenerMessageHandler.h"
+#include "UriShortenerRequestHandler.h"
+
+#include <AffinityExecutor.h>
+#include <InlineExecutor.h>
+#include <Log.h>
+#include <resilience/impl/PriorityLoadShedder.h>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace uri_shortener {
+
+namespace {
+
+thread_local Shard *t_shard = nullptr;
+
+void pin_to_cpu(size_t index) {
+#ifdef __linux__
+  unsigned cpus = std::thread::hardware_concurrency();
+  if (cpus == 0) {
+    return;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(index % cpus, &set);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+    obs::warn("Failed to pin shard thread",
+              {{"shard", std::to_string(index)}});
+  }
+#else
+  (void)index;
+#endif
+}
+
+} // namespace
+
+Shard::Shard(size_t index) : index(index) {
+}
+
+Shard::~Shard() = default;
+
+void Shard::enter(bool pin_thread) {
+  t_shard = this;
+  if (pin_thread) {
+    pin_to_cpu(index);
+  }
+}
+
+Shard *Shard::current() noexcept {
+  return t_shard;
+}
+
+} // namespace uri_shortener
@@ -1,22 +1,23 @@
 #include "UriShortenerApp.h"
 
+#include "AdmissionRoute.h"
 #include "Http2Client.h"
 #include "Http2Server.h"
 #include "IServiceResolver.h"
 #include "ObservableMessageHandler.h"
 #include "ObservableRequestHandler.h"
 #include "Router.h"
+#include "Shard.h"
 #include "UriShortenerMessageHandler.h"
 #include "UriShortenerRequestHandler.h"
 
 #include <AffinityExecutor.h>
-#include <Http2Response.h>
 #include <IRequest.h>
 #include <IResponse.h>
 #include <Log.h>
-#include <Metrics.h>
 #include <Provider.h>
-#include <resilience/impl/AtomicLoadShedder.h>
+#include <boost/asio.hpp>
+#include <resilience/impl/PriorityLoadShedder.h>
 
 namespace uri_shortener {
 
@@ -35,45 +36,15 @@ UriShortenerApp &
 UriShortenerApp::operator=(UriShortenerApp &&) noexcept = default;
 
 int UriShortenerApp::run() {
-  auto accepted = obs::counter("load_shedder.accepted");
-  auto rejected = obs::counter("load_shedder.rejected");
-
-  auto resilient = [this, accepted,
-                    rejected](std::shared_ptr<astra::router::IRequest> req,
-                              std::shared_ptr<astra::router::IResponse> res) {
-    auto guard = m_components.load_shedder->try_acquire();
-    if (!guard) {
-      rejected.inc();
-      obs::warn("Load shedder rejected request",
-                {{"current",
-                  std::to_string(m_components.load_shedder->current_count())},
-                 {"max", std::to_string(
-                             m_components.load_shedder->max_concurrent())}});
-      res->set_status(503);
-      res->set_header("Content-Type", "application/json");
-      res->set_header("Retry-After", "1");
-      res->write(R"({"error": "Service overloaded"})");
-      res->close();
-      return;
-    }
-
-    accepted.inc();
-
-    auto http_res = std::dynamic_pointer_cast<astra::http2::Http2Response>(res);
-    if (http_res) {
-      http_res->add_scoped_resource(
-          std::make_unique<astra::resilience::LoadShedderGuard>(
-              std::move(*guard)));
-    }
-
-    m_components.obs_req_handler->handle(req, res);
-  };
+  using astra::resilience::Priority;
 
+  // Redirects are the product; writes and deletes are shed first
+  m_components.router->add(astra::router::HttpMethod::GET, "/:code",
+                           AdmissionRoute(m_components, Priority::Critical));
   m_components.router->add(astra::router::HttpMethod::POST, "/shorten",
-                           resilient);
-  m_components.router->add(astra::router::HttpMethod::GET, "/:code", resilient);
+                           AdmissionRoute(m_components, Priority::Normal));
   m_components.router->add(astra::router::HttpMethod::DELETE, "/:code",
-                           resilient);
+                           AdmissionRoute(m_components, Priority::Sheddable));
 
   m_components.router->add(astra::router::HttpMethod::GET, "/health",
                            [](std::shared_ptr<astra::router::IRequest>,
@@ -84,13 +55,24 @@ int UriShortenerApp::run() {
                              res->write(R"({"status": "ok"})");
                              res->close();
                            });
+  m_components.router->freeze();
 
   obs::info("URI Shortener listening");
-  obs::info("Using message-based architecture",
-            {{"lanes", std::to_string(m_components.executor->lane_count())}});
-  obs::info("Load shedder enabled",
-            {{"max_concurrent",
-              std::to_string(m_components.load_shedder->max_concurrent())}});
+  if (m_components.shards.empty()) {
+    obs::info("Using message-based architecture",
+              {{"lanes", std::to_string(m_components.executor->lane_count())},
+               {"run_to_completion",
+                m_components.inline_executor ? "true" : "false"}});
+    obs::info("Load shedder enabled",
+              {{"max_concurrent",
+                std::to_string(m_components.load_shedder->max_concurrent())}});
+  } else {
+    obs::info("Using thread-per-core shards",
+              {{"shards", std::to_string(m_components.shards.size())},
+               {"max_concurrent_per_shard",
+                std::to_string(m_components.shards.front()
+                                   ->load_shedder->max_concurrent())}});
+  }
 
   auto start_result = m_components.server->start();
   if (!start_result) {
@@ -98,8 +80,40 @@ int UriShortenerApp::run() {
     return 1;
   }
 
+  // Data service calls made while handling a request then go out on a
+  // connection owned by the same io thread, and the reply comes back there
+  if (m_components.inline_executor) {
+    m_components.http_client->bind_io_contexts(
+        m_components.server->io_contexts());
+  }
+  enterShards();
+
   m_components.server->join();
   return 0;
 }
 
+// Hands each server io thread its shard and binds the shard's data service
+// client to it, so its calls go out on connections owned by that thread.
+// Requests that arrive before the post runs find their shard by io thread.
+void UriShortenerApp::enterShards() {
+  const auto &contexts = m_components.server->io_contexts();
+  if (m_components.shards.size() != contexts.size()) {
+    if (!m_components.shards.empty()) {
+      obs::warn("Shard count does not match server io threads",
+                {{"shards", std::to_string(m_components.shards.size())},
+                 {"io_threads", std::to_string(contexts.size())}});
+    }
+    return;
+  }
+
+  bool pin = m_components.pin_shard_threads;
+  for (size_t i = 0; i < contexts.size(); ++i) {
+    m_components.shards[i]->http_client->bind_io_contexts({contexts[i]});
+    boost::asio::post(*contexts[i],
+                      [shard = m_components.shards[i].get(), pin] {
+                        shard->enter(pin);
+                      });
+  }
+}
+
 } // namespace uri_shortener
@@ -11,7 +11,9 @@
 #include "ProtoConfigLoader.h"
 #include "RandomCodeGenerator.h"
 #include "ResolveLink.h"
+#include "RouteMetrics.h"
 #include "Router.h"
+#include "Shard.h"
 #include "ShortenLink.h"
 #include "StaticServiceResolver.h"
 #include "UriShortenerApp.h"
@@ -19,10 +21,12 @@
 #include "UriShortenerRequestHandler.h"
 
 #include <AffinityExecutor.h>
+#include <Backpressure.h>
+#include <InlineExecutor.h>
 #include <Log.h>
 #include <Provider.h>
-#include <resilience/impl/AtomicLoadShedder.h>
-#include <resilience/policy/LoadShedderPolicy.h>
+#include <resilience/impl/PriorityLoadShedder.h>
+#include <resilience/policy/PriorityLoadShedderPolicy.h>
 
 namespace uri_shortener {
 
@@ -46,6 +50,7 @@ UriShortenerBuilder::bootstrap() {
       .backend()
       .messaging()
       .resilience()
+      .sharding()
       .build();
 }
 
@@ -91,38 +96,47 @@ UriShortenerBuilder &UriShortenerBuilder::useCases() {
   return *this;
 }
 
+// The steps below build the shared components; with shards configured each
+// shard builds its own in sharding() instead, and they are skipped
+
 UriShortenerBuilder &UriShortenerBuilder::httpClient() {
-  ::http2::ClientConfig client_config;
-  if (m_config.bootstrap().has_dataservice() &&
-      m_config.bootstrap().dataservice().has_client()) {
-    client_config = m_config.bootstrap().dataservice().client();
+  if (sharded()) {
+    return *this;
   }
-  m_components.http_client =
-      std::make_unique<astra::http2::Http2Client>(client_config);
+  m_components.http_client = makeHttpClient();
   return *this;
 }
 
 UriShortenerBuilder &UriShortenerBuilder::serviceResolver() {
-  auto resolver =
-      std::make_unique<astra::service_discovery::StaticServiceResolver>();
-  resolver->register_service("dataservice", "localhost", 8080);
-  m_components.resolver = std::move(resolver);
+  if (sharded()) {
+    return *this;
+  }
+  m_components.resolver = makeServiceResolver();
   return *this;
 }
 
 UriShortenerBuilder &UriShortenerBuilder::dataAdapter() {
+  if (sharded()) {
+    return *this;
+  }
   m_components.data_adapter = std::make_shared<service::HttpDataServiceAdapter>(
       *m_components.http_client, *m_components.resolver, "dataservice");
   return *this;
 }
 
 UriShortenerBuilder &UriShortenerBuilder::msgHandler() {
+  if (sharded()) {
+    return *this;
+  }
   m_components.msg_handler =
       std::make_unique<UriShortenerMessageHandler>(m_components.data_adapter);
   return *this;
 }
 
 UriShortenerBuilder &UriShortenerBuilder::executor() {
+  if (sharded()) {
+    return *this;
+  }
   size_t num_lanes = 4;
   if (m_config.bootstrap().has_execution() &&
       m_config.bootstrap().execution().has_pool_executor()) {
@@ -134,35 +148,152 @@ UriShortenerBuilder &UriShortenerBuilder::executor() {
   m_components.executor = std::make_unique<astra::execution::AffinityExecutor>(
       num_lanes, *m_components.obs_msg_handler);
 
-  m_components.msg_handler->setResponseExecutor(*m_components.executor);
+  if (m_config.bootstrap().has_execution() &&
+      m_config.bootstrap().execution().has_affinity_executor()) {
+    const auto &affinity = m_config.bootstrap().execution().affinity_executor();
+    if (affinity.high_water_mark() > 0) {
+      m_components.backpressure =
+          std::make_shared<astra::execution::Backpressure>(
+              affinity.high_water_mark(), affinity.low_water_mark());
+      m_components.executor->set_backpressure(m_components.backpressure);
+    }
+  }
+
+  if (m_config.bootstrap().has_execution() &&
+      m_config.bootstrap().execution().run_to_completion()) {
+    m_components.inline_executor =
+        std::make_unique<astra::execution::InlineExecutor>(
+            *m_components.obs_msg_handler, *m_components.executor);
+  }
+
+  m_components.msg_handler->setResponseExecutor(requestExecutor());
 
   return *this;
 }
 
 UriShortenerBuilder &UriShortenerBuilder::reqHandler() {
+  if (sharded()) {
+    return *this;
+  }
   m_components.req_handler =
-      std::make_unique<UriShortenerRequestHandler>(*m_components.executor);
+      std::make_unique<UriShortenerRequestHandler>(requestExecutor());
   return *this;
 }
 
 UriShortenerBuilder &UriShortenerBuilder::wrapObservable() {
+  if (sharded()) {
+    return *this;
+  }
   m_components.obs_req_handler =
       std::make_unique<ObservableRequestHandler>(*m_components.req_handler);
   return *this;
 }
 
+UriShortenerBuilder &UriShortenerBuilder::sharding() {
+  if (!sharded()) {
+    return *this;
+  }
+
+  size_t count = m_config.bootstrap().sharding().shard_count();
+  m_components.pin_shard_threads =
+      m_config.bootstrap().sharding().pin_threads();
+  auto policy = loadShedderPolicy();
+  m_components.shards.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    auto shard = std::make_unique<Shard>(i);
+    shard->http_client = makeHttpClient();
+    shard->resolver = makeServiceResolver();
+    shard->data_adapter = std::make_shared<service::HttpDataServiceAdapter>(
+        *shard->http_client, *shard->resolver, "dataservice");
+    shard->msg_handler =
+        std::make_unique<UriShortenerMessageHandler>(shard->data_adapter);
+    shard->obs_msg_handler =
+        std::make_unique<ObservableMessageHandler>(*shard->msg_handler);
+    shard->lane = std::make_unique<astra::execution::AffinityExecutor>(
+        1, *shard->obs_msg_handler);
+    shard->executor = std::make_unique<astra::execution::InlineExecutor>(
+        *shard->obs_msg_handler, *shard->lane);
+    shard->msg_handler->setResponseExecutor(*shard->executor);
+    shard->req_handler =
+        std::make_unique<UriShortenerRequestHandler>(*shard->executor);
+    shard->obs_req_handler =
+        std::make_unique<ObservableRequestHandler>(*shard->req_handler);
+    shard->load_shedder =
+        std::make_unique<astra::resilience::PriorityLoadShedder>(policy.slice(
+            count, "uri_shortener.shard" + std::to_string(i)));
+    m_components.shards.push_back(std::move(shard));
+  }
+  return *this;
+}
+
 UriShortenerBuilder &UriShortenerBuilder::loadShedder() {
+  if (sharded()) {
+    return *this;
+  }
+  m_components.load_shedder =
+      std::make_unique<astra::resilience::PriorityLoadShedder>(
+          loadShedderPolicy());
+  return *this;
+}
+
+bool UriShortenerBuilder::sharded() const {
+  return m_config.bootstrap().has_sharding() &&
+         m_config.bootstrap().sharding().shard_count() > 0;
+}
+
+std::unique_ptr<astra::http2::Http2Client>
+UriShortenerBuilder::makeHttpClient() const {
+  ::http2::ClientConfig client_config;
+  if (m_config.bootstrap().has_dataservice() &&
+      m_config.bootstrap().dataservice().has_client()) {
+    client_config = m_config.bootstrap().dataservice().client();
+  }
+  return std::make_unique<astra::http2::Http2Client>(client_config);
+}
+
+std::unique_ptr<astra::service_discovery::IServiceResolver>
+UriShortenerBuilder::makeServiceResolver() const {
+  auto resolver =
+      std::make_unique<astra::service_discovery::StaticServiceResolver>();
+  const auto &endpoint = m_config.bootstrap().dataservice().endpoint();
+  if (endpoint.empty()) {
+    resolver->register_service("dataservice", "localhost", 8080);
+  } else {
+    resolver->register_service("dataservice", endpoint);
+  }
+  return resolver;
+}
+
+astra::resilience::PriorityLoadShedderPolicy
+UriShortenerBuilder::loadShedderPolicy() const {
+  using astra::resilience::PriorityBudget;
+  using astra::resilience::PriorityLoadShedderPolicy;
+
   size_t max_concurrent = 1000;
   if (m_config.has_runtime() && m_config.runtime().has_load_shedder() &&
       m_config.runtime().load_shedder().max_concurrent_requests() > 0) {
     max_concurrent =
         m_config.runtime().load_shedder().max_concurrent_requests();
   }
-  auto policy = astra::resilience::LoadShedderPolicy::create(max_concurrent,
-                                                             "uri_shortener");
-  m_components.load_shedder =
-      std::make_unique<astra::resilience::AtomicLoadShedder>(std::move(policy));
-  return *this;
+
+  auto policy = PriorityLoadShedderPolicy::with_default_budgets(
+      max_concurrent, "uri_shortener");
+
+  if (m_config.has_runtime() &&
+      m_config.runtime().has_priority_load_shedder() &&
+      m_config.runtime().priority_load_shedder().max_concurrent_requests() >
+          0) {
+    const auto &cfg = m_config.runtime().priority_load_shedder();
+    auto to_budget = [](const ::resilience::PriorityBudget &b) {
+      return PriorityBudget{b.reserved(), b.borrowable()};
+    };
+    policy = PriorityLoadShedderPolicy::create(
+        cfg.max_concurrent_requests(),
+        {to_budget(cfg.critical()), to_budget(cfg.normal()),
+         to_budget(cfg.sheddable())},
+        "uri_shortener");
+  }
+  return policy;
 }
 
 astra::outcome::Result<UriShortenerApp, BuilderError>
@@ -175,18 +306,51 @@ UriShortenerBuilder::build() {
     return astra::outcome::Result<UriShortenerApp, BuilderError>::Err(
         BuilderError::InvalidConfig);
   }
+  // Shards listen with SO_REUSEPORT, which the server offers over http://
+  // only
+  if (!m_components.shards.empty() && uri.rfind("https://", 0) == 0) {
+    obs::error("Sharding needs an http:// server uri", {{"uri", uri}});
+    return astra::outcome::Result<UriShortenerApp, BuilderError>::Err(
+        BuilderError::InvalidConfig);
+  }
 
   initObservability();
 
   m_components.router = std::make_unique<astra::router::Router>();
+  m_components.router->set_observer(
+      std::make_shared<astra::router::RouteMetrics>("uri_shortener.route"));
+  // One io thread per shard, each accepting on a listener of its own
+  ::http2::ServerConfig server_config = bootstrap.server();
+  if (!m_components.shards.empty()) {
+    server_config.set_thread_count(
+        static_cast<uint32_t>(m_components.shards.size()));
+    server_config.set_reuse_port(true);
+  }
   m_components.server = std::make_unique<astra::http2::Http2Server>(
-      bootstrap.server(), *m_components.router);
-  m_components.executor->start();
+      server_config, *m_components.router);
+  if (m_components.backpressure) {
+    m_components.server->set_backpressure(m_components.backpressure);
+  }
+  if (m_components.executor) {
+    m_components.executor->start();
+  }
+  for (auto &shard : m_components.shards) {
+    shard->lane->start();
+  }
 
   return astra::outcome::Result<UriShortenerApp, BuilderError>::Ok(
       UriShortenerApp(std::move(m_components)));
 }
 
+// Where requests and data service replies are handled: inline on the io
+// thread in run-to-completion mode, on the lanes otherwise
+astra::execution::IExecutor &UriShortenerBuilder::requestExecutor() {
+  if (m_components.inline_executor) {
+    return *m_components.inline_executor;
+  }
+  return *m_components.executor;
+}
+
 void UriShortenerBuilder::initObservability() {
   const auto &bootstrap = m_config.bootstrap();
 
@@ -2,13 +2,15 @@
 
 // Include complete type definitions for unique_ptr members
 #include "AffinityExecutor.h"
-#include "AtomicLoadShedder.h"
 #include "Http2Client.h"
 #include "Http2Server.h"
 #include "IServiceResolver.h"
+#include "InlineExecutor.h"
 #include "ObservableMessageHandler.h"
 #include "ObservableRequestHandler.h"
+#include "PriorityLoadShedder.h"
 #include "Router.h"
+#include "Shard.h"
 #include "UriShortenerMessageHandler.h"
 #include "UriShortenerRequestHandler.h"
 
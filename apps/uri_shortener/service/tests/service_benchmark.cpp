@@ -1,14 +1,23 @@
+#include "IDataServiceAdapter.h"
 #include "InMemoryLinkRepository.h"
 #include "RandomCodeGenerator.h"
 #include "ResolveLink.h"
 #include "ShortenLink.h"
+#include "UriShortenerMessageHandler.h"
+#include "UriShortenerRequestHandler.h"
 
+#include <AffinityExecutor.h>
+#include <InlineExecutor.h>
+#include <atomic>
 #include <benchmark/benchmark.h>
+#include <boost/asio.hpp>
 #include <memory>
+#include <thread>
 
 using namespace uri_shortener::application;
 using namespace uri_shortener::domain;
 using namespace uri_shortener::infrastructure;
+using namespace uri_shortener::service;
 
 // =============================================================================
 // ShortenLink Use Case Benchmarks
@@ -127,4 +136,149 @@ static void BM_RepositoryLookup(benchmark::State &state) {
 }
 BENCHMARK(BM_RepositoryLookup);
 
+// =============================================================================
+// Request Path Benchmarks
+// =============================================================================
+//
+// GET /:code from the request handler to the closed response, against a data
+// service that answers at once. The calling thread stands in for the server
+// io thread. With lanes, the request goes to a lane, the reply arrives on a
+// separate client io thread (an Http2Client with its own connection thread)
+// and goes back to a lane; in run-to-completion mode all of it runs inline
+// (a client bound to the caller's io_context). The gap is the cost of the
+// thread hops.
+
+namespace {
+
+class BenchRequest : public astra::router::IRequest {
+public:
+  BenchRequest(std::string method, std::string path)
+      : m_method(std::move(method)), m_path(std::move(path)) {
+  }
+
+  const std::string &method() const override {
+    return m_method;
+  }
+  const std::string &path() const override {
+    return m_path;
+  }
+  const std::string &body() const override {
+    return m_empty;
+  }
+  std::string_view header(std::string_view) const override {
+    return {};
+  }
+  std::string_view path_param(std::string_view) const override {
+    return {};
+  }
+  std::string_view query_param(std::string_view) const override {
+    return {};
+  }
+  void set_path_params(astra::router::PathParams) override {
+  }
+
+private:
+  std::string m_method;
+  std::string m_path;
+  std::string m_empty;
+};
+
+class BenchResponse : public astra::router::IResponse {
+public:
+  void set_status(int) noexcept override {
+  }
+  void set_header(const std::string &, const std::string &) override {
+  }
+  void write(const std::string &) override {
+  }
+  void close() override {
+    m_closed.store(true, std::memory_order_release);
+  }
+  bool is_alive() const noexcept override {
+    return true;
+  }
+
+  bool closed() const noexcept {
+    return m_closed.load(std::memory_order_acquire);
+  }
+
+private:
+  std::atomic<bool> m_closed{false};
+};
+
+// Answers every call with a link; on `io` when given, otherwise inline
+class BenchDataService : public IDataServiceAdapter {
+public:
+  explicit BenchDataService(boost::asio::io_context *io) : m_io(io) {
+  }
+
+  void execute(DataServiceRequest request,
+               DataServiceCallback callback) override {
+    auto reply = [response = request.response,
+                  callback = std::move(callback)] {
+      DataServiceResponse resp;
+      resp.success = true;
+      resp.http_status = 200;
+      resp.payload = R"({"url": "https://example.com/page"})";
+      resp.response = response;
+      callback(std::move(resp));
+    };
+    if (m_io) {
+      boost::asio::post(*m_io, std::move(reply));
+    } else {
+      reply();
+    }
+  }
+
+private:
+  boost::asio::io_context *m_io;
+};
+
+void run_request_path(benchmark::State &state,
+                      uri_shortener::UriShortenerRequestHandler &handler) {
+  auto req = std::make_shared<BenchRequest>("GET", "/abc123");
+  for (auto _ : state) {
+    auto res = std::make_shared<BenchResponse>();
+    handler.handle(req, res);
+    while (!res->closed()) {
+    }
+  }
+}
+
+} // namespace
+
+static void BM_RequestPathLanes(benchmark::State &state) {
+  boost::asio::io_context client_io;
+  auto work = boost::asio::make_work_guard(client_io);
+  std::thread client_thread([&client_io] {
+    client_io.run();
+  });
+
+  uri_shortener::UriShortenerMessageHandler msg_handler(
+      std::make_shared<BenchDataService>(&client_io));
+  astra::execution::AffinityExecutor lanes(4, msg_handler);
+  msg_handler.setResponseExecutor(lanes);
+  lanes.start();
+  uri_shortener::UriShortenerRequestHandler handler(lanes);
+
+  run_request_path(state, handler);
+
+  lanes.stop();
+  work.reset();
+  client_thread.join();
+}
+BENCHMARK(BM_RequestPathLanes)->UseRealTime();
+
+static void BM_RequestPathRunToCompletion(benchmark::State &state) {
+  uri_shortener::UriShortenerMessageHandler msg_handler(
+      std::make_shared<BenchDataService>(nullptr));
+  astra::execution::AffinityExecutor lanes(4, msg_handler);
+  astra::execution::InlineExecutor inline_executor(msg_handler, lanes);
+  msg_handler.setResponseExecutor(inline_executor);
+  uri_shortener::UriShortenerRequestHandler handler(inline_executor);
+
+  run_request_path(state, handler);
+}
+BENCHMARK(BM_RequestPathRunToCompletion)->UseRealTime();
+
 BENCHMARK_MAIN();
@@ -0,0 +1,139 @@
+#include "Shard.h"
+
+#include "AdmissionRoute.h"
+#include "Http2Request.h"
+#include "IDataServiceAdapter.h"
+#include "ObservableMessageHandler.h"
+#include "ObservableRequestHandler.h"
+#include "UriShortenerMessageHandler.h"
+#include "UriShortenerRequestHandler.h"
+
+#include <AffinityExecutor.h>
+#include <IResponse.h>
+#include <InlineExecutor.h>
+#include <gtest/gtest.h>
+#include <resilience/impl/PriorityLoadShedder.h>
+#include <thread>
+
+namespace uri_shortener::test {
+
+namespace {
+
+// Counts the calls and leaves them unanswered
+class CountingDataService : public service::IDataServiceAdapter {
+public:
+  void execute(service::DataServiceRequest,
+               service::DataServiceCallback) override {
+    ++calls;
+  }
+
+  int calls{0};
+};
+
+class RecordingResponse : public astra::router::IResponse {
+public:
+  void set_status(int code) noexcept override {
+    status = code;
+  }
+  void set_header(const std::string &, const std::string &) override {
+  }
+  void write(const std::string &) override {
+  }
+  void close() override {
+  }
+  bool is_alive() const noexcept override {
+    return true;
+  }
+
+  int status{0};
+};
+
+// A shard wired like the builder's, on `adapter`, admitting up to
+// `max_concurrent` requests; 0 sheds every request
+std::unique_ptr<Shard>
+makeShard(size_t index, std::shared_ptr<service::IDataServiceAdapter> adapter,
+          size_t max_concurrent) {
+  using astra::resilience::PriorityBudget;
+  using astra::resilience::PriorityLoadShedderPolicy;
+
+  auto shard = std::make_unique<Shard>(index);
+  shard->data_adapter = std::move(adapter);
+  shard->msg_handler =
+      std::make_unique<UriShortenerMessageHandler>(shard->data_adapter);
+  shard->obs_msg_handler =
+      std::make_unique<ObservableMessageHandler>(*shard->msg_handler);
+  shard->lane = std::make_unique<astra::execution::AffinityExecutor>(
+      1, *shard->obs_msg_handler);
+  shard->executor = std::make_unique<astra::execution::InlineExecutor>(
+      *shard->obs_msg_handler, *shard->lane);
+  shard->msg_handler->setResponseExecutor(*shard->executor);
+  shard->req_handler =
+      std::make_unique<UriShortenerRequestHandler>(*shard->executor);
+  shard->obs_req_handler =
+      std::make_unique<ObservableRequestHandler>(*shard->req_handler);
+  auto policy =
+      max_concurrent == 0
+          ? PriorityLoadShedderPolicy::create(1, {}, "shard_test")
+          : PriorityLoadShedderPolicy::with_default_budgets(max_concurrent,
+                                                            "shard_test");
+  shard->load_shedder =
+      std::make_unique<astra::resilience::PriorityLoadShedder>(policy);
+  return shard;
+}
+
+} // namespace
+
+TEST(ShardTest, NoShardOutsideShardThreads) {
+  EXPECT_EQ(Shard::current(), nullptr);
+}
+
+TEST(ShardTest, EnterBindsShardToCallingThreadOnly) {
+  Shard shard(3);
+  Shard *seen = &shard;
+  Shard *other = &shard;
+
+  std::thread shard_thread([&] {
+    shard.enter(false);
+    seen = Shard::current();
+  });
+  shard_thread.join();
+  std::thread other_thread([&] {
+    other = Shard::current();
+  });
+  other_thread.join();
+
+  EXPECT_EQ(seen, &shard);
+  EXPECT_EQ(other, nullptr);
+  EXPECT_EQ(Shard::current(), nullptr);
+}
+
+TEST(ShardTest, RequestUsesShedderAndHandlersOfItsThreadsShard) {
+  auto first = std::make_shared<CountingDataService>();
+  auto second = std::make_shared<CountingDataService>();
+  UriShortenerComponents components;
+  components.shards.push_back(makeShard(0, first, 100));
+  components.shards.push_back(makeShard(1, second, 0));
+  AdmissionRoute route(components, astra::resilience::Priority::Critical);
+
+  auto serve_on = [&](size_t shard) {
+    auto res = std::make_shared<RecordingResponse>();
+    std::thread io_thread([&] {
+      components.shards[shard]->enter(false);
+      route(std::make_shared<astra::http2::Http2Request>("GET", "/abc"), res);
+    });
+    io_thread.join();
+    return res->status;
+  };
+
+  // Admitted by shard 0 and handed to its data service only
+  EXPECT_EQ(serve_on(0), 0);
+  EXPECT_EQ(first->calls, 1);
+  EXPECT_EQ(second->calls, 0);
+
+  // Shed by shard 1, whose budget is empty, though shard 0 has room
+  EXPECT_EQ(serve_on(1), 503);
+  EXPECT_EQ(first->calls, 1);
+  EXPECT_EQ(second->calls, 0);
+}
+
+} // namespace uri_shortener::test
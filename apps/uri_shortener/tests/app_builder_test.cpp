@@ -28,6 +28,81 @@ TEST(UriShortenerBuilderTest, Build_WithAllMethods_Succeeds) {
   EXPECT_TRUE(result.is_ok());
 }
 
+TEST(UriShortenerBuilderTest, Build_WithRunToCompletion_Succeeds) {
+  auto config = makeBuilderTestConfig();
+  config.mutable_bootstrap()->mutable_execution()->set_run_to_completion(true);
+
+  auto result = UriShortenerBuilder(config)
+                    .domain()
+                    .backend()
+                    .messaging()
+                    .resilience()
+                    .build();
+
+  EXPECT_TRUE(result.is_ok());
+}
+
+TEST(UriShortenerBuilderTest, Build_WithShards_Succeeds) {
+  auto config = makeBuilderTestConfig();
+  config.mutable_bootstrap()->mutable_sharding()->set_shard_count(4);
+
+  auto result = UriShortenerBuilder(config)
+                    .domain()
+                    .backend()
+                    .messaging()
+                    .resilience()
+                    .sharding()
+                    .build();
+
+  EXPECT_TRUE(result.is_ok());
+}
+
+TEST(UriShortenerBuilderTest, Build_WithUnixSocketEndpoints_Succeeds) {
+  auto config = makeBuilderTestConfig();
+  config.mutable_bootstrap()->mutable_server()->set_uri(
+      "unix:///tmp/uri_shortener_builder_test.sock");
+  config.mutable_bootstrap()->mutable_dataservice()->set_endpoint(
+      "unix:///tmp/dataservice_builder_test.sock");
+
+  auto result = UriShortenerBuilder(config)
+                    .domain()
+                    .backend()
+                    .messaging()
+                    .resilience()
+                    .build();
+
+  EXPECT_TRUE(result.is_ok());
+}
+
+TEST(UriShortenerBuilderTest, Build_WithShardsOverHttps_Fails) {
+  auto config = makeBuilderTestConfig();
+  config.mutable_bootstrap()->mutable_server()->set_uri(
+      "https://127.0.0.1:8443");
+  config.mutable_bootstrap()->mutable_sharding()->set_shard_count(2);
+
+  auto result = UriShortenerBuilder(config)
+                    .domain()
+                    .backend()
+                    .messaging()
+                    .resilience()
+                    .sharding()
+                    .build();
+
+  ASSERT_TRUE(result.is_err());
+  EXPECT_EQ(result.error(), BuilderError::InvalidConfig);
+}
+
+TEST(UriShortenerBuilderTest, ShardingMethodChainsCorrectly) {
+  auto config = makeBuilderTestConfig();
+  config.mutable_bootstrap()->mutable_sharding()->set_shard_count(2);
+
+  UriShortenerBuilder builder(config);
+  builder.domain().backend().messaging().resilience();
+  auto &returned = builder.sharding();
+
+  EXPECT_EQ(&returned, &builder);
+}
+
 TEST(UriShortenerBuilderTest, Build_WithEmptyUri_Fails) {
   auto config = makeBuilderTestConfig();
   config.mutable_bootstrap()->mutable_server()->set_uri("");
@@ -0,0 +1,39 @@
+# Compression.cmake - codecs for HTTP response compression
+#
+# gzip (zlib) is required; zstd and brotli are used when installed, and the
+# codings of a missing one are simply never negotiated. Link
+# astra_compression PRIVATE; ASTRA_HAS_ZSTD and ASTRA_HAS_BROTLI tell the
+# sources which codecs were found:
+#   target_link_libraries(my_library PRIVATE astra_compression)
+
+find_package(ZLIB REQUIRED)
+
+add_library(astra_compression INTERFACE)
+target_link_libraries(astra_compression INTERFACE ZLIB::ZLIB)
+
+find_path(ZSTD_INCLUDE_DIR NAMES zstd.h)
+find_library(ZSTD_LIBRARY NAMES zstd)
+if(ZSTD_INCLUDE_DIR AND ZSTD_LIBRARY)
+    message(STATUS "Compression: zstd enabled (${ZSTD_LIBRARY})")
+    target_include_directories(astra_compression INTERFACE ${ZSTD_INCLUDE_DIR})
+    target_link_libraries(astra_compression INTERFACE ${ZSTD_LIBRARY})
+    target_compile_definitions(astra_compression INTERFACE ASTRA_HAS_ZSTD)
+else()
+    message(STATUS "Compression: zstd not found, disabled")
+endif()
+
+find_path(BROTLI_INCLUDE_DIR NAMES brotli/encode.h)
+find_library(BROTLIENC_LIBRARY NAMES brotlienc)
+find_library(BROTLICOMMON_LIBRARY NAMES brotlicommon)
+if(BROTLI_INCLUDE_DIR AND BROTLIENC_LIBRARY AND BROTLICOMMON_LIBRARY)
+    message(STATUS "Compression: brotli enabled (${BROTLIENC_LIBRARY})")
+    target_include_directories(astra_compression INTERFACE ${BROTLI_INCLUDE_DIR})
+    target_link_libraries(astra_compression INTERFACE
+        ${BROTLIENC_LIBRARY} ${BROTLICOMMON_LIBRARY})
+    target_compile_definitions(astra_compression INTERFACE ASTRA_HAS_BROTLI)
+else()
+    message(STATUS "Compression: brotli not found, disabled")
+endif()
+
+mark_as_advanced(ZSTD_INCLUDE_DIR ZSTD_LIBRARY BROTLI_INCLUDE_DIR
+                 BROTLIENC_LIBRARY BROTLICOMMON_LIBRARY)
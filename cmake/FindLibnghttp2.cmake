@@ -0,0 +1,37 @@
+# Find the nghttp2 C library (pre-installed in Docker image with nghttp2-asio)
+#
+# This module defines:
+#   Libnghttp2_FOUND - True if nghttp2 was found
+#   Libnghttp2_INCLUDE_DIRS - Include directories
+#   Libnghttp2_LIBRARIES - Libraries to link
+#   nghttp2 - Imported target
+
+find_path(Libnghttp2_INCLUDE_DIR
+    NAMES nghttp2/nghttp2.h
+    PATHS /usr/local/include /usr/include
+)
+
+find_library(Libnghttp2_LIBRARY
+    NAMES nghttp2
+    PATHS /usr/local/lib /usr/lib
+)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Libnghttp2
+    REQUIRED_VARS Libnghttp2_LIBRARY Libnghttp2_INCLUDE_DIR
+)
+
+if(Libnghttp2_FOUND)
+    set(Libnghttp2_INCLUDE_DIRS ${Libnghttp2_INCLUDE_DIR})
+    set(Libnghttp2_LIBRARIES ${Libnghttp2_LIBRARY})
+
+    if(NOT TARGET nghttp2)
+        add_library(nghttp2 UNKNOWN IMPORTED)
+        set_target_properties(nghttp2 PROPERTIES
+            IMPORTED_LOCATION "${Libnghttp2_LIBRARY}"
+            INTERFACE_INCLUDE_DIRECTORIES "${Libnghttp2_INCLUDE_DIR}"
+        )
+    endif()
+endif()
+
+mark_as_advanced(Libnghttp2_INCLUDE_DIR Libnghttp2_LIBRARY)
@@ -0,0 +1,51 @@
+# IoUring.cmake - io_uring transport for the Boost.Asio based HTTP/1.1 code
+# Only active when ENABLE_IO_URING=ON (set by the *-io-uring presets)
+#
+# Asio picks its reactor at compile time, so the backend is a build option
+# rather than runtime config: with it on, sockets, timers and accept run
+# through io_uring instead of epoll. Registered buffers and multishot
+# accept/recv are not used, as Asio's backend does not expose them.
+#
+# The definitions change Asio's own types, so every target sharing an
+# io_context must see them; link astra_io_uring PUBLIC:
+#   target_link_libraries(my_library PUBLIC astra_io_uring)
+#
+# nghttp2-asio is a prebuilt library compiled against epoll, so the HTTP/2
+# targets must not link this, and no binary may link both them and an
+# io_uring target: Asio's types would differ between the two. Tests that
+# need both, like h2c_handoff_test, are left out of the io_uring build.
+
+option(ENABLE_IO_URING "Use Asio's io_uring backend instead of epoll" OFF)
+
+# Create empty interface library so targets can always link to it
+add_library(astra_io_uring INTERFACE)
+
+if(NOT ENABLE_IO_URING)
+    message(STATUS "io_uring: Disabled")
+    return()
+endif()
+
+find_path(LIBURING_INCLUDE_DIR NAMES liburing.h)
+find_library(LIBURING_LIBRARY NAMES uring)
+
+if(NOT LIBURING_INCLUDE_DIR OR NOT LIBURING_LIBRARY)
+    message(FATAL_ERROR "ENABLE_IO_URING requires liburing (liburing-dev)")
+endif()
+
+find_package(Boost REQUIRED)
+if(Boost_VERSION VERSION_LESS 1.78)
+    message(FATAL_ERROR "Asio's io_uring backend needs Boost 1.78 or newer")
+endif()
+
+message(STATUS "io_uring: Enabled (${LIBURING_LIBRARY})")
+
+target_include_directories(astra_io_uring INTERFACE ${LIBURING_INCLUDE_DIR})
+target_link_libraries(astra_io_uring INTERFACE ${LIBURING_LIBRARY})
+target_compile_definitions(astra_io_uring INTERFACE
+    BOOST_ASIO_HAS_IO_URING
+    # Without this Asio keeps epoll for sockets and only uses io_uring for
+    # files
+    BOOST_ASIO_DISABLE_EPOLL
+)
+
+mark_as_advanced(LIBURING_INCLUDE_DIR LIBURING_LIBRARY)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Backpressure.h"
 #include "IExecutor.h"
 #include "IMessageHandler.h"
 #include "MessageQueue.h"
@@ -28,6 +29,23 @@ public:
     return m_lanes.size();
   }
 
+  // Messages submitted but not yet picked up, across all lanes
+  [[nodiscard]] size_t queued() const noexcept {
+    return m_queued.load(std::memory_order_relaxed);
+  }
+
+  // Feeds queued() into `backpressure` on every submit and dequeue, and
+  // opens it for good on stop(). Set before start(); the executor must
+  // outlive its updates.
+  void set_backpressure(std::shared_ptr<Backpressure> backpressure) {
+    m_backpressure = std::move(backpressure);
+    if (m_backpressure) {
+      m_backpressure->track([this] {
+        return queued();
+      });
+    }
+  }
+
 private:
   struct Lane {
     MessageQueue queue;
@@ -37,6 +55,8 @@ private:
   std::vector<std::unique_ptr<Lane>> m_lanes;
   IMessageHandler &m_handler;
   std::atomic<bool> m_running{false};
+  std::atomic<size_t> m_queued{0};
+  std::shared_ptr<Backpressure> m_backpressure;
 };
 
 } // namespace astra::execution
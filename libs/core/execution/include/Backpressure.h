@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+namespace astra::execution {
+
+// Queue-depth gate with hysteresis, fed by an executor and consulted by a
+// transport. It pauses once the depth reaches `high_water` and stays paused
+// until the depth falls to `low_water`, so it does not flap around a
+// single threshold. Transports poll is_paused() and never block on it: the
+// HTTP/2 server's read gate stops reading while paused and lets one read
+// through after its `max_hold`, so a gate that never opens cannot stall a
+// connection for good.
+//
+// update() is called on every enqueue and dequeue and only takes the lock
+// when the state flips. Concurrent updates can arrive out of order, so with
+// a depth source set the flip is checked against the live depth under the
+// lock, and a pause is undone if the queue drained meanwhile.
+class Backpressure {
+public:
+  Backpressure(size_t high_water, size_t low_water);
+
+  Backpressure(const Backpressure &) = delete;
+  Backpressure &operator=(const Backpressure &) = delete;
+
+  // Where update() gets the live depth from when the state flips; set by
+  // the executor that feeds the gate, before its first update
+  void track(std::function<size_t()> depth) {
+    m_depth = std::move(depth);
+  }
+
+  void update(size_t depth) noexcept;
+
+  [[nodiscard]] bool is_paused() const noexcept {
+    return m_paused.load(std::memory_order_acquire);
+  }
+
+  // Opens the gate for good; used at shutdown, when the queues stop
+  // draining
+  void close() noexcept;
+
+  [[nodiscard]] size_t high_water() const noexcept {
+    return m_high_water;
+  }
+  [[nodiscard]] size_t low_water() const noexcept {
+    return m_low_water;
+  }
+
+private:
+  void set_paused(bool paused) noexcept;
+
+  const size_t m_high_water;
+  const size_t m_low_water;
+  std::function<size_t()> m_depth;
+  std::atomic<bool> m_paused{false};
+  std::atomic<bool> m_closed{false};
+  std::mutex m_mutex;
+};
+
+} // namespace astra::execution
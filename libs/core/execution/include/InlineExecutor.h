@@ -0,0 +1,27 @@
+#pragma once
+
+#include "IExecutor.h"
+#include "IMessageHandler.h"
+
+namespace astra::execution {
+
+// Handles each message on the thread that submits it, so a request and the
+// callbacks it triggers run to completion on one thread without queue hops.
+// Messages marked `blocking` go to `offload` instead, keeping threads that
+// must not stall (io threads) free of that work.
+class InlineExecutor : public IExecutor {
+public:
+  InlineExecutor(IMessageHandler &handler, IExecutor &offload);
+  ~InlineExecutor() override = default;
+
+  InlineExecutor(const InlineExecutor &) = delete;
+  InlineExecutor &operator=(const InlineExecutor &) = delete;
+
+  void submit(Message msg) override;
+
+private:
+  IMessageHandler &m_handler;
+  IExecutor &m_offload;
+};
+
+} // namespace astra::execution
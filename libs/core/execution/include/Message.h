@@ -10,6 +10,9 @@ struct Message {
   uint64_t affinity_key;
   astra::observability::Context trace_ctx;
   std::any payload;
+  // Work that may stall its thread (disk, locks, CPU-heavy parsing); an
+  // InlineExecutor hands these to its offload executor
+  bool blocking{false};
 };
 
 } // namespace astra::execution
@@ -26,6 +26,10 @@ void AffinityExecutor::start() {
     Lane *lane = lane_ptr.get();
     lane_ptr->thread = std::thread([this, lane]() {
       while (auto msg = lane->queue.pop()) {
+        size_t depth = m_queued.fetch_sub(1, std::memory_order_relaxed) - 1;
+        if (m_backpressure) {
+          m_backpressure->update(depth);
+        }
         m_handler.handle(*msg);
       }
     });
@@ -38,6 +42,10 @@ void AffinityExecutor::stop() {
   }
   m_running.store(false);
 
+  // Nothing drains the queues from here on
+  if (m_backpressure) {
+    m_backpressure->close();
+  }
   for (auto &lane : m_lanes) {
     lane->queue.close();
   }
@@ -51,6 +59,10 @@ void AffinityExecutor::stop() {
 
 void AffinityExecutor::submit(Message msg) {
   size_t lane_idx = msg.affinity_key % m_lanes.size();
+  size_t depth = m_queued.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (m_backpressure) {
+    m_backpressure->update(depth);
+  }
   m_lanes[lane_idx]->queue.push(std::move(msg));
 }
 
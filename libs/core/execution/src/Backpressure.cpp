@@ -0,0 +1,54 @@
+#include "Backpressure.h"
+
+#include <algorithm>
+
+namespace astra::execution {
+
+Backpressure::Backpressure(size_t high_water, size_t low_water)
+    : m_high_water(std::max<size_t>(high_water, 1)),
+      m_low_water(std::min(low_water, m_high_water - 1)) {
+}
+
+void Backpressure::update(size_t depth) noexcept {
+  if (depth >= m_high_water) {
+    if (!m_paused.load(std::memory_order_relaxed)) {
+      set_paused(true);
+    }
+  } else if (depth <= m_low_water) {
+    // Pairs with the fence in set_paused(true): either this update sees the
+    // pause, or the pausing thread sees the depth this one reports
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_paused.load(std::memory_order_relaxed)) {
+      set_paused(false);
+    }
+  }
+}
+
+void Backpressure::close() noexcept {
+  m_closed.store(true, std::memory_order_release);
+  set_paused(false);
+}
+
+void Backpressure::set_paused(bool paused) noexcept {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  bool closed = m_closed.load(std::memory_order_acquire);
+  if (!paused) {
+    // A stale drain; later dequeues open the gate
+    if (!closed && m_depth && m_depth() > m_low_water) {
+      return;
+    }
+    m_paused.store(false, std::memory_order_release);
+    return;
+  }
+  if (closed) {
+    return;
+  }
+  m_paused.store(true, std::memory_order_release);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  // Dequeues that drained the queue before seeing the pause
+  if (m_depth && m_depth() <= m_low_water) {
+    m_paused.store(false, std::memory_order_release);
+  }
+}
+
+} // namespace astra::execution
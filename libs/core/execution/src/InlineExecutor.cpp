@@ -0,0 +1,19 @@
+#include "InlineExecutor.h"
+
+#include <utility>
+
+namespace astra::execution {
+
+InlineExecutor::InlineExecutor(IMessageHandler &handler, IExecutor &offload)
+    : m_handler(handler), m_offload(offload) {
+}
+
+void InlineExecutor::submit(Message msg) {
+  if (msg.blocking) {
+    m_offload.submit(std::move(msg));
+    return;
+  }
+  m_handler.handle(msg);
+}
+
+} // namespace astra::execution
@@ -321,4 +321,47 @@ TEST_F(AffinityExecutorTest, LongRunningHandler) {
   EXPECT_EQ(handler.processed_count(), 4);
 }
 
+// =============================================================================
+// Backpressure Tests
+// =============================================================================
+
+TEST_F(AffinityExecutorTest, QueuedMessagesDriveBackpressure) {
+  handler.set_delay(20ms);
+  AffinityExecutor executor(1, handler);
+  auto backpressure = std::make_shared<Backpressure>(4, 1);
+  executor.set_backpressure(backpressure);
+  executor.start();
+
+  for (int i = 0; i < 6; ++i) {
+    executor.submit(Message{.affinity_key = 0, .trace_ctx = {}, .payload = {}});
+  }
+  EXPECT_GE(executor.queued(), 4u);
+  EXPECT_TRUE(backpressure->is_paused());
+
+  auto deadline = std::chrono::steady_clock::now() + 2s;
+  while (backpressure->is_paused() &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_FALSE(backpressure->is_paused());
+  EXPECT_LE(executor.queued(), 1u);
+  executor.stop();
+}
+
+TEST_F(AffinityExecutorTest, StopReleasesBackpressure) {
+  AffinityExecutor executor(1, handler);
+  auto backpressure = std::make_shared<Backpressure>(2, 0);
+  executor.set_backpressure(backpressure);
+
+  // Not started, so nothing drains
+  for (int i = 0; i < 3; ++i) {
+    executor.submit(Message{.affinity_key = 0, .trace_ctx = {}, .payload = {}});
+  }
+  ASSERT_TRUE(backpressure->is_paused());
+
+  executor.start();
+  executor.stop();
+  EXPECT_FALSE(backpressure->is_paused());
+}
+
 } // namespace astra::execution
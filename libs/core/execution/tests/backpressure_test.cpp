@@ -0,0 +1,74 @@
+#include "Backpressure.h"
+
+#include <gtest/gtest.h>
+
+namespace astra::execution {
+
+TEST(BackpressureTest, PausesAtHighWaterAndResumesAtLowWater) {
+  Backpressure gate(10, 4);
+
+  gate.update(9);
+  EXPECT_FALSE(gate.is_paused());
+  gate.update(10);
+  EXPECT_TRUE(gate.is_paused());
+
+  // Between the marks the state holds either way
+  gate.update(5);
+  EXPECT_TRUE(gate.is_paused());
+  gate.update(4);
+  EXPECT_FALSE(gate.is_paused());
+  gate.update(9);
+  EXPECT_FALSE(gate.is_paused());
+}
+
+TEST(BackpressureTest, LowWaterIsKeptBelowHighWater) {
+  Backpressure gate(4, 8);
+
+  EXPECT_EQ(gate.high_water(), 4u);
+  EXPECT_EQ(gate.low_water(), 3u);
+}
+
+TEST(BackpressureTest, StalePauseOverADrainedQueueStaysOpen) {
+  Backpressure gate(2, 1);
+  size_t depth = 0;
+  gate.track([&depth] {
+    return depth;
+  });
+
+  // An enqueue that saw depth 2 applies after the queue drained
+  gate.update(2);
+  EXPECT_FALSE(gate.is_paused());
+
+  depth = 2;
+  gate.update(2);
+  EXPECT_TRUE(gate.is_paused());
+}
+
+TEST(BackpressureTest, StaleDrainOverAFullQueueStaysPaused) {
+  Backpressure gate(2, 1);
+  size_t depth = 3;
+  gate.track([&depth] {
+    return depth;
+  });
+  gate.update(3);
+  ASSERT_TRUE(gate.is_paused());
+
+  gate.update(1);
+  EXPECT_TRUE(gate.is_paused());
+
+  depth = 1;
+  gate.update(1);
+  EXPECT_FALSE(gate.is_paused());
+}
+
+TEST(BackpressureTest, CloseOpensForGood) {
+  Backpressure gate(2, 1);
+  gate.update(5);
+
+  gate.close();
+  EXPECT_FALSE(gate.is_paused());
+  gate.update(5);
+  EXPECT_FALSE(gate.is_paused());
+}
+
+} // namespace astra::execution
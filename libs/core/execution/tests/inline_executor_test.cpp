@@ -0,0 +1,60 @@
+#include "InlineExecutor.h"
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace astra::execution {
+
+namespace {
+
+class RecordingHandler : public IMessageHandler {
+public:
+  void handle(Message &msg) override {
+    keys.push_back(msg.affinity_key);
+    threads.push_back(std::this_thread::get_id());
+  }
+
+  std::vector<uint64_t> keys;
+  std::vector<std::thread::id> threads;
+};
+
+class RecordingExecutor : public IExecutor {
+public:
+  void submit(Message msg) override {
+    keys.push_back(msg.affinity_key);
+  }
+
+  std::vector<uint64_t> keys;
+};
+
+} // namespace
+
+TEST(InlineExecutorTest, HandlesOnSubmittingThread) {
+  RecordingHandler handler;
+  RecordingExecutor offload;
+  InlineExecutor executor(handler, offload);
+
+  executor.submit(Message{.affinity_key = 1, .trace_ctx = {}, .payload = {}});
+  executor.submit(Message{.affinity_key = 2, .trace_ctx = {}, .payload = {}});
+
+  EXPECT_EQ(handler.keys, (std::vector<uint64_t>{1, 2}));
+  ASSERT_EQ(handler.threads.size(), 2u);
+  EXPECT_EQ(handler.threads[0], std::this_thread::get_id());
+  EXPECT_TRUE(offload.keys.empty());
+}
+
+TEST(InlineExecutorTest, BlockingMessagesGoToOffload) {
+  RecordingHandler handler;
+  RecordingExecutor offload;
+  InlineExecutor executor(handler, offload);
+
+  executor.submit(Message{.affinity_key = 1, .trace_ctx = {}, .payload = {}});
+  executor.submit(Message{
+      .affinity_key = 2, .trace_ctx = {}, .payload = {}, .blocking = true});
+
+  EXPECT_EQ(handler.keys, (std::vector<uint64_t>{1}));
+  EXPECT_EQ(offload.keys, (std::vector<uint64_t>{2}));
+}
+
+} // namespace astra::execution
@@ -3,3 +3,4 @@
 #include "resilience/ILoadShedder.h"
 #include "resilience/LoadShedderGuard.h"
 #include "resilience/policy/LoadShedderPolicy.h"
+#include "resilience/policy/PriorityLoadShedderPolicy.h"
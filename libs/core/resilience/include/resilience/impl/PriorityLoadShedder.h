@@ -0,0 +1,46 @@
+#pragma once
+
+#include "resilience/LoadShedderGuard.h"
+#include "resilience/policy/PriorityLoadShedderPolicy.h"
+
+#include <array>
+#include <atomic>
+#include <optional>
+
+namespace astra::resilience {
+
+// Load shedder with per-priority concurrency budgets.
+// Each class first consumes its reserved slots, then borrows from the shared
+// pool up to its borrow limit. Lower classes get smaller slices, so they are
+// rejected first as load rises.
+class PriorityLoadShedder {
+public:
+  explicit PriorityLoadShedder(PriorityLoadShedderPolicy policy);
+
+  [[nodiscard]] std::optional<LoadShedderGuard> try_acquire(Priority priority);
+  void update_policy(const PriorityLoadShedderPolicy &policy);
+
+  [[nodiscard]] size_t current_count() const;
+  [[nodiscard]] size_t current_count(Priority priority) const;
+  [[nodiscard]] size_t max_concurrent() const;
+
+private:
+  struct ClassState {
+    std::atomic<size_t> reserved_in_flight{0};
+    std::atomic<size_t> borrowed_in_flight{0};
+    std::atomic<size_t> reserved{0};
+    std::atomic<size_t> borrowable{0};
+  };
+
+  static bool try_increment(std::atomic<size_t> &counter, size_t limit);
+
+  void release_reserved(ClassState &state);
+  void release_borrowed(ClassState &state);
+
+  std::array<ClassState, PRIORITY_COUNT> m_classes;
+  std::atomic<size_t> m_shared_in_flight{0};
+  std::atomic<size_t> m_shared_capacity{0};
+  std::atomic<size_t> m_max_concurrent{0};
+};
+
+} // namespace astra::resilience
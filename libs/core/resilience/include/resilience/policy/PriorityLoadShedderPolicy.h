@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+namespace astra::resilience {
+
+enum class Priority { Critical, Normal, Sheddable };
+
+inline constexpr size_t PRIORITY_COUNT = 3;
+
+inline constexpr size_t index_of(Priority priority) {
+  return static_cast<size_t>(priority);
+}
+
+inline const char *to_string(Priority priority) {
+  switch (priority) {
+  case Priority::Critical:
+    return "critical";
+  case Priority::Normal:
+    return "normal";
+  case Priority::Sheddable:
+    return "sheddable";
+  }
+  return "normal";
+}
+
+// Concurrency slice owned by one priority class.
+// `reserved` slots are never used by other classes; `borrowable` caps how many
+// slots the class may take from the shared pool on top of its reservation.
+struct PriorityBudget {
+  size_t reserved{0};
+  size_t borrowable{0};
+};
+
+struct PriorityLoadShedderPolicy {
+  size_t max_concurrent{0};
+  std::array<PriorityBudget, PRIORITY_COUNT> budgets{};
+  std::string name{};
+
+  [[nodiscard]] const PriorityBudget &budget(Priority priority) const {
+    return budgets[index_of(priority)];
+  }
+
+  // Slots not reserved by any class; shared by borrowing classes
+  [[nodiscard]] size_t shared_capacity() const {
+    size_t reserved = 0;
+    for (const auto &b : budgets) {
+      reserved += b.reserved;
+    }
+    return max_concurrent - reserved;
+  }
+
+  static PriorityLoadShedderPolicy
+  create(size_t max_concurrent,
+         std::array<PriorityBudget, PRIORITY_COUNT> budgets, std::string name) {
+    if (max_concurrent == 0) {
+      throw std::invalid_argument("max_concurrent must be greater than 0");
+    }
+    size_t reserved = 0;
+    for (const auto &b : budgets) {
+      reserved += b.reserved;
+    }
+    if (reserved > max_concurrent) {
+      throw std::invalid_argument(
+          "sum of reserved slots must not exceed max_concurrent");
+    }
+    return PriorityLoadShedderPolicy{max_concurrent, budgets, std::move(name)};
+  }
+
+  // Default split of a single concurrency limit:
+  //   critical  - 50% reserved, may borrow the whole shared pool
+  //   normal    - 20% reserved, may borrow the whole shared pool
+  //   sheddable - nothing reserved, may borrow half of the shared pool
+  static PriorityLoadShedderPolicy with_default_budgets(size_t max_concurrent,
+                                                        std::string name) {
+    size_t critical = max_concurrent / 2;
+    size_t normal = max_concurrent / 5;
+    size_t shared = max_concurrent - critical - normal;
+    return create(max_concurrent,
+                  {PriorityBudget{critical, shared},
+                   PriorityBudget{normal, shared},
+                   PriorityBudget{0, shared / 2}},
+                  std::move(name));
+  }
+
+  // One share of this policy for `parts` shedders that split the load
+  // between them, e.g. one per shard: every limit is divided by `parts`,
+  // rounding down, with at least one slot overall
+  [[nodiscard]] PriorityLoadShedderPolicy slice(size_t parts,
+                                                std::string slice_name) const {
+    if (parts == 0) {
+      throw std::invalid_argument("parts must be greater than 0");
+    }
+    std::array<PriorityBudget, PRIORITY_COUNT> shares{};
+    for (size_t i = 0; i < PRIORITY_COUNT; ++i) {
+      shares[i] = {budgets[i].reserved / parts, budgets[i].borrowable / parts};
+    }
+    return create(std::max<size_t>(max_concurrent / parts, 1), shares,
+                  std::move(slice_name));
+  }
+};
+
+} // namespace astra::resilience
@@ -0,0 +1,90 @@
+#include "resilience/impl/PriorityLoadShedder.h"
+
+namespace astra::resilience {
+
+PriorityLoadShedder::PriorityLoadShedder(PriorityLoadShedderPolicy policy) {
+  update_policy(policy);
+}
+
+bool PriorityLoadShedder::try_increment(std::atomic<size_t> &counter,
+                                        size_t limit) {
+  size_t current = counter.load(std::memory_order_relaxed);
+
+  while (current < limit) {
+    if (counter.compare_exchange_weak(current, current + 1,
+                                      std::memory_order_acquire,
+                                      std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::optional<LoadShedderGuard>
+PriorityLoadShedder::try_acquire(Priority priority) {
+  auto &state = m_classes[index_of(priority)];
+
+  if (try_increment(state.reserved_in_flight,
+                    state.reserved.load(std::memory_order_relaxed))) {
+    return LoadShedderGuard::create([this, &state]() {
+      release_reserved(state);
+    });
+  }
+
+  if (!try_increment(state.borrowed_in_flight,
+                     state.borrowable.load(std::memory_order_relaxed))) {
+    return std::nullopt;
+  }
+
+  if (!try_increment(m_shared_in_flight,
+                     m_shared_capacity.load(std::memory_order_relaxed))) {
+    state.borrowed_in_flight.fetch_sub(1, std::memory_order_release);
+    return std::nullopt;
+  }
+
+  return LoadShedderGuard::create([this, &state]() {
+    release_borrowed(state);
+  });
+}
+
+void PriorityLoadShedder::release_reserved(ClassState &state) {
+  state.reserved_in_flight.fetch_sub(1, std::memory_order_release);
+}
+
+void PriorityLoadShedder::release_borrowed(ClassState &state) {
+  m_shared_in_flight.fetch_sub(1, std::memory_order_release);
+  state.borrowed_in_flight.fetch_sub(1, std::memory_order_release);
+}
+
+void PriorityLoadShedder::update_policy(
+    const PriorityLoadShedderPolicy &policy) {
+  for (size_t i = 0; i < PRIORITY_COUNT; ++i) {
+    m_classes[i].reserved.store(policy.budgets[i].reserved,
+                                std::memory_order_relaxed);
+    m_classes[i].borrowable.store(policy.budgets[i].borrowable,
+                                  std::memory_order_relaxed);
+  }
+  m_shared_capacity.store(policy.shared_capacity(), std::memory_order_relaxed);
+  m_max_concurrent.store(policy.max_concurrent, std::memory_order_relaxed);
+}
+
+size_t PriorityLoadShedder::current_count() const {
+  size_t total = 0;
+  for (const auto &state : m_classes) {
+    total += state.reserved_in_flight.load(std::memory_order_relaxed) +
+             state.borrowed_in_flight.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+size_t PriorityLoadShedder::current_count(Priority priority) const {
+  const auto &state = m_classes[index_of(priority)];
+  return state.reserved_in_flight.load(std::memory_order_relaxed) +
+         state.borrowed_in_flight.load(std::memory_order_relaxed);
+}
+
+size_t PriorityLoadShedder::max_concurrent() const {
+  return m_max_concurrent.load(std::memory_order_relaxed);
+}
+
+} // namespace astra::resilience
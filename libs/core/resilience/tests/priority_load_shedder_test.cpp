@@ -0,0 +1,210 @@
+#include "resilience/impl/PriorityLoadShedder.h"
+#include "resilience/policy/PriorityLoadShedderPolicy.h"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace astra::resilience;
+
+class PriorityLoadShedderTest : public ::testing::Test {
+protected:
+  // 10 slots: critical reserves 4, normal reserves 2, 4 shared.
+  // Critical may borrow all 4 shared, normal 2, sheddable 1.
+  PriorityLoadShedderPolicy policy = PriorityLoadShedderPolicy::create(
+      10, {PriorityBudget{4, 4}, PriorityBudget{2, 2}, PriorityBudget{0, 1}},
+      "test");
+
+  static std::vector<std::optional<LoadShedderGuard>>
+  acquire_n(PriorityLoadShedder &shedder, Priority priority, size_t n) {
+    std::vector<std::optional<LoadShedderGuard>> guards;
+    for (size_t i = 0; i < n; ++i) {
+      guards.push_back(shedder.try_acquire(priority));
+    }
+    return guards;
+  }
+};
+
+TEST(PriorityLoadShedderPolicyTest, CreateThrowsOnZeroMaxConcurrent) {
+  EXPECT_THROW(PriorityLoadShedderPolicy::create(0, {}, "invalid"),
+               std::invalid_argument);
+}
+
+TEST(PriorityLoadShedderPolicyTest, CreateThrowsWhenReservedExceedsMax) {
+  EXPECT_THROW(PriorityLoadShedderPolicy::create(
+                   5,
+                   {PriorityBudget{3, 0}, PriorityBudget{3, 0},
+                    PriorityBudget{0, 0}},
+                   "invalid"),
+               std::invalid_argument);
+}
+
+TEST(PriorityLoadShedderPolicyTest, SharedCapacityIsUnreservedRemainder) {
+  auto policy = PriorityLoadShedderPolicy::create(
+      10, {PriorityBudget{4, 4}, PriorityBudget{2, 2}, PriorityBudget{0, 1}},
+      "test");
+
+  EXPECT_EQ(policy.shared_capacity(), 4);
+}
+
+TEST(PriorityLoadShedderPolicyTest, DefaultBudgetsFavourCritical) {
+  auto policy = PriorityLoadShedderPolicy::with_default_budgets(100, "default");
+
+  EXPECT_EQ(policy.budget(Priority::Critical).reserved, 50);
+  EXPECT_EQ(policy.budget(Priority::Normal).reserved, 20);
+  EXPECT_EQ(policy.budget(Priority::Sheddable).reserved, 0);
+  EXPECT_EQ(policy.shared_capacity(), 30);
+  EXPECT_EQ(policy.budget(Priority::Critical).borrowable, 30);
+  EXPECT_EQ(policy.budget(Priority::Sheddable).borrowable, 15);
+}
+
+TEST(PriorityLoadShedderPolicyTest, SliceDividesEveryLimit) {
+  auto policy = PriorityLoadShedderPolicy::with_default_budgets(100, "default")
+                    .slice(4, "shard");
+
+  EXPECT_EQ(policy.max_concurrent, 25);
+  EXPECT_EQ(policy.budget(Priority::Critical).reserved, 12);
+  EXPECT_EQ(policy.budget(Priority::Normal).reserved, 5);
+  EXPECT_EQ(policy.budget(Priority::Critical).borrowable, 7);
+  EXPECT_EQ(policy.budget(Priority::Sheddable).borrowable, 3);
+  EXPECT_EQ(policy.name, "shard");
+}
+
+TEST(PriorityLoadShedderPolicyTest, SliceKeepsOneSlot) {
+  auto policy = PriorityLoadShedderPolicy::with_default_budgets(2, "default")
+                    .slice(8, "shard");
+
+  EXPECT_EQ(policy.max_concurrent, 1);
+  EXPECT_THROW(policy.slice(0, "invalid"), std::invalid_argument);
+}
+
+TEST_F(PriorityLoadShedderTest, AcquireUsesReservedSlotsFirst) {
+  PriorityLoadShedder shedder(policy);
+
+  auto guards = acquire_n(shedder, Priority::Critical, 4);
+  for (const auto &g : guards) {
+    EXPECT_TRUE(g.has_value());
+  }
+
+  // Reserved slots do not consume the shared pool, so sheddable still fits
+  auto sheddable = shedder.try_acquire(Priority::Sheddable);
+  EXPECT_TRUE(sheddable.has_value());
+  EXPECT_EQ(shedder.current_count(), 5);
+}
+
+TEST_F(PriorityLoadShedderTest, BorrowLimitedPerClass) {
+  PriorityLoadShedder shedder(policy);
+
+  auto first = shedder.try_acquire(Priority::Sheddable);
+  auto second = shedder.try_acquire(Priority::Sheddable);
+
+  EXPECT_TRUE(first.has_value());
+  EXPECT_FALSE(second.has_value());
+  EXPECT_EQ(shedder.current_count(Priority::Sheddable), 1);
+}
+
+TEST_F(PriorityLoadShedderTest, SheddableRejectedWhenCriticalTakesSharedPool) {
+  PriorityLoadShedder shedder(policy);
+
+  // 4 reserved + 4 borrowed
+  auto guards = acquire_n(shedder, Priority::Critical, 8);
+  for (const auto &g : guards) {
+    EXPECT_TRUE(g.has_value());
+  }
+
+  EXPECT_FALSE(shedder.try_acquire(Priority::Sheddable).has_value());
+
+  // Normal still has its reservation
+  auto normal = acquire_n(shedder, Priority::Normal, 3);
+  EXPECT_TRUE(normal[0].has_value());
+  EXPECT_TRUE(normal[1].has_value());
+  EXPECT_FALSE(normal[2].has_value());
+}
+
+TEST_F(PriorityLoadShedderTest, CriticalKeepsReservationUnderLowPriorityLoad) {
+  PriorityLoadShedder shedder(policy);
+
+  auto normal = acquire_n(shedder, Priority::Normal, 4);
+  auto sheddable = acquire_n(shedder, Priority::Sheddable, 1);
+  EXPECT_EQ(shedder.current_count(), 5);
+
+  // Shared pool has 1 slot left plus 4 reserved for critical
+  auto critical = acquire_n(shedder, Priority::Critical, 6);
+  for (size_t i = 0; i < 5; ++i) {
+    EXPECT_TRUE(critical[i].has_value()) << "index " << i;
+  }
+  EXPECT_FALSE(critical[5].has_value());
+}
+
+TEST_F(PriorityLoadShedderTest, FailedBorrowDoesNotLeakClassCount) {
+  PriorityLoadShedder shedder(policy);
+
+  auto critical = acquire_n(shedder, Priority::Critical, 8);
+  EXPECT_FALSE(shedder.try_acquire(Priority::Sheddable).has_value());
+  EXPECT_EQ(shedder.current_count(Priority::Sheddable), 0);
+}
+
+TEST_F(PriorityLoadShedderTest, ReleaseReturnsSlotsToOwningPool) {
+  PriorityLoadShedder shedder(policy);
+
+  {
+    auto guards = acquire_n(shedder, Priority::Critical, 8);
+    EXPECT_EQ(shedder.current_count(), 8);
+  }
+  EXPECT_EQ(shedder.current_count(), 0);
+
+  auto sheddable = shedder.try_acquire(Priority::Sheddable);
+  EXPECT_TRUE(sheddable.has_value());
+}
+
+TEST_F(PriorityLoadShedderTest, UpdatePolicyChangesBudgets) {
+  PriorityLoadShedder shedder(policy);
+  EXPECT_EQ(shedder.max_concurrent(), 10);
+
+  shedder.update_policy(PriorityLoadShedderPolicy::create(
+      20, {PriorityBudget{4, 4}, PriorityBudget{2, 2}, PriorityBudget{0, 3}},
+      "updated"));
+
+  EXPECT_EQ(shedder.max_concurrent(), 20);
+  auto sheddable = acquire_n(shedder, Priority::Sheddable, 4);
+  EXPECT_TRUE(sheddable[2].has_value());
+  EXPECT_FALSE(sheddable[3].has_value());
+}
+
+TEST_F(PriorityLoadShedderTest, ConcurrentAcquireNeverExceedsMax) {
+  PriorityLoadShedder shedder(policy);
+
+  constexpr int NUM_THREADS = 12;
+  constexpr int OPS_PER_THREAD = 2000;
+  // Counted here rather than with current_count(), which also sees the
+  // tentative increments of acquires that are about to fail
+  std::atomic<size_t> held{0};
+  std::atomic<size_t> max_seen{0};
+
+  auto worker = [&](Priority priority) {
+    for (int i = 0; i < OPS_PER_THREAD; ++i) {
+      auto guard = shedder.try_acquire(priority);
+      if (guard) {
+        size_t current = held.fetch_add(1) + 1;
+        size_t expected = max_seen.load();
+        while (current > expected &&
+               !max_seen.compare_exchange_weak(expected, current)) {
+        }
+        std::this_thread::yield();
+        held.fetch_sub(1);
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    threads.emplace_back(worker, static_cast<Priority>(i % 3));
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(shedder.current_count(), 0);
+  EXPECT_LE(max_seen.load(), 10);
+}
@@ -19,7 +19,8 @@ public:
   /**
    * @brief Resolve a service name to host:port
    * @param service_name The logical service name
-   * @return Pair of (host, port)
+   * @return Pair of (host, port); for a service on a Unix domain socket the
+   *         host is "unix:///path" and the port 0
    * @throws std::runtime_error if service not found
    */
   virtual std::pair<std::string, uint16_t>
@@ -28,6 +28,17 @@ public:
   void register_service(const std::string &service_name,
                         const std::string &host, uint16_t port);
 
+  /**
+   * @brief Register a service by endpoint URI
+   * @param service_name Logical service name
+   * @param uri "host:port", or "unix:///path" for a Unix domain socket,
+   *            which resolves to host "unix:///path" and port 0
+   * @throws std::invalid_argument if service_name is empty or the URI is
+   *         malformed
+   */
+  void register_service(const std::string &service_name,
+                        const std::string &uri);
+
   /**
    * @brief Unregister a service
    * @param service_name Logical service name
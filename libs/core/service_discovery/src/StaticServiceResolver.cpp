@@ -1,5 +1,7 @@
 #include "StaticServiceResolver.h"
 
+#include <charconv>
+
 namespace astra::service_discovery {
 
 void StaticServiceResolver::register_service(const std::string &service_name,
@@ -15,6 +17,31 @@ void StaticServiceResolver::register_service(const std::string &service_name,
   m_services[service_name] = Endpoint{host, port};
 }
 
+void StaticServiceResolver::register_service(const std::string &service_name,
+                                             const std::string &uri) {
+  static const std::string unix_scheme = "unix://";
+  if (uri.compare(0, unix_scheme.size(), unix_scheme) == 0) {
+    if (uri.size() == unix_scheme.size()) {
+      throw std::invalid_argument("Socket path cannot be empty: " + uri);
+    }
+    register_service(service_name, uri, 0);
+    return;
+  }
+
+  size_t port_sep = uri.rfind(':');
+  if (port_sep == std::string::npos || port_sep + 1 == uri.size()) {
+    throw std::invalid_argument("Expected host:port or unix:///path: " + uri);
+  }
+  uint16_t port = 0;
+  const char *first = uri.data() + port_sep + 1;
+  const char *last = uri.data() + uri.size();
+  auto [ptr, ec] = std::from_chars(first, last, port);
+  if (ec != std::errc{} || ptr != last) {
+    throw std::invalid_argument("Invalid port in " + uri);
+  }
+  register_service(service_name, uri.substr(0, port_sep), port);
+}
+
 void StaticServiceResolver::unregister_service(
     const std::string &service_name) {
   m_services.erase(service_name);
@@ -205,3 +205,38 @@ TEST_F(StaticServiceResolverTest, UnregisterNonexistentIsNoOp) {
 
   EXPECT_NO_THROW({ resolver.unregister_service("nonexistent"); });
 }
+
+// =============================================================================
+// Endpoint URIs
+// =============================================================================
+
+TEST_F(StaticServiceResolverTest, RegisterHostPortUri) {
+  StaticServiceResolver resolver;
+  resolver.register_service("svc", "api.example.com:8443");
+
+  auto [host, port] = resolver.resolve("svc");
+  EXPECT_EQ(host, "api.example.com");
+  EXPECT_EQ(port, 8443);
+}
+
+TEST_F(StaticServiceResolverTest, RegisterUnixSocketUri) {
+  StaticServiceResolver resolver;
+  resolver.register_service("svc", "unix:///run/dataservice.sock");
+
+  auto [host, port] = resolver.resolve("svc");
+  EXPECT_EQ(host, "unix:///run/dataservice.sock");
+  EXPECT_EQ(port, 0);
+}
+
+TEST_F(StaticServiceResolverTest, RegisterMalformedUriThrows) {
+  StaticServiceResolver resolver;
+
+  EXPECT_THROW(resolver.register_service("svc", "no-port"),
+               std::invalid_argument);
+  EXPECT_THROW(resolver.register_service("svc", "host:"),
+               std::invalid_argument);
+  EXPECT_THROW(resolver.register_service("svc", "host:99999"),
+               std::invalid_argument);
+  EXPECT_THROW(resolver.register_service("svc", "unix://"),
+               std::invalid_argument);
+}
@@ -0,0 +1,111 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+namespace {
+
+std::atomic<size_t> g_allocations{0};
+std::atomic<size_t> g_live_bytes{0};
+
+void *counted(void *p) {
+  if (p) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_live_bytes.fetch_add(malloc_usable_size(p), std::memory_order_relaxed);
+  }
+  return p;
+}
+
+void *counted_alloc(size_t size) {
+  return counted(std::malloc(size == 0 ? 1 : size));
+}
+
+void *counted_aligned_alloc(size_t size, std::align_val_t alignment) {
+  auto align = static_cast<size_t>(alignment);
+  // aligned_alloc wants a multiple of the alignment
+  return counted(
+      std::aligned_alloc(align, (size + align - 1) / align * align));
+}
+
+void counted_free(void *p) {
+  if (p) {
+    g_live_bytes.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+    std::free(p);
+  }
+}
+
+void *or_throw(void *p) {
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+} // namespace
+
+namespace astra::utils {
+
+size_t allocation_count() noexcept {
+  return g_allocations.load(std::memory_order_relaxed);
+}
+
+size_t live_bytes() noexcept {
+  return g_live_bytes.load(std::memory_order_relaxed);
+}
+
+} // namespace astra::utils
+
+// Every replaceable form, so array and over-aligned allocations count too
+void *operator new(size_t size) {
+  return or_throw(counted_alloc(size));
+}
+void *operator new[](size_t size) {
+  return or_throw(counted_alloc(size));
+}
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return counted_alloc(size);
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return counted_alloc(size);
+}
+void *operator new(size_t size, std::align_val_t alignment) {
+  return or_throw(counted_aligned_alloc(size, alignment));
+}
+void *operator new[](size_t size, std::align_val_t alignment) {
+  return or_throw(counted_aligned_alloc(size, alignment));
+}
+void *operator new(size_t size, std::align_val_t alignment,
+                   const std::nothrow_t &) noexcept {
+  return counted_aligned_alloc(size, alignment);
+}
+void *operator new[](size_t size, std::align_val_t alignment,
+                     const std::nothrow_t &) noexcept {
+  return counted_aligned_alloc(size, alignment);
+}
+
+void operator delete(void *p) noexcept {
+  counted_free(p);
+}
+void operator delete[](void *p) noexcept {
+  counted_free(p);
+}
+void operator delete(void *p, size_t) noexcept {
+  counted_free(p);
+}
+void operator delete[](void *p, size_t) noexcept {
+  counted_free(p);
+}
+void operator delete(void *p, std::align_val_t) noexcept {
+  counted_free(p);
+}
+void operator delete[](void *p, std::align_val_t) noexcept {
+  counted_free(p);
+}
+void operator delete(void *p, size_t, std::align_val_t) noexcept {
+  counted_free(p);
+}
+void operator delete[](void *p, size_t, std::align_val_t) noexcept {
+  counted_free(p);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+
+namespace astra::utils {
+
+// Calls to global operator new so far. Only counted in executables linked
+// with astra_alloc_counter, which replaces every form of operator new.
+size_t allocation_count() noexcept;
+
+// Heap bytes allocated through operator new and not yet deleted, as the
+// allocator's usable size of each block, so slightly above what was asked
+// for. Same condition as allocation_count().
+size_t live_bytes() noexcept;
+
+// Runs `body` once per benchmark iteration and reports the heap
+// allocations per iteration as the user counter `counter`
+template <typename Body>
+void run_counted(benchmark::State &state, const char *counter, Body &&body) {
+  size_t before = allocation_count();
+  for (auto _ : state) {
+    body();
+  }
+  size_t allocations = allocation_count() - before;
+  state.counters[counter] = static_cast<double>(allocations) /
+                            static_cast<double>(state.iterations());
+}
+
+} // namespace astra::utils
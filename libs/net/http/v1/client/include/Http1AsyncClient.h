@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Http1Client.h"
+#include "Http1ClientError.h"
+#include "http1client.pb.h"
+
+#include <Result.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace astra::http1 {
+
+using AsyncResponseHandler = std::function<void(
+    astra::outcome::Result<Response, Http1ClientError>)>;
+
+// Non-blocking HTTP/1.1 client driven by its own io thread.
+//
+// Connections are pooled per host and port. With keep_alive set they are
+// reused while the server allows it; otherwise each request gets a fresh
+// connection. At most max_connections are open per host and further
+// requests queue until one frees up. Resolved addresses are cached, so only
+// the first connection to a host waits for DNS. Connections idle for
+// idle_timeout_ms are closed, and a host is dropped from the pool once it
+// has had no connections for as long.
+//
+// The config's host and port are not used; every request names its target.
+// Handlers run on the io thread and must not block. Requests still in
+// flight when the client is destroyed are dropped without a callback.
+class AsyncClient {
+public:
+  // Used when the matching config field is 0
+  static constexpr uint32_t DEFAULT_CONNECT_TIMEOUT_MS = 5000;
+  static constexpr uint32_t DEFAULT_REQUEST_TIMEOUT_MS = 30000;
+  static constexpr uint32_t DEFAULT_MAX_CONNECTIONS = 8;
+  static constexpr uint32_t DEFAULT_IDLE_TIMEOUT_MS = 60000;
+
+  explicit AsyncClient(const http1client::Config &config);
+  ~AsyncClient();
+
+  AsyncClient(const AsyncClient &) = delete;
+  AsyncClient &operator=(const AsyncClient &) = delete;
+
+  void submit(const std::string &host, uint16_t port, const std::string &method,
+              const std::string &target, const std::string &body,
+              const std::map<std::string, std::string> &headers,
+              AsyncResponseHandler handler);
+
+  // Hosts the pool still holds connections or cached addresses for.
+  // Blocks until the io thread answers.
+  [[nodiscard]] size_t pooled_hosts();
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> m_impl;
+};
+
+} // namespace astra::http1
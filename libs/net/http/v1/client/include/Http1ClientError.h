@@ -0,0 +1,12 @@
+#pragma once
+
+namespace astra::http1 {
+
+enum class Http1ClientError {
+  ResolveFailed,
+  ConnectionFailed,
+  RequestTimeout,
+  ConnectionClosed
+};
+
+} // namespace astra::http1
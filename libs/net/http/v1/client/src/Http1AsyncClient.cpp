@@ -0,0 +1,410 @@
+#include "Http1AsyncClient.h"
+
+#include <Log.h>
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace astra::http1 {
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+
+namespace {
+
+using ClientResult = astra::outcome::Result<Response, Http1ClientError>;
+
+// Cached addresses are re-resolved after this long, or as soon as a
+// connect to them fails
+constexpr auto DNS_CACHE_TTL = std::chrono::seconds(30);
+
+uint32_t or_default(uint32_t value, uint32_t fallback) {
+  return value > 0 ? value : fallback;
+}
+
+struct PendingRequest {
+  http::request<http::string_body> request;
+  AsyncResponseHandler handler;
+  // A request that failed on a reused connection is retried once on a new
+  // one, since the server may have closed it while it sat in the pool
+  bool retried = false;
+};
+
+struct Connection {
+  explicit Connection(net::io_context &ioc) : stream(ioc) {
+  }
+
+  beast::tcp_stream stream;
+  beast::flat_buffer buffer;
+  http::response<http::string_body> response;
+  PendingRequest current;
+  uint64_t served = 0;
+  std::chrono::steady_clock::time_point idle_since;
+};
+
+// State for one host:port, only touched on the io thread
+struct Pool {
+  std::string host;
+  std::string port;
+  tcp::resolver::results_type endpoints;
+  std::chrono::steady_clock::time_point resolved_at;
+  bool resolving = false;
+  std::deque<PendingRequest> queue;
+  std::vector<std::shared_ptr<Connection>> idle;
+  // Open connections, including those still connecting
+  size_t open = 0;
+  size_t connecting = 0;
+  // When a request last went out or came back
+  std::chrono::steady_clock::time_point last_used;
+};
+
+Response to_response(http::response<http::string_body> &res) {
+  Response response;
+  response.status_code = static_cast<int>(res.result_int());
+  response.body = std::move(res.body());
+  for (auto &field : res) {
+    response.headers[std::string(field.name_string())] =
+        std::string(field.value());
+  }
+  return response;
+}
+
+bool is_stale_connection_error(const beast::error_code &ec) {
+  return ec == http::error::end_of_stream || ec == net::error::eof ||
+         ec == net::error::connection_reset || ec == net::error::broken_pipe;
+}
+
+} // namespace
+
+class AsyncClient::Impl {
+public:
+  explicit Impl(const http1client::Config &config)
+      : m_connect_timeout(or_default(config.connect_timeout_ms(),
+                                     DEFAULT_CONNECT_TIMEOUT_MS)),
+        m_request_timeout(or_default(config.request_timeout_ms(),
+                                     DEFAULT_REQUEST_TIMEOUT_MS)),
+        m_idle_timeout(or_default(config.idle_timeout_ms(),
+                                  DEFAULT_IDLE_TIMEOUT_MS)),
+        m_max_connections(
+            or_default(config.max_connections(), DEFAULT_MAX_CONNECTIONS)),
+        m_keep_alive(config.keep_alive()), m_resolver(m_ioc),
+        m_sweep_timer(m_ioc), m_work(net::make_work_guard(m_ioc)) {
+    m_io_thread = std::thread([this]() {
+      try {
+        m_ioc.run();
+      } catch (const std::exception &e) {
+        obs::error(std::string("HTTP/1 client io error: ") + e.what());
+      }
+    });
+  }
+
+  ~Impl() {
+    m_work.reset();
+    m_ioc.stop();
+    if (m_io_thread.joinable()) {
+      m_io_thread.join();
+    }
+  }
+
+  void submit(const std::string &host, uint16_t port, const std::string &method,
+              const std::string &target, const std::string &body,
+              const std::map<std::string, std::string> &headers,
+              AsyncResponseHandler handler) {
+    // Serialisable state is built on the caller's thread; only the pool
+    // bookkeeping runs on the io thread
+    PendingRequest pending;
+    auto &req = pending.request;
+    req.version(11);
+    req.method_string(method);
+    req.target(target);
+    req.set(http::field::host, host);
+    req.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+    for (const auto &[name, value] : headers) {
+      req.set(name, value);
+    }
+    req.keep_alive(m_keep_alive);
+    req.body() = body;
+    req.prepare_payload();
+    pending.handler = std::move(handler);
+
+    net::post(m_ioc,
+              [this, host, port, pending = std::move(pending)]() mutable {
+                Pool &pool = pool_for(host, port);
+                pool.queue.push_back(std::move(pending));
+                pump(pool);
+              });
+  }
+
+  size_t pooled_hosts() {
+    std::promise<size_t> count;
+    auto result = count.get_future();
+    net::post(m_ioc, [this, &count] {
+      count.set_value(m_pools.size());
+    });
+    return result.get();
+  }
+
+private:
+  Pool &pool_for(const std::string &host, uint16_t port) {
+    std::string key = host + ":" + std::to_string(port);
+    auto &pool = m_pools[key];
+    if (!pool) {
+      pool = std::make_unique<Pool>();
+      pool->host = host;
+      pool->port = std::to_string(port);
+    }
+    return *pool;
+  }
+
+  // Every callback of a pool ends here, through pump() or directly
+  void touch(Pool &pool) {
+    pool.last_used = std::chrono::steady_clock::now();
+    schedule_sweep(pool.last_used + m_idle_timeout);
+  }
+
+  // Runs sweep() at `deadline` unless it is already due sooner
+  void schedule_sweep(std::chrono::steady_clock::time_point deadline) {
+    if (m_sweep_scheduled && m_sweep_timer.expiry() <= deadline) {
+      return;
+    }
+    m_sweep_scheduled = true;
+    m_sweep_timer.expires_at(deadline);
+    m_sweep_timer.async_wait([this](beast::error_code ec) {
+      if (ec == net::error::operation_aborted) {
+        return;
+      }
+      m_sweep_scheduled = false;
+      sweep();
+    });
+  }
+
+  // Closes connections idle for the idle timeout and drops hosts that have
+  // had none for as long. Callbacks in flight hold a Pool by reference, so
+  // only pools with nothing open, queued or resolving are erased.
+  void sweep() {
+    auto now = std::chrono::steady_clock::now();
+    auto next = std::chrono::steady_clock::time_point::max();
+
+    for (auto it = m_pools.begin(); it != m_pools.end();) {
+      Pool &pool = *it->second;
+      auto &idle = pool.idle;
+      for (auto conn = idle.begin(); conn != idle.end();) {
+        if (now - (*conn)->idle_since >= m_idle_timeout) {
+          --pool.open;
+          beast::error_code ec;
+          (*conn)->stream.socket().shutdown(tcp::socket::shutdown_both, ec);
+          (*conn)->stream.close();
+          conn = idle.erase(conn);
+        } else {
+          next = std::min(next, (*conn)->idle_since + m_idle_timeout);
+          ++conn;
+        }
+      }
+
+      // A busy pool is touched again when its work completes
+      if (pool.open == 0 && pool.queue.empty() && !pool.resolving) {
+        if (now - pool.last_used >= m_idle_timeout) {
+          it = m_pools.erase(it);
+          continue;
+        }
+        next = std::min(next, pool.last_used + m_idle_timeout);
+      }
+      ++it;
+    }
+
+    if (next != std::chrono::steady_clock::time_point::max()) {
+      schedule_sweep(next);
+    }
+  }
+
+  // Hands queued requests to idle connections and opens new ones while
+  // the host is under its limit
+  void pump(Pool &pool) {
+    touch(pool);
+    while (!pool.queue.empty()) {
+      if (!pool.idle.empty()) {
+        auto conn = std::move(pool.idle.back());
+        pool.idle.pop_back();
+        conn->current = std::move(pool.queue.front());
+        pool.queue.pop_front();
+        start_request(pool, std::move(conn));
+        continue;
+      }
+      if (pool.connecting >= pool.queue.size() ||
+          pool.open >= m_max_connections) {
+        return;
+      }
+      if (pool.endpoints.empty() ||
+          std::chrono::steady_clock::now() - pool.resolved_at >
+              DNS_CACHE_TTL) {
+        resolve(pool);
+        return;
+      }
+      connect(pool);
+    }
+  }
+
+  void resolve(Pool &pool) {
+    if (pool.resolving) {
+      return;
+    }
+    pool.resolving = true;
+    m_resolver.async_resolve(
+        pool.host, pool.port,
+        [this, &pool](beast::error_code ec,
+                      tcp::resolver::results_type results) {
+          pool.resolving = false;
+          if (ec) {
+            obs::error("HTTP/1 client failed to resolve " + pool.host + ": " +
+                       ec.message());
+            fail_queued(pool, Http1ClientError::ResolveFailed);
+            touch(pool);
+            return;
+          }
+          pool.endpoints = std::move(results);
+          pool.resolved_at = std::chrono::steady_clock::now();
+          pump(pool);
+        });
+  }
+
+  void connect(Pool &pool) {
+    ++pool.open;
+    ++pool.connecting;
+    auto conn = std::make_shared<Connection>(m_ioc);
+    conn->stream.expires_after(m_connect_timeout);
+    conn->stream.async_connect(
+        pool.endpoints,
+        [this, &pool, conn](beast::error_code ec, const tcp::endpoint &) {
+          --pool.connecting;
+          if (ec) {
+            --pool.open;
+            pool.endpoints = {};
+            // One queued request pays for each failed attempt, so a dead
+            // host drains the queue instead of retrying forever
+            if (!pool.queue.empty()) {
+              auto pending = std::move(pool.queue.front());
+              pool.queue.pop_front();
+              pending.handler(
+                  ClientResult::Err(Http1ClientError::ConnectionFailed));
+            }
+          } else {
+            conn->idle_since = std::chrono::steady_clock::now();
+            pool.idle.push_back(conn);
+          }
+          pump(pool);
+        });
+  }
+
+  void start_request(Pool &pool, std::shared_ptr<Connection> conn) {
+    conn->stream.expires_after(m_request_timeout);
+    http::async_write(
+        conn->stream, conn->current.request,
+        [this, &pool, conn](beast::error_code ec, std::size_t) {
+          if (ec) {
+            return on_error(pool, conn, ec);
+          }
+          conn->response = {};
+          http::async_read(conn->stream, conn->buffer, conn->response,
+                           [this, &pool, conn](beast::error_code ec,
+                                               std::size_t) {
+                             if (ec) {
+                               return on_error(pool, conn, ec);
+                             }
+                             on_response(pool, conn);
+                           });
+        });
+  }
+
+  void on_response(Pool &pool, const std::shared_ptr<Connection> &conn) {
+    ++conn->served;
+    bool reusable = m_keep_alive && conn->response.keep_alive();
+    auto handler = std::move(conn->current.handler);
+    auto response = to_response(conn->response);
+    conn->current = {};
+
+    if (reusable) {
+      conn->idle_since = std::chrono::steady_clock::now();
+      pool.idle.push_back(conn);
+    } else {
+      --pool.open;
+      beast::error_code ec;
+      conn->stream.socket().shutdown(tcp::socket::shutdown_both, ec);
+    }
+    handler(ClientResult::Ok(std::move(response)));
+    pump(pool);
+  }
+
+  void on_error(Pool &pool, const std::shared_ptr<Connection> &conn,
+                beast::error_code ec) {
+    --pool.open;
+    conn->stream.close();
+    auto pending = std::move(conn->current);
+
+    if (conn->served > 0 && !pending.retried &&
+        is_stale_connection_error(ec)) {
+      pending.retried = true;
+      pool.queue.push_front(std::move(pending));
+    } else {
+      auto error = ec == beast::error::timeout
+                       ? Http1ClientError::RequestTimeout
+                       : Http1ClientError::ConnectionClosed;
+      pending.handler(ClientResult::Err(error));
+    }
+    pump(pool);
+  }
+
+  void fail_queued(Pool &pool, Http1ClientError error) {
+    auto queue = std::move(pool.queue);
+    pool.queue.clear();
+    for (auto &pending : queue) {
+      pending.handler(ClientResult::Err(error));
+    }
+  }
+
+  std::chrono::milliseconds m_connect_timeout;
+  std::chrono::milliseconds m_request_timeout;
+  std::chrono::milliseconds m_idle_timeout;
+  size_t m_max_connections;
+  bool m_keep_alive;
+
+  // Handlers still queued when the io_context goes away own connections,
+  // so it is destroyed after the pools
+  net::io_context m_ioc;
+  tcp::resolver m_resolver;
+  std::unordered_map<std::string, std::unique_ptr<Pool>> m_pools;
+  net::steady_timer m_sweep_timer;
+  bool m_sweep_scheduled = false;
+  net::executor_work_guard<net::io_context::executor_type> m_work;
+  std::thread m_io_thread;
+};
+
+AsyncClient::AsyncClient(const http1client::Config &config)
+    : m_impl(std::make_unique<Impl>(config)) {
+}
+
+AsyncClient::~AsyncClient() = default;
+
+void AsyncClient::submit(const std::string &host, uint16_t port,
+                         const std::string &method, const std::string &target,
+                         const std::string &body,
+                         const std::map<std::string, std::string> &headers,
+                         AsyncResponseHandler handler) {
+  m_impl->submit(host, port, method, target, body, headers,
+                 std::move(handler));
+}
+
+size_t AsyncClient::pooled_hosts() {
+  return m_impl->pooled_hosts();
+}
+
+} // namespace astra::http1
@@ -1,7 +1,15 @@
+#include "Http1AsyncClient.h"
 #include "Http1Client.h"
 
+#include <atomic>
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <future>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <thread>
+#include <vector>
 
 using namespace testing;
 
@@ -20,3 +28,214 @@ TEST_F(Http1ClientTest, InvalidHost) {
   auto res = m_client.get("invalid.host.local", "80", "/");
   EXPECT_EQ(res.status_code, 500);
 }
+
+// Keep-alive server answering each request with its target. A thread per
+// connection keeps it simple; "/hang" gets no answer and "/drop" closes the
+// connection right after answering without saying so.
+class TestServer {
+public:
+  TestServer()
+      : m_acceptor(m_ioc, {boost::asio::ip::make_address("127.0.0.1"), 0}) {
+    m_accept_thread = std::thread([this] {
+      accept_loop();
+    });
+  }
+
+  ~TestServer() {
+    m_stopping = true;
+    // Wakes the blocking accept
+    boost::asio::ip::tcp::socket wake(m_ioc);
+    boost::system::error_code ec;
+    wake.connect(m_acceptor.local_endpoint(), ec);
+    m_accept_thread.join();
+    for (auto &t : m_connection_threads) {
+      t.join();
+    }
+  }
+
+  [[nodiscard]] uint16_t port() const {
+    return m_acceptor.local_endpoint().port();
+  }
+
+  [[nodiscard]] int accepted() const {
+    return m_accepted.load();
+  }
+
+private:
+  void accept_loop() {
+    while (true) {
+      boost::asio::ip::tcp::socket socket(m_ioc);
+      m_acceptor.accept(socket);
+      if (m_stopping) {
+        return;
+      }
+      ++m_accepted;
+      m_connection_threads.emplace_back(
+          [s = std::move(socket)]() mutable {
+            serve(std::move(s));
+          });
+    }
+  }
+
+  static void serve(boost::asio::ip::tcp::socket socket) {
+    namespace http = boost::beast::http;
+    boost::beast::flat_buffer buffer;
+    boost::system::error_code ec;
+    while (true) {
+      http::request<http::string_body> req;
+      http::read(socket, buffer, req, ec);
+      if (ec) {
+        return;
+      }
+      if (req.target() == "/hang") {
+        continue;
+      }
+      http::response<http::string_body> res{http::status::ok, req.version()};
+      res.body() = std::string(req.target());
+      res.keep_alive(req.keep_alive());
+      res.prepare_payload();
+      http::write(socket, res, ec);
+      if (ec || !req.keep_alive() || req.target() == "/drop") {
+        return;
+      }
+    }
+  }
+
+  boost::asio::io_context m_ioc;
+  boost::asio::ip::tcp::acceptor m_acceptor;
+  std::thread m_accept_thread;
+  std::vector<std::thread> m_connection_threads;
+  std::atomic<int> m_accepted{0};
+  std::atomic<bool> m_stopping{false};
+};
+
+class Http1AsyncClientTest : public Test {
+protected:
+  using ClientResult =
+      astra::outcome::Result<astra::http1::Response,
+                             astra::http1::Http1ClientError>;
+
+  static http1client::Config make_config(bool keep_alive,
+                                         uint32_t max_connections = 0) {
+    http1client::Config config;
+    config.set_keep_alive(keep_alive);
+    config.set_max_connections(max_connections);
+    config.set_connect_timeout_ms(1000);
+    config.set_request_timeout_ms(2000);
+    return config;
+  }
+
+  static ClientResult get(astra::http1::AsyncClient &client, uint16_t port,
+                          const std::string &target) {
+    std::promise<ClientResult> done;
+    auto result = done.get_future();
+    client.submit("127.0.0.1", port, "GET", target, "", {},
+                  [&done](ClientResult r) {
+                    done.set_value(std::move(r));
+                  });
+    return result.get();
+  }
+
+  TestServer m_server;
+};
+
+TEST_F(Http1AsyncClientTest, ReusesKeptAliveConnection) {
+  astra::http1::AsyncClient client(make_config(true));
+
+  for (int i = 0; i < 3; ++i) {
+    auto target = "/req" + std::to_string(i);
+    auto result = get(client, m_server.port(), target);
+    ASSERT_TRUE(result.is_ok());
+    EXPECT_EQ(result.value().status_code, 200);
+    EXPECT_EQ(result.value().body, target);
+  }
+  EXPECT_EQ(m_server.accepted(), 1);
+}
+
+TEST_F(Http1AsyncClientTest, WithoutKeepAliveEachRequestConnects) {
+  astra::http1::AsyncClient client(make_config(false));
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(get(client, m_server.port(), "/").is_ok());
+  }
+  EXPECT_EQ(m_server.accepted(), 3);
+}
+
+TEST_F(Http1AsyncClientTest, ConcurrentRequestsQueueForBoundedPool) {
+  astra::http1::AsyncClient client(make_config(true, 2));
+
+  constexpr int REQUESTS = 20;
+  std::vector<std::promise<ClientResult>> done(REQUESTS);
+  for (int i = 0; i < REQUESTS; ++i) {
+    client.submit("127.0.0.1", m_server.port(), "GET",
+                  "/" + std::to_string(i), "", {},
+                  [&done, i](ClientResult r) {
+                    done[i].set_value(std::move(r));
+                  });
+  }
+  for (int i = 0; i < REQUESTS; ++i) {
+    auto result = done[i].get_future().get();
+    ASSERT_TRUE(result.is_ok());
+    EXPECT_EQ(result.value().body, "/" + std::to_string(i));
+  }
+  EXPECT_LE(m_server.accepted(), 2);
+}
+
+TEST_F(Http1AsyncClientTest, RetriesWhenPooledConnectionWasClosed) {
+  astra::http1::AsyncClient client(make_config(true));
+
+  ASSERT_TRUE(get(client, m_server.port(), "/drop").is_ok());
+  // Give the close time to reach the client's idle connection
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  auto result = get(client, m_server.port(), "/after");
+  ASSERT_TRUE(result.is_ok());
+  EXPECT_EQ(result.value().body, "/after");
+  EXPECT_EQ(m_server.accepted(), 2);
+}
+
+TEST_F(Http1AsyncClientTest, SlowResponseTimesOut) {
+  auto config = make_config(true);
+  config.set_request_timeout_ms(100);
+  astra::http1::AsyncClient client(config);
+
+  auto result = get(client, m_server.port(), "/hang");
+  ASSERT_TRUE(result.is_err());
+  EXPECT_EQ(result.error(), astra::http1::Http1ClientError::RequestTimeout);
+}
+
+TEST_F(Http1AsyncClientTest, ConnectionRefused) {
+  astra::http1::AsyncClient client(make_config(true));
+
+  auto result = get(client, 1, "/");
+  ASSERT_TRUE(result.is_err());
+  EXPECT_EQ(result.error(), astra::http1::Http1ClientError::ConnectionFailed);
+}
+
+TEST_F(Http1AsyncClientTest, IdleConnectionIsClosedAndHostDropped) {
+  auto config = make_config(true);
+  config.set_idle_timeout_ms(100);
+  astra::http1::AsyncClient client(config);
+
+  ASSERT_TRUE(get(client, m_server.port(), "/first").is_ok());
+  EXPECT_EQ(client.pooled_hosts(), 1u);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  EXPECT_EQ(client.pooled_hosts(), 0u);
+
+  ASSERT_TRUE(get(client, m_server.port(), "/second").is_ok());
+  EXPECT_EQ(m_server.accepted(), 2);
+}
+
+TEST_F(Http1AsyncClientTest, ConnectionInUseOutlivesIdleTimeout) {
+  auto config = make_config(true);
+  config.set_idle_timeout_ms(200);
+  astra::http1::AsyncClient client(config);
+
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(get(client, m_server.port(), "/").is_ok());
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+  }
+  EXPECT_EQ(m_server.accepted(), 1);
+  EXPECT_EQ(client.pooled_hosts(), 1u);
+}
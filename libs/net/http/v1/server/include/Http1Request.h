@@ -1,10 +1,11 @@
 #pragma once
 
 #include "IRequest.h"
+#include "QueryParams.h"
 
 #include <boost/beast/http.hpp>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 namespace astra::http1 {
 
@@ -13,23 +14,32 @@ public:
   explicit Request(
       boost::beast::http::request<boost::beast::http::string_body> req);
 
+  // Path params view into path_str_
+  Request(const Request &) = delete;
+  Request &operator=(const Request &) = delete;
+
   [[nodiscard]] const std::string &method() const override;
   [[nodiscard]] const std::string &path() const override;
-  [[nodiscard]] std::string header(const std::string &name) const override;
   [[nodiscard]] const std::string &body() const override;
-  [[nodiscard]] std::string path_param(const std::string &key) const override;
-  [[nodiscard]] std::string query_param(const std::string &key) const override;
+  [[nodiscard]] std::string_view header(std::string_view name) const override;
+  [[nodiscard]] std::string_view
+  path_param(std::string_view key) const override;
+  [[nodiscard]] std::string_view
+  query_param(std::string_view key) const override;
 
   // Internal setter for Router
-  void
-  set_path_params(std::unordered_map<std::string, std::string> params) override;
+  void set_path_params(astra::router::PathParams params) override;
 
 private:
   boost::beast::http::request<boost::beast::http::string_body> req_;
-  mutable std::string method_str_;
-  mutable std::string path_str_;
-  mutable std::string body_str_;
-  std::unordered_map<std::string, std::string> path_params_;
+  // Only set for methods beast does not know; standard verbs come from a
+  // shared table
+  std::string method_str_;
+  // IRequest::path() hands out a std::string, so the path is the one part
+  // of the target that is copied
+  std::string path_str_;
+  astra::router::PathParams path_params_;
+  astra::router::QueryParams query_params_;
 };
 
 } // namespace astra::http1
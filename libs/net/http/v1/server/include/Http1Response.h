@@ -8,23 +8,59 @@
 
 namespace astra::http1 {
 
+// Builds a response in a message owned by the connection, which writes it
+// from there once it is ready, so the message is never copied or moved.
+//
+// The response may outlive the handler: it is sent when closed or dropped.
+// The callbacks may be called from any thread; the connection runs them on
+// its own executor. A streamed body can be produced from a worker that
+// yields while pending_bytes() is high.
 class Response final : public astra::router::IResponse {
 public:
-  using SendCallback = std::function<void(
-      boost::beast::http::response<boost::beast::http::string_body>)>;
+  using Message =
+      boost::beast::http::response<boost::beast::http::string_body>;
+  // Hands the message back to the connection. With `header_only` only the
+  // header is to be written; the body follows as chunks through WriteRaw.
+  // The message must not be touched afterwards.
+  using ReadyCallback = std::function<void(bool header_only)>;
+  // Writes raw bytes to the connection in order; `last` marks the end of the
+  // response. Required for streaming, which uses chunked transfer encoding,
+  // or a body delimited by closing the connection for HTTP/1.0 peers.
+  using WriteRaw = std::function<void(std::string bytes, bool last)>;
+  // Raw bytes handed to WriteRaw that the connection has not written yet
+  using PendingBytes = std::function<size_t()>;
 
-  explicit Response(SendCallback callback);
+  Response(Message &message, ReadyCallback on_ready, WriteRaw write_raw = {},
+           PendingBytes pending = {});
+  ~Response() override;
 
   void set_status(int status_code) noexcept override;
   void set_header(const std::string &name, const std::string &value) override;
   void write(const std::string &content) override;
   void close() override;
   [[nodiscard]] bool is_alive() const noexcept override;
+  void send_headers() override;
+  [[nodiscard]] size_t pending_bytes() const noexcept override;
+
+  // Answers with the request's HTTP version and tells the client whether the
+  // connection stays open afterwards
+  void set_keep_alive(unsigned version, bool keep_alive);
 
 private:
-  boost::beast::http::response<boost::beast::http::string_body> res_;
-  SendCallback callback_;
+  // The header can still change: nothing has been handed back yet
+  [[nodiscard]] bool is_pending() const noexcept {
+    return !closed_ && !streaming_;
+  }
+
+  Message &res_;
+  ReadyCallback on_ready_;
+  WriteRaw write_raw_;
+  PendingBytes pending_;
   bool closed_ = false;
+  bool streaming_ = false;
+  // HTTP/1.0 has no chunked encoding: the body runs until the connection
+  // closes
+  bool close_delimited_ = false;
 };
 
 } // namespace astra::http1
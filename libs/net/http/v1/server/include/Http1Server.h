@@ -3,27 +3,67 @@
 #include "IRequest.h"
 #include "IResponse.h"
 #include "Router.h"
+#include "http1server.pb.h"
 
 #include <boost/asio.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <thread>
 #include <vector>
 
 namespace astra::http1 {
 
+// How connections are spread over the io threads
+enum class ListenMode {
+  // One io_context and one acceptor shared by all threads
+  Shared,
+  // Every thread owns an io_context and an SO_REUSEPORT listener on the same
+  // endpoint; the kernel balances new connections between them, so threads
+  // never share an acceptor or a scheduler queue
+  ReusePort,
+};
+
 class Server {
 public:
   using Handler = std::function<void(astra::router::IRequest &,
                                      astra::router::IResponse &)>;
 
-  Server(const std::string &address, unsigned short port, int threads = 1);
+  // Takes over a connection sniffed as cleartext HTTP/2: the descriptor of
+  // its socket, now owned by the handler, bytes already read from it, and
+  // for "Upgrade: h2c" the request that asked for it, after its 101 has been
+  // sent. Typically hands them to an http2::Http2Server::adopt() serving the
+  // same router. A descriptor rather than a socket, as the HTTP/2 side may
+  // be built for another Asio backend (see IoUring.cmake).
+  using UpgradeRequest =
+      boost::beast::http::request<boost::beast::http::string_body>;
+  using H2cHandler = std::function<void(int socket, std::string preread,
+                                        std::optional<UpgradeRequest> upgrade)>;
+
+  // Used when keep_alive_timeout_ms or request_timeout_ms is 0.
+  // max_connections 0 means unlimited.
+  static constexpr uint32_t DEFAULT_KEEP_ALIVE_TIMEOUT_MS = 5000;
+  static constexpr uint32_t DEFAULT_REQUEST_TIMEOUT_MS = 30000;
+
+  Server(const std::string &address, unsigned short port, int threads = 1,
+         ListenMode mode = ListenMode::Shared);
+  explicit Server(const http1server::Config &config, int threads = 1,
+                  ListenMode mode = ListenMode::Shared);
   ~Server();
 
+  // Replaces dispatch through router(). The handler's response is sent when
+  // it returns; routes get owned request and response objects and may
+  // finish them later, from any thread.
   void handle(Handler handler);
+  // With h2c on in the config, connections that speak HTTP/2 go to
+  // `handler` instead of this server; without one they are served as
+  // HTTP/1.1 only. Set before run().
+  void handle_h2c(H2cHandler handler);
   void run();
   void stop();
 
@@ -31,16 +71,44 @@ public:
     return m_router;
   }
 
+  // Bound port; differs from the requested one when that was 0
+  [[nodiscard]] unsigned short port() const noexcept {
+    return m_port;
+  }
+
+  // One shard per io_context: 1 in Shared mode, `threads` in ReusePort mode.
+  // Open connections per shard are also exported as the
+  // `http1.server.connections` gauge with a `shard` attribute.
+  [[nodiscard]] size_t shard_count() const noexcept {
+    return m_shards.size();
+  }
+  [[nodiscard]] int64_t connection_count(size_t shard) const;
+
+  // Reactor the sockets run on: "io_uring" in ENABLE_IO_URING builds,
+  // "epoll" otherwise
+  [[nodiscard]] static constexpr const char *io_backend() noexcept {
+#if defined(BOOST_ASIO_HAS_IO_URING_AS_DEFAULT)
+    return "io_uring";
+#else
+    return "epoll";
+#endif
+  }
+
 private:
-  void do_accept();
-  void do_session(boost::asio::ip::tcp::socket socket);
+  friend class Session;
+  struct Shard;
+  struct SessionContext;
+
+  void do_accept(Shard &shard);
 
   std::string m_address;
   unsigned short m_port;
   int m_threads;
-  boost::asio::io_context m_ioc;
+  ListenMode m_mode;
   astra::router::Router m_router;
-  boost::asio::ip::tcp::acceptor m_acceptor;
+  // Outlives the shards, whose sessions release their slot into it
+  std::unique_ptr<SessionContext> m_context;
+  std::vector<std::unique_ptr<Shard>> m_shards;
   std::vector<std::thread> m_thread_pool;
   Handler m_handler;
   mutable std::mutex m_handler_mutex;
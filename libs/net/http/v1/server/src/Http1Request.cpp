@@ -1,52 +1,86 @@
 #include "Http1Request.h"
 
+#include <array>
+
 namespace astra::http1 {
 
+namespace {
+
+namespace http = boost::beast::http;
+
+constexpr size_t VERB_COUNT = static_cast<size_t>(http::verb::unlink) + 1;
+
+// Names of the standard verbs, built once so method() needs no per-request
+// copy
+const std::string &verb_name(http::verb verb) {
+  static const auto names = [] {
+    std::array<std::string, VERB_COUNT> table;
+    for (size_t i = 1; i < VERB_COUNT; ++i) {
+      auto name = http::to_string(static_cast<http::verb>(i));
+      table[i] = std::string(name.data(), name.size());
+    }
+    return table;
+  }();
+  return names[static_cast<size_t>(verb)];
+}
+
+std::string_view target_view(
+    const boost::beast::http::request<boost::beast::http::string_body> &req) {
+  auto target = req.target();
+  return std::string_view(target.data(), target.size());
+}
+
+} // namespace
+
 Request::Request(
     boost::beast::http::request<boost::beast::http::string_body> req)
     : req_(std::move(req)) {
+  if (req_.method() == http::verb::unknown) {
+    auto name = req_.method_string();
+    method_str_ = std::string(name.data(), name.size());
+  }
+  auto target = target_view(req_);
+  auto query = target.find('?');
+  path_str_ = std::string(target.substr(0, query));
+  if (query != std::string_view::npos) {
+    query_params_ = astra::router::QueryParams(
+        std::string(target.substr(query + 1)));
+  }
 }
 
 const std::string &Request::method() const {
-  method_str_ = std::string(boost::beast::http::to_string(req_.method()));
-  return method_str_;
+  if (req_.method() == http::verb::unknown) {
+    return method_str_;
+  }
+  return verb_name(req_.method());
 }
 
 const std::string &Request::path() const {
-  path_str_ = std::string(req_.target());
   return path_str_;
 }
 
-std::string Request::header(const std::string &name) const {
+const std::string &Request::body() const {
+  return req_.body();
+}
+
+std::string_view Request::header(std::string_view name) const {
   auto it = req_.find(boost::beast::string_view(name.data(), name.size()));
   if (it != req_.end()) {
-    return std::string(it->value().data(), it->value().size());
+    return std::string_view(it->value().data(), it->value().size());
   }
   return {};
 }
 
-const std::string &Request::body() const {
-  body_str_ = req_.body();
-  return body_str_;
-}
-
-std::string Request::path_param(const std::string &key) const {
-  auto it = path_params_.find(key);
-  if (it != path_params_.end()) {
-    return it->second;
-  }
-  return {};
+std::string_view Request::path_param(std::string_view key) const {
+  return path_params_.get(key, path_str_);
 }
 
-std::string Request::query_param(const std::string &key) const {
-  // TODO: Implement query param parsing
-  (void)key;
-  return {};
+std::string_view Request::query_param(std::string_view key) const {
+  return query_params_.get(key);
 }
 
-void Request::set_path_params(
-    std::unordered_map<std::string, std::string> params) {
-  path_params_ = std::move(params);
+void Request::set_path_params(astra::router::PathParams params) {
+  path_params_ = params;
 }
 
 } // namespace astra::http1
@@ -1,32 +1,116 @@
 #include "Http1Response.h"
 
+#include <cstdio>
+
 namespace astra::http1 {
 
-Response::Response(SendCallback callback) : callback_(std::move(callback)) {
+namespace {
+
+std::string chunk_frame(const std::string &content) {
+  char size[20];
+  int n = std::snprintf(size, sizeof(size), "%zx\r\n", content.size());
+  std::string frame;
+  frame.reserve(static_cast<size_t>(n) + content.size() + 2);
+  frame.append(size, static_cast<size_t>(n));
+  frame.append(content);
+  frame.append("\r\n");
+  return frame;
+}
+
+} // namespace
+
+Response::Response(Message &message, ReadyCallback on_ready,
+                   WriteRaw write_raw, PendingBytes pending)
+    : res_(message), on_ready_(std::move(on_ready)),
+      write_raw_(std::move(write_raw)), pending_(std::move(pending)) {
   res_.version(11); // HTTP/1.1
 }
 
+Response::~Response() {
+  // Dropped without a close: send what there is, so the connection's queue
+  // moves on
+  close();
+}
+
 void Response::set_status(int status_code) noexcept {
-  res_.result(static_cast<boost::beast::http::status>(status_code));
+  if (is_pending()) {
+    res_.result(static_cast<boost::beast::http::status>(status_code));
+  }
 }
 
 void Response::set_header(const std::string &name, const std::string &value) {
+  if (!is_pending()) {
+    return;
+  }
   res_.set(boost::beast::string_view(name.data(), name.size()),
            boost::beast::string_view(value.data(), value.size()));
 }
 
+void Response::set_keep_alive(unsigned version, bool keep_alive) {
+  if (!is_pending()) {
+    return;
+  }
+  res_.version(version);
+  res_.keep_alive(keep_alive);
+}
+
 void Response::write(const std::string &content) {
-  res_.body().append(content);
+  if (is_pending()) {
+    res_.body().append(content);
+    return;
+  }
+  if (streaming_ && !closed_ && !content.empty()) {
+    write_raw_(close_delimited_ ? content : chunk_frame(content), false);
+  }
+}
+
+void Response::send_headers() {
+  if (!is_pending() || !on_ready_ || !write_raw_) {
+    return;
+  }
+  streaming_ = true;
+
+  // Anything written so far becomes the first chunk
+  std::string buffered = std::move(res_.body());
+  res_.body().clear();
+  if (res_.version() < 11) {
+    close_delimited_ = true;
+    res_.keep_alive(false);
+  } else {
+    res_.chunked(true);
+  }
+  on_ready_(true);
+  if (!buffered.empty()) {
+    write_raw_(close_delimited_ ? std::move(buffered) : chunk_frame(buffered),
+               false);
+  }
 }
 
 void Response::close() {
+  if (streaming_) {
+    if (!closed_) {
+      closed_ = true;
+      write_raw_(close_delimited_ ? std::string() : "0\r\n\r\n", true);
+      run_close_hook(res_.result_int());
+    }
+    return;
+  }
   if (!closed_) {
+    closed_ = true;
     res_.prepare_payload();
-    if (callback_) {
-      callback_(std::move(res_));
+    int status = res_.result_int();
+    if (on_ready_) {
+      on_ready_(false);
     }
-    closed_ = true;
+    run_close_hook(status);
+  }
+}
+
+size_t Response::pending_bytes() const noexcept {
+  if (!streaming_) {
+    return res_.body().size();
   }
+  return pending_ ? pending_() : 0;
 }
 
 bool Response::is_alive() const noexcept {
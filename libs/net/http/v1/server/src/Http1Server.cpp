@@ -3,7 +3,16 @@
 #include "Http1Request.h"
 #include "Http1Response.h"
 
+#include <Metrics.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
 
 namespace astra::http1 {
 
@@ -12,32 +21,194 @@ namespace http = beast::http;
 namespace net = boost::asio;
 using tcp = net::ip::tcp;
 
-Server::Server(const std::string &address, unsigned short port, int threads)
-    : m_address(address), m_port(port), m_threads(threads), m_ioc(threads),
-      m_acceptor(m_ioc) {
-  const auto addr = net::ip::make_address(address);
-  const auto endpoint = tcp::endpoint{addr, port};
-
-  m_acceptor.open(endpoint.protocol());
-  m_acceptor.set_option(net::socket_base::reuse_address(true));
-  m_acceptor.bind(endpoint);
-  m_acceptor.listen(net::socket_base::max_listen_connections);
-
-  // Default handler: Dispatch to Router using shared_ptr wrappers
-  m_handler = [this](astra::router::IRequest &req,
-                     astra::router::IResponse &res) {
-    // Use aliasing constructor to create shared_ptr that doesn't own the object
-    // This is safe because the request/response outlive the dispatch call
-    auto req_ptr =
-        std::shared_ptr<astra::router::IRequest>(std::shared_ptr<void>{}, &req);
-    auto res_ptr = std::shared_ptr<astra::router::IResponse>(
-        std::shared_ptr<void>{}, &res);
-    m_router.dispatch(req_ptr, res_ptr);
-  };
+namespace {
+
+#ifdef SO_REUSEPORT
+using reuse_port =
+    net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+void open_acceptor(tcp::acceptor &acceptor, const tcp::endpoint &endpoint,
+                   ListenMode mode) {
+  acceptor.open(endpoint.protocol());
+  acceptor.set_option(net::socket_base::reuse_address(true));
+  if (mode == ListenMode::ReusePort) {
+#ifdef SO_REUSEPORT
+    acceptor.set_option(reuse_port(true));
+#else
+    throw std::invalid_argument("SO_REUSEPORT is not supported");
+#endif
+  }
+  acceptor.bind(endpoint);
+  acceptor.listen(net::socket_base::max_listen_connections);
+}
+
+// Open connections of one shard, mirrored into a gauge
+class ConnectionCounter {
+public:
+  explicit ConnectionCounter(size_t shard)
+      : m_shard(std::to_string(shard)),
+        m_gauge(obs::register_gauge("http1.server.connections")) {
+  }
+
+  void add(int64_t delta) {
+    m_count.fetch_add(delta, std::memory_order_relaxed);
+    m_gauge.add(delta, {{"shard", m_shard}});
+  }
+
+  [[nodiscard]] int64_t value() const noexcept {
+    return m_count.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::string m_shard;
+  obs::Gauge m_gauge;
+  std::atomic<int64_t> m_count{0};
+};
+
+// Server-wide cap on open connections. Every pending accept holds a slot
+// as well as every session, so the cap is never exceeded. An acceptor that
+// finds no free slot parks itself and the next release wakes it up.
+class ConnectionLimit {
+public:
+  explicit ConnectionLimit(size_t max) : m_max(max) {
+  }
+
+  // Takes a slot, or parks `resume` and returns false
+  bool acquire(std::function<void()> resume) {
+    if (m_max == 0) {
+      return true;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_used < m_max) {
+      ++m_used;
+      return true;
+    }
+    m_parked.push_back(std::move(resume));
+    return false;
+  }
+
+  void release() {
+    if (m_max == 0) {
+      return;
+    }
+    std::function<void()> resume;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      --m_used;
+      if (m_parked.empty()) {
+        return;
+      }
+      resume = std::move(m_parked.back());
+      m_parked.pop_back();
+    }
+    resume();
+  }
+
+  // Forgets parked acceptors; their io_contexts are going away
+  void close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_parked.clear();
+  }
+
+private:
+  size_t m_max;
+  size_t m_used{0};
+  std::vector<std::function<void()>> m_parked;
+  std::mutex m_mutex;
+};
+
+uint32_t or_default(uint32_t value, uint32_t fallback) {
+  return value > 0 ? value : fallback;
+}
+
+http1server::Config make_config(const std::string &address,
+                                unsigned short port) {
+  http1server::Config config;
+  config.set_address(address);
+  config.set_port(port);
+  return config;
+}
+
+} // namespace
+
+// Sessions die with the io_context, so the counter they update is declared
+// first and destroyed last
+struct Server::Shard {
+  Shard(size_t index, int concurrency)
+      : connections(index), ioc(concurrency), acceptor(ioc) {
+  }
+
+  ConnectionCounter connections;
+  net::io_context ioc;
+  tcp::acceptor acceptor;
+};
+
+// Settings and state shared by every session of a server
+struct Server::SessionContext {
+  explicit SessionContext(const http1server::Config &config)
+      : keep_alive_timeout(or_default(config.keep_alive_timeout_ms(),
+                                      DEFAULT_KEEP_ALIVE_TIMEOUT_MS)),
+        request_timeout(or_default(config.request_timeout_ms(),
+                                   DEFAULT_REQUEST_TIMEOUT_MS)),
+        limit(config.max_connections()),
+        idle_timeouts(obs::register_counter("http1.server.timeouts.idle")),
+        header_timeouts(
+            obs::register_counter("http1.server.timeouts.header")),
+        body_timeouts(obs::register_counter("http1.server.timeouts.body")),
+        write_timeouts(obs::register_counter("http1.server.timeouts.write")),
+        h2c(config.h2c()) {
+  }
+
+  // Bounds the wait for the next request on an open connection, including
+  // reading its header
+  std::chrono::milliseconds keep_alive_timeout;
+  // Bounds reading the header of a connection's first request, reading
+  // each body and writing each response
+  std::chrono::milliseconds request_timeout;
+  ConnectionLimit limit;
+  obs::Counter idle_timeouts;
+  obs::Counter header_timeouts;
+  obs::Counter body_timeouts;
+  obs::Counter write_timeouts;
+  bool h2c;
+  // Set before run()
+  Server::H2cHandler h2c_handler;
+};
+
+Server::Server(const std::string &address, unsigned short port, int threads,
+               ListenMode mode)
+    : Server(make_config(address, port), threads, mode) {
+}
+
+Server::Server(const http1server::Config &config, int threads,
+               ListenMode mode)
+    : m_address(config.address()),
+      m_port(static_cast<unsigned short>(config.port())),
+      m_threads(std::max(threads, 1)), m_mode(mode),
+      m_context(std::make_unique<SessionContext>(config)) {
+  if (config.port() > 65535) {
+    throw std::invalid_argument("port out of range: " +
+                                std::to_string(config.port()));
+  }
+  auto endpoint = tcp::endpoint{net::ip::make_address(m_address), m_port};
+
+  bool sharded = mode == ListenMode::ReusePort;
+  size_t shards = sharded ? static_cast<size_t>(m_threads) : 1;
+  for (size_t i = 0; i < shards; ++i) {
+    auto shard = std::make_unique<Shard>(i, sharded ? 1 : m_threads);
+    open_acceptor(shard->acceptor, endpoint, mode);
+    // With port 0 the later listeners must join the port the first one got
+    endpoint.port(shard->acceptor.local_endpoint().port());
+    m_shards.push_back(std::move(shard));
+  }
+  m_port = endpoint.port();
+
 }
 
 Server::~Server() {
   stop();
+  m_context->limit.close();
 }
 
 void Server::handle(Handler handler) {
@@ -45,19 +216,33 @@ void Server::handle(Handler handler) {
   m_handler = std::move(handler);
 }
 
+void Server::handle_h2c(H2cHandler handler) {
+  m_context->h2c_handler = std::move(handler);
+}
+
+int64_t Server::connection_count(size_t shard) const {
+  return m_shards.at(shard)->connections.value();
+}
+
 void Server::run() {
-  do_accept();
+  for (auto &shard : m_shards) {
+    do_accept(*shard);
+  }
 
-  for (int i = 0; i < m_threads - 1; ++i) {
-    m_thread_pool.emplace_back([this] {
-      m_ioc.run();
+  // ReusePort: thread i runs shard i. Shared: every thread runs shard 0.
+  for (int i = 1; i < m_threads; ++i) {
+    auto &shard = *m_shards[static_cast<size_t>(i) % m_shards.size()];
+    m_thread_pool.emplace_back([&shard] {
+      shard.ioc.run();
     });
   }
-  m_ioc.run();
+  m_shards.front()->ioc.run();
 }
 
 void Server::stop() {
-  m_ioc.stop();
+  for (auto &shard : m_shards) {
+    shard->ioc.stop();
+  }
   for (auto &t : m_thread_pool) {
     if (t.joinable()) {
       t.join();
@@ -66,118 +251,411 @@ void Server::stop() {
   m_thread_pool.clear();
 }
 
+// One connection. Requests are read back to back so pipelined ones are
+// parsed straight out of the shared buffer; their responses are queued and
+// written in request order. The next request is read once the current
+// response is finished, which a handler may do after it returns, so queue
+// order is request order.
+//
+// Reads and writes run concurrently and tcp_stream keeps a separate
+// deadline for each; an expired deadline closes the socket.
 class Session : public std::enable_shared_from_this<Session> {
-  tcp::socket socket_;
-  beast::flat_buffer buffer_;
-  http::request<http::string_body> req_;
-  Server::Handler
-      m_handler; // Copy of handler (std::function is cheap to copy usually, or
-                 // use reference if lifetime guaranteed)
-  // Actually Server lifetime outlives Session? Not necessarily if Server is
-  // destroyed. But Handler is a function object.
-
 public:
-  Session(tcp::socket socket, Server::Handler handler)
-      : socket_(std::move(socket)), m_handler(std::move(handler)) {
+  Session(tcp::socket socket, Server::Handler handler,
+          astra::router::Router &router, ConnectionCounter &connections,
+          Server::SessionContext &context)
+      : stream_(std::move(socket)), m_handler(std::move(handler)),
+        router_(router), connections_(connections), context_(context) {
+    connections_.add(1);
+  }
+
+  ~Session() {
+    connections_.add(-1);
+    context_.limit.release();
   }
 
   void run() {
+    if (h2c()) {
+      return sniff();
+    }
     do_read();
   }
 
 private:
+  // Reading stops while this many writes are queued, so a client that
+  // pipelines without reading responses cannot grow the queue unbounded
+  static constexpr size_t MAX_QUEUED_WRITES = 64;
+  // Client connection preface; a connection starting with it speaks HTTP/2
+  // with prior knowledge
+  static constexpr std::string_view H2_PREFACE =
+      "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+  static constexpr std::string_view SWITCHING_PROTOCOLS =
+      "HTTP/1.1 101 Switching Protocols\r\n"
+      "Connection: Upgrade\r\nUpgrade: h2c\r\n\r\n";
+  static constexpr size_t SNIFF_READ_BYTES = 1024;
+
+  // A response message, built in place by the handler and written straight
+  // from here. Shared with the response's callbacks, so a response finished
+  // after a failed write still has somewhere to go.
+  struct Built {
+    Response::Message message;
+    // Writes just the header of a streamed message
+    std::optional<http::response_serializer<http::string_body>> header;
+    bool ready = false;
+  };
+
+  // A queued write: a response message or raw bytes of a streamed one
+  struct Outgoing {
+    std::shared_ptr<Built> built;
+    std::string raw;
+  };
+
   void do_read() {
+    if (reading_ || closing_ || responding_ ||
+        write_queue_.size() >= MAX_QUEUED_WRITES) {
+      return;
+    }
+    reading_ = true;
+    parser_.emplace();
+
+    // Between requests the keep-alive timeout covers the idle wait and the
+    // next header together
+    bool idle = served_ > 0 && buffer_.size() == 0;
+    stream_.expires_after(idle ? context_.keep_alive_timeout
+                               : context_.request_timeout);
+
     auto self = shared_from_this();
-    http::async_read(
-        socket_, buffer_, req_,
-        [self](beast::error_code ec, std::size_t bytes_transferred) {
-          boost::ignore_unused(bytes_transferred);
-          if (ec == http::error::end_of_stream) {
-            return self->do_close();
-          }
+    http::async_read_header(
+        stream_, buffer_, *parser_,
+        [self, idle](beast::error_code ec, std::size_t) {
           if (ec) {
-            return; // Log error?
+            // Nothing arrived at all: the connection just sat idle
+            bool silent = idle && !self->parser_->got_some() &&
+                          self->buffer_.size() == 0;
+            const obs::Counter &timeouts =
+                silent ? self->context_.idle_timeouts
+                       : self->context_.header_timeouts;
+            return self->on_read_error(ec, timeouts);
+          }
+          if (self->parser_->is_done()) {
+            return self->on_request();
           }
 
-          self->process_request();
+          self->stream_.expires_after(self->context_.request_timeout);
+          http::async_read(self->stream_, self->buffer_, *self->parser_,
+                           [self](beast::error_code ec, std::size_t) {
+                             if (ec) {
+                               return self->on_read_error(
+                                   ec, self->context_.body_timeouts);
+                             }
+                             self->on_request();
+                           });
         });
   }
 
-  void process_request() {
-    auto self = shared_from_this();
+  void on_read_error(beast::error_code ec, const obs::Counter &timeouts) {
+    reading_ = false;
+    if (ec == beast::error::timeout) {
+      timeouts.inc();
+    }
+    // EOF, a parse error, a timeout or a failed write closing the socket:
+    // finish queued writes, then close
+    closing_ = true;
+    if (!writing_) {
+      do_close();
+    }
+  }
+
+  void on_request() {
+    reading_ = false;
+    ++served_;
+    auto req = parser_->release();
+    if (h2c() && write_queue_.empty() && wants_h2c(req)) {
+      return start_h2(std::move(req));
+    }
+    process_request(std::move(req));
+    do_read();
+  }
+
+  void process_request(http::request<http::string_body> req) {
+    bool keep_alive = req.keep_alive();
+    unsigned version = req.version();
+    auto request = std::make_shared<Request>(std::move(req));
 
-    // Create abstractions
-    // We need to keep request alive until response is sent?
-    // The Request object copies data or views?
-    // Http1Request uses boost::beast::http::request which owns data.
-    // We move req_ into Request?
-    // If we move req_, we can't use it for next loop if we wanted to reuse.
-    // But for now let's assume one request per read or reset.
-
-    // Construct Request wrapper
-    // We need to be careful about moving req_ if we want to support
-    // pipelining/keep-alive later. But Http1Request takes by value/move
-    // usually.
-
-    // Let's look at Http1Request constructor: explicit
-    // Request(boost::beast::http::request<...> req); It takes by value (copy or
-    // move).
-
-    Request request(std::move(req_));
-
-    auto send_lambda = [self](http::response<http::string_body> msg) {
-      // The response object 'msg' needs to be kept alive during async_write
-      // We need a shared_ptr to the message or capture it by value in the
-      // lambda. http::async_write takes the message by const reference. So the
-      // message must exist until completion.
-
-      auto sp =
-          std::make_shared<http::response<http::string_body>>(std::move(msg));
-
-      http::async_write(self->socket_, *sp,
-                        [self, sp](beast::error_code ec, std::size_t bytes) {
-                          self->socket_.shutdown(tcp::socket::shutdown_send,
-                                                 ec);
-                          // In a real server we would check keep-alive and loop
-                          // back to do_read()
-                        });
+    // Queued before the handler runs, so the response keeps its place
+    // behind earlier pipelined ones however it is produced
+    auto slot = std::make_shared<Built>();
+    write_queue_.push_back(Outgoing{slot, {}});
+    responding_ = true;
+
+    // The response may be finished from any thread; the connection's state
+    // is only touched on its executor
+    auto self = shared_from_this();
+    auto on_ready = [self, slot](bool header_only) {
+      net::dispatch(self->stream_.get_executor(), [self, slot, header_only] {
+        if (!slot->message.keep_alive()) {
+          self->closing_ = true;
+        }
+        if (header_only) {
+          slot->header.emplace(slot->message);
+        }
+        slot->ready = true;
+        if (!header_only) {
+          self->finish_response();
+        }
+        self->kick_write();
+      });
+    };
+    auto write_raw = [self](std::string bytes, bool last) {
+      self->raw_pending_.fetch_add(bytes.size(), std::memory_order_relaxed);
+      net::dispatch(self->stream_.get_executor(),
+                    [self, bytes = std::move(bytes), last]() mutable {
+                      if (!bytes.empty()) {
+                        self->write_queue_.push_back(
+                            Outgoing{nullptr, std::move(bytes)});
+                      }
+                      if (last) {
+                        self->finish_response();
+                      }
+                      self->kick_write();
+                    });
+    };
+    auto pending = [self] {
+      return self->raw_pending_.load(std::memory_order_relaxed);
     };
 
-    Response response(send_lambda);
+    auto response =
+        std::make_shared<Response>(slot->message, on_ready, write_raw, pending);
+    response->set_keep_alive(version, keep_alive);
 
     if (m_handler) {
-      m_handler(request, response);
+      m_handler(*request, *response);
+    } else {
+      router_.dispatch(request, response);
+    }
+    // A handler that kept no reference has finished: dropping the response
+    // sends it
+
+    if (!keep_alive) {
+      closing_ = true;
+    }
+  }
+
+  // The current response is complete; the next request may be read
+  void finish_response() {
+    responding_ = false;
+    do_read();
+  }
+
+  void kick_write() {
+    if (!writing_) {
+      do_write();
+    }
+  }
+
+  void do_write() {
+    if (write_queue_.empty()) {
+      writing_ = false;
+      // A response still streaming has more to come
+      if (responding_) {
+        return;
+      }
+      if (closing_ && !reading_) {
+        do_close();
+        return;
+      }
+      do_read();
+      return;
+    }
+
+    Outgoing &out = write_queue_.front();
+    if (out.built && !out.built->ready) {
+      // Still being built; its on_ready restarts the writes
+      writing_ = false;
+      return;
+    }
+
+    writing_ = true;
+    stream_.expires_after(context_.request_timeout);
+    auto self = shared_from_this();
+    auto on_write = [self](beast::error_code ec, std::size_t) {
+      self->raw_pending_.fetch_sub(self->write_queue_.front().raw.size(),
+                                   std::memory_order_relaxed);
+      self->write_queue_.pop_front();
+      if (ec) {
+        if (ec == beast::error::timeout) {
+          self->context_.write_timeouts.inc();
+        }
+        for (const Outgoing &out : self->write_queue_) {
+          self->raw_pending_.fetch_sub(out.raw.size(),
+                                       std::memory_order_relaxed);
+        }
+        self->write_queue_.clear();
+        self->writing_ = false;
+        self->closing_ = true;
+        self->stream_.close();
+        return;
+      }
+      self->do_write();
+    };
+
+    if (out.built && out.built->header) {
+      http::async_write_header(stream_, *out.built->header,
+                               std::move(on_write));
+    } else if (out.built) {
+      http::async_write(stream_, out.built->message, std::move(on_write));
     } else {
-      response.set_status(404);
-      response.write("No handler configured");
-      response.close();
+      net::async_write(stream_, net::buffer(out.raw), std::move(on_write));
+    }
+  }
+
+  bool h2c() const {
+    return context_.h2c && context_.h2c_handler;
+  }
+
+  // With h2c on, the first bytes pick the protocol: the HTTP/2 preface, or
+  // anything else for HTTP/1.1. Bytes read here stay in the buffer for
+  // whichever side takes over.
+  void sniff() {
+    std::string_view seen(static_cast<const char *>(buffer_.data().data()),
+                          buffer_.size());
+    size_t n = std::min(seen.size(), H2_PREFACE.size());
+    if (seen.substr(0, n) != H2_PREFACE.substr(0, n)) {
+      return do_read();
+    }
+    if (n == H2_PREFACE.size()) {
+      return hand_off(std::nullopt);
+    }
+
+    reading_ = true;
+    stream_.expires_after(context_.request_timeout);
+    auto self = shared_from_this();
+    stream_.async_read_some(
+        buffer_.prepare(SNIFF_READ_BYTES),
+        [self](beast::error_code ec, std::size_t n) {
+          if (ec) {
+            return self->on_read_error(ec, self->context_.header_timeouts);
+          }
+          self->reading_ = false;
+          self->buffer_.commit(n);
+          self->sniff();
+        });
+  }
+
+  static bool wants_h2c(const http::request<http::string_body> &req) {
+    if (req.find("HTTP2-Settings") == req.end()) {
+      return false;
+    }
+    for (auto token : http::token_list(req[http::field::upgrade])) {
+      if (beast::iequals(token, "h2c")) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Answers `upgrade` with a 101, then hands the connection over; the
+  // request itself is answered over HTTP/2
+  void start_h2(http::request<http::string_body> upgrade) {
+    writing_ = true;
+    stream_.expires_after(context_.request_timeout);
+    auto self = shared_from_this();
+    net::async_write(
+        stream_,
+        net::buffer(SWITCHING_PROTOCOLS.data(), SWITCHING_PROTOCOLS.size()),
+        [self, upgrade = std::move(upgrade)](beast::error_code ec,
+                                             std::size_t) mutable {
+          self->writing_ = false;
+          if (ec) {
+            if (ec == beast::error::timeout) {
+              self->context_.write_timeouts.inc();
+            }
+            self->closing_ = true;
+            self->stream_.close();
+            return;
+          }
+          self->hand_off(std::move(upgrade));
+        });
+  }
+
+  // The socket and whatever is buffered go to the h2c handler; this
+  // session ends, and with it its place in the connection count and limit
+  void hand_off(std::optional<http::request<http::string_body>> upgrade) {
+    std::string preread(static_cast<const char *>(buffer_.data().data()),
+                        buffer_.size());
+    buffer_.consume(buffer_.size());
+    stream_.expires_never();
+    beast::error_code ec;
+    int socket = stream_.release_socket().release(ec);
+    if (ec) {
+      return;
     }
+    context_.h2c_handler(socket, std::move(preread), std::move(upgrade));
   }
 
   void do_close() {
     beast::error_code ec;
-    socket_.shutdown(tcp::socket::shutdown_send, ec);
+    stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
   }
+
+  beast::tcp_stream stream_;
+  beast::flat_buffer buffer_;
+  std::optional<http::request_parser<http::string_body>> parser_;
+  Server::Handler m_handler;
+  astra::router::Router &router_;
+  ConnectionCounter &connections_;
+  Server::SessionContext &context_;
+  std::deque<Outgoing> write_queue_;
+  // Raw bytes of streamed responses queued but not yet written
+  std::atomic<size_t> raw_pending_{0};
+  uint64_t served_ = 0;
+  bool reading_ = false;
+  // A response is being produced; no further request is read until it is
+  // finished, so its streamed bytes stay ahead of the next response
+  bool responding_ = false;
+  bool writing_ = false;
+  bool closing_ = false;
 };
 
-void Server::do_accept() {
-  m_acceptor.async_accept(net::make_strand(m_ioc), [this](beast::error_code ec,
-                                                          tcp::socket socket) {
-    if (!ec) {
+void Server::do_accept(Shard &shard) {
+  // At max_connections the acceptor stops and new connections wait in the
+  // kernel backlog until a session ends
+  bool admitted = m_context->limit.acquire([this, &shard] {
+    net::post(shard.acceptor.get_executor(), [this, &shard] {
+      do_accept(shard);
+    });
+  });
+  if (!admitted) {
+    return;
+  }
+
+  // A shared io_context runs on many threads, so each connection gets a
+  // strand; a ReusePort shard is single-threaded already
+  net::any_io_executor executor = shard.ioc.get_executor();
+  if (m_mode == ListenMode::Shared) {
+    executor = net::make_strand(shard.ioc);
+  }
+
+  shard.acceptor.async_accept(executor, [this, &shard](beast::error_code ec,
+                                                       tcp::socket socket) {
+    if (ec) {
+      m_context->limit.release();
+    } else {
+      // Responses to pipelined requests go out as separate writes; with
+      // Nagle each would wait for the peer's delayed ACK of the one before
+      beast::error_code ignored;
+      socket.set_option(tcp::no_delay(true), ignored);
       Handler handler_copy;
       {
         std::lock_guard<std::mutex> lock(m_handler_mutex);
         handler_copy = m_handler;
       }
-      std::make_shared<Session>(std::move(socket), std::move(handler_copy))
+      std::make_shared<Session>(std::move(socket), std::move(handler_copy),
+                                m_router, shard.connections, *m_context)
           ->run();
     }
-    do_accept();
+    do_accept(shard);
   });
 }
 
-void Server::do_session(tcp::socket socket) {
-  // Deprecated/Unused
-}
-
 } // namespace astra::http1
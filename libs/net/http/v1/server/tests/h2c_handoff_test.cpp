@@ -0,0 +1,242 @@
+#include "Http1Server.h"
+#include "Http2Server.h"
+
+#include <array>
+#include <boost/asio.hpp>
+#include <cstring>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <map>
+#include <nghttp2/nghttp2.h>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+
+using namespace testing;
+
+// Blocking HTTP/2 client for one request at a time over an open socket
+class H2TestClient {
+public:
+  struct Result {
+    int status = 0;
+    std::string body;
+  };
+
+  explicit H2TestClient(boost::asio::ip::tcp::socket &socket)
+      : m_socket(socket) {
+    nghttp2_session_callbacks *callbacks;
+    nghttp2_session_callbacks_new(&callbacks);
+    nghttp2_session_callbacks_set_on_header_callback(callbacks, &on_header);
+    nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks,
+                                                              &on_data);
+    nghttp2_session_callbacks_set_on_stream_close_callback(callbacks,
+                                                           &on_close);
+    nghttp2_session_client_new(&m_session, callbacks, this);
+    nghttp2_session_callbacks_del(callbacks);
+    nghttp2_submit_settings(m_session, NGHTTP2_FLAG_NONE, nullptr, 0);
+  }
+
+  ~H2TestClient() {
+    nghttp2_session_del(m_session);
+  }
+
+  // Takes over after a 101: stream 1 carries the upgraded request and
+  // `pending` holds frames read along with the 101
+  Result upgraded(const uint8_t *settings, size_t size,
+                  const std::string &pending) {
+    nghttp2_session_upgrade2(m_session, settings, size, 0, nullptr);
+    nghttp2_session_mem_recv(m_session,
+                             reinterpret_cast<const uint8_t *>(pending.data()),
+                             pending.size());
+    return wait_for(1);
+  }
+
+  Result get(const std::string &path) {
+    std::string method = "GET", scheme = "http", authority = "localhost";
+    nghttp2_nv nva[] = {nv(":method", method), nv(":scheme", scheme),
+                        nv(":authority", authority), nv(":path", path)};
+    int32_t id = nghttp2_submit_request(m_session, nullptr, nva,
+                                        std::size(nva), nullptr, nullptr);
+    return wait_for(id);
+  }
+
+private:
+  static nghttp2_nv nv(const char *name, const std::string &value) {
+    return {reinterpret_cast<uint8_t *>(const_cast<char *>(name)),
+            reinterpret_cast<uint8_t *>(const_cast<char *>(value.data())),
+            std::strlen(name), value.size(), NGHTTP2_NV_FLAG_NONE};
+  }
+
+  Result wait_for(int32_t id) {
+    while (m_closed.count(id) == 0) {
+      const uint8_t *data;
+      ssize_t n;
+      while ((n = nghttp2_session_mem_send(m_session, &data)) > 0) {
+        boost::asio::write(m_socket,
+                           boost::asio::buffer(data, static_cast<size_t>(n)));
+      }
+      std::array<uint8_t, 4096> buf;
+      boost::system::error_code ec;
+      size_t got = m_socket.read_some(boost::asio::buffer(buf), ec);
+      if (ec) {
+        break;
+      }
+      nghttp2_session_mem_recv(m_session, buf.data(), got);
+    }
+    return m_results[id];
+  }
+
+  static int on_header(nghttp2_session *, const nghttp2_frame *frame,
+                       const uint8_t *name, size_t namelen,
+                       const uint8_t *value, size_t valuelen, uint8_t,
+                       void *user_data) {
+    auto *self = static_cast<H2TestClient *>(user_data);
+    if (std::string_view(reinterpret_cast<const char *>(name), namelen) ==
+        ":status") {
+      self->m_results[frame->hd.stream_id].status = std::stoi(
+          std::string(reinterpret_cast<const char *>(value), valuelen));
+    }
+    return 0;
+  }
+
+  static int on_data(nghttp2_session *, uint8_t, int32_t stream_id,
+                     const uint8_t *data, size_t len, void *user_data) {
+    auto *self = static_cast<H2TestClient *>(user_data);
+    self->m_results[stream_id].body.append(
+        reinterpret_cast<const char *>(data), len);
+    return 0;
+  }
+
+  static int on_close(nghttp2_session *, int32_t stream_id, uint32_t,
+                      void *user_data) {
+    static_cast<H2TestClient *>(user_data)->m_closed.insert(stream_id);
+    return 0;
+  }
+
+  boost::asio::ip::tcp::socket &m_socket;
+  nghttp2_session *m_session{nullptr};
+  std::map<int32_t, Result> m_results;
+  std::set<int32_t> m_closed;
+};
+
+// The HTTP/2 side of an h2c handoff, as the HTTP/2 server takes it
+std::optional<astra::http2::H2cUpgrade>
+to_h2c_upgrade(std::optional<astra::http1::Server::UpgradeRequest> req) {
+  if (!req) {
+    return std::nullopt;
+  }
+  astra::http2::H2cUpgrade upgrade;
+  upgrade.settings = std::string((*req)["HTTP2-Settings"]);
+  upgrade.method = std::string(req->method_string());
+  upgrade.target = std::string(req->target());
+  for (const auto &field : *req) {
+    upgrade.headers.emplace_back(std::string(field.name_string()),
+                                 std::string(field.value()));
+  }
+  upgrade.body = std::move(req->body());
+  return upgrade;
+}
+
+class Http1ServerH2cTest : public Test {
+protected:
+  void SetUp() override {
+    http1server::Config config;
+    config.set_address("127.0.0.1");
+    config.set_h2c(true);
+    m_server = std::make_unique<astra::http1::Server>(config, 2);
+    auto echo = [](std::shared_ptr<astra::router::IRequest> req,
+                   std::shared_ptr<astra::router::IResponse> res) {
+      res->set_status(200);
+      res->write(req->method() + " " + req->path());
+      res->close();
+    };
+    for (const char *path : {"/h2/:n", "/upgraded", "/next", "/plain"}) {
+      m_server->router().add(astra::router::HttpMethod::GET, path, echo);
+    }
+
+    // No uri: the HTTP/2 server only serves what the listener hands over
+    m_h2 = std::make_unique<astra::http2::Http2Server>(
+        ::http2::ServerConfig{}, m_server->router());
+    ASSERT_TRUE(m_h2->start().is_ok());
+    m_server->handle_h2c(
+        [this](int socket, std::string preread,
+               std::optional<astra::http1::Server::UpgradeRequest> upgrade) {
+          (void)m_h2->adopt(socket, std::move(preread),
+                            to_h2c_upgrade(std::move(upgrade)));
+        });
+
+    m_thread = std::thread([this] {
+      m_server->run();
+    });
+    m_socket.connect(boost::asio::ip::tcp::endpoint(
+        boost::asio::ip::make_address("127.0.0.1"), m_server->port()));
+  }
+
+  void TearDown() override {
+    m_socket.close();
+    m_server->stop();
+    m_thread.join();
+    (void)m_h2->stop();
+    (void)m_h2->join();
+  }
+
+  boost::asio::io_context m_ioc;
+  boost::asio::ip::tcp::socket m_socket{m_ioc};
+  std::unique_ptr<astra::http1::Server> m_server;
+  std::unique_ptr<astra::http2::Http2Server> m_h2;
+  std::thread m_thread;
+};
+
+TEST_F(Http1ServerH2cTest, PriorKnowledgeStreamsShareOneConnection) {
+  H2TestClient client(m_socket);
+
+  for (int i = 0; i < 3; ++i) {
+    auto path = "/h2/" + std::to_string(i);
+    auto res = client.get(path);
+    EXPECT_EQ(res.status, 200);
+    EXPECT_EQ(res.body, "GET " + path);
+  }
+  // Served by the HTTP/2 server, which now owns the connection
+  EXPECT_EQ(m_h2->connection_count(0), 1);
+  EXPECT_EQ(m_server->connection_count(0), 0);
+}
+
+TEST_F(Http1ServerH2cTest, UpgradeAnswersFirstRequestOverHttp2) {
+  // SETTINGS_MAX_CONCURRENT_STREAMS = 100, base64url encoded
+  const uint8_t settings[] = {0x00, 0x03, 0x00, 0x00, 0x00, 0x64};
+  std::string req = "GET /upgraded HTTP/1.1\r\nHost: 127.0.0.1\r\n"
+                    "Connection: Upgrade, HTTP2-Settings\r\n"
+                    "Upgrade: h2c\r\nHTTP2-Settings: AAMAAABk\r\n\r\n";
+  boost::asio::write(m_socket, boost::asio::buffer(req));
+
+  boost::asio::streambuf head;
+  size_t n = boost::asio::read_until(m_socket, head, "\r\n\r\n");
+  std::string status(boost::asio::buffers_begin(head.data()),
+                     boost::asio::buffers_begin(head.data()) + n);
+  EXPECT_THAT(status, StartsWith("HTTP/1.1 101 Switching Protocols\r\n"));
+  head.consume(n);
+  // Frames the server sent right behind the 101
+  std::string pending(boost::asio::buffers_begin(head.data()),
+                      boost::asio::buffers_end(head.data()));
+
+  H2TestClient client(m_socket);
+  auto res = client.upgraded(settings, sizeof(settings), pending);
+  EXPECT_EQ(res.status, 200);
+  EXPECT_EQ(res.body, "GET /upgraded");
+
+  res = client.get("/next");
+  EXPECT_EQ(res.body, "GET /next");
+}
+
+TEST_F(Http1ServerH2cTest, PlainHttp1StillServed) {
+  std::string req = "GET /plain HTTP/1.1\r\nHost: 127.0.0.1\r\n"
+                    "Connection: close\r\n\r\n";
+  boost::asio::write(m_socket, boost::asio::buffer(req));
+
+  std::string response;
+  boost::system::error_code ec;
+  boost::asio::read(m_socket, boost::asio::dynamic_buffer(response), ec);
+  EXPECT_THAT(response, StartsWith("HTTP/1.1 200 OK\r\n"));
+  EXPECT_THAT(response, EndsWith("GET /plain"));
+}
@@ -0,0 +1,131 @@
+#include "Http1Server.h"
+
+#include <benchmark/benchmark.h>
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// Loopback throughput of the HTTP/1.1 server. Run the same binary from the
+// clang-bench and clang-bench-io-uring presets to compare the epoll and
+// io_uring backends; each result is labelled with the backend it ran on.
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+
+namespace {
+
+class BenchServer {
+public:
+  BenchServer() {
+    http1server::Config config;
+    config.set_address("127.0.0.1");
+    m_server = std::make_unique<astra::http1::Server>(config, 2);
+    m_server->handle(
+        [](astra::router::IRequest &, astra::router::IResponse &res) {
+          res.set_status(200);
+          res.write("OK");
+          res.close();
+        });
+    m_thread = std::thread([this] {
+      m_server->run();
+    });
+  }
+
+  ~BenchServer() {
+    m_server->stop();
+    m_thread.join();
+  }
+
+  [[nodiscard]] tcp::endpoint endpoint() const {
+    return {net::ip::make_address("127.0.0.1"), m_server->port()};
+  }
+
+private:
+  std::unique_ptr<astra::http1::Server> m_server;
+  std::thread m_thread;
+};
+
+http::request<http::empty_body> make_request(bool keep_alive) {
+  http::request<http::empty_body> req(http::verb::get, "/bench", 11);
+  req.set(http::field::host, "127.0.0.1");
+  req.keep_alive(keep_alive);
+  return req;
+}
+
+} // namespace
+
+// New connection per request: accept, one exchange, close
+static void BM_ConnectionsPerSecond(benchmark::State &state) {
+  BenchServer server;
+  net::io_context ioc;
+  auto req = make_request(false);
+
+  for (auto _ : state) {
+    tcp::socket socket(ioc);
+    socket.connect(server.endpoint());
+    http::write(socket, req);
+    beast::flat_buffer buffer;
+    http::response<http::string_body> res;
+    http::read(socket, buffer, res);
+    benchmark::DoNotOptimize(res);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(astra::http1::Server::io_backend());
+}
+BENCHMARK(BM_ConnectionsPerSecond)->UseRealTime();
+
+// Sequential requests over one keep-alive connection
+static void BM_RequestsPerSecond(benchmark::State &state) {
+  BenchServer server;
+  net::io_context ioc;
+  tcp::socket socket(ioc);
+  socket.connect(server.endpoint());
+  auto req = make_request(true);
+  beast::flat_buffer buffer;
+
+  for (auto _ : state) {
+    http::write(socket, req);
+    http::response<http::string_body> res;
+    http::read(socket, buffer, res);
+    benchmark::DoNotOptimize(res);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(astra::http1::Server::io_backend());
+}
+BENCHMARK(BM_RequestsPerSecond)->UseRealTime();
+
+// Batches of state.range(0) pipelined requests sent in one write
+static void BM_PipelinedRequestsPerSecond(benchmark::State &state) {
+  BenchServer server;
+  net::io_context ioc;
+  tcp::socket socket(ioc);
+  socket.connect(server.endpoint());
+
+  std::string batch;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    std::ostringstream out;
+    out << make_request(true);
+    batch += out.str();
+  }
+  beast::flat_buffer buffer;
+
+  for (auto _ : state) {
+    net::write(socket, net::buffer(batch));
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      http::response<http::string_body> res;
+      http::read(socket, buffer, res);
+      benchmark::DoNotOptimize(res);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetLabel(astra::http1::Server::io_backend());
+}
+BENCHMARK(BM_PipelinedRequestsPerSecond)->Arg(16)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -1,15 +1,37 @@
+#include "Http1Response.h"
 #include "Http1Server.h"
 
 #include <boost/asio.hpp>
 #include <chrono>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <mutex>
+#include <optional>
 #include <random>
 #include <thread>
 
 using namespace std::chrono_literals;
 using namespace testing;
 
+// Helper to send a request and read the raw response until the server closes
+std::string send_request_raw(int port, const std::string &method,
+                             const std::string &path) {
+  boost::asio::io_context ioc;
+  boost::asio::ip::tcp::socket socket(ioc);
+  socket.connect(boost::asio::ip::tcp::endpoint(
+      boost::asio::ip::make_address("127.0.0.1"), port));
+
+  std::string req = method + " " + path +
+                    " HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n"
+                    "Content-Length: 0\r\n\r\n";
+  boost::asio::write(socket, boost::asio::buffer(req));
+
+  std::string response;
+  boost::system::error_code ec;
+  boost::asio::read(socket, boost::asio::dynamic_buffer(response), ec);
+  return response;
+}
+
 // Helper to send a request and get response
 std::string send_request(int port, const std::string &method,
                          const std::string &path,
@@ -60,6 +82,15 @@ protected:
           if (req.path() == "/test") {
             res.set_status(200);
             res.write("Hello Test");
+          } else if (req.path() == "/stream") {
+            res.set_status(200);
+            res.set_header("Content-Type", "text/plain");
+            res.send_headers();
+            res.write("first,");
+            res.write("second");
+          } else if (req.path() == "/query") {
+            res.set_status(200);
+            res.write(std::string(req.query_param("name")));
           } else if (req.path() == "/echo") {
             res.set_status(200);
             res.write(req.body());
@@ -108,6 +139,206 @@ TEST_F(Http1ServerTest, BasicRequests) {
   EXPECT_THAT(res, HasSubstr("404 Not Found"));
 }
 
+TEST_F(Http1ServerTest, StreamedResponseUsesChunkedEncoding) {
+  auto raw = send_request_raw(m_port, "GET", "/stream");
+
+  EXPECT_THAT(raw, StartsWith("HTTP/1.1 200 OK\r\n"));
+  EXPECT_THAT(raw, HasSubstr("Transfer-Encoding: chunked\r\n"));
+  EXPECT_THAT(raw, HasSubstr("Content-Type: text/plain\r\n"));
+  EXPECT_THAT(raw, EndsWith("\r\n\r\n6\r\nfirst,\r\n6\r\nsecond\r\n0\r\n\r\n"));
+}
+
+TEST_F(Http1ServerTest, StreamToHttp10PeerIsDelimitedByClose) {
+  boost::asio::io_context ioc;
+  boost::asio::ip::tcp::socket socket(ioc);
+  socket.connect(boost::asio::ip::tcp::endpoint(
+      boost::asio::ip::make_address("127.0.0.1"), m_port));
+  std::string req = "GET /stream HTTP/1.0\r\nHost: 127.0.0.1\r\n\r\n";
+  boost::asio::write(socket, boost::asio::buffer(req));
+
+  std::string raw;
+  boost::system::error_code ec;
+  boost::asio::read(socket, boost::asio::dynamic_buffer(raw), ec);
+
+  EXPECT_THAT(raw, StartsWith("HTTP/1.0 200 OK\r\n"));
+  EXPECT_THAT(raw, Not(HasSubstr("Transfer-Encoding")));
+  EXPECT_THAT(raw, Not(HasSubstr("Content-Length")));
+  EXPECT_THAT(raw, EndsWith("\r\n\r\nfirst,second"));
+}
+
+TEST_F(Http1ServerTest, QueryIsSplitFromPath) {
+  auto raw = send_request_raw(m_port, "GET", "/query?id=1&name=a%20b");
+
+  EXPECT_THAT(raw, StartsWith("HTTP/1.1 200 OK\r\n"));
+  EXPECT_THAT(raw, EndsWith("\r\n\r\na b"));
+}
+
+TEST_F(Http1ServerTest, KeepAliveServesSeveralRequestsPerConnection) {
+  boost::asio::io_context ioc;
+  boost::asio::ip::tcp::socket socket(ioc);
+  socket.connect(boost::asio::ip::tcp::endpoint(
+      boost::asio::ip::make_address("127.0.0.1"), m_port));
+
+  boost::beast::flat_buffer buffer;
+  for (int i = 0; i < 3; ++i) {
+    std::string req = "GET /test HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+    boost::asio::write(socket, boost::asio::buffer(req));
+
+    boost::beast::http::response<boost::beast::http::string_body> res;
+    boost::beast::http::read(socket, buffer, res);
+    EXPECT_EQ(res.result_int(), 200);
+    EXPECT_TRUE(res.keep_alive());
+    EXPECT_EQ(res.body(), "Hello Test");
+  }
+}
+
+TEST_F(Http1ServerTest, PipelinedResponsesKeepRequestOrder) {
+  boost::asio::io_context ioc;
+  boost::asio::ip::tcp::socket socket(ioc);
+  socket.connect(boost::asio::ip::tcp::endpoint(
+      boost::asio::ip::make_address("127.0.0.1"), m_port));
+
+  // All requests in one write, so the server parses them from one buffer
+  std::string reqs = "GET /query?name=one HTTP/1.1\r\nHost: a\r\n\r\n"
+                     "GET /stream HTTP/1.1\r\nHost: a\r\n\r\n"
+                     "GET /query?name=three HTTP/1.1\r\nHost: a\r\n"
+                     "Connection: close\r\n\r\n";
+  boost::asio::write(socket, boost::asio::buffer(reqs));
+
+  boost::beast::flat_buffer buffer;
+  std::vector<std::string> bodies;
+  for (int i = 0; i < 3; ++i) {
+    boost::beast::http::response<boost::beast::http::string_body> res;
+    boost::beast::http::read(socket, buffer, res);
+    bodies.push_back(res.body());
+  }
+  EXPECT_THAT(bodies, ElementsAre("one", "first,second", "three"));
+
+  // The last request asked for close
+  boost::system::error_code ec;
+  char byte;
+  socket.read_some(boost::asio::buffer(&byte, 1), ec);
+  EXPECT_EQ(ec, boost::asio::error::eof);
+}
+
+TEST(Http1ServerKeepAliveTest, IdleConnectionIsClosed) {
+  http1server::Config config;
+  config.set_address("127.0.0.1");
+  config.set_keep_alive_timeout_ms(100);
+  astra::http1::Server server(config);
+  server.handle([](const astra::router::IRequest &,
+                   astra::router::IResponse &res) {
+    res.set_status(200);
+    res.close();
+  });
+  std::thread server_thread([&server] {
+    server.run();
+  });
+
+  boost::asio::io_context ioc;
+  boost::asio::ip::tcp::socket socket(ioc);
+  socket.connect(boost::asio::ip::tcp::endpoint(
+      boost::asio::ip::make_address("127.0.0.1"), server.port()));
+  std::string req = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+  boost::asio::write(socket, boost::asio::buffer(req));
+
+  boost::beast::flat_buffer buffer;
+  boost::beast::http::response<boost::beast::http::string_body> res;
+  boost::beast::http::read(socket, buffer, res);
+  EXPECT_TRUE(res.keep_alive());
+
+  // Blocks until the server gives up on the idle connection
+  auto start = std::chrono::steady_clock::now();
+  boost::system::error_code ec;
+  char byte;
+  socket.read_some(boost::asio::buffer(&byte, 1), ec);
+  EXPECT_TRUE(ec);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 50ms);
+
+  server.stop();
+  server_thread.join();
+}
+
+TEST(Http1ServerLimitsTest, AcceptingPausesAtMaxConnections) {
+  http1server::Config config;
+  config.set_address("127.0.0.1");
+  config.set_max_connections(1);
+  astra::http1::Server server(config);
+  server.handle([](const astra::router::IRequest &,
+                   astra::router::IResponse &res) {
+    res.set_status(200);
+    res.write("ok");
+    res.close();
+  });
+  std::thread server_thread([&server] {
+    server.run();
+  });
+
+  boost::asio::io_context ioc;
+  auto endpoint = boost::asio::ip::tcp::endpoint(
+      boost::asio::ip::make_address("127.0.0.1"), server.port());
+  std::string req = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+
+  boost::asio::ip::tcp::socket first(ioc);
+  first.connect(endpoint);
+  boost::asio::write(first, boost::asio::buffer(req));
+  boost::beast::flat_buffer buffer;
+  boost::beast::http::response<boost::beast::http::string_body> res;
+  boost::beast::http::read(first, buffer, res);
+  EXPECT_EQ(res.body(), "ok");
+
+  // Connects through the kernel backlog but is not served yet
+  boost::asio::ip::tcp::socket second(ioc);
+  second.connect(endpoint);
+  boost::asio::write(second, boost::asio::buffer(req));
+  std::string reply;
+  bool replied = false;
+  boost::asio::async_read(second, boost::asio::dynamic_buffer(reply),
+                          boost::asio::transfer_at_least(1),
+                          [&replied](boost::system::error_code ec, size_t) {
+                            replied = !ec;
+                          });
+  ioc.run_for(200ms);
+  EXPECT_FALSE(replied);
+
+  first.close();
+  ioc.restart();
+  ioc.run_for(2s);
+  EXPECT_TRUE(replied);
+  EXPECT_THAT(reply, StartsWith("HTTP/1.1 200 OK\r\n"));
+
+  server.stop();
+  server_thread.join();
+}
+
+TEST(Http1ServerLimitsTest, IncompleteHeaderTimesOut) {
+  http1server::Config config;
+  config.set_address("127.0.0.1");
+  config.set_request_timeout_ms(100);
+  astra::http1::Server server(config);
+  std::thread server_thread([&server] {
+    server.run();
+  });
+
+  boost::asio::io_context ioc;
+  boost::asio::ip::tcp::socket socket(ioc);
+  socket.connect(boost::asio::ip::tcp::endpoint(
+      boost::asio::ip::make_address("127.0.0.1"), server.port()));
+  // The blank line ending the header never comes
+  std::string partial = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n";
+  boost::asio::write(socket, boost::asio::buffer(partial));
+
+  auto start = std::chrono::steady_clock::now();
+  boost::system::error_code ec;
+  char byte;
+  socket.read_some(boost::asio::buffer(&byte, 1), ec);
+  EXPECT_TRUE(ec);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 50ms);
+
+  server.stop();
+  server_thread.join();
+}
+
 TEST_F(Http1ServerTest, LargeBody) {
   std::string large_body(1024 * 1024, 'a'); // 1MB body
   auto res = send_request(m_port, "POST", "/echo", large_body);
@@ -166,3 +397,130 @@ TEST_F(Http1ServerTest, HighConcurrency) {
 
   EXPECT_EQ(success_count, num_threads * 10);
 }
+
+TEST(Http1ServerRouterTest, RouteFinishesStreamAfterReturning) {
+  astra::http1::Server server("127.0.0.1", 0, 1);
+  std::vector<std::thread> producers;
+  std::mutex producers_mutex;
+  server.router().add(
+      astra::router::HttpMethod::GET, "/later",
+      [&](std::shared_ptr<astra::router::IRequest>,
+          std::shared_ptr<astra::router::IResponse> res) {
+        // The route returns at once; the response lives on in the producer
+        std::lock_guard<std::mutex> lock(producers_mutex);
+        producers.emplace_back([res] {
+          res->set_status(200);
+          res->send_headers();
+          for (int i = 0; i < 4; ++i) {
+            res->write(std::string(64 * 1024, static_cast<char>('a' + i)));
+            // Yield until the connection has taken the chunk
+            for (int spin = 0; spin < 500 && res->pending_bytes() > 0;
+                 ++spin) {
+              std::this_thread::sleep_for(1ms);
+            }
+          }
+          res->close();
+        });
+      });
+  std::thread server_thread([&server] {
+    server.run();
+  });
+
+  boost::asio::io_context ioc;
+  boost::asio::ip::tcp::socket socket(ioc);
+  socket.connect(boost::asio::ip::tcp::endpoint(
+      boost::asio::ip::make_address("127.0.0.1"), server.port()));
+  std::string reqs = "GET /later HTTP/1.1\r\nHost: a\r\n\r\n"
+                     "GET /missing HTTP/1.1\r\nHost: a\r\n\r\n";
+  boost::asio::write(socket, boost::asio::buffer(reqs));
+
+  // The pipelined second response waits behind the whole stream
+  boost::beast::flat_buffer buffer;
+  boost::beast::http::response<boost::beast::http::string_body> first;
+  boost::beast::http::read(socket, buffer, first);
+  boost::beast::http::response<boost::beast::http::string_body> second;
+  boost::beast::http::read(socket, buffer, second);
+
+  EXPECT_EQ(first.result_int(), 200);
+  EXPECT_TRUE(first.chunked());
+  ASSERT_EQ(first.body().size(), 4u * 64 * 1024);
+  EXPECT_EQ(first.body().front(), 'a');
+  EXPECT_EQ(first.body().back(), 'd');
+  EXPECT_EQ(second.result_int(), 404);
+
+  server.stop();
+  server_thread.join();
+  for (auto &t : producers) {
+    t.join();
+  }
+}
+
+TEST(Http1ResponseTest, PendingBytesCoverBufferedAndQueuedBody) {
+  astra::http1::Response::Message message;
+  size_t queued = 0;
+  std::string written;
+  astra::http1::Response res(
+      message, [](bool) {},
+      [&](std::string bytes, bool) {
+        queued += bytes.size();
+        written += bytes;
+      },
+      [&] {
+        return queued;
+      });
+
+  res.write("abc");
+  EXPECT_EQ(res.pending_bytes(), 3u);
+
+  res.send_headers();
+  EXPECT_EQ(res.pending_bytes(), written.size());
+  EXPECT_EQ(written, "3\r\nabc\r\n");
+
+  queued = 0;
+  EXPECT_EQ(res.pending_bytes(), 0u);
+  res.close();
+}
+
+TEST(Http1ServerReusePortTest, EachThreadOwnsAListener) {
+  astra::http1::Server server("127.0.0.1", 0, 4,
+                              astra::http1::ListenMode::ReusePort);
+  server.handle([](const astra::router::IRequest &,
+                   astra::router::IResponse &res) {
+    res.set_status(200);
+    res.write("ok");
+    res.close();
+  });
+  ASSERT_EQ(server.shard_count(), 4);
+  ASSERT_NE(server.port(), 0);
+
+  std::thread server_thread([&server] {
+    server.run();
+  });
+
+  int ok = 0;
+  for (int i = 0; i < 40; ++i) {
+    if (send_request(server.port(), "GET", "/").find("200 OK") !=
+        std::string::npos) {
+      ++ok;
+    }
+  }
+  EXPECT_EQ(ok, 40);
+
+  // Sessions end once the response is written and the client disconnects
+  for (int attempt = 0; attempt < 50; ++attempt) {
+    int64_t open = 0;
+    for (size_t shard = 0; shard < server.shard_count(); ++shard) {
+      open += server.connection_count(shard);
+    }
+    if (open == 0) {
+      break;
+    }
+    std::this_thread::sleep_for(10ms);
+  }
+  for (size_t shard = 0; shard < server.shard_count(); ++shard) {
+    EXPECT_EQ(server.connection_count(shard), 0) << "shard " << shard;
+  }
+
+  server.stop();
+  server_thread.join();
+}
@@ -5,12 +5,25 @@
 #include <memory>
 #include <shared_mutex>
 #include <unordered_map>
+#include <vector>
 
 namespace astra::http2 {
 
+class TlsClientContext;
+
+// A pool of connections to each host, sized by ClientConfig.pool: one
+// connection unless configured otherwise. get_or_create() hands out the
+// less busy of two connections picked at random, by outstanding streams,
+// and opens another connection, up to max_connections, when that one is
+// busy too. Dead connections are dropped and replaced up to
+// min_connections. With TLS enabled a host's TLS context is shared by its
+// connections and outlives them, so new connections resume a session.
 class ClientRegistry {
 public:
   explicit ClientRegistry(const ::http2::ClientConfig &config);
+  // Clients created here run on `io_context` instead of threads of their own
+  ClientRegistry(const ::http2::ClientConfig &config,
+                 boost::asio::io_context &io_context);
   ~ClientRegistry();
 
   ClientRegistry(const ClientRegistry &) = delete;
@@ -19,10 +32,32 @@ public:
   std::shared_ptr<NgHttp2Client> get_or_create(const std::string &host,
                                                uint16_t port);
 
+  // Connections currently pooled for `host`:`port`, dead ones included
+  [[nodiscard]] size_t connections(const std::string &host,
+                                   uint16_t port) const;
+
 private:
-  std::unordered_map<std::string, std::shared_ptr<NgHttp2Client>> m_clients;
+  using Pool = std::vector<std::shared_ptr<NgHttp2Client>>;
+
+  // The less busy of two random connections, or a dead one among them so
+  // the caller prunes the pool
+  static const std::shared_ptr<NgHttp2Client> &pick(const Pool &pool);
+  bool busy(const NgHttp2Client &client) const noexcept;
+  std::shared_ptr<NgHttp2Client> create(const std::string &key,
+                                        const std::string &host,
+                                        uint16_t port);
+  std::shared_ptr<TlsClientContext> tls_context(const std::string &key,
+                                               const std::string &host);
+
+  std::unordered_map<std::string, Pool> m_pools;
+  std::unordered_map<std::string, std::shared_ptr<TlsClientContext>>
+      m_tls_contexts;
   mutable std::shared_mutex m_mutex;
   ::http2::ClientConfig m_config;
+  boost::asio::io_context *m_io_context{nullptr};
+  size_t m_min_connections;
+  size_t m_max_connections;
+  uint32_t m_scale_up_streams;
 };
 
 } // namespace astra::http2
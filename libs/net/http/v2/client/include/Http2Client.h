@@ -9,6 +9,11 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
+
+namespace boost::asio {
+class io_context;
+}
 
 namespace astra::http2 {
 
@@ -28,6 +33,14 @@ public:
               const std::map<std::string, std::string> &headers,
               ResponseHandler handler);
 
+  // Run-to-completion: gives each thread running one of `contexts` its own
+  // upstream connections, owned by that io_context, so a submit() made
+  // there runs the exchange and `handler` on the calling thread. Calls from
+  // any other thread keep using the client's own io thread. Takes effect
+  // on each thread once it next runs a handler.
+  void bind_io_contexts(
+      const std::vector<std::shared_ptr<boost::asio::io_context>> &contexts);
+
 private:
   class Impl;
   std::unique_ptr<Impl> m_impl;
@@ -9,6 +9,7 @@
 #include <atomic>
 #include <boost/asio.hpp>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <nghttp2/asio_http2_client.h>
 #include <queue>
@@ -16,6 +17,9 @@
 
 namespace astra::http2 {
 
+class TlsClientContext;
+class UnixSocketSession;
+
 enum class ConnectionState { DISCONNECTED, CONNECTING, CONNECTED, FAILED };
 
 using ResponseHandler = std::function<void(
@@ -31,12 +35,23 @@ struct PendingRequest {
   ResponseHandler handler;
 };
 
+// One HTTP/2 connection to `host`:`port`, over TLS when given a `tls`
+// context, or to a Unix domain socket when `host` is unix:///path
 class NgHttp2Client {
 public:
+  // Runs the connection on an io thread of its own
   NgHttp2Client(const std::string &host, uint16_t port,
                 const ::http2::ClientConfig &config,
                 OnCloseCallback on_close = nullptr,
-                OnErrorCallback on_error = nullptr);
+                OnErrorCallback on_error = nullptr,
+                std::shared_ptr<TlsClientContext> tls = nullptr);
+  // Runs the connection on `io_context`, driven by its owner. submit() and
+  // the destructor must then be called from the thread running it, and
+  // handlers run there too.
+  NgHttp2Client(const std::string &host, uint16_t port,
+                const ::http2::ClientConfig &config,
+                boost::asio::io_context &io_context,
+                std::shared_ptr<TlsClientContext> tls = nullptr);
   ~NgHttp2Client();
 
   NgHttp2Client(const NgHttp2Client &) = delete;
@@ -50,6 +65,8 @@ public:
   bool is_connected() const;
   ConnectionState state() const;
   bool is_dead() const;
+  // Requests submitted whose handler has not run yet
+  uint32_t outstanding_streams() const;
 
 private:
   void ensure_connected();
@@ -61,24 +78,41 @@ private:
                  const std::map<std::string, std::string> &headers,
                  ResponseHandler handler);
   void flush_pending_requests();
+  template <typename Request>
+  void watch_response(const boost::system::error_code &ec, const Request *req,
+                      const ResponseHandler &handler);
+  void shutdown_session();
+  void reset_session();
 
   std::string m_host;
   uint16_t m_port;
   ::http2::ClientConfig m_config;
   OnCloseCallback m_on_close;
   OnErrorCallback m_on_error;
+  // Shared with the connections to the same host before and after this one
+  std::shared_ptr<TlsClientContext> m_tls;
 
-  boost::asio::io_context m_io_context;
+  // Null when bound to a caller's io_context
+  std::unique_ptr<boost::asio::io_context> m_owned_io_context;
+  boost::asio::io_context &m_io_context;
   std::unique_ptr<
       boost::asio::executor_work_guard<boost::asio::io_context::executor_type>>
       m_work;
   std::thread m_io_thread;
 
+  // At most one is set, depending on the host
   std::unique_ptr<nghttp2::asio_http2::client::session> m_session;
+  std::unique_ptr<UnixSocketSession> m_unix_session;
   std::atomic<ConnectionState> m_state{ConnectionState::DISCONNECTED};
   std::mutex m_connect_mutex;
   std::queue<PendingRequest> m_pending_requests;
   std::atomic<bool> m_is_dead{false};
+  // Shared with the handlers, which may run after the client is gone
+  std::shared_ptr<std::atomic<uint32_t>> m_outstanding =
+      std::make_shared<std::atomic<uint32_t>>(0);
+  // Callbacks left queued on a bound io_context can outlive the client;
+  // they check this before touching it
+  std::shared_ptr<bool> m_lifetime = std::make_shared<bool>(true);
 };
 
 } // namespace astra::http2
@@ -1,9 +1,55 @@
 #include "ClientRegistry.h"
 
+#include "TlsClientContext.h"
+#include "UnixSocketSession.h"
+
+#include <algorithm>
+#include <random>
+
 namespace astra::http2 {
 
+namespace {
+
+// Peers commonly allow 100 concurrent streams
+constexpr uint32_t DEFAULT_SCALE_UP_STREAMS = 75;
+
+size_t min_connections(const ::http2::ClientPoolConfig &pool) {
+  return std::max<size_t>(pool.min_connections(), 1);
+}
+
+size_t max_connections(const ::http2::ClientPoolConfig &pool) {
+  return std::max<size_t>(pool.max_connections(), min_connections(pool));
+}
+
+uint32_t scale_up_streams(const ::http2::ClientConfig &config) {
+  if (config.pool().scale_up_streams() > 0) {
+    return config.pool().scale_up_streams();
+  }
+  if (config.max_concurrent_streams() > 0) {
+    return std::max<uint32_t>(config.max_concurrent_streams() * 3 / 4, 1);
+  }
+  return DEFAULT_SCALE_UP_STREAMS;
+}
+
+size_t random_index(size_t size) {
+  thread_local std::minstd_rand engine(std::random_device{}());
+  return std::uniform_int_distribution<size_t>(0, size - 1)(engine);
+}
+
+} // namespace
+
 ClientRegistry::ClientRegistry(const ::http2::ClientConfig &config)
-    : m_config(config) {
+    : m_config(config), m_min_connections(min_connections(config.pool())),
+      m_max_connections(max_connections(config.pool())),
+      m_scale_up_streams(scale_up_streams(config)) {
+}
+
+ClientRegistry::ClientRegistry(const ::http2::ClientConfig &config,
+                               boost::asio::io_context &io_context)
+    : m_config(config), m_io_context(&io_context),
+      m_min_connections(min_connections(config.pool())),
+      m_max_connections(max_connections(config.pool())),
+      m_scale_up_streams(scale_up_streams(config)) {
 }
 
 ClientRegistry::~ClientRegistry() = default;
@@ -14,24 +60,90 @@ ClientRegistry::get_or_create(const std::string &host, uint16_t port) {
 
   {
     std::shared_lock lock(m_mutex);
-    auto it = m_clients.find(key);
-    if (it != m_clients.end() && !it->second->is_dead()) {
-      return it->second;
+    auto it = m_pools.find(key);
+    if (it != m_pools.end()) {
+      const auto &client = pick(it->second);
+      if (!client->is_dead() &&
+          (!busy(*client) || it->second.size() >= m_max_connections)) {
+        return client;
+      }
     }
   }
 
   std::unique_lock lock(m_mutex);
-  auto it = m_clients.find(key);
-  if (it != m_clients.end() && it->second->is_dead()) {
-    m_clients.erase(it);
-    it = m_clients.end();
+  auto &pool = m_pools[key];
+  pool.erase(std::remove_if(pool.begin(), pool.end(),
+                            [](const auto &client) {
+                              return client->is_dead();
+                            }),
+             pool.end());
+  while (pool.size() < m_min_connections) {
+    pool.push_back(create(key, host, port));
+  }
+  // Picked again: other threads may have grown the pool meanwhile
+  const auto &client = pick(pool);
+  if (busy(*client) && pool.size() < m_max_connections) {
+    obs::debug("Opening connection " + std::to_string(pool.size() + 1) +
+               " to " + key);
+    pool.push_back(create(key, host, port));
+    return pool.back();
+  }
+  return client;
+}
+
+size_t ClientRegistry::connections(const std::string &host,
+                                   uint16_t port) const {
+  std::shared_lock lock(m_mutex);
+  auto it = m_pools.find(host + ":" + std::to_string(port));
+  return it == m_pools.end() ? 0 : it->second.size();
+}
+
+// Two choices rather than the least busy of all: as good at spreading load
+// and O(1), while threads picking at the same time do not all pile onto
+// the same connection
+const std::shared_ptr<NgHttp2Client> &ClientRegistry::pick(const Pool &pool) {
+  if (pool.size() == 1) {
+    return pool.front();
+  }
+  size_t first = random_index(pool.size());
+  size_t second = random_index(pool.size() - 1);
+  if (second >= first) {
+    ++second;
+  }
+  const auto &a = pool[first];
+  const auto &b = pool[second];
+  if (a->is_dead() || b->is_dead()) {
+    return a->is_dead() ? a : b;
+  }
+  return b->outstanding_streams() < a->outstanding_streams() ? b : a;
+}
+
+bool ClientRegistry::busy(const NgHttp2Client &client) const noexcept {
+  return client.outstanding_streams() >= m_scale_up_streams;
+}
+
+// Called with m_mutex held exclusively
+std::shared_ptr<NgHttp2Client>
+ClientRegistry::create(const std::string &key, const std::string &host,
+                       uint16_t port) {
+  auto tls = tls_context(key, host);
+  return m_io_context ? std::make_shared<NgHttp2Client>(host, port, m_config,
+                                                        *m_io_context, tls)
+                      : std::make_shared<NgHttp2Client>(
+                            host, port, m_config, nullptr, nullptr, tls);
+}
+
+// Called with m_mutex held exclusively
+std::shared_ptr<TlsClientContext>
+ClientRegistry::tls_context(const std::string &key, const std::string &host) {
+  if (!m_config.tls().enabled() || UnixSocketSession::socket_path(host)) {
+    return nullptr;
   }
-  if (it == m_clients.end()) {
-    auto client =
-        std::make_shared<NgHttp2Client>(host, port, m_config, nullptr, nullptr);
-    it = m_clients.emplace(key, std::move(client)).first;
+  auto &tls = m_tls_contexts[key];
+  if (!tls) {
+    tls = std::make_shared<TlsClientContext>(m_config.tls(), host);
   }
-  return it->second;
+  return tls;
 }
 
 } // namespace astra::http2
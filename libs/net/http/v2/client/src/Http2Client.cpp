@@ -1,24 +1,58 @@
 #include "Http2Client.h"
 
 #include "ClientRegistry.h"
+#include "IoContextClients.h"
 
 namespace astra::http2 {
 
 class Http2Client::Impl {
 public:
-  explicit Impl(const ::http2::ClientConfig &config) : m_registry(config) {
+  explicit Impl(const ::http2::ClientConfig &config)
+      : m_config(config), m_registry(config) {
+  }
+
+  // Registries are keyed by this object's address, so they go before a
+  // later client can be given the same one. Posted work runs in order, so
+  // the unbind lands ahead of any bind made after it.
+  ~Impl() {
+    for (const auto &bound : m_bound) {
+      if (auto ioc = bound.lock()) {
+        boost::asio::post(*ioc, [owner = this, ctx = ioc.get()] {
+          IoContextClients::of(*ctx).unbind(owner);
+        });
+      }
+    }
   }
 
   void submit(const std::string &host, uint16_t port, const std::string &method,
               const std::string &path, const std::string &body,
               const std::map<std::string, std::string> &headers,
               ResponseHandler handler) {
-    auto client = m_registry.get_or_create(host, port);
+    auto &registry = registry_for_this_thread();
+    auto client = registry.get_or_create(host, port);
     client->submit(method, path, body, headers, handler);
   }
 
+  void bind(const std::shared_ptr<boost::asio::io_context> &ioc) {
+    m_bound.push_back(ioc);
+    boost::asio::post(*ioc, [owner = this, ctx = ioc.get(), config = m_config] {
+      IoContextClients::of(*ctx).bind(owner, config);
+    });
+  }
+
 private:
+  ClientRegistry &registry_for_this_thread() {
+    if (auto *local = IoContextClients::current()) {
+      if (auto *registry = local->find(this)) {
+        return *registry;
+      }
+    }
+    return m_registry;
+  }
+
+  ::http2::ClientConfig m_config;
   ClientRegistry m_registry;
+  std::vector<std::weak_ptr<boost::asio::io_context>> m_bound;
 };
 
 Http2Client::Http2Client(const ::http2::ClientConfig &config)
@@ -35,4 +69,11 @@ void Http2Client::submit(const std::string &host, uint16_t port,
   m_impl->submit(host, port, method, path, body, headers, handler);
 }
 
+void Http2Client::bind_io_contexts(
+    const std::vector<std::shared_ptr<boost::asio::io_context>> &contexts) {
+  for (const auto &ioc : contexts) {
+    m_impl->bind(ioc);
+  }
+}
+
 } // namespace astra::http2
@@ -0,0 +1,56 @@
+#include "IoContextClients.h"
+
+namespace astra::http2 {
+
+namespace {
+
+// Set on a thread by the first bind() that runs there; nghttp2-asio runs
+// each io_context on a thread of its own for the thread's whole life
+thread_local IoContextClients *t_current = nullptr;
+
+} // namespace
+
+boost::asio::io_context::id IoContextClients::id;
+
+IoContextClients::IoContextClients(boost::asio::io_context &ioc)
+    : boost::asio::io_context::service(ioc), m_ioc(ioc) {
+}
+
+IoContextClients::~IoContextClients() {
+  if (t_current == this) {
+    t_current = nullptr;
+  }
+}
+
+IoContextClients *IoContextClients::current() noexcept {
+  if (t_current && t_current->m_ioc.get_executor().running_in_this_thread()) {
+    return t_current;
+  }
+  return nullptr;
+}
+
+void IoContextClients::bind(const void *owner,
+                            const ::http2::ClientConfig &config) {
+  t_current = this;
+  auto &registry = m_registries[owner];
+  if (!registry) {
+    registry = std::make_unique<ClientRegistry>(config, m_ioc);
+  }
+}
+
+void IoContextClients::unbind(const void *owner) {
+  m_registries.erase(owner);
+}
+
+ClientRegistry *IoContextClients::find(const void *owner) const noexcept {
+  auto it = m_registries.find(owner);
+  return it != m_registries.end() ? it->second.get() : nullptr;
+}
+
+// Connections close with the io_context; submit() calls still made on its
+// thread find no registry and use the client's own io thread
+void IoContextClients::shutdown() {
+  m_registries.clear();
+}
+
+} // namespace astra::http2
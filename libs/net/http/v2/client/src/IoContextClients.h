@@ -0,0 +1,54 @@
+#pragma once
+
+#include "ClientRegistry.h"
+
+#include <boost/asio.hpp>
+#include <memory>
+#include <unordered_map>
+
+namespace astra::http2 {
+
+// Connections owned by one io_context, for Http2Clients bound to it with
+// bind_io_contexts(). Each bound client gets a registry of its own here, so
+// a thread running the io_context talks to upstreams over connections no
+// other thread touches.
+//
+// One instance per io_context, created on first use through of(). Apart
+// from of(), call only from the io_context's thread.
+class IoContextClients : public boost::asio::io_context::service {
+public:
+  static boost::asio::io_context::id id;
+
+  explicit IoContextClients(boost::asio::io_context &ioc);
+  ~IoContextClients() override;
+
+  static IoContextClients &of(boost::asio::io_context &ioc) {
+    return boost::asio::use_service<IoContextClients>(ioc);
+  }
+
+  // The instance of the io_context running this thread, once bind() has
+  // run on it; nullptr elsewhere
+  static IoContextClients *current() noexcept;
+
+  void bind(const void *owner, const ::http2::ClientConfig &config);
+  // Closes `owner`'s connections here; the owner must not be used again
+  // on this io_context
+  void unbind(const void *owner);
+
+  // `owner`'s registry on this io_context, or nullptr when not bound here
+  [[nodiscard]] ClientRegistry *find(const void *owner) const noexcept;
+
+  // Clients bound here
+  [[nodiscard]] size_t size() const noexcept {
+    return m_registries.size();
+  }
+
+private:
+  void shutdown() override;
+
+  boost::asio::io_context &m_ioc;
+  std::unordered_map<const void *, std::unique_ptr<ClientRegistry>>
+      m_registries;
+};
+
+} // namespace astra::http2
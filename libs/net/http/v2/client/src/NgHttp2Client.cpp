@@ -1,6 +1,8 @@
 #include "NgHttp2Client.h"
 
 #include "Http2ClientResponse.h"
+#include "TlsClientContext.h"
+#include "UnixSocketSession.h"
 
 #include <boost/asio/deadline_timer.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
@@ -20,14 +22,37 @@ struct ResponseStream {
 
 NgHttp2Client::NgHttp2Client(const std::string &host, uint16_t port,
                              const ::http2::ClientConfig &config,
-                             OnCloseCallback on_close, OnErrorCallback on_error)
+                             OnCloseCallback on_close, OnErrorCallback on_error,
+                             std::shared_ptr<TlsClientContext> tls)
     : m_host(host), m_port(port), m_config(config),
-      m_on_close(std::move(on_close)), m_on_error(std::move(on_error)) {
+      m_on_close(std::move(on_close)), m_on_error(std::move(on_error)),
+      m_tls(std::move(tls)),
+      m_owned_io_context(std::make_unique<boost::asio::io_context>()),
+      m_io_context(*m_owned_io_context) {
   start_io_thread();
 }
 
+NgHttp2Client::NgHttp2Client(const std::string &host, uint16_t port,
+                             const ::http2::ClientConfig &config,
+                             boost::asio::io_context &io_context,
+                             std::shared_ptr<TlsClientContext> tls)
+    : m_host(host), m_port(port), m_config(config), m_tls(std::move(tls)),
+      m_io_context(io_context) {
+}
+
 NgHttp2Client::~NgHttp2Client() {
-  stop_io_thread();
+  if (m_owned_io_context) {
+    stop_io_thread();
+    return;
+  }
+
+  // Bound: already on the io thread, or the io_context is shutting down
+  m_lifetime.reset();
+  if (!m_io_context.stopped() &&
+      m_state.load(std::memory_order_acquire) == ConnectionState::CONNECTED) {
+    shutdown_session();
+  }
+  reset_session();
 }
 
 void NgHttp2Client::start_io_thread() {
@@ -48,9 +73,8 @@ void NgHttp2Client::stop_io_thread() {
   // io_thread. This prevents TSAN race between main thread reading m_session
   // and io_thread writing it.
   boost::asio::post(m_io_context, [this]() {
-    if (m_session &&
-        m_state.load(std::memory_order_acquire) == ConnectionState::CONNECTED) {
-      m_session->shutdown();
+    if (m_state.load(std::memory_order_acquire) == ConnectionState::CONNECTED) {
+      shutdown_session();
     }
   });
 
@@ -67,7 +91,20 @@ void NgHttp2Client::stop_io_thread() {
 
   // Now safe to destroy the session - io_thread has exited, no callbacks
   // running
+  reset_session();
+}
+
+void NgHttp2Client::shutdown_session() {
+  if (m_session) {
+    m_session->shutdown();
+  } else if (m_unix_session) {
+    m_unix_session->shutdown();
+  }
+}
+
+void NgHttp2Client::reset_session() {
   m_session.reset();
+  m_unix_session.reset();
 }
 
 void NgHttp2Client::ensure_connected() {
@@ -91,13 +128,24 @@ void NgHttp2Client::connect() {
   // Post to io_context to ensure session creation and callback registration
   // happen on the same thread that will invoke the callbacks. This prevents
   // TSAN data races between callback registration and invocation.
-  boost::asio::post(m_io_context, [this]() {
+  boost::asio::post(m_io_context, [this,
+                                   lifetime = std::weak_ptr<bool>(m_lifetime)]() {
+    if (lifetime.expired()) {
+      return;
+    }
     try {
-      boost::system::error_code ec;
-      std::string port_str = std::to_string(m_port);
-
-      m_session = std::make_unique<nghttp2::asio_http2::client::session>(
-          m_io_context, m_host, port_str);
+      // A unix:///path host connects over a Unix domain socket; the port
+      // is ignored
+      if (auto path = UnixSocketSession::socket_path(m_host)) {
+        m_unix_session =
+            std::make_unique<UnixSocketSession>(m_io_context, *path);
+      } else if (m_tls) {
+        m_session = std::make_unique<nghttp2::asio_http2::client::session>(
+            m_io_context, m_tls->context(), m_host, std::to_string(m_port));
+      } else {
+        m_session = std::make_unique<nghttp2::asio_http2::client::session>(
+            m_io_context, m_host, std::to_string(m_port));
+      }
 
       // Create connect timeout timer
       uint32_t timeout_ms = m_config.connect_timeout_ms() > 0
@@ -110,9 +158,10 @@ void NgHttp2Client::connect() {
 
       auto connect_completed = std::make_shared<std::atomic<bool>>(false);
 
-      connect_timer->async_wait([this, connect_completed](
+      connect_timer->async_wait([this, connect_completed,
+                                 lifetime = std::weak_ptr<bool>(m_lifetime)](
                                     const boost::system::error_code &ec) {
-        if (ec) {
+        if (ec || lifetime.expired()) {
           return; // Timer was cancelled
         }
 
@@ -143,25 +192,29 @@ void NgHttp2Client::connect() {
         }
       });
 
-      m_session->on_connect(
-          [this, connect_timer, connect_completed](
-              boost::asio::ip::tcp::resolver::results_type::iterator
-                  endpoint_it) {
-            // Atomic CAS: only proceed if we're the first to claim completion
-            bool expected = false;
-            if (!connect_completed->compare_exchange_strong(expected, true)) {
-              return; // Already handled by timeout or on_error
-            }
-
-            connect_timer->cancel();
-            m_state.store(ConnectionState::CONNECTED,
-                          std::memory_order_release);
-            obs::info("Connected to " + m_host + ":" + std::to_string(m_port));
-            flush_pending_requests();
-          });
-
-      m_session->on_error([this, connect_timer, connect_completed](
-                              const boost::system::error_code &ec) {
+      auto on_connect = [this, connect_timer, connect_completed,
+                         lifetime = std::weak_ptr<bool>(m_lifetime)]() {
+        if (lifetime.expired()) {
+          return;
+        }
+        // Atomic CAS: only proceed if we're the first to claim completion
+        bool expected = false;
+        if (!connect_completed->compare_exchange_strong(expected, true)) {
+          return; // Already handled by timeout or on_error
+        }
+
+        connect_timer->cancel();
+        m_state.store(ConnectionState::CONNECTED, std::memory_order_release);
+        obs::info("Connected to " + m_host + ":" + std::to_string(m_port));
+        flush_pending_requests();
+      };
+
+      auto on_error = [this, connect_timer, connect_completed,
+                       lifetime = std::weak_ptr<bool>(m_lifetime)](
+                          const boost::system::error_code &ec) {
+        if (lifetime.expired()) {
+          return;
+        }
         // Atomic CAS: only proceed if we're the first to claim completion
         bool expected = false;
         if (!connect_completed->compare_exchange_strong(expected, true)) {
@@ -189,12 +242,36 @@ void NgHttp2Client::connect() {
         } else if (prev_state == ConnectionState::CONNECTED && m_on_close) {
           m_on_close();
         }
-      });
+      };
+
+      if (m_unix_session) {
+        m_unix_session->on_connect(std::move(on_connect));
+        m_unix_session->on_error(std::move(on_error));
+      } else {
+        m_session->on_connect(
+            [on_connect = std::move(on_connect)](
+                boost::asio::ip::tcp::resolver::results_type::iterator) {
+              on_connect();
+            });
+        m_session->on_error(std::move(on_error));
+      }
 
     } catch (const std::exception &e) {
       m_state.store(ConnectionState::FAILED, std::memory_order_release);
       m_is_dead.store(true, std::memory_order_release);
       obs::error("Failed to create session: " + std::string(e.what()));
+
+      // E.g. an unusable TLS configuration; nothing else would ever
+      // answer the requests waiting for the connection
+      std::lock_guard<std::mutex> lock(m_connect_mutex);
+      while (!m_pending_requests.empty()) {
+        auto &req = m_pending_requests.front();
+        req.handler(
+            astra::outcome::Result<Http2ClientResponse, Http2ClientError>::
+                Err(Http2ClientError::ConnectionFailed));
+        m_pending_requests.pop();
+      }
+
       if (m_on_error) {
         m_on_error(Http2ClientError::ConnectionFailed);
       }
@@ -214,10 +291,23 @@ bool NgHttp2Client::is_dead() const {
   return m_is_dead.load(std::memory_order_acquire);
 }
 
+uint32_t NgHttp2Client::outstanding_streams() const {
+  return m_outstanding->load(std::memory_order_relaxed);
+}
+
 void NgHttp2Client::submit(const std::string &method, const std::string &path,
                            const std::string &body,
                            const std::map<std::string, std::string> &headers,
                            ResponseHandler handler) {
+  // Every path below runs the handler exactly once
+  m_outstanding->fetch_add(1, std::memory_order_relaxed);
+  handler = [outstanding = m_outstanding, handler = std::move(handler)](
+                astra::outcome::Result<Http2ClientResponse, Http2ClientError>
+                    result) {
+    outstanding->fetch_sub(1, std::memory_order_relaxed);
+    handler(std::move(result));
+  };
+
   ConnectionState current = m_state.load(std::memory_order_acquire);
 
   if (current == ConnectionState::FAILED) {
@@ -241,10 +331,16 @@ void NgHttp2Client::submit(const std::string &method, const std::string &path,
 }
 
 void NgHttp2Client::flush_pending_requests() {
-  std::lock_guard<std::mutex> lock(m_connect_mutex);
-  while (!m_pending_requests.empty()) {
-    auto req = std::move(m_pending_requests.front());
-    m_pending_requests.pop();
+  // Runs on the io thread, where do_submit() submits inline; taken out of
+  // the queue first so a handler that fails right away can submit again
+  std::queue<PendingRequest> pending;
+  {
+    std::lock_guard<std::mutex> lock(m_connect_mutex);
+    pending.swap(m_pending_requests);
+  }
+  while (!pending.empty()) {
+    auto req = std::move(pending.front());
+    pending.pop();
     do_submit(req.method, req.path, req.body, req.headers, req.handler);
   }
 }
@@ -253,8 +349,18 @@ void NgHttp2Client::do_submit(const std::string &method,
                               const std::string &path, const std::string &body,
                               const std::map<std::string, std::string> &headers,
                               ResponseHandler handler) {
-  boost::asio::post(m_io_context, [this, method, path, body, headers,
-                                   handler]() {
+  // Inline when already on the io thread: a bound client called from its
+  // own io_context, or requests flushed once connected
+  boost::asio::dispatch(m_io_context, [this, method, path, body, headers,
+                                       handler,
+                                       lifetime = std::weak_ptr<bool>(
+                                           m_lifetime)]() {
+    if (lifetime.expired()) {
+      handler(
+          astra::outcome::Result<Http2ClientResponse, Http2ClientError>::Err(
+              Http2ClientError::NotConnected));
+      return;
+    }
     if (m_state.load(std::memory_order_acquire) != ConnectionState::CONNECTED) {
       obs::debug("do_submit: returning error - not connected");
       handler(
@@ -271,9 +377,7 @@ void NgHttp2Client::do_submit(const std::string &method,
                          nghttp2::asio_http2::header_value{kv.second, false});
     }
 
-    std::string uri = "http://" + m_host + ":" + std::to_string(m_port) + path;
-
-    if (!m_session) {
+    if (!m_session && !m_unix_session) {
       obs::debug("do_submit: m_session is nullptr!");
       handler(
           astra::outcome::Result<Http2ClientResponse, Http2ClientError>::Err(
@@ -281,92 +385,103 @@ void NgHttp2Client::do_submit(const std::string &method,
       return;
     }
 
-    auto req = m_session->submit(ec, method, uri, body, ng_headers);
-
-    if (ec) {
-      obs::debug("do_submit: submit failed - ec=" + std::to_string(ec.value()) +
-                 " msg=" + ec.message());
+    if (m_unix_session) {
+      auto *req = m_unix_session->submit(ec, method, path, body, ng_headers);
+      watch_response(ec, req, handler);
+    } else {
+      // nghttp2-asio sends the uri's scheme as :scheme
+      std::string uri = std::string(m_tls ? "https://" : "http://") + m_host +
+                        ":" + std::to_string(m_port) + path;
+      auto *req = m_session->submit(ec, method, uri, body, ng_headers);
+      watch_response(ec, req, handler);
+    }
+  });
+}
 
-      if (ec.value() == 2) {
-        obs::info("Connection closed by peer - will reconnect on next request");
-        m_state.store(ConnectionState::DISCONNECTED, std::memory_order_release);
-        m_is_dead.store(true, std::memory_order_release);
-        m_session.reset();
-        if (m_on_close) {
-          m_on_close();
-        }
+// Request is nghttp2-asio's client request or UnixClientRequest
+template <typename Request>
+void NgHttp2Client::watch_response(const boost::system::error_code &ec,
+                                   const Request *req,
+                                   const ResponseHandler &handler) {
+  if (ec) {
+    obs::debug("do_submit: submit failed - ec=" + std::to_string(ec.value()) +
+               " msg=" + ec.message());
+
+    if (ec.value() == 2 || ec == boost::asio::error::not_connected) {
+      obs::info("Connection closed by peer - will reconnect on next request");
+      m_state.store(ConnectionState::DISCONNECTED, std::memory_order_release);
+      m_is_dead.store(true, std::memory_order_release);
+      reset_session();
+      if (m_on_close) {
+        m_on_close();
       }
+    }
+
+    handler(astra::outcome::Result<Http2ClientResponse, Http2ClientError>::Err(
+        Http2ClientError::SubmitFailed));
+    return;
+  }
+
+  if (!req) {
+    obs::debug("do_submit: submit returned nullptr but no error code!");
+    handler(astra::outcome::Result<Http2ClientResponse, Http2ClientError>::Err(
+        Http2ClientError::SubmitFailed));
+    return;
+  }
+
+  uint32_t timeout_ms = m_config.request_timeout_ms() > 0
+                            ? m_config.request_timeout_ms()
+                            : 10000;
+  auto timer = std::make_shared<boost::asio::deadline_timer>(m_io_context);
+  timer->expires_from_now(boost::posix_time::milliseconds(timeout_ms));
+
+  auto stream = std::make_shared<ResponseStream>();
 
+  timer->async_wait([req, stream,
+                     handler](const boost::system::error_code &ec) {
+    if (!ec && !stream->completed) {
+      stream->completed = true;
+      req->cancel(NGHTTP2_CANCEL);
       handler(
           astra::outcome::Result<Http2ClientResponse, Http2ClientError>::Err(
-              Http2ClientError::SubmitFailed));
-      return;
+              Http2ClientError::RequestTimeout));
     }
+  });
 
-    if (!req) {
-      obs::debug("do_submit: submit returned nullptr but no error code!");
-      handler(
-          astra::outcome::Result<Http2ClientResponse, Http2ClientError>::Err(
-              Http2ClientError::SubmitFailed));
-      return;
+  req->on_response([stream](const auto &res) {
+    stream->status_code = res.status_code();
+
+    for (const auto &kv : res.header()) {
+      stream->headers[kv.first] = kv.second.value;
     }
 
-    uint32_t timeout_ms = m_config.request_timeout_ms() > 0
-                              ? m_config.request_timeout_ms()
-                              : 10000;
-    auto timer = std::make_shared<boost::asio::deadline_timer>(m_io_context);
-    timer->expires_from_now(boost::posix_time::milliseconds(timeout_ms));
-
-    auto stream = std::make_shared<ResponseStream>();
-
-    timer->async_wait([req, stream,
-                       handler](const boost::system::error_code &ec) {
-      if (!ec && !stream->completed) {
-        stream->completed = true;
-        req->cancel(NGHTTP2_CANCEL);
-        handler(
-            astra::outcome::Result<Http2ClientResponse, Http2ClientError>::Err(
-                Http2ClientError::RequestTimeout));
+    res.on_data([stream](const uint8_t *data, std::size_t len) {
+      if (len > 0) {
+        stream->body.append(reinterpret_cast<const char *>(data), len);
       }
     });
+  });
 
-    req->on_response(
-        [stream](const nghttp2::asio_http2::client::response &res) {
-          stream->status_code = res.status_code();
-
-          for (const auto &kv : res.header()) {
-            stream->headers[kv.first] = kv.second.value;
-          }
-
-          res.on_data([stream](const uint8_t *data, std::size_t len) {
-            if (len > 0) {
-              stream->body.append(reinterpret_cast<const char *>(data), len);
-            }
-          });
-        });
-
-    req->on_close([stream, timer, handler](uint32_t error_code) {
-      if (stream->completed) {
-        return;
-      }
+  req->on_close([stream, timer, handler](uint32_t error_code) {
+    if (stream->completed) {
+      return;
+    }
 
-      timer->cancel();
-      stream->completed = true;
+    timer->cancel();
+    stream->completed = true;
 
-      if (error_code != 0) {
-        obs::debug("on_close: Stream closed with error code " +
-                   std::to_string(error_code));
-        handler(
-            astra::outcome::Result<Http2ClientResponse, Http2ClientError>::Err(
-                Http2ClientError::StreamClosed));
-      } else {
-        handler(
-            astra::outcome::Result<Http2ClientResponse, Http2ClientError>::Ok(
-                Http2ClientResponse(stream->status_code,
-                                    std::move(stream->body),
-                                    std::move(stream->headers))));
-      }
-    });
+    if (error_code != 0) {
+      obs::debug("on_close: Stream closed with error code " +
+                 std::to_string(error_code));
+      handler(
+          astra::outcome::Result<Http2ClientResponse, Http2ClientError>::Err(
+              Http2ClientError::StreamClosed));
+    } else {
+      handler(
+          astra::outcome::Result<Http2ClientResponse, Http2ClientError>::Ok(
+              Http2ClientResponse(stream->status_code, std::move(stream->body),
+                                  std::move(stream->headers))));
+    }
   });
 }
 
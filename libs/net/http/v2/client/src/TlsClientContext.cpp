@@ -0,0 +1,198 @@
+#include "TlsClientContext.h"
+
+#include <Metrics.h>
+#include <boost/asio/ssl/error.hpp>
+#include <boost/asio/ssl/host_name_verification.hpp>
+#include <nghttp2/asio_http2_client.h>
+#include <openssl/err.h>
+
+namespace astra::http2 {
+
+namespace {
+
+struct Handles {
+  obs::Histogram handshake = obs::register_histogram(
+      "http2.client.tls.handshake", obs::Unit::Milliseconds);
+  obs::Counter full = obs::register_counter("http2.client.tls.handshakes.full");
+  obs::Counter resumed =
+      obs::register_counter("http2.client.tls.handshakes.resumed");
+};
+
+const Handles &handles() {
+  static const Handles instance;
+  return instance;
+}
+
+// Start of the handshake of one connection, kept on its SSL
+struct Handshake {
+  std::chrono::steady_clock::time_point start;
+  bool done{false};
+};
+
+void free_handshake(void *, void *ptr, CRYPTO_EX_DATA *, int, long, void *) {
+  delete static_cast<Handshake *>(ptr);
+}
+
+int handshake_index() {
+  static const int index =
+      SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, free_handshake);
+  return index;
+}
+
+int context_index() {
+  static const int index =
+      SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+  return index;
+}
+
+TlsClientContext *owner(const SSL *ssl) {
+  return static_cast<TlsClientContext *>(
+      SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), context_index()));
+}
+
+[[noreturn]] void throw_openssl_error() {
+  throw boost::system::system_error(static_cast<int>(ERR_get_error()),
+                                    boost::asio::error::get_ssl_category());
+}
+
+} // namespace
+
+TlsClientContext::TlsClientContext(const ::http2::ClientTlsConfig &config,
+                                   std::string host)
+    : m_config(config), m_host(std::move(host)) {
+  handles();
+}
+
+TlsClientContext::~TlsClientContext() {
+  if (m_session) {
+    SSL_SESSION_free(m_session);
+  }
+}
+
+boost::asio::ssl::context &TlsClientContext::context() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (!m_context) {
+    m_context = build();
+  }
+  return *m_context;
+}
+
+std::unique_ptr<boost::asio::ssl::context> TlsClientContext::build() const {
+  auto context = std::make_unique<boost::asio::ssl::context>(
+      boost::asio::ssl::context::tls_client);
+  if (m_config.insecure_skip_verify()) {
+    context->set_verify_mode(boost::asio::ssl::verify_none);
+  } else {
+    if (m_config.ca_file().empty()) {
+      context->set_default_verify_paths();
+    } else {
+      context->load_verify_file(m_config.ca_file());
+    }
+    context->set_verify_mode(boost::asio::ssl::verify_peer);
+    context->set_verify_callback(
+        boost::asio::ssl::host_name_verification(m_host));
+  }
+
+  boost::system::error_code ec;
+  if (nghttp2::asio_http2::client::configure_tls_context(ec, *context)) {
+    throw boost::system::system_error(ec);
+  }
+
+  SSL_CTX *native = context->native_handle();
+  if (!m_config.cipher_list().empty() &&
+      SSL_CTX_set_cipher_list(native, m_config.cipher_list().c_str()) != 1) {
+    throw_openssl_error();
+  }
+  if (!m_config.ciphersuites().empty() &&
+      SSL_CTX_set_ciphersuites(native, m_config.ciphersuites().c_str()) !=
+          1) {
+    throw_openssl_error();
+  }
+
+  // OpenSSL keeps no client sessions by itself; on_new_session() holds on
+  // to the latest and on_info() hands it to the next handshake
+  if (!m_config.disable_session_resumption()) {
+    SSL_CTX_set_session_cache_mode(native, SSL_SESS_CACHE_CLIENT |
+                                               SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_sess_set_new_cb(native, &TlsClientContext::on_new_session);
+  }
+  SSL_CTX_set_ex_data(native, context_index(),
+                      const_cast<TlsClientContext *>(this));
+  SSL_CTX_set_info_callback(native, &TlsClientContext::on_info);
+  return context;
+}
+
+bool TlsClientContext::has_session() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_session != nullptr;
+}
+
+// Runs on the io thread of the connection
+void TlsClientContext::on_info(const SSL *ssl, int where, int) {
+  auto now = std::chrono::steady_clock::now();
+  auto *self = owner(ssl);
+  auto *handshake =
+      static_cast<Handshake *>(SSL_get_ex_data(ssl, handshake_index()));
+  if (where & SSL_CB_HANDSHAKE_START) {
+    // Before the ClientHello is written, the only point nghttp2-asio
+    // leaves to set the session on a connection it creates
+    if (!handshake) {
+      auto *mutable_ssl = const_cast<SSL *>(ssl);
+      SSL_set_ex_data(mutable_ssl, handshake_index(), new Handshake{now});
+      if (self) {
+        self->offer_session(mutable_ssl);
+      }
+    }
+    return;
+  }
+  // TLS 1.3 reports post-handshake messages, such as the session tickets,
+  // as handshakes too; only the first one counts
+  if (!(where & SSL_CB_HANDSHAKE_DONE) || !handshake || handshake->done) {
+    return;
+  }
+  handshake->done = true;
+  if (self) {
+    self->handshake_done(ssl, now - handshake->start);
+  }
+}
+
+int TlsClientContext::on_new_session(SSL *ssl, SSL_SESSION *session) {
+  auto *self = owner(ssl);
+  // A copy: OpenSSL marks the connection's own session as not resumable
+  // when the connection is freed without a TLS shutdown, which is how
+  // nghttp2-asio closes it
+  SSL_SESSION *copy = self ? SSL_SESSION_dup(session) : nullptr;
+  if (!copy) {
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock(self->m_mutex);
+  if (self->m_session) {
+    SSL_SESSION_free(self->m_session);
+  }
+  self->m_session = copy;
+  // OpenSSL keeps its reference to `session`
+  return 0;
+}
+
+void TlsClientContext::offer_session(SSL *ssl) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_session && SSL_SESSION_is_resumable(m_session)) {
+    SSL_set_session(ssl, m_session);
+  }
+}
+
+void TlsClientContext::handshake_done(
+    const SSL *ssl, std::chrono::steady_clock::duration took) {
+  const auto &h = handles();
+  h.handshake.record(
+      std::chrono::duration<double, std::milli>(took).count());
+  if (SSL_session_reused(ssl)) {
+    m_resumed.fetch_add(1, std::memory_order_relaxed);
+    h.resumed.inc();
+  } else {
+    m_full.fetch_add(1, std::memory_order_relaxed);
+    h.full.inc();
+  }
+}
+
+} // namespace astra::http2
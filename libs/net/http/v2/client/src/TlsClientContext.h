@@ -0,0 +1,69 @@
+#pragma once
+
+#include "http2client.pb.h"
+
+#include <atomic>
+#include <boost/asio/ssl/context.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <openssl/ssl.h>
+#include <string>
+
+namespace astra::http2 {
+
+// TLS context for the connections to one host. ClientRegistry keeps it
+// across reconnects along with the last session the host handed out, which
+// the next handshake offers again, so a reconnect resumes instead of paying
+// for a full handshake. Handshakes are recorded as
+//   http2.client.tls.handshake            start to finish, in ms
+//   http2.client.tls.handshakes.full      ones that negotiated new keys
+//   http2.client.tls.handshakes.resumed   ones that resumed a session
+//
+// Must outlive every connection made with context(). Safe to share between
+// threads.
+class TlsClientContext {
+public:
+  TlsClientContext(const ::http2::ClientTlsConfig &config, std::string host);
+  ~TlsClientContext();
+
+  TlsClientContext(const TlsClientContext &) = delete;
+  TlsClientContext &operator=(const TlsClientContext &) = delete;
+
+  // Built on first use: h2 through ALPN, the configured ciphers and peer
+  // verification against `host`. Throws boost::system::system_error when
+  // the configuration is unusable, e.g. a missing CA file; the next call
+  // tries again.
+  boost::asio::ssl::context &context();
+
+  // Whether a session is held for the next handshake to resume
+  [[nodiscard]] bool has_session() const;
+
+  [[nodiscard]] uint64_t full_handshakes() const noexcept {
+    return m_full.load(std::memory_order_relaxed);
+  }
+  [[nodiscard]] uint64_t resumed_handshakes() const noexcept {
+    return m_resumed.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::unique_ptr<boost::asio::ssl::context> build() const;
+
+  static void on_info(const SSL *ssl, int where, int ret);
+  static int on_new_session(SSL *ssl, SSL_SESSION *session);
+  void offer_session(SSL *ssl);
+  void handshake_done(const SSL *ssl,
+                      std::chrono::steady_clock::duration took);
+
+  ::http2::ClientTlsConfig m_config;
+  std::string m_host;
+  mutable std::mutex m_mutex;
+  std::unique_ptr<boost::asio::ssl::context> m_context;
+  // Owned reference, guarded by m_mutex
+  SSL_SESSION *m_session{nullptr};
+  std::atomic<uint64_t> m_full{0};
+  std::atomic<uint64_t> m_resumed{0};
+};
+
+} // namespace astra::http2
@@ -0,0 +1,398 @@
+#include "UnixSocketSession.h"
+
+#include <Log.h>
+#include <SessionIo.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <nghttp2/nghttp2.h>
+#include <vector>
+
+namespace astra::http2 {
+
+namespace {
+
+using local = boost::asio::local::stream_protocol;
+
+nghttp2_nv make_nv(const std::string &name, const std::string &value) {
+  return nghttp2_nv{
+      reinterpret_cast<uint8_t *>(const_cast<char *>(name.data())),
+      reinterpret_cast<uint8_t *>(const_cast<char *>(value.data())),
+      name.size(), value.size(), NGHTTP2_NV_FLAG_NONE};
+}
+
+} // namespace
+
+struct UnixClientStream {
+  UnixClientStream(UnixSocketSession::Impl &s)
+      : session(s), request(*this), response(*this) {
+  }
+
+  UnixSocketSession::Impl &session;
+  int32_t id{-1};
+
+  std::string body;
+  size_t body_offset{0};
+
+  int status{0};
+  nghttp2::asio_http2::header_map headers;
+  UnixClientRequest::ResponseCallback on_response;
+  nghttp2::asio_http2::data_cb on_data;
+  nghttp2::asio_http2::close_cb on_close;
+
+  UnixClientRequest request;
+  UnixClientResponse response;
+};
+
+class UnixSocketSession::Impl
+    : public std::enable_shared_from_this<Impl>,
+      public SessionIo<UnixSocketSession::Impl, local::socket> {
+public:
+  explicit Impl(boost::asio::io_context &ioc) : SessionIo(local::socket(ioc)) {
+  }
+
+  ~Impl() {
+    if (m_session) {
+      nghttp2_session_del(m_session);
+    }
+  }
+
+  void connect(const std::string &path);
+  const UnixClientRequest *submit(boost::system::error_code &ec,
+                                  const std::string &method,
+                                  const std::string &path, std::string body,
+                                  nghttp2::asio_http2::header_map h);
+  void cancel(UnixClientStream &stream, uint32_t error_code);
+  void shutdown();
+  // Closes without running callbacks; the owning session is going away
+  void stop();
+
+  nghttp2_session *nghttp2() const {
+    return m_session;
+  }
+  void on_io_closed(const boost::system::error_code &ec);
+
+  ConnectCallback m_on_connect;
+  nghttp2::asio_http2::error_cb m_on_error;
+
+private:
+  friend struct UnixClientCallbacks;
+
+  bool start_session();
+  void close_streams(uint32_t error_code);
+
+  nghttp2_session *m_session{nullptr};
+  std::map<int32_t, std::unique_ptr<UnixClientStream>> m_streams;
+  bool m_connected{false};
+  bool m_stopped{false};
+};
+
+// libnghttp2 callbacks; `user_data` is the session Impl
+struct UnixClientCallbacks {
+  using Impl = UnixSocketSession::Impl;
+
+  static Impl &self(void *user_data) {
+    return *static_cast<Impl *>(user_data);
+  }
+
+  static UnixClientStream *find(Impl &impl, int32_t stream_id) {
+    auto it = impl.m_streams.find(stream_id);
+    return it == impl.m_streams.end() ? nullptr : it->second.get();
+  }
+
+  static int on_header(nghttp2_session *, const nghttp2_frame *frame,
+                       const uint8_t *name, size_t namelen,
+                       const uint8_t *value, size_t valuelen, uint8_t,
+                       void *user_data) {
+    if (frame->hd.type != NGHTTP2_HEADERS ||
+        frame->headers.cat != NGHTTP2_HCAT_RESPONSE) {
+      return 0;
+    }
+    auto *stream = find(self(user_data), frame->hd.stream_id);
+    if (!stream) {
+      return 0;
+    }
+    std::string_view n(reinterpret_cast<const char *>(name), namelen);
+    std::string v(reinterpret_cast<const char *>(value), valuelen);
+    if (n == ":status") {
+      stream->status = std::atoi(v.c_str());
+    } else if (!n.empty() && n.front() != ':') {
+      stream->headers.emplace(std::string(n),
+                              nghttp2::asio_http2::header_value{v, false});
+    }
+    return 0;
+  }
+
+  static int on_data_chunk(nghttp2_session *, uint8_t, int32_t stream_id,
+                           const uint8_t *data, size_t len, void *user_data) {
+    auto *stream = find(self(user_data), stream_id);
+    if (stream && stream->on_data) {
+      stream->on_data(data, len);
+    }
+    return 0;
+  }
+
+  static int on_frame_recv(nghttp2_session *, const nghttp2_frame *frame,
+                           void *user_data) {
+    if (frame->hd.type != NGHTTP2_HEADERS &&
+        frame->hd.type != NGHTTP2_DATA) {
+      return 0;
+    }
+    auto *stream = find(self(user_data), frame->hd.stream_id);
+    if (!stream) {
+      return 0;
+    }
+    if (frame->hd.type == NGHTTP2_HEADERS &&
+        frame->headers.cat == NGHTTP2_HCAT_RESPONSE &&
+        stream->on_response) {
+      stream->on_response(stream->response);
+    }
+    if ((frame->hd.flags & NGHTTP2_FLAG_END_STREAM) && stream->on_data) {
+      stream->on_data(nullptr, 0);
+    }
+    return 0;
+  }
+
+  static int on_stream_close(nghttp2_session *, int32_t stream_id,
+                             uint32_t error_code, void *user_data) {
+    auto &impl = self(user_data);
+    auto it = impl.m_streams.find(stream_id);
+    if (it == impl.m_streams.end()) {
+      return 0;
+    }
+    auto stream = std::move(it->second);
+    impl.m_streams.erase(it);
+    if (stream->on_close) {
+      stream->on_close(error_code);
+    }
+    return 0;
+  }
+
+  static ssize_t read_body(nghttp2_session *, int32_t stream_id, uint8_t *buf,
+                           size_t length, uint32_t *data_flags,
+                           nghttp2_data_source *, void *user_data) {
+    auto *stream = find(self(user_data), stream_id);
+    if (!stream) {
+      return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+    }
+    size_t n = std::min(length, stream->body.size() - stream->body_offset);
+    std::memcpy(buf, stream->body.data() + stream->body_offset, n);
+    stream->body_offset += n;
+    if (stream->body_offset == stream->body.size()) {
+      *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+    }
+    return static_cast<ssize_t>(n);
+  }
+};
+
+void UnixSocketSession::Impl::connect(const std::string &path) {
+  socket().async_connect(
+      local::endpoint(path),
+      [self = shared_from_this()](const boost::system::error_code &ec) {
+        if (self->m_stopped) {
+          return;
+        }
+        if (ec) {
+          self->close_io(ec);
+          return;
+        }
+        if (!self->start_session()) {
+          self->close_io(boost::asio::error::connection_aborted);
+          return;
+        }
+        self->m_connected = true;
+        if (self->m_on_connect) {
+          self->m_on_connect();
+        }
+        self->start_io();
+      });
+}
+
+bool UnixSocketSession::Impl::start_session() {
+  nghttp2_session_callbacks *callbacks;
+  nghttp2_session_callbacks_new(&callbacks);
+  nghttp2_session_callbacks_set_on_header_callback(
+      callbacks, &UnixClientCallbacks::on_header);
+  nghttp2_session_callbacks_set_on_data_chunk_recv_callback(
+      callbacks, &UnixClientCallbacks::on_data_chunk);
+  nghttp2_session_callbacks_set_on_frame_recv_callback(
+      callbacks, &UnixClientCallbacks::on_frame_recv);
+  nghttp2_session_callbacks_set_on_stream_close_callback(
+      callbacks, &UnixClientCallbacks::on_stream_close);
+  int rv = nghttp2_session_client_new(&m_session, callbacks, this);
+  nghttp2_session_callbacks_del(callbacks);
+  if (rv != 0) {
+    return false;
+  }
+
+  nghttp2_settings_entry settings[] = {{NGHTTP2_SETTINGS_ENABLE_PUSH, 0}};
+  return nghttp2_submit_settings(m_session, NGHTTP2_FLAG_NONE, settings,
+                                 std::size(settings)) == 0;
+}
+
+const UnixClientRequest *UnixSocketSession::Impl::submit(
+    boost::system::error_code &ec, const std::string &method,
+    const std::string &path, std::string body,
+    nghttp2::asio_http2::header_map h) {
+  ec.clear();
+  if (!m_connected || is_closed()) {
+    ec = boost::asio::error::not_connected;
+    return nullptr;
+  }
+
+  std::vector<std::pair<std::string, std::string>> fields;
+  fields.reserve(h.size() + 4);
+  fields.emplace_back(":method", method);
+  fields.emplace_back(":scheme", "http");
+  fields.emplace_back(":authority", "localhost");
+  fields.emplace_back(":path", path);
+  for (auto &[key, value] : h) {
+    std::string name = key;
+    std::transform(name.begin(), name.end(), name.begin(), [](char c) {
+      return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    });
+    fields.emplace_back(std::move(name), std::move(value.value));
+  }
+  std::vector<nghttp2_nv> nva;
+  nva.reserve(fields.size());
+  for (const auto &[name, value] : fields) {
+    nva.push_back(make_nv(name, value));
+  }
+
+  auto stream = std::make_unique<UnixClientStream>(*this);
+  stream->body = std::move(body);
+  nghttp2_data_provider provider{};
+  provider.read_callback = &UnixClientCallbacks::read_body;
+  // read_body() finds the stream by the id returned here; it only runs
+  // from mem_send, after the stream is in m_streams
+  int32_t stream_id =
+      nghttp2_submit_request(m_session, nullptr, nva.data(), nva.size(),
+                             stream->body.empty() ? nullptr : &provider,
+                             nullptr);
+  if (stream_id < 0) {
+    ec = boost::system::errc::make_error_code(
+        boost::system::errc::protocol_error);
+    return nullptr;
+  }
+  stream->id = stream_id;
+  auto &inserted = m_streams[stream_id];
+  inserted = std::move(stream);
+  signal_write();
+  return &inserted->request;
+}
+
+void UnixSocketSession::Impl::cancel(UnixClientStream &stream,
+                                     uint32_t error_code) {
+  if (is_closed() || !m_session) {
+    return;
+  }
+  nghttp2_submit_rst_stream(m_session, NGHTTP2_FLAG_NONE, stream.id,
+                            error_code);
+  signal_write();
+}
+
+void UnixSocketSession::Impl::shutdown() {
+  if (is_closed() || !m_session) {
+    return;
+  }
+  nghttp2_session_terminate_session(m_session, NGHTTP2_NO_ERROR);
+  signal_write();
+}
+
+void UnixSocketSession::Impl::stop() {
+  m_stopped = true;
+  m_on_connect = nullptr;
+  m_on_error = nullptr;
+  close_io(boost::asio::error::operation_aborted);
+  m_streams.clear();
+}
+
+void UnixSocketSession::Impl::on_io_closed(
+    const boost::system::error_code &ec) {
+  m_connected = false;
+  if (m_stopped) {
+    return;
+  }
+  close_streams(NGHTTP2_INTERNAL_ERROR);
+  if (auto on_error = std::move(m_on_error)) {
+    on_error(ec);
+  }
+}
+
+void UnixSocketSession::Impl::close_streams(uint32_t error_code) {
+  auto streams = std::move(m_streams);
+  m_streams.clear();
+  for (auto &[id, stream] : streams) {
+    if (stream->on_close) {
+      stream->on_close(error_code);
+    }
+  }
+}
+
+int UnixClientResponse::status_code() const {
+  return m_stream.status;
+}
+
+const nghttp2::asio_http2::header_map &UnixClientResponse::header() const {
+  return m_stream.headers;
+}
+
+void UnixClientResponse::on_data(nghttp2::asio_http2::data_cb cb) const {
+  m_stream.on_data = std::move(cb);
+}
+
+void UnixClientRequest::on_response(ResponseCallback cb) const {
+  m_stream.on_response = std::move(cb);
+}
+
+void UnixClientRequest::on_close(nghttp2::asio_http2::close_cb cb) const {
+  m_stream.on_close = std::move(cb);
+}
+
+void UnixClientRequest::cancel(uint32_t error_code) const {
+  m_stream.session.cancel(m_stream, error_code);
+}
+
+std::optional<std::string>
+UnixSocketSession::socket_path(const std::string &host) {
+  if (host.compare(0, URI_SCHEME.size(), URI_SCHEME) != 0 ||
+      host.size() == URI_SCHEME.size()) {
+    return std::nullopt;
+  }
+  return host.substr(URI_SCHEME.size());
+}
+
+UnixSocketSession::UnixSocketSession(boost::asio::io_context &io_context,
+                                     const std::string &path)
+    : m_impl(std::make_shared<Impl>(io_context)) {
+  m_impl->connect(path);
+}
+
+UnixSocketSession::~UnixSocketSession() {
+  m_impl->stop();
+}
+
+void UnixSocketSession::on_connect(ConnectCallback cb) const {
+  m_impl->m_on_connect = std::move(cb);
+}
+
+void UnixSocketSession::on_error(nghttp2::asio_http2::error_cb cb) const {
+  m_impl->m_on_error = std::move(cb);
+}
+
+const UnixClientRequest *
+UnixSocketSession::submit(boost::system::error_code &ec,
+                          const std::string &method, const std::string &path,
+                          std::string body,
+                          nghttp2::asio_http2::header_map h) const {
+  return m_impl->submit(ec, method, path, std::move(body), std::move(h));
+}
+
+void UnixSocketSession::shutdown() const {
+  m_impl->shutdown();
+}
+
+} // namespace astra::http2
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <boost/asio.hpp>
+#include <functional>
+#include <memory>
+#include <nghttp2/asio_http2.h>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace astra::http2 {
+
+struct UnixClientStream;
+
+// Response and request of one stream sent over a Unix domain socket. They
+// mirror the nghttp2-asio client response and request, so NgHttp2Client
+// handles both transports alike. Valid until the on_close callback has
+// run; use only on the session's io thread.
+class UnixClientResponse {
+public:
+  explicit UnixClientResponse(UnixClientStream &stream) : m_stream(stream) {
+  }
+
+  int status_code() const;
+  const nghttp2::asio_http2::header_map &header() const;
+  // Called with each DATA chunk, then with a zero length at the end
+  void on_data(nghttp2::asio_http2::data_cb cb) const;
+
+private:
+  UnixClientStream &m_stream;
+};
+
+class UnixClientRequest {
+public:
+  using ResponseCallback = std::function<void(const UnixClientResponse &)>;
+
+  explicit UnixClientRequest(UnixClientStream &stream) : m_stream(stream) {
+  }
+
+  void on_response(ResponseCallback cb) const;
+  void on_close(nghttp2::asio_http2::close_cb cb) const;
+  void cancel(uint32_t error_code) const;
+
+private:
+  UnixClientStream &m_stream;
+};
+
+// Client side of HTTP/2 over a Unix domain socket, prior knowledge h2c
+// driven by libnghttp2 since nghttp2-asio only connects over TCP.
+// Connecting starts on construction; register on_connect() and on_error()
+// right after, before the io_context runs them. All calls belong on the
+// io thread.
+class UnixSocketSession {
+public:
+  using ConnectCallback = std::function<void()>;
+
+  static constexpr std::string_view URI_SCHEME = "unix://";
+
+  // The socket path of a unix:///path host, nullopt for any other host
+  static std::optional<std::string> socket_path(const std::string &host);
+
+  UnixSocketSession(boost::asio::io_context &io_context,
+                    const std::string &path);
+  // Drops the connection without running any further callback
+  ~UnixSocketSession();
+
+  UnixSocketSession(const UnixSocketSession &) = delete;
+  UnixSocketSession &operator=(const UnixSocketSession &) = delete;
+
+  void on_connect(ConnectCallback cb) const;
+  // Connect failures and, once connected, the connection going away
+  void on_error(nghttp2::asio_http2::error_cb cb) const;
+
+  // Returns nullptr and sets `ec` when the request could not be sent, e.g.
+  // with boost::asio::error::not_connected once the connection is gone
+  const UnixClientRequest *submit(boost::system::error_code &ec,
+                                  const std::string &method,
+                                  const std::string &path,
+                                  std::string body,
+                                  nghttp2::asio_http2::header_map h) const;
+
+  // Sends GOAWAY and closes once the streams in flight have finished
+  void shutdown() const;
+
+  class Impl;
+
+private:
+  std::shared_ptr<Impl> m_impl;
+};
+
+} // namespace astra::http2
@@ -2,11 +2,20 @@
 #include "Http2Client.h"
 #include "Http2ClientError.h"
 #include "Http2ClientResponse.h"
+#include "IoContextClients.h"
 #include "NgHttp2Client.h"
 
+#include <Http2Server.h>
+#include <HttpMethod.h>
+#include <Router.h>
+
 #include <atomic>
+#include <boost/asio.hpp>
 #include <chrono>
+#include <future>
+#include <mutex>
 #include <gtest/gtest.h>
+#include <set>
 #include <thread>
 #include <vector>
 
@@ -285,6 +294,174 @@ TEST_F(Http2ClientTest, SubmitWithSpecialCharactersInPath) {
   }
 }
 
+TEST_F(Http2ClientTest, BoundIoContextRunsExchangeOnCallingThread) {
+  auto ioc = std::make_shared<boost::asio::io_context>();
+  auto work = boost::asio::make_work_guard(*ioc);
+  std::thread io_thread([ioc] {
+    ioc->run();
+  });
+
+  Http2Client client(m_config);
+  client.bind_io_contexts({ioc});
+
+  std::promise<std::thread::id> handled_on;
+  boost::asio::post(*ioc, [&] {
+    client.submit("127.0.0.1", 19999, "GET", "/test", "", {},
+                  [&](auto result) {
+                    EXPECT_TRUE(result.is_err());
+                    handled_on.set_value(std::this_thread::get_id());
+                  });
+  });
+
+  EXPECT_EQ(handled_on.get_future().get(), io_thread.get_id());
+  work.reset();
+  ioc->stop();
+  io_thread.join();
+}
+
+TEST_F(Http2ClientTest, DestroyedClientIsUnboundFromIoContext) {
+  auto ioc = std::make_shared<boost::asio::io_context>();
+  auto &clients = IoContextClients::of(*ioc);
+
+  {
+    Http2Client first(m_config);
+    Http2Client second(m_config);
+    first.bind_io_contexts({ioc});
+    second.bind_io_contexts({ioc});
+    ioc->run();
+    ioc->restart();
+    EXPECT_EQ(clients.size(), 2u);
+  }
+
+  ioc->run();
+  EXPECT_EQ(clients.size(), 0u);
+}
+
+TEST_F(Http2ClientTest, UnboundThreadUsesClientIoThread) {
+  auto ioc = std::make_shared<boost::asio::io_context>();
+  auto work = boost::asio::make_work_guard(*ioc);
+  std::thread io_thread([ioc] {
+    ioc->run();
+  });
+
+  Http2Client client(m_config);
+
+  std::promise<std::thread::id> handled_on;
+  boost::asio::post(*ioc, [&] {
+    client.submit("127.0.0.1", 19999, "GET", "/test", "", {},
+                  [&](auto) {
+                    handled_on.set_value(std::this_thread::get_id());
+                  });
+  });
+
+  EXPECT_NE(handled_on.get_future().get(), io_thread.get_id());
+  work.reset();
+  ioc->stop();
+  io_thread.join();
+}
+
+TEST_F(Http2ClientTest, SubmitOverUnixSocketReachesServer) {
+  const std::string path = "/tmp/astra_http2_client_test.sock";
+  astra::router::Router router;
+  router.add(astra::router::HttpMethod::POST, "/echo", [](auto req, auto res) {
+    res->set_status(201);
+    res->set_header("X-Method", req->method());
+    res->write(req->body());
+    res->close();
+  });
+  ::http2::ServerConfig server_config;
+  server_config.set_uri("unix://" + path);
+  server_config.set_thread_count(1);
+  Http2Server server(server_config, router);
+  ASSERT_TRUE(server.start().is_ok());
+
+  m_config.set_request_timeout_ms(2000);
+  m_config.set_connect_timeout_ms(2000);
+  Http2Client client(m_config);
+  std::promise<astra::outcome::Result<Http2ClientResponse, Http2ClientError>>
+      result;
+  client.submit("unix://" + path, 0, "POST", "/echo", "ping", {},
+                [&](auto r) {
+                  result.set_value(std::move(r));
+                });
+
+  auto response = result.get_future().get();
+  ASSERT_TRUE(response.is_ok());
+  EXPECT_EQ(response.value().status_code(), 201);
+  EXPECT_EQ(response.value().body(), "ping");
+  EXPECT_EQ(response.value().header("x-method"), "POST");
+
+  server.stop();
+  server.join();
+}
+
+TEST_F(Http2ClientTest, StreamedResponseArrivesInOrder) {
+  const std::string path = "/tmp/astra_http2_client_stream.sock";
+  std::vector<std::thread> producers;
+  std::mutex producers_mutex;
+  astra::router::Router router;
+  router.add(astra::router::HttpMethod::GET, "/stream", [&](auto, auto res) {
+    // Larger than the initial 64 KiB window, so the body only gets through
+    // as the client grants more
+    std::lock_guard<std::mutex> lock(producers_mutex);
+    producers.emplace_back([res] {
+      res->set_status(200);
+      res->set_header("content-type", "text/plain");
+      res->send_headers();
+      for (int i = 0; i < 4; ++i) {
+        res->write(std::string(48 * 1024, static_cast<char>('a' + i)));
+        for (int spin = 0; spin < 500 && res->pending_bytes() > 64 * 1024;
+             ++spin) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      }
+      res->close();
+    });
+  });
+  ::http2::ServerConfig server_config;
+  server_config.set_uri("unix://" + path);
+  server_config.set_thread_count(1);
+  Http2Server server(server_config, router);
+  ASSERT_TRUE(server.start().is_ok());
+
+  m_config.set_request_timeout_ms(5000);
+  m_config.set_connect_timeout_ms(2000);
+  Http2Client client(m_config);
+  std::promise<astra::outcome::Result<Http2ClientResponse, Http2ClientError>>
+      result;
+  client.submit("unix://" + path, 0, "GET", "/stream", "", {}, [&](auto r) {
+    result.set_value(std::move(r));
+  });
+
+  auto response = result.get_future().get();
+  ASSERT_TRUE(response.is_ok());
+  EXPECT_EQ(response.value().status_code(), 200);
+  EXPECT_EQ(response.value().header("content-type"), "text/plain");
+  std::string expected;
+  for (int i = 0; i < 4; ++i) {
+    expected.append(48 * 1024, static_cast<char>('a' + i));
+  }
+  EXPECT_TRUE(response.value().body() == expected);
+
+  server.stop();
+  server.join();
+  for (auto &t : producers) {
+    t.join();
+  }
+}
+
+TEST_F(Http2ClientTest, SubmitToMissingUnixSocketFails) {
+  Http2Client client(m_config);
+  std::promise<bool> failed;
+
+  client.submit("unix:///tmp/astra_no_such_socket.sock", 0, "GET", "/", "",
+                {}, [&](auto result) {
+                  failed.set_value(result.is_err());
+                });
+
+  EXPECT_TRUE(failed.get_future().get());
+}
+
 // =============================================================================
 // Http2ClientResponse Tests
 // =============================================================================
@@ -551,6 +728,82 @@ TEST_F(ClientRegistryTest, DestructorTimingMeasurement) {
   EXPECT_LT(ms, 500);
 }
 
+TEST_F(ClientRegistryTest, PoolOpensMinConnections) {
+  m_config.mutable_pool()->set_min_connections(3);
+  ClientRegistry registry(m_config);
+
+  std::set<NgHttp2Client *> seen;
+  for (int i = 0; i < 200; i++) {
+    seen.insert(registry.get_or_create("127.0.0.1", 19999).get());
+  }
+
+  EXPECT_EQ(registry.connections("127.0.0.1", 19999), 3u);
+  EXPECT_EQ(seen.size(), 3u);
+}
+
+TEST_F(ClientRegistryTest, PoolScalesUpWhileConnectionsAreBusy) {
+  const std::string path = "/tmp/astra_http2_pool_test.sock";
+  std::mutex held_mutex;
+  std::vector<std::shared_ptr<astra::router::IResponse>> held;
+  astra::router::Router router;
+  router.add(astra::router::HttpMethod::GET, "/slow", [&](auto, auto res) {
+    std::lock_guard<std::mutex> lock(held_mutex);
+    held.push_back(res);
+  });
+  ::http2::ServerConfig server_config;
+  server_config.set_uri("unix://" + path);
+  server_config.set_thread_count(1);
+  Http2Server server(server_config, router);
+  ASSERT_TRUE(server.start().is_ok());
+
+  m_config.set_request_timeout_ms(5000);
+  m_config.set_connect_timeout_ms(2000);
+  m_config.mutable_pool()->set_max_connections(3);
+  m_config.mutable_pool()->set_scale_up_streams(2);
+  ClientRegistry registry(m_config);
+  const std::string host = "unix://" + path;
+
+  std::atomic<int> ok{0};
+  std::set<NgHttp2Client *> used;
+  for (int i = 0; i < 10; i++) {
+    auto client = registry.get_or_create(host, 0);
+    used.insert(client.get());
+    client->submit("GET", "/slow", "", {}, [&](auto result) {
+      if (result.is_ok()) {
+        ok++;
+      }
+    });
+  }
+  // Two streams make a connection busy; past three connections requests
+  // share them
+  EXPECT_EQ(registry.connections(host, 0), 3u);
+  EXPECT_EQ(used.size(), 3u);
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (std::chrono::steady_clock::now() < deadline) {
+    std::lock_guard<std::mutex> lock(held_mutex);
+    if (held.size() == 10) {
+      break;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(held_mutex);
+    ASSERT_EQ(held.size(), 10u);
+    for (auto &res : held) {
+      res->set_status(200);
+      res->close();
+    }
+  }
+  while (ok < 10 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(ok.load(), 10);
+  EXPECT_EQ(registry.get_or_create(host, 0)->outstanding_streams(), 0u);
+
+  server.stop();
+  server.join();
+}
+
 // NgHttp2Client is_dead tests
 TEST_F(NgHttp2ClientTest, IsDeadInitiallyFalse) {
   NgHttp2Client client("127.0.0.1", 19999, m_config);
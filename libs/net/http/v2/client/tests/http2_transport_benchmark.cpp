@@ -0,0 +1,268 @@
+#include "Http2Client.h"
+
+#include <Http2Server.h>
+#include <HttpMethod.h>
+#include <Router.h>
+#include <SessionServer.h>
+#include <array>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <boost/asio.hpp>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <nghttp2/nghttp2.h>
+#include <set>
+#include <string>
+
+using namespace astra::http2;
+
+// TCP loopback against a Unix domain socket: the same server, client and
+// handler, only the transport differs. Range(0) is the number of requests
+// in flight per iteration; 1 measures round-trip latency, larger values
+// throughput (items/s).
+//
+// BM_RoundTrip* go through Http2Server and Http2Client, so their TCP case
+// runs on nghttp2-asio. BM_SessionRoundTrip* serve both sockets with the
+// same SessionServer and a plain libnghttp2 client, which isolates the
+// socket itself.
+
+namespace {
+
+constexpr const char *TCP_PEER = "127.0.0.1";
+constexpr uint16_t TCP_PORT = 19311;
+constexpr const char *UNIX_PEER = "unix:///tmp/astra_transport_bench.sock";
+constexpr uint16_t SESSION_TCP_PORT = 19312;
+constexpr const char *SESSION_UNIX_PATH = "/tmp/astra_session_bench.sock";
+
+struct Peer {
+  astra::router::Router router;
+  std::unique_ptr<Http2Server> server;
+
+  explicit Peer(const std::string &uri) {
+    router.add(astra::router::HttpMethod::GET, "/ping", [](auto, auto res) {
+      res->set_status(200);
+      res->write("pong");
+      res->close();
+    });
+    ::http2::ServerConfig config;
+    config.set_uri(uri);
+    config.set_thread_count(1);
+    server = std::make_unique<Http2Server>(config, router);
+    server->start();
+  }
+
+  ~Peer() {
+    server->stop();
+    server->join();
+  }
+};
+
+void run_exchanges(benchmark::State &state, const std::string &host,
+                   uint16_t port) {
+  ::http2::ClientConfig config;
+  config.set_connect_timeout_ms(1000);
+  config.set_request_timeout_ms(5000);
+  Http2Client client(config);
+
+  const auto in_flight = static_cast<int>(state.range(0));
+  std::mutex mutex;
+  std::condition_variable cv;
+  int remaining = 0;
+  std::atomic<int> failed{0};
+
+  auto round = [&] {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      remaining = in_flight;
+    }
+    for (int i = 0; i < in_flight; ++i) {
+      client.submit(host, port, "GET", "/ping", "", {}, [&](auto result) {
+        if (result.is_err()) {
+          failed++;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--remaining == 0) {
+          cv.notify_one();
+        }
+      });
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] {
+      return remaining == 0;
+    });
+  };
+
+  // Connect outside the timed loop
+  round();
+
+  for (auto _ : state) {
+    round();
+  }
+
+  if (failed.load() > 0) {
+    state.SkipWithError("requests failed");
+  }
+  state.SetItemsProcessed(state.iterations() * in_flight);
+}
+
+// Serves GET /ping with a SessionServer on one io thread
+struct SessionPeer {
+  SessionServer server{SessionServer::Options{}};
+
+  SessionPeer() {
+    server.handle("/ping", [](const SessionRequest &,
+                              const SessionResponse &res) {
+      res.write_head(200);
+      res.end("pong");
+    });
+  }
+
+  ~SessionPeer() {
+    server.stop();
+    server.join();
+  }
+};
+
+// Blocking libnghttp2 client on the benchmark thread
+template <typename Socket> class SessionClient {
+public:
+  explicit SessionClient(const typename Socket::endpoint_type &endpoint)
+      : m_socket(m_ioc) {
+    m_socket.connect(endpoint);
+    nghttp2_session_callbacks *callbacks;
+    nghttp2_session_callbacks_new(&callbacks);
+    nghttp2_session_callbacks_set_on_header_callback(callbacks, &on_header);
+    nghttp2_session_callbacks_set_on_stream_close_callback(callbacks,
+                                                           &on_close);
+    nghttp2_session_client_new(&m_session, callbacks, this);
+    nghttp2_session_callbacks_del(callbacks);
+    nghttp2_submit_settings(m_session, NGHTTP2_FLAG_NONE, nullptr, 0);
+  }
+
+  ~SessionClient() {
+    nghttp2_session_del(m_session);
+  }
+
+  // Sends `count` GET /ping at once and waits for all of them; false when
+  // one was not answered with 200 or the connection failed
+  bool round(int count) {
+    static const std::string method = "GET", scheme = "http",
+                             authority = "localhost", path = "/ping";
+    nghttp2_nv nva[] = {nv(":method", method), nv(":scheme", scheme),
+                        nv(":authority", authority), nv(":path", path)};
+    m_closed = 0;
+    m_ok = 0;
+    for (int i = 0; i < count; ++i) {
+      nghttp2_submit_request(m_session, nullptr, nva, std::size(nva),
+                             nullptr, nullptr);
+    }
+    while (m_closed < count) {
+      const uint8_t *data;
+      ssize_t n;
+      while ((n = nghttp2_session_mem_send(m_session, &data)) > 0) {
+        boost::asio::write(m_socket,
+                           boost::asio::buffer(data, static_cast<size_t>(n)));
+      }
+      boost::system::error_code ec;
+      size_t got = m_socket.read_some(boost::asio::buffer(m_buffer), ec);
+      if (ec || nghttp2_session_mem_recv(m_session, m_buffer.data(), got) < 0) {
+        return false;
+      }
+    }
+    return m_ok == count;
+  }
+
+private:
+  static nghttp2_nv nv(const char *name, const std::string &value) {
+    return {reinterpret_cast<uint8_t *>(const_cast<char *>(name)),
+            reinterpret_cast<uint8_t *>(const_cast<char *>(value.data())),
+            std::strlen(name), value.size(), NGHTTP2_NV_FLAG_NONE};
+  }
+
+  static int on_header(nghttp2_session *, const nghttp2_frame *,
+                       const uint8_t *name, size_t namelen,
+                       const uint8_t *value, size_t valuelen, uint8_t,
+                       void *user_data) {
+    if (std::string_view(reinterpret_cast<const char *>(name), namelen) ==
+            ":status" &&
+        std::string_view(reinterpret_cast<const char *>(value), valuelen) ==
+            "200") {
+      static_cast<SessionClient *>(user_data)->m_ok++;
+    }
+    return 0;
+  }
+
+  static int on_close(nghttp2_session *, int32_t, uint32_t,
+                      void *user_data) {
+    static_cast<SessionClient *>(user_data)->m_closed++;
+    return 0;
+  }
+
+  boost::asio::io_context m_ioc;
+  Socket m_socket;
+  nghttp2_session *m_session{nullptr};
+  std::array<uint8_t, 16 * 1024> m_buffer;
+  int m_closed{0};
+  int m_ok{0};
+};
+
+template <typename Socket>
+void run_session_exchanges(benchmark::State &state,
+                           const typename Socket::endpoint_type &endpoint) {
+  SessionClient<Socket> client(endpoint);
+  const auto in_flight = static_cast<int>(state.range(0));
+
+  // Settles SETTINGS outside the timed loop
+  bool ok = client.round(1);
+
+  for (auto _ : state) {
+    ok = client.round(in_flight) && ok;
+  }
+
+  if (!ok) {
+    state.SkipWithError("requests failed");
+  }
+  state.SetItemsProcessed(state.iterations() * in_flight);
+}
+
+} // namespace
+
+static void BM_RoundTripTcpLoopback(benchmark::State &state) {
+  Peer peer("http://" + std::string(TCP_PEER) + ":" +
+            std::to_string(TCP_PORT));
+  run_exchanges(state, TCP_PEER, TCP_PORT);
+}
+BENCHMARK(BM_RoundTripTcpLoopback)->Arg(1)->Arg(64)->UseRealTime();
+
+static void BM_RoundTripUnixSocket(benchmark::State &state) {
+  Peer peer(UNIX_PEER);
+  run_exchanges(state, UNIX_PEER, 0);
+}
+BENCHMARK(BM_RoundTripUnixSocket)->Arg(1)->Arg(64)->UseRealTime();
+
+static void BM_SessionRoundTripTcpLoopback(benchmark::State &state) {
+  SessionPeer peer;
+  if (peer.server.listen_and_serve(TCP_PEER,
+                                   std::to_string(SESSION_TCP_PORT))) {
+    state.SkipWithError("listen failed");
+    return;
+  }
+  run_session_exchanges<boost::asio::ip::tcp::socket>(
+      state, {boost::asio::ip::make_address(TCP_PEER), SESSION_TCP_PORT});
+}
+BENCHMARK(BM_SessionRoundTripTcpLoopback)->Arg(1)->Arg(64)->UseRealTime();
+
+static void BM_SessionRoundTripUnixSocket(benchmark::State &state) {
+  SessionPeer peer;
+  if (peer.server.listen_and_serve(SESSION_UNIX_PATH)) {
+    state.SkipWithError("listen failed");
+    return;
+  }
+  run_session_exchanges<boost::asio::local::stream_protocol::socket>(
+      state, boost::asio::local::stream_protocol::endpoint(SESSION_UNIX_PATH));
+}
+BENCHMARK(BM_SessionRoundTripUnixSocket)->Arg(1)->Arg(64)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,320 @@
+#include "Http2Client.h"
+#include "Http2ClientError.h"
+#include "TlsClientContext.h"
+
+#include <TlsServerContext.h>
+#include <atomic>
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <cstdio>
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <nghttp2/asio_http2_server.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace astra::http2 {
+namespace test {
+
+namespace {
+
+namespace fs = std::filesystem;
+using boost::asio::ip::tcp;
+
+// A self-signed certificate for localhost and its key, as PEM files
+struct Certificate {
+  fs::path dir;
+  std::string cert_file;
+  std::string key_file;
+
+  explicit Certificate(const std::string &name) {
+    dir = fs::temp_directory_path() /
+          ("astra_tls_" + name + "_" + std::to_string(::getpid()));
+    fs::create_directories(dir);
+    cert_file = (dir / "cert.pem").string();
+    key_file = (dir / "key.pem").string();
+
+    EVP_PKEY_CTX *key_ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+    EVP_PKEY_keygen_init(key_ctx);
+    EVP_PKEY_CTX_set_ec_paramgen_curve_nid(key_ctx, NID_X9_62_prime256v1);
+    EVP_PKEY *key = nullptr;
+    EVP_PKEY_keygen(key_ctx, &key);
+    EVP_PKEY_CTX_free(key_ctx);
+
+    X509 *cert = X509_new();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), -60);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 24 * 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME *subject = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(subject, "CN", MBSTRING_ASC,
+                               reinterpret_cast<const unsigned char *>(
+                                   "localhost"),
+                               -1, -1, 0);
+    X509_set_issuer_name(cert, subject);
+    X509V3_CTX v3;
+    X509V3_set_ctx(&v3, cert, cert, nullptr, nullptr, 0);
+    X509_EXTENSION *san = X509V3_EXT_conf_nid(
+        nullptr, &v3, NID_subject_alt_name, "DNS:localhost");
+    X509_add_ext(cert, san, -1);
+    X509_EXTENSION_free(san);
+    X509_sign(cert, key, EVP_sha256());
+
+    FILE *out = std::fopen(cert_file.c_str(), "w");
+    PEM_write_X509(out, cert);
+    std::fclose(out);
+    out = std::fopen(key_file.c_str(), "w");
+    PEM_write_PrivateKey(out, key, nullptr, nullptr, 0, nullptr, nullptr);
+    std::fclose(out);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+  }
+
+  ~Certificate() {
+    fs::remove_all(dir);
+  }
+};
+
+struct Handshake {
+  bool ok{false};
+  bool resumed{false};
+  std::string alpn;
+};
+
+// One connection between the two contexts: the handshake, then a byte from
+// the server, which has the client take in the session tickets sent ahead
+// of it
+Handshake connect_once(TlsServerContext &server, TlsClientContext &client) {
+  boost::asio::io_context ioc;
+  tcp::acceptor acceptor(ioc,
+                         tcp::endpoint(boost::asio::ip::address_v4::loopback(),
+                                       0));
+
+  std::thread server_thread([&] {
+    boost::asio::ssl::stream<tcp::socket> stream(ioc, server.context());
+    boost::system::error_code ec;
+    acceptor.accept(stream.lowest_layer(), ec);
+    if (!ec) {
+      stream.handshake(boost::asio::ssl::stream_base::server, ec);
+    }
+    if (!ec) {
+      boost::asio::write(stream, boost::asio::buffer("x", 1), ec);
+    }
+    char byte;
+    while (!ec) {
+      stream.read_some(boost::asio::buffer(&byte, 1), ec);
+    }
+  });
+
+  Handshake result;
+  boost::asio::ssl::stream<tcp::socket> stream(ioc, client.context());
+  SSL_set_tlsext_host_name(stream.native_handle(), "localhost");
+  boost::system::error_code ec;
+  stream.lowest_layer().connect(acceptor.local_endpoint(), ec);
+  if (!ec) {
+    stream.handshake(boost::asio::ssl::stream_base::client, ec);
+  }
+  if (!ec) {
+    char byte;
+    boost::asio::read(stream, boost::asio::buffer(&byte, 1), ec);
+  }
+  if (!ec) {
+    result.ok = true;
+    result.resumed = SSL_session_reused(stream.native_handle()) == 1;
+    const unsigned char *alpn = nullptr;
+    unsigned int alpn_len = 0;
+    SSL_get0_alpn_selected(stream.native_handle(), &alpn, &alpn_len);
+    result.alpn.assign(reinterpret_cast<const char *>(alpn), alpn_len);
+  }
+  stream.lowest_layer().close();
+  server_thread.join();
+  return result;
+}
+
+} // namespace
+
+class TlsContextTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    m_server_config.set_cert_file(m_cert.cert_file);
+    m_server_config.set_key_file(m_cert.key_file);
+    m_client_config.set_enabled(true);
+    m_client_config.set_ca_file(m_cert.cert_file);
+  }
+
+  std::unique_ptr<TlsServerContext> server() {
+    auto server = TlsServerContext::create(m_server_config);
+    EXPECT_TRUE(server.is_ok());
+    return std::move(server).value();
+  }
+
+  Certificate m_cert{"ctx"};
+  ::http2::ServerTlsConfig m_server_config;
+  ::http2::ClientTlsConfig m_client_config;
+};
+
+TEST_F(TlsContextTest, NegotiatesH2ThroughAlpn) {
+  auto server_tls = server();
+  TlsClientContext client(m_client_config, "localhost");
+
+  auto handshake = connect_once(*server_tls, client);
+
+  ASSERT_TRUE(handshake.ok);
+  EXPECT_EQ(handshake.alpn, "h2");
+}
+
+TEST_F(TlsContextTest, ReconnectResumesSession) {
+  auto server_tls = server();
+  TlsClientContext client(m_client_config, "localhost");
+
+  auto first = connect_once(*server_tls, client);
+  auto second = connect_once(*server_tls, client);
+
+  ASSERT_TRUE(first.ok);
+  ASSERT_TRUE(second.ok);
+  EXPECT_FALSE(first.resumed);
+  EXPECT_TRUE(second.resumed);
+  EXPECT_EQ(client.full_handshakes(), 1U);
+  EXPECT_EQ(client.resumed_handshakes(), 1U);
+  EXPECT_EQ(server_tls->full_handshakes(), 1U);
+  EXPECT_EQ(server_tls->resumed_handshakes(), 1U);
+}
+
+TEST_F(TlsContextTest, ResumesFromSessionCacheWithoutTickets) {
+  m_server_config.set_disable_session_tickets(true);
+  auto server_tls = server();
+  TlsClientContext client(m_client_config, "localhost");
+
+  connect_once(*server_tls, client);
+  auto second = connect_once(*server_tls, client);
+
+  ASSERT_TRUE(second.ok);
+  EXPECT_TRUE(second.resumed);
+}
+
+TEST_F(TlsContextTest, SessionCacheEvictsLeastRecentlyUsed) {
+  m_server_config.set_disable_session_tickets(true);
+  m_server_config.set_session_cache_size(1);
+  auto server_tls = server();
+  TlsClientContext first(m_client_config, "localhost");
+  TlsClientContext second(m_client_config, "localhost");
+
+  connect_once(*server_tls, first);
+  connect_once(*server_tls, second);
+
+  EXPECT_EQ(server_tls->cached_sessions(), 1U);
+  EXPECT_FALSE(connect_once(*server_tls, first).resumed);
+  EXPECT_TRUE(connect_once(*server_tls, first).resumed);
+}
+
+TEST_F(TlsContextTest, DisabledResumptionAlwaysRunsFullHandshake) {
+  m_client_config.set_disable_session_resumption(true);
+  auto server_tls = server();
+  TlsClientContext client(m_client_config, "localhost");
+
+  connect_once(*server_tls, client);
+  auto second = connect_once(*server_tls, client);
+
+  ASSERT_TRUE(second.ok);
+  EXPECT_FALSE(second.resumed);
+  EXPECT_FALSE(client.has_session());
+  EXPECT_EQ(client.full_handshakes(), 2U);
+}
+
+TEST_F(TlsContextTest, RejectsServerWithUntrustedCertificate) {
+  Certificate other("other");
+  m_client_config.set_ca_file(other.cert_file);
+  auto server_tls = server();
+  TlsClientContext client(m_client_config, "localhost");
+
+  EXPECT_FALSE(connect_once(*server_tls, client).ok);
+}
+
+TEST_F(TlsContextTest, RejectsServerWithOtherHostName) {
+  auto server_tls = server();
+  TlsClientContext client(m_client_config, "example.com");
+
+  EXPECT_FALSE(connect_once(*server_tls, client).ok);
+}
+
+TEST_F(TlsContextTest, ServerSetupFailsWithoutCertificate) {
+  m_server_config.set_cert_file((m_cert.dir / "missing.pem").string());
+
+  auto server_tls = TlsServerContext::create(m_server_config);
+
+  ASSERT_TRUE(server_tls.is_err());
+  EXPECT_EQ(server_tls.error(), Http2ServerError::TlsSetupFailed);
+}
+
+TEST_F(TlsContextTest, ServerSetupFailsWithUnknownCipher) {
+  m_server_config.set_cipher_list("NOT-A-CIPHER");
+
+  EXPECT_TRUE(TlsServerContext::create(m_server_config).is_err());
+}
+
+TEST_F(TlsContextTest, RequestsOverTlsCarryHttpsScheme) {
+  auto server_tls = server();
+  std::string scheme;
+  nghttp2::asio_http2::server::http2 h2;
+  h2.handle("/", [&scheme](const auto &req, const auto &res) {
+    scheme = req.uri().scheme;
+    res.write_head(200);
+    res.end("");
+  });
+  boost::system::error_code ec;
+  h2.listen_and_serve(ec, server_tls->context(), "127.0.0.1", "0", true);
+  ASSERT_FALSE(ec);
+
+  ::http2::ClientConfig config;
+  config.set_connect_timeout_ms(1000);
+  config.set_request_timeout_ms(1000);
+  *config.mutable_tls() = m_client_config;
+  Http2Client client(config);
+  std::atomic<bool> done{false};
+  bool ok = false;
+
+  client.submit("localhost", h2.ports().front(), "GET", "/", "", {},
+                [&](auto result) {
+                  ok = result.is_ok();
+                  done = true;
+                });
+
+  while (!done) {
+    std::this_thread::yield();
+  }
+  h2.stop();
+  h2.join();
+  ASSERT_TRUE(ok);
+  EXPECT_EQ(scheme, "https");
+}
+
+TEST_F(TlsContextTest, UnusableClientConfigFailsRequests) {
+  ::http2::ClientConfig config;
+  config.set_connect_timeout_ms(1000);
+  config.set_request_timeout_ms(1000);
+  config.mutable_tls()->set_enabled(true);
+  config.mutable_tls()->set_ca_file((m_cert.dir / "missing.pem").string());
+  Http2Client client(config);
+  std::atomic<bool> done{false};
+  std::optional<Http2ClientError> error;
+
+  client.submit("127.0.0.1", 19998, "GET", "/", "", {}, [&](auto result) {
+    if (result.is_err()) {
+      error = result.error();
+    }
+    done = true;
+  });
+
+  while (!done) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(error, Http2ClientError::ConnectionFailed);
+}
+
+} // namespace test
+} // namespace astra::http2
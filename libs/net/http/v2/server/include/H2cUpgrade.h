@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace astra::http2 {
+
+// An HTTP/1.1 request that switched its connection to cleartext HTTP/2
+// with "Upgrade: h2c"; it is answered over HTTP/2 as stream 1
+struct H2cUpgrade {
+  // The request's HTTP2-Settings header, base64url encoded
+  std::string settings;
+  std::string method;
+  // Path and query, as in the request line
+  std::string target;
+  std::vector<std::pair<std::string, std::string>> headers;
+  std::string body;
+};
+
+} // namespace astra::http2
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "StreamArena.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace astra::http2 {
+
+struct HeaderField {
+  std::string_view name;
+  std::string_view value;
+};
+
+// Request headers packed into a single buffer with a flat index beside it.
+// Fields are stored as offsets, so the block can be copied or moved without
+// re-pointing anything, and lookups hand out views into the buffer.
+class HeaderBlock {
+public:
+  HeaderBlock() = default;
+  HeaderBlock(std::initializer_list<HeaderField> fields);
+  // Places both buffers in `arena`, keeping it alive while the block exists
+  explicit HeaderBlock(std::shared_ptr<StreamArena> arena);
+
+  // Pre-sizes both buffers so that add() does not reallocate
+  void reserve(size_t fields, size_t bytes);
+  void add(std::string_view name, std::string_view value);
+
+  // Returns an empty view when the header is absent
+  [[nodiscard]] std::string_view find(std::string_view name) const;
+
+  [[nodiscard]] size_t size() const noexcept {
+    return m_fields.size();
+  }
+  [[nodiscard]] bool empty() const noexcept {
+    return m_fields.empty();
+  }
+
+private:
+  // The value is stored right after the name
+  struct Field {
+    uint32_t name_offset;
+    uint32_t name_size;
+    uint32_t value_size;
+  };
+
+  std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>
+      m_bytes;
+  std::vector<Field, ArenaAllocator<Field>> m_fields;
+};
+
+} // namespace astra::http2
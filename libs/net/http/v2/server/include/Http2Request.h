@@ -1,20 +1,21 @@
 #pragma once
 
+#include "HeaderBlock.h"
 #include "IRequest.h"
+#include "QueryParams.h"
 
-#include <map>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 namespace astra::http2 {
 
 class Http2Request final : public astra::router::IRequest {
 public:
   Http2Request() = default;
-  Http2Request(std::string method, std::string path,
-               std::map<std::string, std::string> headers = {},
-               std::string body = {},
-               std::unordered_map<std::string, std::string> query_params = {});
+  // `raw_query` is the undecoded query string; it is parsed on the first
+  // query_param() call
+  Http2Request(std::string method, std::string path, HeaderBlock headers = {},
+               std::string body = {}, std::string raw_query = {});
 
   Http2Request(const Http2Request &) = default;
   Http2Request &operator=(const Http2Request &) = default;
@@ -25,22 +26,24 @@ public:
 
   [[nodiscard]] const std::string &method() const override;
   [[nodiscard]] const std::string &path() const override;
-  [[nodiscard]] std::string header(const std::string &key) const override;
   [[nodiscard]] const std::string &body() const override;
 
-  [[nodiscard]] std::string path_param(const std::string &key) const override;
-  [[nodiscard]] std::string query_param(const std::string &key) const override;
+  [[nodiscard]] std::string_view header(std::string_view key) const override;
+  [[nodiscard]] std::string_view
+  path_param(std::string_view key) const override;
+  [[nodiscard]] std::string_view
+  query_param(std::string_view key) const override;
 
-  void
-  set_path_params(std::unordered_map<std::string, std::string> params) override;
+  void set_path_params(astra::router::PathParams params) override;
 
 private:
   std::string m_method;
   std::string m_path;
   std::string m_body;
-  std::map<std::string, std::string> m_headers;
-  std::unordered_map<std::string, std::string> m_path_params;
-  std::unordered_map<std::string, std::string> m_query_params;
+  HeaderBlock m_headers;
+  // Offsets into m_path, so copies and moves need no fix-up
+  astra::router::PathParams m_path_params;
+  astra::router::QueryParams m_query_params;
 };
 
 } // namespace astra::http2
@@ -22,13 +22,15 @@ public:
   Http2Response(Http2Response &&) noexcept = default;
   Http2Response &operator=(Http2Response &&) noexcept = default;
 
-  ~Http2Response() override = default;
+  ~Http2Response() override;
 
   void set_status(int code) noexcept override;
   void set_header(const std::string &key, const std::string &value) override;
   void write(const std::string &data) override;
   void close() override;
   [[nodiscard]] bool is_alive() const noexcept override;
+  void send_headers() override;
+  [[nodiscard]] size_t pending_bytes() const noexcept override;
 
   void add_scoped_resource(
       std::unique_ptr<astra::execution::IScopedResource> resource);
@@ -39,6 +41,7 @@ private:
   std::string m_body;
   std::weak_ptr<Http2ResponseWriter> m_writer;
   bool m_closed = false;
+  bool m_streaming = false;
 };
 
 } // namespace astra::http2
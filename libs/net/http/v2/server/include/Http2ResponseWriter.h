@@ -2,14 +2,20 @@
 
 #include <IScopedResource.h>
 #include <atomic>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <vector>
 
 namespace astra::http2 {
 
+class ResponseCompressor;
+enum class ContentEncoding;
+
 class Http2ResponseWriter
     : public std::enable_shared_from_this<Http2ResponseWriter> {
 public:
@@ -18,11 +24,60 @@ public:
                          std::string body)>;
   using PostWork = std::function<void(std::function<void()>)>;
 
+  // Streaming transport hooks, both run on the io thread. StartStream sends
+  // the headers and begins a body that pulls bytes from `writer` through
+  // read_stream(); ResumeStream wakes that body after read_stream() reported
+  // `deferred`.
+  using StartStream =
+      std::function<void(Http2ResponseWriter &writer, int status,
+                         std::map<std::string, std::string> headers)>;
+  using ResumeStream = std::function<void()>;
+
+  struct StreamRead {
+    size_t bytes{0};
+    bool deferred{false};
+    bool eof{false};
+  };
+
   Http2ResponseWriter(SendResponse send_response, PostWork post_work);
 
   void send(int status, std::map<std::string, std::string> headers,
             std::string body);
 
+  // Has send() compress the body with `encoding`, the coding negotiated
+  // for the request. A body worth compressing goes through `offload`, which
+  // runs the work elsewhere when called on the io thread and inline
+  // otherwise; without one it is compressed on the calling thread. Set
+  // before the response is sent.
+  void set_compression(std::shared_ptr<ResponseCompressor> compressor,
+                       std::optional<ContentEncoding> encoding,
+                       PostWork offload = {}) {
+    m_compressor = std::move(compressor);
+    m_encoding = encoding;
+    m_offload = std::move(offload);
+  }
+
+  void set_stream_transport(StartStream start_stream,
+                            ResumeStream resume_stream);
+  [[nodiscard]] bool supports_streaming() const noexcept {
+    return static_cast<bool>(m_start_stream);
+  }
+
+  // Producer side; callable from any thread
+  void start_stream(int status, std::map<std::string, std::string> headers);
+  void write_stream(std::string chunk);
+  void end_stream();
+
+  // Transport side: copies up to `len` queued bytes into `buf`. The
+  // transport only asks for as much as the peer's flow-control window
+  // allows, so unsent chunks stay queued here.
+  StreamRead read_stream(uint8_t *buf, size_t len);
+
+  // Bytes queued by write_stream() that the transport has not read yet
+  [[nodiscard]] size_t pending_bytes() const noexcept {
+    return m_pending_bytes.load(std::memory_order_relaxed);
+  }
+
   void mark_closed() noexcept;
 
   [[nodiscard]] bool is_alive() const noexcept;
@@ -33,9 +88,28 @@ public:
   }
 
 private:
+  void post_send(int status, std::map<std::string, std::string> headers,
+                 std::string body);
+  void schedule_resume();
+
   SendResponse m_send_response;
   PostWork m_post_work;
   std::atomic<bool> m_stream_alive{true};
+  std::shared_ptr<ResponseCompressor> m_compressor;
+  std::optional<ContentEncoding> m_encoding;
+  PostWork m_offload;
+
+  StartStream m_start_stream;
+  ResumeStream m_resume_stream;
+  std::mutex m_stream_mutex;
+  // Unread chunks are m_chunks[m_chunk_head..]; a vector rather than a deque
+  // so that non-streaming responses never allocate queue storage
+  std::vector<std::string> m_chunks;
+  size_t m_chunk_head{0};
+  size_t m_chunk_offset{0};
+  bool m_stream_finished{false};
+  bool m_stream_deferred{false};
+  std::atomic<size_t> m_pending_bytes{0};
   std::vector<std::unique_ptr<astra::execution::IScopedResource>>
       m_scoped_resources;
 };
@@ -1,14 +1,28 @@
 #pragma once
 
+#include "H2cUpgrade.h"
 #include "Http2ServerError.h"
+#include "Http2StreamHandler.h"
 #include "IHttp2Server.h"
 #include "IRouter.h"
 #include "http2server.pb.h"
 
 #include <Result.h>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
+#include <vector>
+
+namespace boost::asio {
+class io_context;
+}
+
+namespace astra::execution {
+class Backpressure;
+}
 
 namespace astra::http2 {
 
@@ -27,10 +41,51 @@ public:
   void handle(const std::string &method, const std::string &path,
               Handler handler) override;
 
+  // Registers a handler that receives the request body incrementally
+  // instead of buffered. Bypasses the router, like handle().
+  void handle_stream(const std::string &method, const std::string &path,
+                     StreamHandler handler);
+
+  // Holds new requests back while `backpressure` is on; typically fed by
+  // the executor the handlers submit to. Connections on sockets the server
+  // owns (unix://, reuse_port, adopted, or http:// with transport
+  // settings) stop reading; streams arriving
+  // through nghttp2-asio are refused with REFUSED_STREAM, which peers may
+  // retry. No io thread is blocked either way. Set before start().
+  void set_backpressure(
+      std::shared_ptr<astra::execution::Backpressure> backpressure);
+
   astra::outcome::Result<void, Http2ServerError> start() override;
   astra::outcome::Result<void, Http2ServerError> join() override;
   astra::outcome::Result<void, Http2ServerError> stop() override;
 
+  // Serves a cleartext HTTP/2 connection accepted elsewhere, such as one an
+  // http1::Server sniffed as h2c, on an io thread of this server like those
+  // of its own listener: same handlers, router, metrics and backpressure.
+  // `socket` is the descriptor of the connected TCP socket, owned by the
+  // server from here on and closed if it fails. `preread` holds bytes
+  // already read from it. `upgrade` is the HTTP/1.1 request that switched
+  // the connection, answered as stream 1; its 101 must have been sent.
+  // Needs a running server with an empty uri, which opens no listener, a
+  // unix:// one, reuse_port or an http:// one with transport settings;
+  // fails with NotStarted otherwise. Callable from any thread.
+  astra::outcome::Result<void, Http2ServerError>
+  adopt(int socket, std::string preread = {},
+        std::optional<H2cUpgrade> upgrade = std::nullopt);
+
+  // The io_contexts connections are served on, one per io thread; empty
+  // until start(). A handler runs on the io thread of the connection that
+  // carried its request.
+  const std::vector<std::shared_ptr<boost::asio::io_context>> &
+  io_contexts() const;
+
+  // Connections open on the io thread at index `thread` of io_contexts(),
+  // also exported as the http2.server.connections.active gauge with a
+  // `shard` attribute. Counted where the server owns its sockets (unix://,
+  // reuse_port, transport settings and adopted ones); 0 on nghttp2-asio
+  // listeners.
+  [[nodiscard]] int64_t connection_count(size_t thread) const;
+
 private:
   class Impl;
   std::unique_ptr<Impl> m_impl;
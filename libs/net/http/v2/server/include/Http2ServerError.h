@@ -2,6 +2,11 @@
 
 namespace astra::http2 {
 
-enum class Http2ServerError { AlreadyRunning, NotStarted, BindFailed };
+enum class Http2ServerError {
+  AlreadyRunning,
+  NotStarted,
+  BindFailed,
+  TlsSetupFailed
+};
 
 } // namespace astra::http2
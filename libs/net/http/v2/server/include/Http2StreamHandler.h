@@ -0,0 +1,40 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string_view>
+
+namespace astra::http2 {
+
+class Http2Request;
+class Http2Response;
+
+// Acknowledges one chunk given to RequestBodyHandler::on_data_deferred.
+// Call it once, from any thread, when the chunk has been taken.
+using ConsumeCallback = std::function<void()>;
+
+// Incremental request body callbacks returned by a StreamHandler.
+// They run on the connection's io thread in arrival order, and chunks are
+// only valid for the duration of the call. Neither may block: hand slow
+// work off and return.
+//
+// With on_data, a chunk is credited back to the peer's flow-control window
+// as soon as the call returns. Set on_data_deferred instead to have a slow
+// consumer throttle the sender: a chunk is credited only once its
+// `consumed` is called, so the peer stops sending when the stream or
+// connection window runs out. That needs the server to own the HTTP/2
+// session (unix://, reuse_port, adopted connections and http:// with
+// transport settings); nghttp2-asio credits every chunk as it arrives and
+// `consumed` does nothing there.
+struct RequestBodyHandler {
+  std::function<void(std::string_view chunk)> on_data;
+  std::function<void()> on_end;
+  std::function<void(std::string_view chunk, ConsumeCallback consumed)>
+      on_data_deferred;
+};
+
+// Invoked once headers arrive; the request carries no body
+using StreamHandler = std::function<RequestBodyHandler(
+    std::shared_ptr<Http2Request>, std::shared_ptr<Http2Response>)>;
+
+} // namespace astra::http2
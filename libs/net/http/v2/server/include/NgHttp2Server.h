@@ -1,31 +1,96 @@
 #pragma once
 
+#include "H2cUpgrade.h"
 #include "Http2Server.h"
 #include "Http2ServerError.h"
+#include "Http2StreamHandler.h"
 
+#include <Backpressure.h>
 #include <Result.h>
 #include <atomic>
+#include <boost/asio/thread_pool.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <nghttp2/asio_http2_server.h>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace astra::http2 {
 
+class ResponseCompressor;
+class SessionServer;
+class TlsServerContext;
+
+// Serves over TCP through nghttp2-asio, over TLS when the uri is
+// https://address:port, or over a Unix domain socket when it is
+// unix:///path. Unix sockets, reuse_port listeners, adopted connections and
+// http:// listeners with transport settings are served by a SessionServer,
+// which owns its sockets.
 class NgHttp2Server {
 public:
+  static constexpr uint64_t DEFAULT_MAX_REQUEST_BODY_BYTES = 8 * 1024 * 1024;
+  static constexpr uint32_t DEFAULT_READ_TIMEOUT_MS = 60000;
+  // Longest a connection holds its reads back while backpressure is on;
+  // one read then goes through, so a gate that stays paused cannot stall a
+  // connection for good.
+  static constexpr std::chrono::milliseconds MAX_BACKPRESSURE_PAUSE{1000};
+
   NgHttp2Server(const ::http2::ServerConfig &config);
   ~NgHttp2Server();
 
   void handle(const std::string &method, const std::string &path,
               Http2Server::Handler handler);
+  void handle_stream(const std::string &method, const std::string &path,
+                     StreamHandler handler);
+
+  // Set before start()
+  void set_backpressure(
+      std::shared_ptr<astra::execution::Backpressure> backpressure) {
+    m_backpressure = std::move(backpressure);
+  }
 
   astra::outcome::Result<void, Http2ServerError> start();
   astra::outcome::Result<void, Http2ServerError> join();
+
+  // See Http2Server::adopt()
+  astra::outcome::Result<void, Http2ServerError>
+  adopt(int socket, std::string preread,
+        std::optional<H2cUpgrade> upgrade);
+
+  // One per io thread; empty until start()
+  const std::vector<std::shared_ptr<boost::asio::io_context>> &
+  io_contexts() const;
+
+  // Connections open on io thread `thread`; counted where the server owns
+  // the sockets, always 0 on nghttp2-asio listeners
+  int64_t connection_count(size_t thread) const;
+
   astra::outcome::Result<void, Http2ServerError> stop();
 
 private:
+  // True when a stream arriving through nghttp2-asio should be refused
+  bool refuse_under_backpressure() const;
+  template <typename Route>
+  void add_route(const std::string &path, Route route);
+
   ::http2::ServerConfig m_config;
+  uint64_t m_max_request_body_bytes;
   std::atomic<bool> m_is_running{false};
+  std::shared_ptr<astra::execution::Backpressure> m_backpressure;
+  // Set when compression is enabled; shared with the response writers
+  std::shared_ptr<ResponseCompressor> m_compressor;
+  // Set by start() for an https:// uri; outlives m_server's connections
+  std::unique_ptr<TlsServerContext> m_tls;
   nghttp2::asio_http2::server::http2 m_server;
+  // Set for a unix:// uri, reuse_port, no uri or an http:// uri with
+  // transport settings; m_server then stays idle
+  std::unique_ptr<SessionServer> m_session_server;
+  // Compresses responses finished on an io thread; set with m_compressor.
+  // Declared last so it is joined while the io_contexts it posts back to
+  // still exist.
+  std::unique_ptr<boost::asio::thread_pool> m_compression_pool;
 };
 
 } // namespace astra::http2
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace astra::http2 {
+
+// Monotonic arena backing the objects of one HTTP/2 stream. The first
+// INLINE_BYTES come from the arena's own storage, so a typical request costs
+// a single heap allocation for the arena itself. Memory is only returned
+// when the arena is destroyed.
+//
+// Allocation is not thread-safe: allocate from the stream's io thread only.
+// Deallocation is a no-op and may happen on any thread.
+class StreamArena {
+public:
+  static constexpr size_t INLINE_BYTES = 4096;
+
+  StreamArena() = default;
+  StreamArena(const StreamArena &) = delete;
+  StreamArena &operator=(const StreamArena &) = delete;
+
+  static std::shared_ptr<StreamArena> create() {
+    return std::make_shared<StreamArena>();
+  }
+
+  [[nodiscard]] std::pmr::memory_resource *resource() noexcept {
+    return &m_resource;
+  }
+
+private:
+  alignas(std::max_align_t) std::array<std::byte, INLINE_BYTES> m_buffer;
+  std::pmr::monotonic_buffer_resource m_resource{m_buffer.data(),
+                                                 m_buffer.size()};
+};
+
+// Allocator drawing from a StreamArena and keeping it alive for as long as
+// anything allocated from it exists, so objects handed to worker threads
+// may outlive the stream. A default-constructed allocator uses the heap.
+// Container copies fall back to the heap rather than allocating from the
+// arena on a foreign thread; moves carry the arena along with the storage.
+template <typename T> class ArenaAllocator {
+public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  ArenaAllocator() noexcept = default;
+  explicit ArenaAllocator(std::shared_ptr<StreamArena> arena) noexcept
+      : m_arena(std::move(arena)) {
+  }
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) noexcept
+      : m_arena(other.arena()) {
+  }
+
+  [[nodiscard]] T *allocate(size_t n) {
+    if (!m_arena) {
+      return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+    return static_cast<T *>(
+        m_arena->resource()->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T *p, size_t n) noexcept {
+    if (!m_arena) {
+      ::operator delete(p);
+      return;
+    }
+    m_arena->resource()->deallocate(p, n * sizeof(T), alignof(T));
+  }
+
+  [[nodiscard]] ArenaAllocator
+  select_on_container_copy_construction() const noexcept {
+    return ArenaAllocator();
+  }
+
+  [[nodiscard]] const std::shared_ptr<StreamArena> &arena() const noexcept {
+    return m_arena;
+  }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U> &other) const noexcept {
+    return m_arena == other.arena();
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U> &other) const noexcept {
+    return m_arena != other.arena();
+  }
+
+private:
+  std::shared_ptr<StreamArena> m_arena;
+};
+
+// std::make_shared equivalent placing the object and its control block in
+// `arena`
+template <typename T, typename... Args>
+std::shared_ptr<T> make_in_arena(const std::shared_ptr<StreamArena> &arena,
+                                 Args &&...args) {
+  return std::allocate_shared<T>(ArenaAllocator<T>(arena),
+                                 std::forward<Args>(args)...);
+}
+
+} // namespace astra::http2
@@ -0,0 +1,45 @@
+#include "HeaderBlock.h"
+
+namespace astra::http2 {
+
+HeaderBlock::HeaderBlock(std::initializer_list<HeaderField> fields) {
+  size_t bytes = 0;
+  for (const auto &f : fields) {
+    bytes += f.name.size() + f.value.size();
+  }
+  reserve(fields.size(), bytes);
+  for (const auto &f : fields) {
+    add(f.name, f.value);
+  }
+}
+
+HeaderBlock::HeaderBlock(std::shared_ptr<StreamArena> arena)
+    : m_bytes(ArenaAllocator<char>(arena)),
+      m_fields(ArenaAllocator<Field>(std::move(arena))) {
+}
+
+void HeaderBlock::reserve(size_t fields, size_t bytes) {
+  m_fields.reserve(fields);
+  m_bytes.reserve(bytes);
+}
+
+void HeaderBlock::add(std::string_view name, std::string_view value) {
+  Field field{static_cast<uint32_t>(m_bytes.size()),
+              static_cast<uint32_t>(name.size()),
+              static_cast<uint32_t>(value.size())};
+  m_bytes.append(name);
+  m_bytes.append(value);
+  m_fields.push_back(field);
+}
+
+std::string_view HeaderBlock::find(std::string_view name) const {
+  std::string_view bytes(m_bytes);
+  for (const auto &f : m_fields) {
+    if (bytes.substr(f.name_offset, f.name_size) == name) {
+      return bytes.substr(f.name_offset + f.name_size, f.value_size);
+    }
+  }
+  return {};
+}
+
+} // namespace astra::http2
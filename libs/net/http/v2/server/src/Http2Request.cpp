@@ -2,13 +2,12 @@
 
 namespace astra::http2 {
 
-Http2Request::Http2Request(
-    std::string method, std::string path,
-    std::map<std::string, std::string> headers, std::string body,
-    std::unordered_map<std::string, std::string> query_params)
+Http2Request::Http2Request(std::string method, std::string path,
+                           HeaderBlock headers, std::string body,
+                           std::string raw_query)
     : m_method(std::move(method)), m_path(std::move(path)),
       m_body(std::move(body)), m_headers(std::move(headers)),
-      m_query_params(std::move(query_params)) {
+      m_query_params(std::move(raw_query)) {
 }
 
 const std::string &Http2Request::method() const {
@@ -19,37 +18,24 @@ const std::string &Http2Request::path() const {
   return m_path;
 }
 
-std::string Http2Request::header(const std::string &key) const {
-  auto it = m_headers.find(key);
-  if (it != m_headers.end()) {
-    return it->second;
-  }
-  return {};
-}
-
 const std::string &Http2Request::body() const {
   return m_body;
 }
 
-std::string Http2Request::path_param(const std::string &key) const {
-  auto it = m_path_params.find(key);
-  if (it != m_path_params.end()) {
-    return it->second;
-  }
-  return {};
+std::string_view Http2Request::header(std::string_view key) const {
+  return m_headers.find(key);
+}
+
+std::string_view Http2Request::path_param(std::string_view key) const {
+  return m_path_params.get(key, m_path);
 }
 
-std::string Http2Request::query_param(const std::string &key) const {
-  auto it = m_query_params.find(key);
-  if (it != m_query_params.end()) {
-    return it->second;
-  }
-  return {};
+std::string_view Http2Request::query_param(std::string_view key) const {
+  return m_query_params.get(key);
 }
 
-void Http2Request::set_path_params(
-    std::unordered_map<std::string, std::string> params) {
-  m_path_params = std::move(params);
+void Http2Request::set_path_params(astra::router::PathParams params) {
+  m_path_params = params;
 }
 
 } // namespace astra::http2
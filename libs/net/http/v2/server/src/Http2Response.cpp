@@ -1,6 +1,7 @@
 #include "Http2Response.h"
 
 #include "Http2ResponseWriter.h"
+#include "StreamMetrics.h"
 
 #include <Log.h>
 
@@ -10,6 +11,10 @@ Http2Response::Http2Response(std::weak_ptr<Http2ResponseWriter> handle)
     : m_writer(std::move(handle)) {
 }
 
+Http2Response::~Http2Response() {
+  run_close_hook(m_status.value_or(0));
+}
+
 void Http2Response::set_status(int code) noexcept {
   m_status = code;
 }
@@ -20,7 +25,30 @@ void Http2Response::set_header(const std::string &key,
 }
 
 void Http2Response::write(const std::string &data) {
-  m_body.append(data);
+  if (!m_streaming) {
+    m_body.append(data);
+    return;
+  }
+  if (auto handle = m_writer.lock()) {
+    handle->write_stream(data);
+  }
+}
+
+void Http2Response::send_headers() {
+  if (m_closed || m_streaming) {
+    return;
+  }
+  auto handle = m_writer.lock();
+  if (!handle || !handle->supports_streaming()) {
+    return;
+  }
+
+  m_streaming = true;
+  handle->start_stream(m_status.value_or(200), std::move(m_headers));
+  if (!m_body.empty()) {
+    handle->write_stream(std::move(m_body));
+    m_body.clear();
+  }
 }
 
 void Http2Response::close() {
@@ -29,6 +57,14 @@ void Http2Response::close() {
   }
   m_closed = true;
 
+  if (m_streaming) {
+    if (auto handle = m_writer.lock()) {
+      handle->end_stream();
+    }
+    run_close_hook(m_status.value_or(200));
+    return;
+  }
+
   if (auto handle = m_writer.lock()) {
     int status = m_status.value_or(500);
     if (!m_status.has_value()) {
@@ -37,8 +73,10 @@ void Http2Response::close() {
     }
     handle->send(status, std::move(m_headers), std::move(m_body));
   } else {
+    StreamMetrics::response_dropped();
     obs::debug("Cannot send response: stream already closed");
   }
+  run_close_hook(m_status.value_or(500));
 }
 
 void Http2Response::add_scoped_resource(
@@ -48,6 +86,16 @@ void Http2Response::add_scoped_resource(
   }
 }
 
+size_t Http2Response::pending_bytes() const noexcept {
+  if (!m_streaming) {
+    return m_body.size();
+  }
+  if (auto handle = m_writer.lock()) {
+    return handle->pending_bytes();
+  }
+  return 0;
+}
+
 bool Http2Response::is_alive() const noexcept {
   if (auto handle = m_writer.lock()) {
     return handle->is_alive();
@@ -1,5 +1,13 @@
 #include "Http2ResponseWriter.h"
 
+#include "ResponseCompressor.h"
+#include "StreamMetrics.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
 namespace astra::http2 {
 
 Http2ResponseWriter::Http2ResponseWriter(SendResponse send_response,
@@ -11,12 +19,131 @@ Http2ResponseWriter::Http2ResponseWriter(SendResponse send_response,
 void Http2ResponseWriter::send(int status,
                                std::map<std::string, std::string> headers,
                                std::string body) {
+  if (m_compressor && m_offload &&
+      m_compressor->would_compress(m_encoding, headers, body)) {
+    m_offload([self = shared_from_this(), status, headers = std::move(headers),
+               body = std::move(body)]() mutable {
+      self->m_compressor->apply(self->m_encoding, headers, body);
+      self->post_send(status, std::move(headers), std::move(body));
+    });
+    return;
+  }
+  // Before the hand-off, so the io thread does not spend its time on it
+  if (m_compressor) {
+    m_compressor->apply(m_encoding, headers, body);
+  }
+  post_send(status, std::move(headers), std::move(body));
+}
+
+void Http2ResponseWriter::post_send(int status,
+                                    std::map<std::string, std::string> headers,
+                                    std::string body) {
   auto self = shared_from_this();
 
   m_post_work([self, status, headers = std::move(headers),
                body = std::move(body)]() mutable {
     if (self->m_stream_alive.load(std::memory_order_acquire)) {
       self->m_send_response(status, std::move(headers), std::move(body));
+    } else {
+      StreamMetrics::response_dropped();
+    }
+  });
+}
+
+void Http2ResponseWriter::set_stream_transport(StartStream start_stream,
+                                               ResumeStream resume_stream) {
+  m_start_stream = std::move(start_stream);
+  m_resume_stream = std::move(resume_stream);
+}
+
+void Http2ResponseWriter::start_stream(
+    int status, std::map<std::string, std::string> headers) {
+  auto self = shared_from_this();
+
+  m_post_work([self, status, headers = std::move(headers)]() mutable {
+    if (self->m_stream_alive.load(std::memory_order_acquire)) {
+      self->m_start_stream(*self, status, std::move(headers));
+    }
+  });
+}
+
+void Http2ResponseWriter::write_stream(std::string chunk) {
+  if (chunk.empty()) {
+    return;
+  }
+
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock(m_stream_mutex);
+    if (m_stream_finished) {
+      return;
+    }
+    m_pending_bytes.fetch_add(chunk.size(), std::memory_order_relaxed);
+    m_chunks.push_back(std::move(chunk));
+    wake = std::exchange(m_stream_deferred, false);
+  }
+  if (wake) {
+    schedule_resume();
+  }
+}
+
+void Http2ResponseWriter::end_stream() {
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock(m_stream_mutex);
+    m_stream_finished = true;
+    wake = std::exchange(m_stream_deferred, false);
+  }
+  if (wake) {
+    schedule_resume();
+  }
+}
+
+Http2ResponseWriter::StreamRead Http2ResponseWriter::read_stream(uint8_t *buf,
+                                                                 size_t len) {
+  std::lock_guard<std::mutex> lock(m_stream_mutex);
+
+  StreamRead result;
+  while (result.bytes < len && m_chunk_head < m_chunks.size()) {
+    auto &front = m_chunks[m_chunk_head];
+    size_t n = std::min(len - result.bytes, front.size() - m_chunk_offset);
+    std::memcpy(buf + result.bytes, front.data() + m_chunk_offset, n);
+    result.bytes += n;
+    m_chunk_offset += n;
+    if (m_chunk_offset == front.size()) {
+      std::string().swap(front);
+      ++m_chunk_head;
+      m_chunk_offset = 0;
+    }
+  }
+  m_pending_bytes.fetch_sub(result.bytes, std::memory_order_relaxed);
+
+  if (m_chunk_head == m_chunks.size()) {
+    m_chunks.clear();
+    m_chunk_head = 0;
+  } else if (m_chunk_head > m_chunks.size() / 2) {
+    auto consumed = static_cast<std::ptrdiff_t>(m_chunk_head);
+    m_chunks.erase(m_chunks.begin(), m_chunks.begin() + consumed);
+    m_chunk_head = 0;
+  }
+
+  if (m_chunks.empty()) {
+    if (m_stream_finished) {
+      result.eof = true;
+    } else if (result.bytes == 0) {
+      result.deferred = true;
+      m_stream_deferred = true;
+    }
+  }
+  return result;
+}
+
+void Http2ResponseWriter::schedule_resume() {
+  auto self = shared_from_this();
+
+  m_post_work([self]() {
+    if (self->m_stream_alive.load(std::memory_order_acquire)) {
+      self->m_resume_stream();
     }
   });
 }
@@ -31,10 +31,28 @@ void Http2Server::handle(const std::string &method, const std::string &path,
   m_impl->backend.handle(method, path, handler);
 }
 
+void Http2Server::handle_stream(const std::string &method,
+                                const std::string &path,
+                                StreamHandler handler) {
+  m_impl->backend.handle_stream(method, path, std::move(handler));
+}
+
+void Http2Server::set_backpressure(
+    std::shared_ptr<astra::execution::Backpressure> backpressure) {
+  m_impl->backend.set_backpressure(std::move(backpressure));
+}
+
 astra::outcome::Result<void, Http2ServerError> Http2Server::start() {
   return m_impl->backend.start();
 }
 
+astra::outcome::Result<void, Http2ServerError>
+Http2Server::adopt(int socket, std::string preread,
+                   std::optional<H2cUpgrade> upgrade) {
+  return m_impl->backend.adopt(socket, std::move(preread),
+                               std::move(upgrade));
+}
+
 astra::outcome::Result<void, Http2ServerError> Http2Server::join() {
   return m_impl->backend.join();
 }
@@ -43,4 +61,13 @@ astra::outcome::Result<void, Http2ServerError> Http2Server::stop() {
   return m_impl->backend.stop();
 }
 
+const std::vector<std::shared_ptr<boost::asio::io_context>> &
+Http2Server::io_contexts() const {
+  return m_impl->backend.io_contexts();
+}
+
+int64_t Http2Server::connection_count(size_t thread) const {
+  return m_impl->backend.connection_count(thread);
+}
+
 } // namespace astra::http2
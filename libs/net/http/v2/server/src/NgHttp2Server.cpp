@@ -3,106 +3,474 @@
 #include "Http2Request.h"
 #include "Http2Response.h"
 #include "Http2ResponseWriter.h"
-#include "Url.h"
+#include "ResponseBatcher.h"
+#include "ResponseCompressor.h"
+#include "StreamArena.h"
+#include "StreamMetrics.h"
+#include "TlsServerContext.h"
+#include "SessionServer.h"
 
 #include <Log.h>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <charconv>
+#include <chrono>
+#include <optional>
+#include <string_view>
+#include <unistd.h>
 
 namespace {
 
+using astra::http2::make_in_arena;
+
+// Per-stream state. The stream, its writer, request and response and the
+// header block all live in `arena`, which is freed in one go once the last
+// of them is released.
 struct RequestStream {
+  explicit RequestStream(std::shared_ptr<astra::http2::StreamArena> a)
+      : arena(a), headers(std::move(a)) {
+  }
+
+  std::shared_ptr<astra::http2::StreamArena> arena;
   std::string method;
   std::string path;
-  std::map<std::string, std::string> headers;
+  astra::http2::HeaderBlock headers;
   std::string body;
-  std::unordered_map<std::string, std::string> query_params;
+  std::string raw_query;
   std::shared_ptr<astra::http2::Http2ResponseWriter> response_writer;
   astra::http2::Http2Server::Handler handler;
+  astra::http2::RequestBodyHandler body_handler;
+  // Credits body bytes back to the peer; set for on_data_deferred
+  std::function<void(std::size_t)> consume;
+  astra::http2::StreamMetrics *metrics{nullptr};
+  // Set once the request has been read in full; the response wait starts
+  // here
+  std::optional<std::chrono::steady_clock::time_point> request_done;
+  uint64_t body_bytes{0};
+  bool rejected{false};
 };
 
+template <typename Request>
+std::optional<uint64_t> content_length(const Request &req) {
+  auto it = req.header().find("content-length");
+  if (it == req.header().end()) {
+    return std::nullopt;
+  }
+  const auto &value = it->second.value;
+  uint64_t length = 0;
+  auto [ptr, ec] =
+      std::from_chars(value.data(), value.data() + value.size(), length);
+  if (ec != std::errc{} || ptr != value.data() + value.size()) {
+    return std::nullopt;
+  }
+  return length;
+}
+
+// Answers 413 directly and detaches the writer so a response the handler
+// sends later is dropped
+template <typename Response>
+void reject_too_large(RequestStream &stream, const Response &res) {
+  stream.rejected = true;
+  stream.response_writer->mark_closed();
+  res.write_head(413);
+  res.end();
+}
+
+// Counts `len` more body bytes; rejects the request once over the limit
+template <typename Response>
+bool within_body_limit(RequestStream &stream, const Response &res,
+                       std::size_t len, uint64_t max_body_bytes) {
+  stream.metrics->bytes_in(len);
+  stream.body_bytes += len;
+  if (stream.body_bytes > max_body_bytes) {
+    obs::debug("Request body exceeds " + std::to_string(max_body_bytes) +
+               " bytes, rejecting with 413");
+    reject_too_large(stream, res);
+    return false;
+  }
+  return true;
+}
+
+// Called as the response reaches nghttp2; a response started before the
+// request was read in full has no wait to report
+void record_response_wait(const std::weak_ptr<RequestStream> &weak_stream,
+                          astra::http2::StreamMetrics &metrics) {
+  auto stream = weak_stream.lock();
+  if (stream && stream->request_done) {
+    metrics.response_started(std::chrono::steady_clock::now() -
+                             *stream->request_done);
+  }
+}
+
+// Common per-stream setup. Returns nullptr when the request was already
+// answered (method mismatch or declared body too large). Request and
+// Response are nghttp2-asio's or a SessionServer's.
+template <typename Request, typename Response>
+std::shared_ptr<RequestStream>
+open_stream(const std::string &method, const Request &req, const Response &res,
+            uint64_t max_body_bytes,
+            const std::shared_ptr<astra::http2::ResponseCompressor>
+                &compressor,
+            boost::asio::thread_pool *compression_pool) {
+  if (method != "*" && req.method() != method) {
+    res.write_head(405);
+    res.end();
+    return nullptr;
+  }
+
+  auto arena = astra::http2::StreamArena::create();
+  auto stream = make_in_arena<RequestStream>(arena, arena);
+  auto &metrics = astra::http2::StreamMetrics::of(res.io_service());
+  stream->metrics = &metrics;
+
+  // Responses finished on worker threads are queued per io thread and
+  // flushed together; those finished on the io thread itself go out
+  // directly
+  auto &batcher = astra::http2::ResponseBatcher::of(res.io_service());
+  std::weak_ptr<RequestStream> weak_stream = stream;
+  stream->response_writer = make_in_arena<astra::http2::Http2ResponseWriter>(
+      arena,
+      [&res, &metrics, weak_stream](int status,
+                                    std::map<std::string, std::string> headers,
+                                    std::string body) {
+        record_response_wait(weak_stream, metrics);
+        metrics.bytes_out(body.size());
+        nghttp2::asio_http2::header_map h;
+        for (const auto &[k, v] : headers) {
+          h.emplace(k, nghttp2::asio_http2::header_value{v, false});
+        }
+
+        res.write_head(status, h);
+        res.end(std::move(body));
+      },
+
+      [&batcher](std::function<void()> work) {
+        batcher.dispatch(std::move(work));
+      });
+
+  stream->response_writer->set_stream_transport(
+      [&res, &metrics, weak_stream](
+          astra::http2::Http2ResponseWriter &stream_writer, int status,
+          std::map<std::string, std::string> headers) {
+        record_response_wait(weak_stream, metrics);
+        nghttp2::asio_http2::header_map h;
+        for (const auto &[k, v] : headers) {
+          h.emplace(k, nghttp2::asio_http2::header_value{v, false});
+        }
+
+        res.write_head(status, h);
+        // nghttp2 only asks for as many bytes as the peer's flow-control
+        // window allows; DEFERRED parks the stream until resume()
+        auto writer = stream_writer.weak_from_this();
+        res.end([writer, &metrics](uint8_t *buf, std::size_t len,
+                                   uint32_t *data_flags) -> ssize_t {
+          auto self = writer.lock();
+          if (!self) {
+            *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+            return 0;
+          }
+          auto read = self->read_stream(buf, len);
+          if (read.deferred) {
+            return NGHTTP2_ERR_DEFERRED;
+          }
+          if (read.eof) {
+            *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+          }
+          metrics.bytes_out(read.bytes);
+          return static_cast<ssize_t>(read.bytes);
+        });
+      },
+      [&res] { res.resume(); });
+
+  metrics.stream_opened();
+  const_cast<Response &>(res).on_close(
+      [response_writer = stream->response_writer,
+       &metrics](uint32_t error_code) {
+        response_writer->mark_closed();
+        metrics.stream_closed(error_code);
+        if (error_code != 0) {
+          obs::debug("Stream closed with error code: " +
+                     std::to_string(error_code));
+        }
+      });
+
+  auto declared = content_length(req);
+  if (declared && *declared > max_body_bytes) {
+    reject_too_large(*stream, res);
+    return nullptr;
+  }
+  if (declared) {
+    stream->body.reserve(*declared);
+  }
+
+  if (compressor) {
+    auto accept = req.header().find("accept-encoding");
+    // Handlers that finish on the io thread would hold up every other
+    // stream on it while compressing
+    stream->response_writer->set_compression(
+        compressor,
+        accept == req.header().end()
+            ? std::nullopt
+            : compressor->negotiate(accept->second.value),
+        [&ioc = res.io_service(),
+         compression_pool](std::function<void()> work) {
+          if (ioc.get_executor().running_in_this_thread()) {
+            boost::asio::post(*compression_pool, std::move(work));
+          } else {
+            work();
+          }
+        });
+  }
+
+  stream->method = req.method();
+  stream->path = req.uri().path;
+  stream->raw_query = req.uri().raw_query;
+
+  // One buffer and one index for the whole header block
+  const auto &headers = req.header();
+  size_t header_bytes = 0;
+  for (const auto &h : headers) {
+    header_bytes += h.first.size() + h.second.value.size();
+  }
+  stream->headers.reserve(headers.size(), header_bytes);
+  for (const auto &h : headers) {
+    stream->headers.add(h.first, h.second.value);
+  }
+  return stream;
+}
+
+// Only sessions of our own can hold the peer's flow-control window open;
+// nghttp2-asio credits each chunk as it arrives
+std::function<void(std::size_t)>
+defer_consume(const astra::http2::SessionRequest &req) {
+  return req.defer_consume();
+}
+
+std::function<void(std::size_t)>
+defer_consume(const nghttp2::asio_http2::server::request &) {
+  return [](std::size_t) {};
+}
+
+// The transport settings of `config`, for the sessions on sockets the server
+// owns
+astra::http2::SessionServer::Options
+session_options(const ::http2::ServerConfig &config) {
+  astra::http2::SessionServer::Options options;
+  options.threads = config.thread_count() > 0 ? config.thread_count() : 1;
+  options.backlog = static_cast<int>(config.listen_backlog());
+  options.read_timeout = std::chrono::milliseconds(
+      config.read_timeout_ms() > 0
+          ? config.read_timeout_ms()
+          : astra::http2::NgHttp2Server::DEFAULT_READ_TIMEOUT_MS);
+  if (config.max_concurrent_streams() > 0) {
+    options.max_concurrent_streams = config.max_concurrent_streams();
+  }
+  options.initial_stream_window_bytes = config.initial_stream_window_bytes();
+  options.connection_window_bytes = config.connection_window_bytes();
+  options.header_table_size = config.header_table_size();
+  options.tcp_nodelay = !config.disable_tcp_nodelay();
+  options.receive_buffer_bytes =
+      static_cast<int>(config.socket_receive_buffer_bytes());
+  options.send_buffer_bytes =
+      static_cast<int>(config.socket_send_buffer_bytes());
+  return options;
+}
+
+// Whether `config` sets any of the transport settings nghttp2-asio cannot
+// apply
+bool tunes_transport(const ::http2::ServerConfig &config) {
+  return config.max_concurrent_streams() > 0 ||
+         config.initial_stream_window_bytes() > 0 ||
+         config.connection_window_bytes() > 0 ||
+         config.header_table_size() > 0 || config.disable_tcp_nodelay() ||
+         config.socket_receive_buffer_bytes() > 0 ||
+         config.socket_send_buffer_bytes() > 0;
+}
+
 } // namespace
 
 namespace astra::http2 {
 
 NgHttp2Server::NgHttp2Server(const ::http2::ServerConfig &config)
-    : m_config(config) {
+    : m_config(config),
+      m_max_request_body_bytes(config.max_request_body_bytes() > 0
+                                   ? config.max_request_body_bytes()
+                                   : DEFAULT_MAX_REQUEST_BODY_BYTES) {
   int threads = m_config.thread_count() > 0 ? m_config.thread_count() : 1;
   m_server.num_threads(threads);
+  if (m_config.listen_backlog() > 0) {
+    m_server.backlog(static_cast<int>(m_config.listen_backlog()));
+  }
+  uint32_t read_timeout_ms = m_config.read_timeout_ms() > 0
+                                 ? m_config.read_timeout_ms()
+                                 : DEFAULT_READ_TIMEOUT_MS;
+  m_server.read_timeout(boost::posix_time::milliseconds(read_timeout_ms));
+
+  if (m_config.compression().enabled()) {
+    m_compressor =
+        std::make_shared<ResponseCompressor>(m_config.compression());
+    uint32_t offload_threads =
+        m_config.compression().offload_threads() > 0
+            ? m_config.compression().offload_threads()
+            : ResponseCompressor::DEFAULT_OFFLOAD_THREADS;
+    m_compression_pool =
+        std::make_unique<boost::asio::thread_pool>(offload_threads);
+  }
+
+  // unix:///path serves over a Unix domain socket instead of TCP.
+  // nghttp2-asio can listen on neither that nor per-thread reuse_port
+  // sockets, nor take over a connection accepted elsewhere, nor apply the
+  // transport settings, so all of these are served by sessions on sockets
+  // of our own. TLS is left to nghttp2-asio.
+  bool https = m_config.uri().rfind("https://", 0) == 0;
+  if (SessionServer::socket_path(m_config.uri()) || m_config.reuse_port() ||
+      m_config.uri().empty() || (!https && tunes_transport(m_config))) {
+    m_session_server =
+        std::make_unique<SessionServer>(session_options(m_config));
+  } else if (https && tunes_transport(m_config)) {
+    obs::warn("Transport settings are not applied to https:// listeners",
+              {{"uri", m_config.uri()}});
+  }
   obs::info("NgHttp2Server initialized with " + std::to_string(threads) +
             " threads");
 }
 
 NgHttp2Server::~NgHttp2Server() {
   if (m_is_running.load(std::memory_order_acquire)) {
-    m_server.stop();
-    m_server.join();
+    if (m_session_server) {
+      m_session_server->stop();
+      m_session_server->join();
+    } else {
+      m_server.stop();
+      m_server.join();
+    }
   }
 }
 
+const std::vector<std::shared_ptr<boost::asio::io_context>> &
+NgHttp2Server::io_contexts() const {
+  return m_session_server ? m_session_server->io_services()
+                          : m_server.io_services();
+}
+
+int64_t NgHttp2Server::connection_count(size_t thread) const {
+  return StreamMetrics::of(*io_contexts().at(thread)).connections();
+}
+
 void NgHttp2Server::handle(const std::string &method, const std::string &path,
                            Http2Server::Handler handler) {
-  m_server.handle(path, [handler = std::move(handler), method](
-                            const nghttp2::asio_http2::server::request &req,
-                            const nghttp2::asio_http2::server::response &res) {
-    if (method != "*" && req.method() != method) {
-      res.write_head(405);
-      res.end();
+  // Generic over the transport's request and response types
+  auto route = [this, handler = std::move(handler), method,
+                max_body = m_max_request_body_bytes](const auto &req,
+                                                     const auto &res) {
+    if (refuse_under_backpressure()) {
+      res.cancel(NGHTTP2_REFUSED_STREAM);
       return;
     }
-
-    auto stream = std::make_shared<RequestStream>();
-    stream->method = req.method();
-    stream->path = req.uri().path;
-    if (!req.uri().raw_query.empty()) {
-      stream->query_params =
-          utils::Url::parse_query_string(req.uri().raw_query);
-    }
-    for (const auto &h : req.header()) {
-      stream->headers[h.first] = h.second.value;
+    auto stream = open_stream(method, req, res, max_body, m_compressor,
+                              m_compression_pool.get());
+    if (!stream) {
+      return;
     }
     stream->handler = handler;
 
-    auto &io_ctx = res.io_service();
-    stream->response_writer = std::make_shared<Http2ResponseWriter>(
-        [&res](int status, std::map<std::string, std::string> headers,
-               std::string body) {
-          nghttp2::asio_http2::header_map h;
-          for (const auto &[k, v] : headers) {
-            h.emplace(k, nghttp2::asio_http2::header_value{v, false});
-          }
+    req.on_data([stream, &res, max_body](const uint8_t *data,
+                                         std::size_t len) {
+      if (stream->rejected) {
+        return;
+      }
+      if (len > 0) {
+        if (within_body_limit(*stream, res, len, max_body)) {
+          stream->body.append(reinterpret_cast<const char *>(data), len);
+        }
+      } else {
+        stream->request_done = std::chrono::steady_clock::now();
+        auto request = make_in_arena<Http2Request>(
+            stream->arena, std::move(stream->method), std::move(stream->path),
+            std::move(stream->headers), std::move(stream->body),
+            std::move(stream->raw_query));
+        auto response = make_in_arena<Http2Response>(stream->arena,
+                                                     stream->response_writer);
 
-          res.write_head(status, h);
-          res.end(std::move(body));
-        },
+        stream->handler(request, response);
+      }
+    });
+  };
+  add_route(path, std::move(route));
+}
 
-        [&io_ctx](std::function<void()> work) {
-          boost::asio::post(io_ctx, std::move(work));
-        });
+void NgHttp2Server::handle_stream(const std::string &method,
+                                  const std::string &path,
+                                  StreamHandler handler) {
+  auto route = [this, handler = std::move(handler), method,
+                max_body = m_max_request_body_bytes](const auto &req,
+                                                     const auto &res) {
+    if (refuse_under_backpressure()) {
+      res.cancel(NGHTTP2_REFUSED_STREAM);
+      return;
+    }
+    auto stream = open_stream(method, req, res, max_body, m_compressor,
+                              m_compression_pool.get());
+    if (!stream) {
+      return;
+    }
 
-    const_cast<nghttp2::asio_http2::server::response &>(res).on_close(
-        [response_writer = stream->response_writer](uint32_t error_code) {
-          response_writer->mark_closed();
-          if (error_code != 0) {
-            obs::debug("Stream closed with error code: " +
-                       std::to_string(error_code));
-          }
-        });
+    auto request = make_in_arena<Http2Request>(
+        stream->arena, std::move(stream->method), std::move(stream->path),
+        std::move(stream->headers), std::string{},
+        std::move(stream->raw_query));
+    auto response =
+        make_in_arena<Http2Response>(stream->arena, stream->response_writer);
+    stream->body_handler = handler(request, response);
+    if (stream->body_handler.on_data_deferred) {
+      stream->consume = defer_consume(req);
+    }
 
-    const_cast<nghttp2::asio_http2::server::request &>(req).on_data(
-        [stream](const uint8_t *data, std::size_t len) {
-          if (len > 0) {
-            stream->body.append(reinterpret_cast<const char *>(data), len);
-          } else {
-            auto request = std::make_shared<Http2Request>(
-                std::move(stream->method), std::move(stream->path),
-                std::move(stream->headers), std::move(stream->body),
-                std::move(stream->query_params));
-            auto response =
-                std::make_shared<Http2Response>(stream->response_writer);
-
-            stream->handler(request, response);
+    req.on_data([stream, &res, max_body](const uint8_t *data,
+                                         std::size_t len) {
+      const auto &body_handler = stream->body_handler;
+      if (len == 0) {
+        if (!stream->rejected) {
+          stream->request_done = std::chrono::steady_clock::now();
+          if (body_handler.on_end) {
+            body_handler.on_end();
           }
-        });
-  });
+        }
+        return;
+      }
+      // Dropped chunks are credited right away
+      if (stream->rejected || !within_body_limit(*stream, res, len, max_body)) {
+        if (stream->consume) {
+          stream->consume(len);
+        }
+        return;
+      }
+      std::string_view chunk(reinterpret_cast<const char *>(data), len);
+      if (stream->consume) {
+        body_handler.on_data_deferred(
+            chunk, [consume = stream->consume, len] { consume(len); });
+      } else if (body_handler.on_data) {
+        body_handler.on_data(chunk);
+      }
+    });
+  };
+  add_route(path, std::move(route));
+}
+
+template <typename Route>
+void NgHttp2Server::add_route(const std::string &path, Route route) {
+  if (m_session_server) {
+    m_session_server->handle(path, std::move(route));
+  } else {
+    m_server.handle(path, std::move(route));
+  }
+}
+
+// nghttp2-asio gives no hold on its sockets or flow control, so new streams
+// are refused with REFUSED_STREAM while backpressure is on; the peer may
+// retry them. Connections on sockets of our own stop reading instead (see
+// start()), and the streams they have already read are served.
+bool NgHttp2Server::refuse_under_backpressure() const {
+  return !m_session_server && m_backpressure && m_backpressure->is_paused();
 }
 
 astra::outcome::Result<void, Http2ServerError> NgHttp2Server::start() {
@@ -111,6 +479,33 @@ astra::outcome::Result<void, Http2ServerError> NgHttp2Server::start() {
         Http2ServerError::AlreadyRunning);
   }
 
+  if (m_session_server && m_backpressure) {
+    m_session_server->set_read_gate(
+        [backpressure = m_backpressure] {
+          return !backpressure->is_paused();
+        },
+        MAX_BACKPRESSURE_PAUSE);
+  }
+
+  if (m_config.uri().empty()) {
+    obs::info("Server starting without a listener");
+    m_session_server->serve();
+    m_is_running.store(true, std::memory_order_release);
+    return astra::outcome::Result<void, Http2ServerError>::Ok();
+  }
+
+  if (auto path = SessionServer::socket_path(m_config.uri())) {
+    obs::info("Server starting on " + m_config.uri());
+    if (auto ec = m_session_server->listen_and_serve(*path)) {
+      obs::error("Server failed to start: " + ec.message());
+      return astra::outcome::Result<void, Http2ServerError>::Err(
+          Http2ServerError::BindFailed);
+    }
+    m_is_running.store(true, std::memory_order_release);
+    obs::info("Server started successfully");
+    return astra::outcome::Result<void, Http2ServerError>::Ok();
+  }
+
   // Parse uri to extract address and port
   // Format: http://address:port or https://address:port
   std::string uri = m_config.uri();
@@ -118,8 +513,10 @@ astra::outcome::Result<void, Http2ServerError> NgHttp2Server::start() {
   std::string port = "8080";
 
   // Remove protocol prefix
+  bool use_tls = false;
   size_t protocol_end = uri.find("://");
   if (protocol_end != std::string::npos) {
+    use_tls = uri.compare(0, protocol_end, "https") == 0;
     uri = uri.substr(protocol_end + 3);
   }
 
@@ -134,9 +531,37 @@ astra::outcome::Result<void, Http2ServerError> NgHttp2Server::start() {
 
   obs::info("Server starting on " + address + ":" + port);
 
+  if (m_session_server) {
+    if (use_tls) {
+      obs::error("Server failed to start: reuse_port needs an http:// uri");
+      return astra::outcome::Result<void, Http2ServerError>::Err(
+          Http2ServerError::BindFailed);
+    }
+    if (auto ec = m_session_server->listen_and_serve(address, port,
+                                                     m_config.reuse_port())) {
+      obs::error("Server failed to start: " + ec.message());
+      return astra::outcome::Result<void, Http2ServerError>::Err(
+          Http2ServerError::BindFailed);
+    }
+    m_is_running.store(true, std::memory_order_release);
+    obs::info("Server started successfully");
+    return astra::outcome::Result<void, Http2ServerError>::Ok();
+  }
+
+  if (use_tls && !m_tls) {
+    auto tls = TlsServerContext::create(m_config.tls());
+    if (tls.is_err()) {
+      return astra::outcome::Result<void, Http2ServerError>::Err(
+          tls.error());
+    }
+    m_tls = std::move(tls).value();
+  }
+
   boost::system::error_code ec;
 
-  if (m_server.listen_and_serve(ec, address, port, true)) {
+  if (use_tls ? m_server.listen_and_serve(ec, m_tls->context(), address, port,
+                                          true)
+              : m_server.listen_and_serve(ec, address, port, true)) {
     obs::error("Server failed to start: " + ec.message());
     return astra::outcome::Result<void, Http2ServerError>::Err(
         Http2ServerError::BindFailed);
@@ -147,13 +572,29 @@ astra::outcome::Result<void, Http2ServerError> NgHttp2Server::start() {
   return astra::outcome::Result<void, Http2ServerError>::Ok();
 }
 
+astra::outcome::Result<void, Http2ServerError>
+NgHttp2Server::adopt(int socket, std::string preread,
+                     std::optional<H2cUpgrade> upgrade) {
+  if (!m_session_server || !m_is_running.load(std::memory_order_acquire)) {
+    ::close(socket);
+    return astra::outcome::Result<void, Http2ServerError>::Err(
+        Http2ServerError::NotStarted);
+  }
+  m_session_server->adopt(socket, std::move(preread), std::move(upgrade));
+  return astra::outcome::Result<void, Http2ServerError>::Ok();
+}
+
 astra::outcome::Result<void, Http2ServerError> NgHttp2Server::join() {
   if (!m_is_running.load(std::memory_order_acquire)) {
     return astra::outcome::Result<void, Http2ServerError>::Err(
         Http2ServerError::NotStarted);
   }
 
-  m_server.join();
+  if (m_session_server) {
+    m_session_server->join();
+  } else {
+    m_server.join();
+  }
   m_is_running.store(false, std::memory_order_release);
   obs::info("Server stopped cleanly");
   return astra::outcome::Result<void, Http2ServerError>::Ok();
@@ -165,7 +606,11 @@ astra::outcome::Result<void, Http2ServerError> NgHttp2Server::stop() {
         Http2ServerError::NotStarted);
   }
 
-  m_server.stop();
+  if (m_session_server) {
+    m_session_server->stop();
+  } else {
+    m_server.stop();
+  }
   obs::info("Server stop requested");
   return astra::outcome::Result<void, Http2ServerError>::Ok();
 }
@@ -0,0 +1,97 @@
+#include "ResponseBatcher.h"
+
+#include <memory>
+#include <utility>
+
+namespace astra::http2 {
+
+boost::asio::io_context::id ResponseBatcher::id;
+
+ResponseBatcher::ResponseBatcher(boost::asio::io_context &ioc)
+    : boost::asio::io_context::service(ioc), m_ioc(ioc) {
+}
+
+ResponseBatcher::~ResponseBatcher() {
+  destroy(m_head.exchange(nullptr));
+  destroy(m_unfinished.exchange(nullptr));
+}
+
+void ResponseBatcher::post(std::function<void()> work) {
+  auto *node = new Node{std::move(work), m_head.load()};
+  while (!m_head.compare_exchange_weak(node->next, node)) {
+  }
+
+  if (!m_scheduled.exchange(true)) {
+    boost::asio::post(m_ioc, [this] {
+      drain();
+    });
+  }
+}
+
+void ResponseBatcher::dispatch(std::function<void()> work) {
+  if (m_ioc.get_executor().running_in_this_thread()) {
+    work();
+    return;
+  }
+  post(std::move(work));
+}
+
+void ResponseBatcher::drain() {
+  // Cleared before taking the batch: a push racing with the drain either
+  // lands in this batch or posts the next one
+  m_scheduled.store(false);
+  Node *list = m_head.exchange(nullptr);
+
+  Node *ordered = nullptr;
+  while (list) {
+    Node *next = list->next;
+    list->next = ordered;
+    ordered = list;
+    list = next;
+  }
+
+  if (Node *unfinished = m_unfinished.exchange(nullptr)) {
+    Node *tail = unfinished;
+    while (tail->next) {
+      tail = tail->next;
+    }
+    tail->next = ordered;
+    ordered = unfinished;
+  }
+
+  while (ordered) {
+    std::unique_ptr<Node> node(ordered);
+    ordered = node->next;
+    try {
+      node->work();
+    } catch (...) {
+      // The exception leaves io_context::run() like any handler's; the rest
+      // of the batch is kept for the next drain, ahead of newer work
+      if (ordered) {
+        m_unfinished.store(ordered);
+        if (!m_scheduled.exchange(true)) {
+          boost::asio::post(m_ioc, [this] {
+            drain();
+          });
+        }
+      }
+      throw;
+    }
+  }
+}
+
+// Work still queued when the io_context shuts down is dropped, like
+// handlers posted to it directly
+void ResponseBatcher::shutdown() {
+  destroy(m_head.exchange(nullptr));
+  destroy(m_unfinished.exchange(nullptr));
+}
+
+void ResponseBatcher::destroy(Node *list) noexcept {
+  while (list) {
+    std::unique_ptr<Node> node(list);
+    list = node->next;
+  }
+}
+
+} // namespace astra::http2
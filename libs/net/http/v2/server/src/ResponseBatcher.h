@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <boost/asio.hpp>
+#include <functional>
+
+namespace astra::http2 {
+
+// Coalesces the response work handed to one io_context. Producers on any
+// thread push onto a lock-free stack; the first push after a drain posts a
+// single handler that runs everything queued so far, in submission order,
+// so a burst of responses costs one io_context handler instead of one each.
+//
+// One instance per io_context, created on first use through of().
+class ResponseBatcher : public boost::asio::io_context::service {
+public:
+  static boost::asio::io_context::id id;
+
+  explicit ResponseBatcher(boost::asio::io_context &ioc);
+  ~ResponseBatcher() override;
+
+  static ResponseBatcher &of(boost::asio::io_context &ioc) {
+    return boost::asio::use_service<ResponseBatcher>(ioc);
+  }
+
+  // Callable from any thread; `work` runs on the io thread
+  void post(std::function<void()> work);
+
+  // Runs `work` right away when called on the io thread, where there is
+  // nothing to hand over; otherwise post()s it
+  void dispatch(std::function<void()> work);
+
+private:
+  struct Node {
+    std::function<void()> work;
+    Node *next;
+  };
+
+  void shutdown() override;
+  void drain();
+  static void destroy(Node *list) noexcept;
+
+  boost::asio::io_context &m_ioc;
+  // Newest first; drain() reverses it
+  std::atomic<Node *> m_head{nullptr};
+  // Oldest first: the rest of a batch whose work threw, run before m_head
+  std::atomic<Node *> m_unfinished{nullptr};
+  std::atomic<bool> m_scheduled{false};
+};
+
+} // namespace astra::http2
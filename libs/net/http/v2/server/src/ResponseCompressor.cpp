@@ -0,0 +1,469 @@
+#include "ResponseCompressor.h"
+
+#include <Log.h>
+#include <Metrics.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <zlib.h>
+
+#ifdef ASTRA_HAS_ZSTD
+#include <zstd.h>
+#endif
+#ifdef ASTRA_HAS_BROTLI
+#include <brotli/encode.h>
+#endif
+
+namespace astra::http2 {
+
+namespace {
+
+struct Handles {
+  obs::Counter bytes_in = obs::register_counter(
+      "http2.server.compression.bytes.in", obs::Unit::Bytes);
+  obs::Counter bytes_out = obs::register_counter(
+      "http2.server.compression.bytes.out", obs::Unit::Bytes);
+  obs::Counter cache_hits =
+      obs::register_counter("http2.server.compression.cache.hits");
+};
+
+const Handles &handles() {
+  static const Handles instance;
+  return instance;
+}
+
+constexpr ContentEncoding ALL_ENCODINGS[] = {
+    ContentEncoding::Brotli, ContentEncoding::Zstd, ContentEncoding::Gzip};
+
+bool iequals(std::string_view a, std::string_view b) {
+  return a.size() == b.size() &&
+         std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+           return std::tolower(static_cast<unsigned char>(x)) ==
+                  std::tolower(static_cast<unsigned char>(y));
+         });
+}
+
+std::string_view trim(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+    s.remove_prefix(1);
+  }
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+    s.remove_suffix(1);
+  }
+  return s;
+}
+
+std::optional<ContentEncoding> from_name(std::string_view coding) {
+  if (iequals(coding, "br")) {
+    return ContentEncoding::Brotli;
+  }
+  if (iequals(coding, "zstd")) {
+    return ContentEncoding::Zstd;
+  }
+  if (iequals(coding, "gzip") || iequals(coding, "x-gzip")) {
+    return ContentEncoding::Gzip;
+  }
+  return std::nullopt;
+}
+
+// The q parameter of an Accept-Encoding item, 1 when absent
+double quality(std::string_view params) {
+  while (!params.empty()) {
+    auto semi = params.find(';');
+    auto param = trim(params.substr(0, semi));
+    params = semi == std::string_view::npos ? std::string_view{}
+                                            : params.substr(semi + 1);
+    if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') &&
+        param[1] == '=') {
+      return std::strtod(std::string(param.substr(2)).c_str(), nullptr);
+    }
+  }
+  return 1.0;
+}
+
+using Headers = std::map<std::string, std::string>;
+
+template <typename Map>
+auto find_header(Map &headers, std::string_view name) {
+  return std::find_if(headers.begin(), headers.end(), [name](const auto &h) {
+    return iequals(h.first, name);
+  });
+}
+
+bool ends_with(std::string_view s, std::string_view suffix) {
+  return s.size() >= suffix.size() &&
+         iequals(s.substr(s.size() - suffix.size()), suffix);
+}
+
+// Text-like types compress well; images, archives and the like are
+// compressed already
+bool compressible(std::string_view content_type) {
+  auto type = trim(content_type.substr(0, content_type.find(';')));
+  return (type.size() > 5 && iequals(type.substr(0, 5), "text/")) ||
+         iequals(type, "application/json") ||
+         iequals(type, "application/javascript") ||
+         iequals(type, "application/xml") || ends_with(type, "+json") ||
+         ends_with(type, "+xml");
+}
+
+void add_vary(Headers &headers) {
+  auto vary = find_header(headers, "vary");
+  if (vary == headers.end()) {
+    headers.emplace("vary", "accept-encoding");
+    return;
+  }
+  std::string lowered = vary->second;
+  std::transform(lowered.begin(), lowered.end(), lowered.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  if (lowered.find("accept-encoding") == std::string::npos &&
+      trim(lowered) != "*") {
+    vary->second += ", accept-encoding";
+  }
+}
+
+// One deflate stream per thread, reset between bodies instead of
+// allocating its window and tables for each one
+class Deflater {
+public:
+  ~Deflater() {
+    if (m_level) {
+      deflateEnd(&m_stream);
+    }
+  }
+
+  std::string gzip(std::string_view body, int level) {
+    if (body.size() > std::numeric_limits<uInt>::max() || !reset(level)) {
+      return {};
+    }
+    std::string out(deflateBound(&m_stream, body.size()), '\0');
+    m_stream.next_in =
+        reinterpret_cast<Bytef *>(const_cast<char *>(body.data()));
+    m_stream.avail_in = static_cast<uInt>(body.size());
+    m_stream.next_out = reinterpret_cast<Bytef *>(out.data());
+    m_stream.avail_out = static_cast<uInt>(out.size());
+    if (deflate(&m_stream, Z_FINISH) != Z_STREAM_END) {
+      return {};
+    }
+    out.resize(m_stream.total_out);
+    return out;
+  }
+
+private:
+  bool reset(int level) {
+    if (m_level == level) {
+      return deflateReset(&m_stream) == Z_OK;
+    }
+    if (m_level) {
+      deflateEnd(&m_stream);
+      m_level.reset();
+    }
+    m_stream = z_stream{};
+    // 16 + 15: a gzip wrapper around the largest window
+    if (deflateInit2(&m_stream, level, Z_DEFLATED, 16 + 15, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+      return false;
+    }
+    m_level = level;
+    return true;
+  }
+
+  z_stream m_stream{};
+  std::optional<int> m_level;
+};
+
+} // namespace
+
+ResponseCompressor::ResponseCompressor(
+    const ::http2::CompressionConfig &config)
+    : m_min_size_bytes(config.min_size_bytes() > 0 ? config.min_size_bytes()
+                                                   : DEFAULT_MIN_SIZE_BYTES),
+      m_gzip_level(config.gzip_level() != 0 ? config.gzip_level()
+                                            : DEFAULT_GZIP_LEVEL),
+      m_zstd_level(config.zstd_level() != 0 ? config.zstd_level()
+                                            : DEFAULT_ZSTD_LEVEL),
+      m_brotli_quality(config.brotli_quality() != 0
+                           ? config.brotli_quality()
+                           : DEFAULT_BROTLI_QUALITY),
+      m_cache_entries(config.disable_cache() ? 0
+                      : config.cache_entries() > 0
+                          ? config.cache_entries()
+                          : DEFAULT_CACHE_ENTRIES),
+      m_cache_max_body_bytes(config.cache_max_body_bytes() > 0
+                                 ? config.cache_max_body_bytes()
+                                 : DEFAULT_CACHE_MAX_BODY_BYTES) {
+  handles();
+  size_t stripes = std::clamp<size_t>(m_cache_entries / MIN_STRIPE_ENTRIES, 1,
+                                      MAX_STRIPES);
+  m_stripe_entries = (m_cache_entries + stripes - 1) / stripes;
+  for (size_t i = 0; i < stripes; ++i) {
+    m_stripes.push_back(std::make_unique<Stripe>());
+  }
+  if (config.encodings().empty()) {
+    for (auto encoding : ALL_ENCODINGS) {
+      if (is_available(encoding)) {
+        m_preference.push_back(encoding);
+      }
+    }
+    return;
+  }
+  for (const auto &coding : config.encodings()) {
+    auto encoding = from_name(coding);
+    if (!encoding) {
+      obs::warn("Unknown response coding ignored: " + coding);
+    } else if (!is_available(*encoding)) {
+      obs::warn("Response coding not built in, ignored: " + coding);
+    } else if (std::find(m_preference.begin(), m_preference.end(),
+                         *encoding) == m_preference.end()) {
+      m_preference.push_back(*encoding);
+    }
+  }
+}
+
+bool ResponseCompressor::is_available(ContentEncoding encoding) noexcept {
+  switch (encoding) {
+  case ContentEncoding::Gzip:
+    return true;
+  case ContentEncoding::Zstd:
+#ifdef ASTRA_HAS_ZSTD
+    return true;
+#else
+    return false;
+#endif
+  case ContentEncoding::Brotli:
+#ifdef ASTRA_HAS_BROTLI
+    return true;
+#else
+    return false;
+#endif
+  }
+  return false;
+}
+
+std::string_view ResponseCompressor::name(ContentEncoding encoding) noexcept {
+  switch (encoding) {
+  case ContentEncoding::Gzip:
+    return "gzip";
+  case ContentEncoding::Zstd:
+    return "zstd";
+  case ContentEncoding::Brotli:
+    return "br";
+  }
+  return "identity";
+}
+
+// The coding the client ranks highest, the server's preference breaking
+// ties; "*" stands for any coding the client does not list
+std::optional<ContentEncoding>
+ResponseCompressor::negotiate(std::string_view accept_encoding) const {
+  double listed[std::size(ALL_ENCODINGS)] = {-1, -1, -1};
+  double any = -1;
+  while (!accept_encoding.empty()) {
+    auto comma = accept_encoding.find(',');
+    auto item = accept_encoding.substr(0, comma);
+    accept_encoding = comma == std::string_view::npos
+                          ? std::string_view{}
+                          : accept_encoding.substr(comma + 1);
+    auto semi = item.find(';');
+    auto coding = trim(item.substr(0, semi));
+    double q = semi == std::string_view::npos
+                   ? 1.0
+                   : quality(item.substr(semi + 1));
+    if (coding == "*") {
+      any = q;
+    } else if (auto encoding = from_name(coding)) {
+      listed[static_cast<size_t>(*encoding)] = q;
+    }
+  }
+
+  std::optional<ContentEncoding> best;
+  double best_q = 0;
+  for (auto encoding : m_preference) {
+    double q = listed[static_cast<size_t>(encoding)];
+    if (q < 0) {
+      q = any;
+    }
+    if (q > best_q) {
+      best = encoding;
+      best_q = q;
+    }
+  }
+  return best;
+}
+
+bool ResponseCompressor::would_compress(
+    std::optional<ContentEncoding> encoding,
+    const std::map<std::string, std::string> &headers,
+    const std::string &body) const {
+  if (!encoding || body.size() < m_min_size_bytes) {
+    return false;
+  }
+  auto type = find_header(headers, "content-type");
+  return type != headers.end() && compressible(type->second) &&
+         find_header(headers, "content-encoding") == headers.end();
+}
+
+void ResponseCompressor::apply(std::optional<ContentEncoding> encoding,
+                               std::map<std::string, std::string> &headers,
+                               std::string &body) {
+  if (body.size() < m_min_size_bytes) {
+    return;
+  }
+  auto type = find_header(headers, "content-type");
+  if (type == headers.end() || !compressible(type->second) ||
+      find_header(headers, "content-encoding") != headers.end()) {
+    return;
+  }
+  add_vary(headers);
+  if (!encoding) {
+    return;
+  }
+
+  const auto &h = handles();
+  h.bytes_in.inc(body.size());
+  auto compressed = compress(*encoding, body);
+  if (!compressed) {
+    h.bytes_out.inc(body.size());
+    return;
+  }
+  h.bytes_out.inc(compressed->size());
+  if (auto length = find_header(headers, "content-length");
+      length != headers.end()) {
+    headers.erase(length);
+  }
+  headers["content-encoding"] = std::string(name(*encoding));
+  body = std::move(*compressed);
+}
+
+std::optional<std::string>
+ResponseCompressor::compress(ContentEncoding encoding, std::string_view body) {
+  if (!cacheable(body)) {
+    auto out = encode(encoding, body);
+    if (out.empty() || out.size() >= body.size()) {
+      return std::nullopt;
+    }
+    return out;
+  }
+
+  uint64_t key = std::hash<std::string_view>{}(body) ^
+                 ((static_cast<uint64_t>(encoding) + 1) * 0x9e3779b97f4a7c15);
+  Stripe &stripe = stripe_for(key);
+  bool admit = false;
+  {
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.entries.find(key);
+    if (it != stripe.entries.end() && it->second.body == body) {
+      stripe.order.splice(stripe.order.begin(), stripe.order,
+                          it->second.order);
+      handles().cache_hits.inc();
+      if (it->second.compressed.empty()) {
+        return std::nullopt;
+      }
+      return it->second.compressed;
+    }
+    // Cached from the second sighting on
+    admit = !stripe.seen.insert(key).second;
+    if (admit) {
+      stripe.seen.erase(key);
+    } else if (stripe.seen.size() > 4 * m_stripe_entries) {
+      stripe.seen.clear();
+    }
+  }
+
+  auto out = encode(encoding, body);
+  bool smaller = !out.empty() && out.size() < body.size();
+  if (admit) {
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.entries.find(key);
+    if (it == stripe.entries.end()) {
+      stripe.order.push_front(key);
+      it = stripe.entries.emplace(key, CacheEntry{{}, {}, stripe.order.begin()})
+               .first;
+    } else {
+      stripe.order.splice(stripe.order.begin(), stripe.order,
+                          it->second.order);
+    }
+    it->second.body.assign(body);
+    it->second.compressed = smaller ? out : std::string{};
+    if (stripe.entries.size() > m_stripe_entries) {
+      stripe.entries.erase(stripe.order.back());
+      stripe.order.pop_back();
+    }
+  }
+  if (!smaller) {
+    return std::nullopt;
+  }
+  return out;
+}
+
+size_t ResponseCompressor::cached_bodies() const {
+  size_t total = 0;
+  for (const auto &stripe : m_stripes) {
+    std::lock_guard<std::mutex> lock(stripe->mutex);
+    total += stripe->entries.size();
+  }
+  return total;
+}
+
+ResponseCompressor::Stripe &
+ResponseCompressor::stripe_for(uint64_t key) noexcept {
+  // The low bits pick the bucket inside the stripe's map
+  return *m_stripes[(key >> 32) % m_stripes.size()];
+}
+
+bool ResponseCompressor::cacheable(std::string_view body) const noexcept {
+  return m_cache_entries > 0 && body.size() <= m_cache_max_body_bytes;
+}
+
+// Empty on failure
+std::string ResponseCompressor::encode(ContentEncoding encoding,
+                                       std::string_view body) const {
+  switch (encoding) {
+  case ContentEncoding::Gzip: {
+    thread_local Deflater deflater;
+    return deflater.gzip(body, m_gzip_level);
+  }
+  case ContentEncoding::Zstd: {
+#ifdef ASTRA_HAS_ZSTD
+    thread_local std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx *)> context(
+        ZSTD_createCCtx(), ZSTD_freeCCtx);
+    std::string out(ZSTD_compressBound(body.size()), '\0');
+    size_t size =
+        ZSTD_compressCCtx(context.get(), out.data(), out.size(), body.data(),
+                          body.size(), m_zstd_level);
+    if (ZSTD_isError(size)) {
+      return {};
+    }
+    out.resize(size);
+    return out;
+#else
+    return {};
+#endif
+  }
+  case ContentEncoding::Brotli: {
+#ifdef ASTRA_HAS_BROTLI
+    size_t size = BrotliEncoderMaxCompressedSize(body.size());
+    if (size == 0) {
+      return {};
+    }
+    std::string out(size, '\0');
+    if (!BrotliEncoderCompress(
+            m_brotli_quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+            body.size(), reinterpret_cast<const uint8_t *>(body.data()),
+            &size, reinterpret_cast<uint8_t *>(out.data()))) {
+      return {};
+    }
+    out.resize(size);
+    return out;
+#else
+    return {};
+#endif
+  }
+  }
+  return {};
+}
+
+} // namespace astra::http2
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "http2server.pb.h"
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace astra::http2 {
+
+enum class ContentEncoding { Gzip, Zstd, Brotli };
+
+// Compresses buffered responses with the coding the server prefers among
+// those the request's Accept-Encoding allows. A body is compressed when it
+// is at least min_size_bytes, has a text-like content type and no
+// content-encoding of its own, and only sent compressed when that makes it
+// smaller. Streamed responses go out as they are.
+//
+// The second time a body is seen it is kept in compressed form, so a
+// response that repeats, such as an error body or a popular JSON document,
+// is compressed once per coding. A first sighting only records a
+// fingerprint, which keeps one-off bodies out of the cache. The cache is
+// split into stripes by body hash, each under a lock of its own, so threads
+// compressing different bodies do not wait on each other. Recorded as
+//   http2.server.compression.bytes.in    bodies before compression
+//   http2.server.compression.bytes.out   the same bodies as sent
+//   http2.server.compression.cache.hits  bodies served from the cache
+//
+// Thread-safe; apply() runs on the thread that finishes the response, or
+// on the server's compression threads when that is an io thread.
+class ResponseCompressor {
+public:
+  static constexpr uint32_t DEFAULT_MIN_SIZE_BYTES = 1024;
+  static constexpr uint32_t DEFAULT_CACHE_ENTRIES = 256;
+  static constexpr uint32_t DEFAULT_CACHE_MAX_BODY_BYTES = 64 * 1024;
+  static constexpr int DEFAULT_GZIP_LEVEL = 6;
+  static constexpr int DEFAULT_ZSTD_LEVEL = 3;
+  static constexpr int DEFAULT_BROTLI_QUALITY = 5;
+  static constexpr uint32_t DEFAULT_OFFLOAD_THREADS = 2;
+  // Each stripe holds at least this many entries, so a small cache keeps
+  // an exact LRU order
+  static constexpr size_t MIN_STRIPE_ENTRIES = 32;
+  static constexpr size_t MAX_STRIPES = 16;
+
+  explicit ResponseCompressor(const ::http2::CompressionConfig &config);
+
+  // Whether the codec was built in
+  static bool is_available(ContentEncoding encoding) noexcept;
+  // The Content-Encoding token
+  static std::string_view name(ContentEncoding encoding) noexcept;
+
+  // The coding to answer a request with this Accept-Encoding in, nullopt
+  // when it accepts none of the server's
+  [[nodiscard]] std::optional<ContentEncoding>
+  negotiate(std::string_view accept_encoding) const;
+
+  // Compresses `body` with `encoding`, the coding negotiated for the
+  // request, and sets the headers to match when worthwhile. Any response
+  // that qualifies gets Vary: accept-encoding, compressed or not.
+  void apply(std::optional<ContentEncoding> encoding,
+             std::map<std::string, std::string> &headers,
+             std::string &body);
+
+  // Whether apply() would try to compress `body`; cheap, checks only the
+  // size and headers
+  [[nodiscard]] bool
+  would_compress(std::optional<ContentEncoding> encoding,
+                 const std::map<std::string, std::string> &headers,
+                 const std::string &body) const;
+
+  // `body` compressed, from the cache when possible; nullopt when
+  // compressing does not make it smaller
+  std::optional<std::string> compress(ContentEncoding encoding,
+                                      std::string_view body);
+
+  [[nodiscard]] size_t cached_bodies() const;
+
+private:
+  struct CacheEntry {
+    std::string body;
+    // Empty when compressing does not make the body smaller
+    std::string compressed;
+    std::list<uint64_t>::iterator order;
+  };
+
+  struct Stripe {
+    std::mutex mutex;
+    // Keys by recency, most recent first
+    std::list<uint64_t> order;
+    std::unordered_map<uint64_t, CacheEntry> entries;
+    // Keys of bodies seen once
+    std::unordered_set<uint64_t> seen;
+  };
+
+  std::string encode(ContentEncoding encoding, std::string_view body) const;
+  bool cacheable(std::string_view body) const noexcept;
+  Stripe &stripe_for(uint64_t key) noexcept;
+
+  std::vector<ContentEncoding> m_preference;
+  uint32_t m_min_size_bytes;
+  int m_gzip_level;
+  int m_zstd_level;
+  int m_brotli_quality;
+  size_t m_cache_entries;
+  size_t m_cache_max_body_bytes;
+  // Entries each stripe keeps
+  size_t m_stripe_entries;
+  std::vector<std::unique_ptr<Stripe>> m_stripes;
+};
+
+} // namespace astra::http2
@@ -0,0 +1,916 @@
+#include "SessionServer.h"
+
+#include "StreamMetrics.h"
+
+#include <Log.h>
+#include <SessionIo.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <nghttp2/nghttp2.h>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+namespace astra::http2 {
+
+namespace {
+
+using local = boost::asio::local::stream_protocol;
+using tcp = boost::asio::ip::tcp;
+
+#ifdef SO_REUSEPORT
+using reuse_port_option =
+    boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+// Socket buffer sizes; on a TCP listener they are inherited by accepted
+// sockets in time for the window scale of the handshake
+template <typename Socket>
+void set_buffer_sizes(Socket &socket, const SessionServer::Options &options) {
+  boost::system::error_code ec;
+  if (options.receive_buffer_bytes > 0) {
+    socket.set_option(boost::asio::socket_base::receive_buffer_size(
+                          options.receive_buffer_bytes),
+                      ec);
+  }
+  if (options.send_buffer_bytes > 0) {
+    socket.set_option(
+        boost::asio::socket_base::send_buffer_size(options.send_buffer_bytes),
+        ec);
+  }
+  if (ec) {
+    obs::debug("Could not size socket buffers: " + ec.message());
+  }
+}
+
+template <typename Acceptor>
+boost::system::error_code
+open_listener(Acceptor &acceptor,
+              const typename Acceptor::endpoint_type &endpoint,
+              const SessionServer::Options &options, bool reuse_port) {
+  boost::system::error_code ec;
+  acceptor.open(endpoint.protocol(), ec);
+  if constexpr (std::is_same_v<Acceptor, tcp::acceptor>) {
+    if (!ec) {
+      acceptor.set_option(boost::asio::socket_base::reuse_address(true), ec);
+    }
+    if (!ec && reuse_port) {
+#ifdef SO_REUSEPORT
+      acceptor.set_option(reuse_port_option(true), ec);
+#else
+      ec = boost::asio::error::operation_not_supported;
+#endif
+    }
+    if (!ec) {
+      set_buffer_sizes(acceptor, options);
+    }
+  }
+  if (!ec) {
+    acceptor.bind(endpoint, ec);
+  }
+  if (!ec) {
+    acceptor.listen(options.backlog > 0
+                        ? options.backlog
+                        : boost::asio::socket_base::max_listen_connections,
+                    ec);
+  }
+  return ec;
+}
+
+nghttp2_nv make_nv(const std::string &name, const std::string &value) {
+  return nghttp2_nv{
+      reinterpret_cast<uint8_t *>(const_cast<char *>(name.data())),
+      reinterpret_cast<uint8_t *>(const_cast<char *>(value.data())),
+      name.size(), value.size(), NGHTTP2_NV_FLAG_NONE};
+}
+
+int hex_value(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+// nghttp2-asio hands handlers the decoded path
+std::string percent_decode(std::string_view in) {
+  std::string out;
+  out.reserve(in.size());
+  for (size_t i = 0; i < in.size(); ++i) {
+    if (in[i] == '%' && i + 2 < in.size()) {
+      int hi = hex_value(in[i + 1]);
+      int lo = hex_value(in[i + 2]);
+      if (hi >= 0 && lo >= 0) {
+        out.push_back(static_cast<char>(hi * 16 + lo));
+        i += 2;
+        continue;
+      }
+    }
+    out.push_back(in[i]);
+  }
+  return out;
+}
+
+// HTTP2-Settings is base64url without padding (RFC 7540 section 3.2.1)
+bool decode_base64url(std::string_view in, std::string &out) {
+  auto value = [](char c) -> int {
+    if (c >= 'A' && c <= 'Z') {
+      return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+      return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+      return c - '0' + 52;
+    }
+    if (c == '-') {
+      return 62;
+    }
+    if (c == '_') {
+      return 63;
+    }
+    return -1;
+  };
+
+  uint32_t acc = 0;
+  int bits = 0;
+  for (char c : in) {
+    if (c == '=') {
+      break;
+    }
+    int v = value(c);
+    if (v < 0) {
+      return false;
+    }
+    acc = (acc << 6) | static_cast<uint32_t>(v);
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      out.push_back(static_cast<char>((acc >> bits) & 0xff));
+    }
+  }
+  return true;
+}
+
+// Fields of the upgraded HTTP/1.1 request that HTTP/2 forbids or that only
+// served the upgrade (RFC 7540 sections 3.2 and 8.1.2.2)
+bool is_hop_by_hop(std::string_view name) {
+  return name == "connection" || name == "keep-alive" ||
+         name == "proxy-connection" || name == "transfer-encoding" ||
+         name == "upgrade" || name == "http2-settings";
+}
+
+std::string to_lower(std::string s) {
+  std::transform(s.begin(), s.end(), s.begin(), [](char c) {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  });
+  return s;
+}
+
+} // namespace
+
+struct SessionStream {
+  SessionStream(ServerConnection &c, int32_t stream_id)
+      : conn(c), id(stream_id), request(*this), response(*this) {
+  }
+
+  // Splits a :path, or an HTTP/1.1 request target, into the uri
+  void set_path(const std::string &target) {
+    auto query = target.find('?');
+    uri.raw_path = target.substr(0, query);
+    if (query != std::string::npos) {
+      uri.raw_query = target.substr(query + 1);
+    }
+    uri.path = percent_decode(uri.raw_path);
+  }
+
+  ServerConnection &conn;
+  int32_t id;
+
+  std::string method;
+  nghttp2::asio_http2::uri_ref uri;
+  nghttp2::asio_http2::header_map headers;
+  nghttp2::asio_http2::data_cb on_data;
+  nghttp2::asio_http2::close_cb on_close;
+  // Body bytes are credited back by the callable defer_consume() returned
+  bool defer_consume{false};
+  // Request read over HTTP/1.1 before the switch to h2c, so its body never
+  // took any flow-control window
+  bool upgraded{false};
+
+  unsigned int status{200};
+  nghttp2::asio_http2::header_map response_headers;
+  std::string body;
+  size_t body_offset{0};
+  nghttp2::asio_http2::generator_cb generator;
+  bool submitted{false};
+
+  SessionRequest request;
+  SessionResponse response;
+};
+
+// The nghttp2 session and streams of one accepted connection, whatever
+// socket carries it; SocketConnection adds the socket
+class ServerConnection {
+public:
+  ServerConnection(SessionServer &server, boost::asio::io_context &ioc)
+      : m_server(server), m_ioc(ioc) {
+  }
+  virtual ~ServerConnection();
+
+  ServerConnection(const ServerConnection &) = delete;
+  ServerConnection &operator=(const ServerConnection &) = delete;
+
+  void submit_response(SessionStream &stream);
+  void cancel(SessionStream &stream, uint32_t error_code);
+  void resume(SessionStream &stream);
+  // Credits `len` body bytes of `stream_id` back to the peer
+  void consume(int32_t stream_id, size_t len);
+  virtual std::weak_ptr<ServerConnection> weak_self() = 0;
+
+  boost::asio::io_context &io_context() {
+    return m_ioc;
+  }
+
+protected:
+  friend struct ServerCallbacks;
+
+  // Creates the session and queues the server SETTINGS
+  bool start_session();
+  // Takes `upgrade` as stream 1, already half-closed, and dispatches it
+  bool start_upgraded(H2cUpgrade upgrade);
+  virtual void schedule_write() = 0;
+  virtual bool is_open() const = 0;
+  void close_streams(uint32_t error_code);
+  void dispatch(SessionStream &stream);
+
+  SessionServer &m_server;
+  boost::asio::io_context &m_ioc;
+  nghttp2_session *m_session{nullptr};
+  std::map<int32_t, std::unique_ptr<SessionStream>> m_streams;
+};
+
+// A connection served on the io thread its socket belongs to
+template <typename Socket>
+class SocketConnection final
+    : public ServerConnection,
+      public std::enable_shared_from_this<SocketConnection<Socket>>,
+      public SessionIo<SocketConnection<Socket>, Socket> {
+public:
+  SocketConnection(SessionServer &server, boost::asio::io_context &ioc,
+                   Socket socket)
+      : ServerConnection(server, ioc),
+        SessionIo<SocketConnection<Socket>, Socket>(std::move(socket)) {
+  }
+
+  void start(std::string preread = {},
+             std::optional<H2cUpgrade> upgrade = std::nullopt) {
+    StreamMetrics::of(m_ioc).connection_opened();
+    const auto &options = m_server.options();
+    auto &socket = this->socket();
+    if constexpr (std::is_same_v<Socket, tcp::socket>) {
+      boost::system::error_code ec;
+      socket.set_option(tcp::no_delay(options.tcp_nodelay), ec);
+    }
+    set_buffer_sizes(socket, options);
+    bool started = start_session() &&
+                   (!upgrade || start_upgraded(std::move(*upgrade)));
+    if (!started) {
+      this->close_io(boost::asio::error::connection_aborted);
+      return;
+    }
+    this->set_read_timeout(options.read_timeout);
+    if (m_server.m_read_gate) {
+      this->set_read_gate(m_server.m_read_gate, m_server.m_max_read_hold);
+    }
+    this->start_io(preread);
+  }
+
+  nghttp2_session *nghttp2() const {
+    return m_session;
+  }
+
+  std::weak_ptr<ServerConnection> weak_self() override {
+    return this->weak_from_this();
+  }
+
+  void on_io_closed(const boost::system::error_code &ec) {
+    if (ec == boost::asio::error::connection_aborted) {
+      obs::debug("HTTP/2 session error, closing the connection");
+    }
+    StreamMetrics::of(m_ioc).connection_closed();
+    close_streams(NGHTTP2_INTERNAL_ERROR);
+  }
+
+private:
+  void schedule_write() override {
+    this->signal_write();
+  }
+
+  bool is_open() const override {
+    return !this->is_closed();
+  }
+};
+
+// libnghttp2 callbacks; `user_data` is the ServerConnection
+struct ServerCallbacks {
+  static ServerConnection &self(void *user_data) {
+    return *static_cast<ServerConnection *>(user_data);
+  }
+
+  static SessionStream *find(ServerConnection &conn, int32_t stream_id) {
+    auto it = conn.m_streams.find(stream_id);
+    return it == conn.m_streams.end() ? nullptr : it->second.get();
+  }
+
+  static int on_begin_headers(nghttp2_session *, const nghttp2_frame *frame,
+                              void *user_data) {
+    if (frame->hd.type == NGHTTP2_HEADERS &&
+        frame->headers.cat == NGHTTP2_HCAT_REQUEST) {
+      auto &conn = self(user_data);
+      conn.m_streams[frame->hd.stream_id] =
+          std::make_unique<SessionStream>(conn, frame->hd.stream_id);
+    }
+    return 0;
+  }
+  static int on_header(nghttp2_session *, const nghttp2_frame *frame,
+                       const uint8_t *name, size_t namelen,
+                       const uint8_t *value, size_t valuelen, uint8_t,
+                       void *user_data) {
+    auto *stream = find(self(user_data), frame->hd.stream_id);
+    if (!stream) {
+      return 0;
+    }
+    std::string_view n(reinterpret_cast<const char *>(name), namelen);
+    std::string v(reinterpret_cast<const char *>(value), valuelen);
+    if (n == ":method") {
+      stream->method = std::move(v);
+    } else if (n == ":path") {
+      stream->set_path(v);
+    } else if (n == ":authority") {
+      stream->uri.host = v;
+    } else if (n == ":scheme") {
+      stream->uri.scheme = v;
+    } else if (!n.empty() && n.front() != ':') {
+      stream->headers.emplace(std::string(n),
+                              nghttp2::asio_http2::header_value{v, false});
+    }
+    return 0;
+  }
+
+  // Automatic window updates are off, so every chunk is credited back here
+  // unless its stream has taken that over
+  static int on_data_chunk(nghttp2_session *session, uint8_t,
+                           int32_t stream_id, const uint8_t *data, size_t len,
+                           void *user_data) {
+    auto *stream = find(self(user_data), stream_id);
+    bool deferred = stream && stream->defer_consume;
+    if (stream && stream->on_data) {
+      stream->on_data(data, len);
+    }
+    if (!deferred) {
+      nghttp2_session_consume(session, stream_id, len);
+    }
+    return 0;
+  }
+
+  static int on_frame_recv(nghttp2_session *, const nghttp2_frame *frame,
+                           void *user_data) {
+    if (frame->hd.type != NGHTTP2_HEADERS &&
+        frame->hd.type != NGHTTP2_DATA) {
+      return 0;
+    }
+    auto &conn = self(user_data);
+    auto *stream = find(conn, frame->hd.stream_id);
+    if (!stream) {
+      return 0;
+    }
+    if (frame->hd.type == NGHTTP2_HEADERS &&
+        frame->headers.cat == NGHTTP2_HCAT_REQUEST) {
+      conn.dispatch(*stream);
+    }
+    if ((frame->hd.flags & NGHTTP2_FLAG_END_STREAM) &&
+        stream->on_data) {
+      stream->on_data(nullptr, 0);
+    }
+    return 0;
+  }
+
+  static int on_stream_close(nghttp2_session *, int32_t stream_id,
+                             uint32_t error_code, void *user_data) {
+    auto &conn = self(user_data);
+    auto it = conn.m_streams.find(stream_id);
+    if (it == conn.m_streams.end()) {
+      return 0;
+    }
+    auto stream = std::move(it->second);
+    conn.m_streams.erase(it);
+    if (stream->on_close) {
+      stream->on_close(error_code);
+    }
+    return 0;
+  }
+
+  static ssize_t read_body(nghttp2_session *, int32_t stream_id, uint8_t *buf,
+                           size_t length, uint32_t *data_flags,
+                           nghttp2_data_source *, void *user_data) {
+    auto *stream = find(self(user_data), stream_id);
+    if (!stream) {
+      return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+    }
+    if (stream->generator) {
+      return stream->generator(buf, length, data_flags);
+    }
+    size_t n = std::min(length, stream->body.size() - stream->body_offset);
+    std::memcpy(buf, stream->body.data() + stream->body_offset, n);
+    stream->body_offset += n;
+    if (stream->body_offset == stream->body.size()) {
+      *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+    }
+    return static_cast<ssize_t>(n);
+  }
+};
+
+
+const nghttp2::asio_http2::header_map &SessionRequest::header() const {
+  return m_stream.headers;
+}
+
+const std::string &SessionRequest::method() const {
+  return m_stream.method;
+}
+
+const nghttp2::asio_http2::uri_ref &SessionRequest::uri() const {
+  return m_stream.uri;
+}
+
+void SessionRequest::on_data(nghttp2::asio_http2::data_cb cb) const {
+  m_stream.on_data = std::move(cb);
+}
+
+std::function<void(std::size_t)> SessionRequest::defer_consume() const {
+  if (m_stream.upgraded) {
+    return [](std::size_t) {};
+  }
+  m_stream.defer_consume = true;
+  return [conn = m_stream.conn.weak_self(),
+          id = m_stream.id](std::size_t len) {
+    auto self = conn.lock();
+    if (!self) {
+      return;
+    }
+    auto &ioc = self->io_context();
+    boost::asio::dispatch(ioc, [self = std::move(self), id, len] {
+      self->consume(id, len);
+    });
+  };
+}
+
+void SessionResponse::write_head(unsigned int status_code,
+                              nghttp2::asio_http2::header_map h) const {
+  m_stream.status = status_code;
+  m_stream.response_headers = std::move(h);
+}
+
+void SessionResponse::end(std::string data) const {
+  if (m_stream.submitted) {
+    return;
+  }
+  m_stream.body = std::move(data);
+  m_stream.conn.submit_response(m_stream);
+}
+
+void SessionResponse::end(nghttp2::asio_http2::generator_cb cb) const {
+  if (m_stream.submitted) {
+    return;
+  }
+  m_stream.generator = std::move(cb);
+  m_stream.conn.submit_response(m_stream);
+}
+
+void SessionResponse::on_close(nghttp2::asio_http2::close_cb cb) const {
+  m_stream.on_close = std::move(cb);
+}
+
+void SessionResponse::cancel(uint32_t error_code) const {
+  m_stream.conn.cancel(m_stream, error_code);
+}
+
+void SessionResponse::resume() const {
+  m_stream.conn.resume(m_stream);
+}
+
+boost::asio::io_context &SessionResponse::io_service() const {
+  return m_stream.conn.io_context();
+}
+
+ServerConnection::~ServerConnection() {
+  // Still open when the io_context is torn down with the server
+  close_streams(NGHTTP2_INTERNAL_ERROR);
+  if (m_session) {
+    nghttp2_session_del(m_session);
+  }
+}
+
+bool ServerConnection::start_session() {
+  nghttp2_session_callbacks *callbacks;
+  nghttp2_session_callbacks_new(&callbacks);
+  nghttp2_session_callbacks_set_on_begin_headers_callback(
+      callbacks, &ServerCallbacks::on_begin_headers);
+  nghttp2_session_callbacks_set_on_header_callback(callbacks,
+                                                   &ServerCallbacks::on_header);
+  nghttp2_session_callbacks_set_on_data_chunk_recv_callback(
+      callbacks, &ServerCallbacks::on_data_chunk);
+  nghttp2_session_callbacks_set_on_frame_recv_callback(
+      callbacks, &ServerCallbacks::on_frame_recv);
+  nghttp2_session_callbacks_set_on_stream_close_callback(
+      callbacks, &ServerCallbacks::on_stream_close);
+  // Window updates follow the body handlers, which may take a chunk after
+  // on_data returns; see defer_consume()
+  nghttp2_option *option;
+  nghttp2_option_new(&option);
+  nghttp2_option_set_no_auto_window_update(option, 1);
+  int rv = nghttp2_session_server_new2(&m_session, callbacks, this, option);
+  nghttp2_option_del(option);
+  nghttp2_session_callbacks_del(callbacks);
+  if (rv != 0) {
+    return false;
+  }
+
+  const auto &options = m_server.options();
+  std::vector<nghttp2_settings_entry> settings = {
+      {NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS,
+       options.max_concurrent_streams}};
+  if (options.initial_stream_window_bytes > 0) {
+    settings.push_back({NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE,
+                        std::min<uint32_t>(options.initial_stream_window_bytes,
+                                           NGHTTP2_MAX_WINDOW_SIZE)});
+  }
+  if (options.header_table_size > 0) {
+    settings.push_back(
+        {NGHTTP2_SETTINGS_HEADER_TABLE_SIZE, options.header_table_size});
+  }
+  if (nghttp2_submit_settings(m_session, NGHTTP2_FLAG_NONE, settings.data(),
+                              settings.size()) != 0) {
+    return false;
+  }
+  // Sent as a WINDOW_UPDATE on stream 0 right after the SETTINGS
+  if (options.connection_window_bytes > 0) {
+    return nghttp2_session_set_local_window_size(
+               m_session, NGHTTP2_FLAG_NONE, 0,
+               static_cast<int32_t>(std::min<uint32_t>(
+                   options.connection_window_bytes,
+                   NGHTTP2_MAX_WINDOW_SIZE))) == 0;
+  }
+  return true;
+}
+
+bool ServerConnection::start_upgraded(H2cUpgrade upgrade) {
+  std::string payload;
+  if (!decode_base64url(upgrade.settings, payload)) {
+    return false;
+  }
+  bool head = upgrade.method == "HEAD";
+  if (nghttp2_session_upgrade2(
+          m_session, reinterpret_cast<const uint8_t *>(payload.data()),
+          payload.size(), head ? 1 : 0, nullptr) != 0) {
+    return false;
+  }
+
+  auto &stream = *(m_streams[1] = std::make_unique<SessionStream>(*this, 1));
+  stream.method = std::move(upgrade.method);
+  stream.set_path(upgrade.target);
+  stream.uri.scheme = "http";
+  stream.upgraded = true;
+  for (auto &[name, value] : upgrade.headers) {
+    std::string key = to_lower(std::move(name));
+    if (key == "host") {
+      stream.uri.host = std::move(value);
+    } else if (!is_hop_by_hop(key)) {
+      stream.headers.emplace(
+          std::move(key),
+          nghttp2::asio_http2::header_value{std::move(value), false});
+    }
+  }
+
+  // The whole request came in over HTTP/1.1
+  dispatch(stream);
+  if (stream.on_data) {
+    if (!upgrade.body.empty()) {
+      stream.on_data(reinterpret_cast<const uint8_t *>(upgrade.body.data()),
+                     upgrade.body.size());
+    }
+    stream.on_data(nullptr, 0);
+  }
+  return true;
+}
+
+void ServerConnection::close_streams(uint32_t error_code) {
+  auto streams = std::move(m_streams);
+  m_streams.clear();
+  for (auto &[id, stream] : streams) {
+    if (stream->on_close) {
+      stream->on_close(error_code);
+    }
+  }
+}
+
+void ServerConnection::dispatch(SessionStream &stream) {
+  const auto *cb = m_server.find(stream.uri.path);
+  if (!cb) {
+    stream.response.write_head(404);
+    stream.response.end();
+    return;
+  }
+  (*cb)(stream.request, stream.response);
+}
+
+void ServerConnection::submit_response(SessionStream &stream) {
+  if (!is_open()) {
+    return;
+  }
+  stream.submitted = true;
+
+  std::vector<std::pair<std::string, std::string>> fields;
+  fields.reserve(stream.response_headers.size() + 1);
+  fields.emplace_back(":status", std::to_string(stream.status));
+  for (const auto &[key, value] : stream.response_headers) {
+    fields.emplace_back(to_lower(key), value.value);
+  }
+
+  std::vector<nghttp2_nv> nva;
+  nva.reserve(fields.size());
+  for (const auto &[name, value] : fields) {
+    nva.push_back(make_nv(name, value));
+  }
+
+  nghttp2_data_provider provider{};
+  provider.read_callback = &ServerCallbacks::read_body;
+  bool has_body = stream.generator || !stream.body.empty();
+  if (nghttp2_submit_response(m_session, stream.id, nva.data(), nva.size(),
+                              has_body ? &provider : nullptr) != 0) {
+    nghttp2_submit_rst_stream(m_session, NGHTTP2_FLAG_NONE, stream.id,
+                              NGHTTP2_INTERNAL_ERROR);
+  }
+  schedule_write();
+}
+
+void ServerConnection::cancel(SessionStream &stream, uint32_t error_code) {
+  if (!is_open()) {
+    return;
+  }
+  nghttp2_submit_rst_stream(m_session, NGHTTP2_FLAG_NONE, stream.id,
+                            error_code);
+  schedule_write();
+}
+
+void ServerConnection::resume(SessionStream &stream) {
+  if (!is_open()) {
+    return;
+  }
+  nghttp2_session_resume_data(m_session, stream.id);
+  schedule_write();
+}
+
+void ServerConnection::consume(int32_t stream_id, size_t len) {
+  if (!is_open()) {
+    return;
+  }
+  // Credits the connection window even once the stream has closed
+  nghttp2_session_consume(m_session, stream_id, len);
+  schedule_write();
+}
+
+std::optional<std::string>
+SessionServer::socket_path(const std::string &uri) {
+  if (uri.compare(0, URI_SCHEME.size(), URI_SCHEME) != 0 ||
+      uri.size() == URI_SCHEME.size()) {
+    return std::nullopt;
+  }
+  return uri.substr(URI_SCHEME.size());
+}
+
+SessionServer::SessionServer(Options options) : m_options(options) {
+  m_options.threads = std::max<size_t>(m_options.threads, 1);
+}
+
+SessionServer::~SessionServer() {
+  stop();
+  join();
+}
+
+void SessionServer::handle(const std::string &pattern, RequestCallback cb) {
+  for (auto &route : m_routes) {
+    if (route.first == pattern) {
+      route.second = std::move(cb);
+      return;
+    }
+  }
+  m_routes.emplace_back(pattern, std::move(cb));
+}
+
+const SessionServer::RequestCallback *
+SessionServer::find(const std::string &path) const {
+  const std::pair<std::string, RequestCallback> *best = nullptr;
+  for (const auto &route : m_routes) {
+    const auto &pattern = route.first;
+    bool match = !pattern.empty() && pattern.back() == '/'
+                     ? path.compare(0, pattern.size(), pattern) == 0
+                     : path == pattern;
+    if (match && (!best || pattern.size() > best->first.size())) {
+      best = &route;
+    }
+  }
+  return best ? &best->second : nullptr;
+}
+
+boost::system::error_code
+SessionServer::listen_and_serve(const std::string &path) {
+  // A socket file left by a previous run makes bind() fail; anything that
+  // is not a socket is left alone
+  struct stat st {};
+  if (::stat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+    ::unlink(path.c_str());
+  }
+
+  create_io_contexts();
+  m_unix_acceptor = std::make_unique<local::acceptor>(*m_io_contexts.front());
+  if (auto ec = open_listener(*m_unix_acceptor, local::endpoint(path),
+                              m_options, false)) {
+    abandon();
+    return ec;
+  }
+  m_path = path;
+  do_accept(*m_unix_acceptor, nullptr);
+  run_io_threads();
+  return {};
+}
+
+boost::system::error_code
+SessionServer::listen_and_serve(const std::string &address,
+                                const std::string &port, bool reuse_port) {
+  boost::system::error_code ec;
+  boost::asio::io_context resolver_ioc;
+  tcp::resolver resolver(resolver_ioc);
+  auto endpoints = resolver.resolve(address, port, ec);
+  if (ec) {
+    return ec;
+  }
+  auto endpoint = endpoints.begin()->endpoint();
+
+  create_io_contexts();
+  size_t listeners = reuse_port ? m_io_contexts.size() : 1;
+  for (size_t i = 0; i < listeners; ++i) {
+    auto acceptor = std::make_unique<tcp::acceptor>(*m_io_contexts[i]);
+    if ((ec = open_listener(*acceptor, endpoint, m_options, reuse_port))) {
+      abandon();
+      return ec;
+    }
+    // With port 0 the later listeners must join the port the first one got
+    endpoint.port(acceptor->local_endpoint().port());
+    m_tcp_acceptors.push_back(std::move(acceptor));
+  }
+
+  for (size_t i = 0; i < listeners; ++i) {
+    do_accept(*m_tcp_acceptors[i],
+              reuse_port ? m_io_contexts[i].get() : nullptr);
+  }
+  run_io_threads();
+  return ec;
+}
+
+void SessionServer::serve() {
+  create_io_contexts();
+  run_io_threads();
+}
+
+void SessionServer::adopt(int socket, std::string preread,
+                          std::optional<H2cUpgrade> upgrade) {
+  if (m_io_contexts.empty() || m_stopped.load(std::memory_order_acquire)) {
+    ::close(socket);
+    return;
+  }
+  sockaddr_storage addr{};
+  socklen_t len = sizeof(addr);
+  boost::system::error_code ec;
+  if (::getsockname(socket, reinterpret_cast<sockaddr *>(&addr), &len) != 0) {
+    ec.assign(errno, boost::system::system_category());
+  }
+  auto &ioc = next_io_context();
+  tcp::socket own(ioc);
+  if (!ec) {
+    own.assign(addr.ss_family == AF_INET6 ? tcp::v6() : tcp::v4(), socket,
+               ec);
+  }
+  if (ec) {
+    ::close(socket);
+    obs::debug("Could not adopt an HTTP/2 connection: " + ec.message());
+    return;
+  }
+
+  auto conn =
+      std::make_shared<SocketConnection<tcp::socket>>(*this, ioc,
+                                                      std::move(own));
+  boost::asio::post(ioc, [conn, preread = std::move(preread),
+                          upgrade = std::move(upgrade)]() mutable {
+    conn->start(std::move(preread), std::move(upgrade));
+  });
+}
+
+void SessionServer::create_io_contexts() {
+  for (size_t i = 0; i < m_options.threads; ++i) {
+    auto ioc = std::make_shared<boost::asio::io_context>(1);
+    StreamMetrics::of(*ioc).set_shard(i);
+    m_work.push_back(boost::asio::make_work_guard(*ioc));
+    m_io_contexts.push_back(std::move(ioc));
+  }
+}
+
+boost::asio::io_context &SessionServer::next_io_context() {
+  return *m_io_contexts[m_next_io_context.fetch_add(
+                            1, std::memory_order_relaxed) %
+                        m_io_contexts.size()];
+}
+
+void SessionServer::abandon() {
+  m_unix_acceptor.reset();
+  m_tcp_acceptors.clear();
+  m_work.clear();
+  m_io_contexts.clear();
+}
+
+void SessionServer::run_io_threads() {
+  for (auto &ioc : m_io_contexts) {
+    m_threads.emplace_back([ioc] {
+      try {
+        ioc->run();
+      } catch (const std::exception &e) {
+        obs::error(std::string("HTTP/2 session io thread error: ") +
+                   e.what());
+      }
+    });
+  }
+}
+
+template <typename Acceptor>
+void SessionServer::do_accept(Acceptor &acceptor,
+                              boost::asio::io_context *home) {
+  using Socket = typename Acceptor::protocol_type::socket;
+  // A listener of its own io thread keeps its connections there; a shared
+  // one spreads them over the io threads round-robin
+  auto &ioc = home ? *home : next_io_context();
+  auto socket = std::make_shared<Socket>(ioc);
+  acceptor.async_accept(*socket, [this, &acceptor, home, socket,
+                                  &ioc](const boost::system::error_code &ec) {
+    if (ec == boost::asio::error::operation_aborted ||
+        m_stopped.load(std::memory_order_acquire)) {
+      return;
+    }
+    if (!ec) {
+      auto conn = std::make_shared<SocketConnection<Socket>>(
+          *this, ioc, std::move(*socket));
+      boost::asio::post(ioc, [conn] {
+        conn->start();
+      });
+    }
+    do_accept(acceptor, home);
+  });
+}
+
+void SessionServer::stop() {
+  m_stopped.store(true, std::memory_order_release);
+  m_work.clear();
+  for (auto &ioc : m_io_contexts) {
+    ioc->stop();
+  }
+}
+
+void SessionServer::join() {
+  for (auto &thread : m_threads) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+  m_threads.clear();
+  boost::system::error_code ec;
+  if (m_unix_acceptor) {
+    m_unix_acceptor->close(ec);
+    m_unix_acceptor.reset();
+    ::unlink(m_path.c_str());
+  }
+  for (auto &acceptor : m_tcp_acceptors) {
+    acceptor->close(ec);
+  }
+  m_tcp_acceptors.clear();
+}
+
+} // namespace astra::http2
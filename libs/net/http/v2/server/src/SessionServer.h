@@ -0,0 +1,184 @@
+#pragma once
+
+#include "H2cUpgrade.h"
+
+#include <atomic>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <nghttp2/asio_http2.h>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace astra::http2 {
+
+class ServerConnection;
+struct SessionStream;
+
+// Request and response of one stream served by a SessionServer. They
+// mirror the nghttp2-asio server request and response, so the per-stream
+// code in NgHttp2Server serves both. Valid until the on_close callback has
+// run; use only on the connection's io thread.
+class SessionRequest {
+public:
+  explicit SessionRequest(SessionStream &stream) : m_stream(stream) {
+  }
+
+  const nghttp2::asio_http2::header_map &header() const;
+  const std::string &method() const;
+  const nghttp2::asio_http2::uri_ref &uri() const;
+  void on_data(nghttp2::asio_http2::data_cb cb) const;
+  // Leaves crediting the body back to the peer's flow-control window to the
+  // returned callable, which takes the bytes to credit and may be called
+  // from any thread. Otherwise each chunk is credited once on_data returns.
+  std::function<void(std::size_t)> defer_consume() const;
+
+private:
+  SessionStream &m_stream;
+};
+
+class SessionResponse {
+public:
+  explicit SessionResponse(SessionStream &stream) : m_stream(stream) {
+  }
+
+  void write_head(unsigned int status_code,
+                  nghttp2::asio_http2::header_map h = {}) const;
+  void end(std::string data = "") const;
+  void end(nghttp2::asio_http2::generator_cb cb) const;
+  void on_close(nghttp2::asio_http2::close_cb cb) const;
+  void cancel(uint32_t error_code) const;
+  void resume() const;
+  boost::asio::io_context &io_service() const;
+
+private:
+  SessionStream &m_stream;
+};
+
+// Prior knowledge h2c over sockets it owns, each connection a libnghttp2
+// session driven by SessionIo: a Unix domain socket, which nghttp2-asio
+// cannot listen on, TCP, or a connection accepted elsewhere. Routing follows
+// nghttp2-asio: a pattern ending in '/' matches its whole subtree, others
+// match exactly, and the longest match wins.
+class SessionServer {
+public:
+  using RequestCallback =
+      std::function<void(const SessionRequest &, const SessionResponse &)>;
+
+  static constexpr std::string_view URI_SCHEME = "unix://";
+  static constexpr uint32_t DEFAULT_MAX_CONCURRENT_STREAMS = 100;
+
+  // Applied to every connection; a zero keeps the default noted
+  struct Options {
+    size_t threads{1};
+    // 0 uses SOMAXCONN
+    int backlog{0};
+    // 0 never closes an idle connection
+    std::chrono::milliseconds read_timeout{0};
+    uint32_t max_concurrent_streams{DEFAULT_MAX_CONCURRENT_STREAMS};
+    // SETTINGS_INITIAL_WINDOW_SIZE; 0 keeps the protocol's 65535
+    uint32_t initial_stream_window_bytes{0};
+    // Receive window of the whole connection; 0 keeps the protocol's 65535
+    uint32_t connection_window_bytes{0};
+    // SETTINGS_HEADER_TABLE_SIZE; 0 keeps the protocol's 4096
+    uint32_t header_table_size{0};
+    // TCP only
+    bool tcp_nodelay{true};
+    // SO_RCVBUF and SO_SNDBUF; 0 keeps the kernel's
+    int receive_buffer_bytes{0};
+    int send_buffer_bytes{0};
+  };
+
+  // The socket path of a unix:///path uri, nullopt for any other uri
+  static std::optional<std::string> socket_path(const std::string &uri);
+
+  explicit SessionServer(Options options);
+  ~SessionServer();
+
+  SessionServer(const SessionServer &) = delete;
+  SessionServer &operator=(const SessionServer &) = delete;
+
+  const Options &options() const noexcept {
+    return m_options;
+  }
+
+  void handle(const std::string &pattern, RequestCallback cb);
+
+  // While `open` returns false, connections stop reading from their
+  // sockets, for at most `max_hold` at a time. Set before
+  // listen_and_serve(); called on the io threads.
+  void set_read_gate(std::function<bool()> open,
+                     std::chrono::milliseconds max_hold) {
+    m_read_gate = std::move(open);
+    m_max_read_hold = max_hold;
+  }
+
+  // Replaces a stale socket file, binds and starts the io threads
+  boost::system::error_code listen_and_serve(const std::string &path);
+  // Binds address:port and starts the io threads. With `reuse_port` every
+  // io thread gets an SO_REUSEPORT listener of its own on the endpoint and
+  // serves the connections it accepts, so the kernel balances connections
+  // and the threads share no acceptor; otherwise one listener hands them
+  // out round-robin.
+  boost::system::error_code listen_and_serve(const std::string &address,
+                                             const std::string &port,
+                                             bool reuse_port = false);
+  // Starts the io threads without a listener; connections come in through
+  // adopt() only
+  void serve();
+  // Serves a TCP connection accepted elsewhere, given its descriptor, on
+  // the next io thread round-robin. `preread` holds bytes already read from
+  // the socket; `upgrade` is the request that switched it to h2c, whose 101
+  // has been sent. Callable from any thread once serving; the socket is
+  // closed if the server is not.
+  void adopt(int socket, std::string preread,
+             std::optional<H2cUpgrade> upgrade);
+  void stop();
+  void join();
+
+  const std::vector<std::shared_ptr<boost::asio::io_context>> &
+  io_services() const {
+    return m_io_contexts;
+  }
+
+private:
+  friend class ServerConnection;
+  template <typename Socket> friend class SocketConnection;
+
+  void create_io_contexts();
+  // Undoes a listen_and_serve() that failed to bind
+  void abandon();
+  void run_io_threads();
+  // Round-robin over the io threads
+  boost::asio::io_context &next_io_context();
+  // `home` is the io_context of a per-thread listener, nullptr for a
+  // shared one
+  template <typename Acceptor>
+  void do_accept(Acceptor &acceptor, boost::asio::io_context *home);
+  const RequestCallback *find(const std::string &path) const;
+
+  Options m_options;
+  std::vector<std::pair<std::string, RequestCallback>> m_routes;
+  std::function<bool()> m_read_gate;
+  std::chrono::milliseconds m_max_read_hold{0};
+
+  std::vector<std::shared_ptr<boost::asio::io_context>> m_io_contexts;
+  std::vector<boost::asio::executor_work_guard<
+      boost::asio::io_context::executor_type>>
+      m_work;
+  std::vector<std::thread> m_threads;
+  // Set by one of the listen_and_serve() overloads
+  std::unique_ptr<boost::asio::local::stream_protocol::acceptor>
+      m_unix_acceptor;
+  std::vector<std::unique_ptr<boost::asio::ip::tcp::acceptor>>
+      m_tcp_acceptors;
+  std::string m_path;
+  std::atomic<size_t> m_next_io_context{0};
+  std::atomic<bool> m_stopped{false};
+};
+
+} // namespace astra::http2
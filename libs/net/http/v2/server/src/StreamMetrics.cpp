@@ -0,0 +1,165 @@
+#include "StreamMetrics.h"
+
+#include <Metrics.h>
+#include <atomic>
+
+namespace astra::http2 {
+
+namespace {
+
+struct Handles {
+  obs::Counter opened = obs::register_counter("http2.server.streams.opened");
+  obs::Gauge active = obs::register_gauge("http2.server.streams.active");
+  obs::Counter reset = obs::register_counter("http2.server.streams.reset");
+  obs::Counter bytes_in =
+      obs::register_counter("http2.server.bytes.in", obs::Unit::Bytes);
+  obs::Counter bytes_out =
+      obs::register_counter("http2.server.bytes.out", obs::Unit::Bytes);
+  obs::DurationHistogram response_wait =
+      obs::register_duration_histogram("http2.server.response.wait");
+  obs::Counter dropped =
+      obs::register_counter("http2.server.responses.dropped");
+  obs::Counter connections_opened =
+      obs::register_counter("http2.server.connections.opened");
+  obs::Gauge connections_active =
+      obs::register_gauge("http2.server.connections.active");
+};
+
+const Handles &handles() {
+  static const Handles instance;
+  return instance;
+}
+
+std::atomic<uint64_t> g_dropped{0};
+
+} // namespace
+
+boost::asio::io_context::id StreamMetrics::id;
+
+StreamMetrics::StreamMetrics(boost::asio::io_context &ioc)
+    : boost::asio::io_context::service(ioc), m_ioc(ioc) {
+  handles();
+}
+
+void StreamMetrics::stream_opened() {
+  ++m_totals.opened;
+  schedule_flush();
+}
+
+void StreamMetrics::stream_closed(uint32_t error_code) {
+  ++m_totals.closed;
+  if (error_code != 0) {
+    ++m_totals.reset;
+  }
+  schedule_flush();
+}
+
+void StreamMetrics::bytes_in(size_t n) {
+  m_totals.bytes_in += n;
+  schedule_flush();
+}
+
+void StreamMetrics::bytes_out(size_t n) {
+  m_totals.bytes_out += n;
+  schedule_flush();
+}
+
+void StreamMetrics::response_started(
+    std::chrono::steady_clock::duration waited) {
+  handles().response_wait.record(waited);
+}
+
+void StreamMetrics::connection_opened() {
+  ++m_totals.connections_opened;
+  m_connections.fetch_add(1, std::memory_order_relaxed);
+  schedule_flush();
+}
+
+void StreamMetrics::connection_closed() {
+  ++m_totals.connections_closed;
+  m_connections.fetch_sub(1, std::memory_order_relaxed);
+  schedule_flush();
+}
+
+void StreamMetrics::set_shard(size_t shard) {
+  m_shard = std::to_string(shard);
+}
+
+void StreamMetrics::response_dropped() noexcept {
+  g_dropped.fetch_add(1, std::memory_order_relaxed);
+  handles().dropped.inc();
+}
+
+uint64_t StreamMetrics::responses_dropped() noexcept {
+  return g_dropped.load(std::memory_order_relaxed);
+}
+
+void StreamMetrics::shutdown() {
+  flush();
+  m_timer.reset();
+  // Counts after this point have nowhere to go
+  m_flush_scheduled = true;
+}
+
+void StreamMetrics::schedule_flush() {
+  if (m_flush_scheduled) {
+    return;
+  }
+  m_flush_scheduled = true;
+  if (!m_timer) {
+    m_timer.emplace(m_ioc);
+  }
+  m_timer->expires_after(FLUSH_INTERVAL);
+  m_timer->async_wait([this](const boost::system::error_code &ec) {
+    if (ec) {
+      return;
+    }
+    m_flush_scheduled = false;
+    flush();
+  });
+}
+
+void StreamMetrics::flush() noexcept {
+  const auto &h = handles();
+  auto delta = [](uint64_t total, uint64_t &flushed) {
+    uint64_t d = total - flushed;
+    flushed = total;
+    return d;
+  };
+
+  uint64_t opened = delta(m_totals.opened, m_flushed.opened);
+  uint64_t closed = delta(m_totals.closed, m_flushed.closed);
+  uint64_t reset = delta(m_totals.reset, m_flushed.reset);
+  uint64_t bytes_in = delta(m_totals.bytes_in, m_flushed.bytes_in);
+  uint64_t bytes_out = delta(m_totals.bytes_out, m_flushed.bytes_out);
+  uint64_t connections_opened =
+      delta(m_totals.connections_opened, m_flushed.connections_opened);
+  uint64_t connections_closed =
+      delta(m_totals.connections_closed, m_flushed.connections_closed);
+
+  if (opened > 0) {
+    h.opened.inc(opened);
+  }
+  if (opened != closed) {
+    h.active.add(static_cast<int64_t>(opened) - static_cast<int64_t>(closed));
+  }
+  if (reset > 0) {
+    h.reset.inc(reset);
+  }
+  if (bytes_in > 0) {
+    h.bytes_in.inc(bytes_in);
+  }
+  if (bytes_out > 0) {
+    h.bytes_out.inc(bytes_out);
+  }
+  if (connections_opened > 0) {
+    h.connections_opened.inc(connections_opened);
+  }
+  if (connections_opened != connections_closed) {
+    h.connections_active.add(static_cast<int64_t>(connections_opened) -
+                                 static_cast<int64_t>(connections_closed),
+                             {{"shard", m_shard}});
+  }
+}
+
+} // namespace astra::http2
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace astra::http2 {
+
+// Transport metrics of the HTTP/2 server, one instance per io thread:
+//   http2.server.streams.opened     streams that reached a handler
+//   http2.server.streams.active     gauge of those not yet closed
+//   http2.server.streams.reset      closed with an error code (RST_STREAM
+//                                   either way, or GOAWAY)
+//   http2.server.bytes.in / .out    request and response DATA payload
+//   http2.server.response.wait      end of request to response handed to
+//                                   nghttp2
+//   http2.server.responses.dropped  responses finished after their stream
+//                                   was closed
+//   http2.server.connections.opened connections served by transports that
+//   http2.server.connections.active own their sockets (unix sockets,
+//                                   reuse_port, adopted h2c); the gauge
+//                                   carries the io thread's index as a
+//                                   `shard` attribute
+//
+// Counts are summed in plain fields and handed to the metric handles by a
+// timer FLUSH_INTERVAL after the first count that is not yet flushed, and
+// when the io_context shuts down, so the per-stream cost is a few increments
+// and an idle server still reports its last counts. Apart from
+// response_dropped(), call only from the instance's io thread.
+class StreamMetrics : public boost::asio::io_context::service {
+public:
+  static boost::asio::io_context::id id;
+  static constexpr auto FLUSH_INTERVAL = std::chrono::seconds(1);
+
+  struct Totals {
+    uint64_t opened{0};
+    uint64_t closed{0};
+    uint64_t reset{0};
+    uint64_t bytes_in{0};
+    uint64_t bytes_out{0};
+    uint64_t connections_opened{0};
+    uint64_t connections_closed{0};
+  };
+
+  explicit StreamMetrics(boost::asio::io_context &ioc);
+
+  static StreamMetrics &of(boost::asio::io_context &ioc) {
+    return boost::asio::use_service<StreamMetrics>(ioc);
+  }
+
+  void stream_opened();
+  void stream_closed(uint32_t error_code);
+  void bytes_in(size_t n);
+  void bytes_out(size_t n);
+  void response_started(std::chrono::steady_clock::duration waited);
+  void connection_opened();
+  void connection_closed();
+
+  // Index of the io thread among the server's, reported with the
+  // connection gauge; set before the io thread runs
+  void set_shard(size_t shard);
+  // Connections open on this io thread now; callable from any thread
+  [[nodiscard]] int64_t connections() const noexcept {
+    return m_connections.load(std::memory_order_relaxed);
+  }
+
+  // Callable from any thread
+  static void response_dropped() noexcept;
+  // Process-wide count of response_dropped() calls
+  [[nodiscard]] static uint64_t responses_dropped() noexcept;
+
+  // Everything recorded on this io thread so far, flushed or not
+  [[nodiscard]] const Totals &totals() const noexcept {
+    return m_totals;
+  }
+  // What has been handed to the metric handles
+  [[nodiscard]] const Totals &flushed() const noexcept {
+    return m_flushed;
+  }
+
+private:
+  void shutdown() override;
+  void schedule_flush();
+  void flush() noexcept;
+
+  boost::asio::io_context &m_ioc;
+  Totals m_totals;
+  Totals m_flushed;
+  std::string m_shard{"0"};
+  std::atomic<int64_t> m_connections{0};
+  // Created on first use and dropped at shutdown, before the timer service
+  // it belongs to is destroyed
+  std::optional<boost::asio::steady_timer> m_timer;
+  bool m_flush_scheduled{false};
+};
+
+} // namespace astra::http2
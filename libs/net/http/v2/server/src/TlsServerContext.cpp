@@ -0,0 +1,230 @@
+#include "TlsServerContext.h"
+
+#include <Log.h>
+#include <Metrics.h>
+#include <nghttp2/asio_http2_server.h>
+#include <openssl/err.h>
+
+namespace astra::http2 {
+
+namespace {
+
+using Result =
+    astra::outcome::Result<std::unique_ptr<TlsServerContext>, Http2ServerError>;
+
+// Sessions are only resumed on contexts with the same id
+constexpr unsigned char SESSION_ID_CONTEXT[] = "astra-http2";
+
+struct Handles {
+  obs::Histogram handshake = obs::register_histogram(
+      "http2.server.tls.handshake", obs::Unit::Milliseconds);
+  obs::Counter full = obs::register_counter("http2.server.tls.handshakes.full");
+  obs::Counter resumed =
+      obs::register_counter("http2.server.tls.handshakes.resumed");
+};
+
+const Handles &handles() {
+  static const Handles instance;
+  return instance;
+}
+
+// Start of the handshake of one connection, kept on its SSL
+struct Handshake {
+  std::chrono::steady_clock::time_point start;
+  bool done{false};
+};
+
+void free_handshake(void *, void *ptr, CRYPTO_EX_DATA *, int, long, void *) {
+  delete static_cast<Handshake *>(ptr);
+}
+
+int handshake_index() {
+  static const int index =
+      SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, free_handshake);
+  return index;
+}
+
+int context_index() {
+  static const int index =
+      SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+  return index;
+}
+
+Result fail(const std::string &what) {
+  obs::error("TLS setup failed: " + what);
+  return Result::Err(Http2ServerError::TlsSetupFailed);
+}
+
+std::string openssl_error() {
+  char buffer[256];
+  ERR_error_string_n(ERR_get_error(), buffer, sizeof(buffer));
+  return buffer;
+}
+
+} // namespace
+
+TlsServerContext::TlsServerContext(size_t session_cache_size)
+    : m_context(boost::asio::ssl::context::tls_server),
+      m_session_cache_size(session_cache_size) {
+  handles();
+}
+
+TlsServerContext::~TlsServerContext() {
+  for (auto &[id, entry] : m_sessions) {
+    SSL_SESSION_free(entry.first);
+  }
+}
+
+Result TlsServerContext::create(const ::http2::ServerTlsConfig &config) {
+  std::unique_ptr<TlsServerContext> tls(
+      new TlsServerContext(config.session_cache_size() > 0
+                               ? config.session_cache_size()
+                               : DEFAULT_SESSION_CACHE_SIZE));
+  auto &context = tls->m_context;
+
+  boost::system::error_code ec;
+  if (context.use_certificate_chain_file(config.cert_file(), ec)) {
+    return fail(config.cert_file() + ": " + ec.message());
+  }
+  if (context.use_private_key_file(config.key_file(),
+                                   boost::asio::ssl::context::pem, ec)) {
+    return fail(config.key_file() + ": " + ec.message());
+  }
+  // ALPN, protocol versions and nghttp2's default ciphers
+  if (nghttp2::asio_http2::server::configure_tls_context_easy(ec, context)) {
+    return fail(ec.message());
+  }
+
+  SSL_CTX *native = context.native_handle();
+  if (!config.cipher_list().empty() &&
+      SSL_CTX_set_cipher_list(native, config.cipher_list().c_str()) != 1) {
+    return fail("cipher list " + config.cipher_list() + ": " +
+                openssl_error());
+  }
+  if (!config.ciphersuites().empty() &&
+      SSL_CTX_set_ciphersuites(native, config.ciphersuites().c_str()) != 1) {
+    return fail("ciphersuites " + config.ciphersuites() + ": " +
+                openssl_error());
+  }
+
+  // nghttp2-asio turns session tickets off; with neither tickets nor the
+  // cache every reconnect pays for a full handshake
+  SSL_CTX_set_session_cache_mode(native, SSL_SESS_CACHE_SERVER |
+                                             SSL_SESS_CACHE_NO_INTERNAL);
+  SSL_CTX_set_session_id_context(native, SESSION_ID_CONTEXT,
+                                 sizeof(SESSION_ID_CONTEXT) - 1);
+  SSL_CTX_sess_set_new_cb(native, &TlsServerContext::on_new_session);
+  SSL_CTX_sess_set_get_cb(native, &TlsServerContext::on_get_session);
+  if (config.session_timeout_s() > 0) {
+    SSL_CTX_set_timeout(native, config.session_timeout_s());
+  }
+  if (config.disable_session_tickets()) {
+    SSL_CTX_set_options(native, SSL_OP_NO_TICKET);
+  } else {
+    SSL_CTX_clear_options(native, SSL_OP_NO_TICKET);
+  }
+
+  SSL_CTX_set_ex_data(native, context_index(), tls.get());
+  SSL_CTX_set_info_callback(native, &TlsServerContext::on_info);
+  return Result::Ok(std::move(tls));
+}
+
+// Runs on the io thread of the connection
+void TlsServerContext::on_info(const SSL *ssl, int where, int) {
+  auto now = std::chrono::steady_clock::now();
+  auto *handshake =
+      static_cast<Handshake *>(SSL_get_ex_data(ssl, handshake_index()));
+  if (where & SSL_CB_HANDSHAKE_START) {
+    if (!handshake) {
+      SSL_set_ex_data(const_cast<SSL *>(ssl), handshake_index(),
+                      new Handshake{now});
+    }
+    return;
+  }
+  // TLS 1.3 reports post-handshake messages as handshakes too; only the
+  // first one counts
+  if (!(where & SSL_CB_HANDSHAKE_DONE) || !handshake || handshake->done) {
+    return;
+  }
+  handshake->done = true;
+  auto *self = static_cast<TlsServerContext *>(
+      SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), context_index()));
+  if (self) {
+    self->handshake_done(ssl, now - handshake->start);
+  }
+}
+
+size_t TlsServerContext::cached_sessions() const {
+  std::lock_guard<std::mutex> lock(m_sessions_mutex);
+  return m_sessions.size();
+}
+
+int TlsServerContext::on_new_session(SSL *ssl, SSL_SESSION *session) {
+  auto *self = static_cast<TlsServerContext *>(
+      SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), context_index()));
+  SSL_SESSION *copy = self ? SSL_SESSION_dup(session) : nullptr;
+  if (!copy) {
+    return 0;
+  }
+  unsigned int id_length = 0;
+  const unsigned char *id = SSL_SESSION_get_id(copy, &id_length);
+  std::string key(reinterpret_cast<const char *>(id), id_length);
+
+  std::lock_guard<std::mutex> lock(self->m_sessions_mutex);
+  auto it = self->m_sessions.find(key);
+  if (it != self->m_sessions.end()) {
+    SSL_SESSION_free(it->second.first);
+    self->m_session_order.erase(it->second.second);
+    self->m_sessions.erase(it);
+  }
+  self->m_session_order.push_front(key);
+  self->m_sessions.emplace(
+      std::move(key), std::make_pair(copy, self->m_session_order.begin()));
+  if (self->m_sessions.size() > self->m_session_cache_size) {
+    auto oldest = self->m_sessions.find(self->m_session_order.back());
+    SSL_SESSION_free(oldest->second.first);
+    self->m_sessions.erase(oldest);
+    self->m_session_order.pop_back();
+  }
+  // OpenSSL keeps its reference to `session`
+  return 0;
+}
+
+// OpenSSL checks the session has not expired before resuming it
+SSL_SESSION *TlsServerContext::on_get_session(SSL *ssl,
+                                              const unsigned char *id,
+                                              int id_length, int *copy) {
+  auto *self = static_cast<TlsServerContext *>(
+      SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), context_index()));
+  if (!self) {
+    return nullptr;
+  }
+  std::string key(reinterpret_cast<const char *>(id),
+                  static_cast<size_t>(id_length));
+  std::lock_guard<std::mutex> lock(self->m_sessions_mutex);
+  auto it = self->m_sessions.find(key);
+  if (it == self->m_sessions.end()) {
+    return nullptr;
+  }
+  self->m_session_order.splice(self->m_session_order.begin(),
+                               self->m_session_order, it->second.second);
+  // The cache keeps its reference; OpenSSL takes one of its own
+  *copy = 1;
+  return it->second.first;
+}
+
+void TlsServerContext::handshake_done(
+    const SSL *ssl, std::chrono::steady_clock::duration took) {
+  const auto &h = handles();
+  h.handshake.record(
+      std::chrono::duration<double, std::milli>(took).count());
+  if (SSL_session_reused(ssl)) {
+    m_resumed.fetch_add(1, std::memory_order_relaxed);
+    h.resumed.inc();
+  } else {
+    m_full.fetch_add(1, std::memory_order_relaxed);
+    h.full.inc();
+  }
+}
+
+} // namespace astra::http2
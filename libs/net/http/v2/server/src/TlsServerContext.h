@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Http2ServerError.h"
+#include "http2server.pb.h"
+
+#include <Result.h>
+#include <atomic>
+#include <boost/asio/ssl/context.hpp>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <openssl/ssl.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace astra::http2 {
+
+// TLS context of the HTTP/2 server: the certificate chain and key, h2
+// through ALPN, the configured ciphers, and session resumption through both
+// the session cache and session tickets, so a client reconnecting skips the
+// full handshake.
+//
+// The session cache is kept here rather than in OpenSSL, which drops a
+// session from its own cache when the connection is freed without a TLS
+// shutdown, as nghttp2-asio closes every connection. It holds copies, the
+// least recently used evicted first. Handshakes are recorded as
+//   http2.server.tls.handshake            start to finish, in ms
+//   http2.server.tls.handshakes.full      ones that negotiated new keys
+//   http2.server.tls.handshakes.resumed   ones that resumed a session
+//
+// Must outlive every connection accepted with context().
+class TlsServerContext {
+public:
+  static constexpr uint32_t DEFAULT_SESSION_CACHE_SIZE = 20480;
+
+  static astra::outcome::Result<std::unique_ptr<TlsServerContext>,
+                                Http2ServerError>
+  create(const ::http2::ServerTlsConfig &config);
+
+  ~TlsServerContext();
+
+  TlsServerContext(const TlsServerContext &) = delete;
+  TlsServerContext &operator=(const TlsServerContext &) = delete;
+
+  boost::asio::ssl::context &context() noexcept {
+    return m_context;
+  }
+
+  [[nodiscard]] size_t cached_sessions() const;
+
+  [[nodiscard]] uint64_t full_handshakes() const noexcept {
+    return m_full.load(std::memory_order_relaxed);
+  }
+  [[nodiscard]] uint64_t resumed_handshakes() const noexcept {
+    return m_resumed.load(std::memory_order_relaxed);
+  }
+
+private:
+  explicit TlsServerContext(size_t session_cache_size);
+
+  static void on_info(const SSL *ssl, int where, int ret);
+  static int on_new_session(SSL *ssl, SSL_SESSION *session);
+  static SSL_SESSION *on_get_session(SSL *ssl, const unsigned char *id,
+                                     int id_length, int *copy);
+  void handshake_done(const SSL *ssl,
+                      std::chrono::steady_clock::duration took);
+
+  boost::asio::ssl::context m_context;
+  size_t m_session_cache_size;
+  // Session ids, most recently used first, and the sessions by id; shared
+  // by the io threads
+  mutable std::mutex m_sessions_mutex;
+  std::list<std::string> m_session_order;
+  std::unordered_map<std::string,
+                     std::pair<SSL_SESSION *, std::list<std::string>::iterator>>
+      m_sessions;
+  std::atomic<uint64_t> m_full{0};
+  std::atomic<uint64_t> m_resumed{0};
+};
+
+} // namespace astra::http2
@@ -0,0 +1,102 @@
+#include "HeaderBlock.h"
+#include "Http2Request.h"
+#include "Http2Response.h"
+#include "Http2ResponseWriter.h"
+#include "StreamArena.h"
+
+#include <AllocationCounter.h>
+#include <benchmark/benchmark.h>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+// Counts heap allocations for the objects NgHttp2Server creates per stream:
+// response writer, header block, request, response and the send round trip.
+// Every benchmark reports `allocs_per_request`; compare the heap and arena
+// variants.
+
+using namespace astra::http2;
+using astra::utils::run_counted;
+
+namespace {
+
+const std::pair<std::string_view, std::string_view> kHeaders[] = {
+    {":authority", "api.example.com"},
+    {"accept", "application/json"},
+    {"accept-encoding", "gzip, deflate, br"},
+    {"content-type", "application/json"},
+    {"traceparent", "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01"},
+    {"user-agent", "astra-bench/1.0"},
+    {"x-request-id", "f3a1c2d4-5b6e-4f70-8a91-b2c3d4e5f607"},
+};
+
+void fill_headers(HeaderBlock &block) {
+  size_t bytes = 0;
+  for (const auto &[name, value] : kHeaders) {
+    bytes += name.size() + value.size();
+  }
+  block.reserve(std::size(kHeaders), bytes);
+  for (const auto &[name, value] : kHeaders) {
+    block.add(name, value);
+  }
+}
+
+// The transport callbacks capture a single reference, as in NgHttp2Server,
+// so they fit std::function's inline storage
+std::shared_ptr<Http2ResponseWriter>
+make_writer(int &sent, std::shared_ptr<StreamArena> arena) {
+  auto send = [&sent](int, std::map<std::string, std::string>,
+                      std::string) { ++sent; };
+  auto post = [](std::function<void()> work) { work(); };
+  if (arena) {
+    return make_in_arena<Http2ResponseWriter>(arena, send, post);
+  }
+  return std::make_shared<Http2ResponseWriter>(send, post);
+}
+
+void respond(Http2Response &response) {
+  response.set_status(200);
+  response.write("{\"ok\":true}");
+  response.close();
+}
+
+} // namespace
+
+// Every per-stream object gets its own heap allocation
+static void BM_StreamObjectsHeap(benchmark::State &state) {
+  int sent = 0;
+  run_counted(state, "allocs_per_request", [&] {
+    auto writer = make_writer(sent, nullptr);
+    HeaderBlock headers;
+    fill_headers(headers);
+    auto request = std::make_shared<Http2Request>(
+        "GET", "/users/12345", std::move(headers), std::string{},
+        "fields=name,email");
+    auto response = std::make_shared<Http2Response>(writer);
+    benchmark::DoNotOptimize(request->header("content-type"));
+    respond(*response);
+  });
+}
+BENCHMARK(BM_StreamObjectsHeap);
+
+// Writer, header block, request and response share one StreamArena
+static void BM_StreamObjectsArena(benchmark::State &state) {
+  int sent = 0;
+  run_counted(state, "allocs_per_request", [&] {
+    auto arena = StreamArena::create();
+    auto writer = make_writer(sent, arena);
+    HeaderBlock headers(arena);
+    fill_headers(headers);
+    auto request = make_in_arena<Http2Request>(
+        arena, "GET", "/users/12345", std::move(headers), std::string{},
+        "fields=name,email");
+    auto response = make_in_arena<Http2Response>(arena, writer);
+    benchmark::DoNotOptimize(request->header("content-type"));
+    respond(*response);
+  });
+}
+BENCHMARK(BM_StreamObjectsArena);
+
+BENCHMARK_MAIN();
@@ -1,4 +1,5 @@
 #include "Http2ResponseWriter.h"
+#include "ResponseCompressor.h"
 
 #include <IScopedResource.h>
 #include <boost/asio/executor_work_guard.hpp>
@@ -449,3 +450,177 @@ TEST_F(Http2ResponseWriterTest, ConcurrentCloseAndSend) {
   // No crashes = success
   EXPECT_FALSE(handle->is_alive());
 }
+
+TEST_F(Http2ResponseWriterTest, StreamStartPostsHeaders) {
+  auto handle =
+      std::make_shared<Http2ResponseWriter>(make_send_fn(), make_post_work());
+  int started_status = -1;
+  handle->set_stream_transport(
+      [&](Http2ResponseWriter &, int status,
+          std::map<std::string, std::string>) {
+        started_status = status;
+      },
+      [] {});
+  EXPECT_TRUE(handle->supports_streaming());
+
+  handle->start_stream(200, {});
+  EXPECT_EQ(started_status, -1);
+
+  io_ctx.run();
+  EXPECT_EQ(started_status, 200);
+  EXPECT_FALSE(send_called);
+}
+
+TEST_F(Http2ResponseWriterTest, StreamReadRespectsWindow) {
+  auto handle =
+      std::make_shared<Http2ResponseWriter>(make_send_fn(), make_post_work());
+  handle->write_stream("hello ");
+  handle->write_stream("world");
+  EXPECT_EQ(handle->pending_bytes(), 11);
+
+  uint8_t buf[16];
+  auto first = handle->read_stream(buf, 4);
+  EXPECT_EQ(first.bytes, 4);
+  EXPECT_FALSE(first.deferred);
+  EXPECT_FALSE(first.eof);
+  EXPECT_EQ(handle->pending_bytes(), 7);
+
+  auto rest = handle->read_stream(buf + 4, sizeof(buf) - 4);
+  EXPECT_EQ(rest.bytes, 7);
+  EXPECT_EQ(std::string(reinterpret_cast<char *>(buf), 11), "hello world");
+  EXPECT_EQ(handle->pending_bytes(), 0);
+}
+
+TEST_F(Http2ResponseWriterTest, StreamDefersUntilNextWrite) {
+  auto handle =
+      std::make_shared<Http2ResponseWriter>(make_send_fn(), make_post_work());
+  int resumes = 0;
+  handle->set_stream_transport(
+      [](Http2ResponseWriter &, int, std::map<std::string, std::string>) {},
+      [&] { ++resumes; });
+
+  uint8_t buf[16];
+  auto empty = handle->read_stream(buf, sizeof(buf));
+  EXPECT_EQ(empty.bytes, 0);
+  EXPECT_TRUE(empty.deferred);
+
+  handle->write_stream("chunk");
+  io_ctx.run();
+  EXPECT_EQ(resumes, 1);
+
+  auto data = handle->read_stream(buf, sizeof(buf));
+  EXPECT_EQ(data.bytes, 5);
+  EXPECT_FALSE(data.eof);
+
+  handle->end_stream();
+  auto end = handle->read_stream(buf, sizeof(buf));
+  EXPECT_EQ(end.bytes, 0);
+  EXPECT_TRUE(end.eof);
+  EXPECT_FALSE(end.deferred);
+}
+
+TEST_F(Http2ResponseWriterTest, StreamWritesAfterEndAreDropped) {
+  auto handle =
+      std::make_shared<Http2ResponseWriter>(make_send_fn(), make_post_work());
+  handle->write_stream("last");
+  handle->end_stream();
+  handle->write_stream("dropped");
+  EXPECT_EQ(handle->pending_bytes(), 4);
+
+  uint8_t buf[16];
+  auto read = handle->read_stream(buf, sizeof(buf));
+  EXPECT_EQ(read.bytes, 4);
+  EXPECT_TRUE(read.eof);
+}
+
+TEST_F(Http2ResponseWriterTest, StreamResumeSkippedAfterClose) {
+  auto handle =
+      std::make_shared<Http2ResponseWriter>(make_send_fn(), make_post_work());
+  int resumes = 0;
+  handle->set_stream_transport(
+      [](Http2ResponseWriter &, int, std::map<std::string, std::string>) {},
+      [&] { ++resumes; });
+
+  uint8_t buf[4];
+  (void)handle->read_stream(buf, sizeof(buf));
+  handle->mark_closed();
+  handle->write_stream("late");
+  io_ctx.run();
+
+  EXPECT_EQ(resumes, 0);
+}
+
+TEST_F(Http2ResponseWriterTest, StreamInterleavedWritesKeepOrder) {
+  auto handle =
+      std::make_shared<Http2ResponseWriter>(make_send_fn(), make_post_work());
+
+  std::string expected;
+  std::string received;
+  uint8_t buf[3];
+  for (int i = 0; i < 50; ++i) {
+    std::string chunk = std::to_string(i) + ",";
+    expected += chunk;
+    handle->write_stream(chunk);
+    auto read = handle->read_stream(buf, sizeof(buf));
+    received.append(reinterpret_cast<char *>(buf), read.bytes);
+  }
+  handle->end_stream();
+
+  for (;;) {
+    auto read = handle->read_stream(buf, sizeof(buf));
+    received.append(reinterpret_cast<char *>(buf), read.bytes);
+    if (read.eof) {
+      break;
+    }
+  }
+  EXPECT_EQ(received, expected);
+  EXPECT_EQ(handle->pending_bytes(), 0);
+}
+
+TEST_F(Http2ResponseWriterTest, CompressionGoesThroughOffload) {
+  ::http2::CompressionConfig config;
+  config.add_encodings("gzip");
+  auto compressor = std::make_shared<ResponseCompressor>(config);
+
+  std::vector<std::function<void()>> offloaded;
+  auto offload = [&offloaded](std::function<void()> work) {
+    offloaded.push_back(std::move(work));
+  };
+
+  auto handle =
+      std::make_shared<Http2ResponseWriter>(make_send_fn(), make_post_work());
+  handle->set_compression(compressor, ContentEncoding::Gzip, offload);
+  std::string body(8 * 1024, 'a');
+  handle->send(200, {{"content-type", "text/plain"}}, body);
+
+  // Nothing reaches the io thread until the offloaded work has run
+  EXPECT_EQ(io_ctx.poll(), 0u);
+  ASSERT_EQ(offloaded.size(), 1u);
+  offloaded.front()();
+  io_ctx.restart();
+  io_ctx.run();
+
+  EXPECT_TRUE(send_called);
+  EXPECT_EQ(captured_headers["content-encoding"], "gzip");
+  EXPECT_LT(captured_body.size(), body.size());
+}
+
+TEST_F(Http2ResponseWriterTest, BodyNotWorthCompressingSkipsOffload) {
+  auto compressor =
+      std::make_shared<ResponseCompressor>(::http2::CompressionConfig{});
+  int offloaded = 0;
+
+  auto handle =
+      std::make_shared<Http2ResponseWriter>(make_send_fn(), make_post_work());
+  handle->set_compression(compressor, ContentEncoding::Gzip,
+                          [&offloaded](std::function<void()> work) {
+                            ++offloaded;
+                            work();
+                          });
+  handle->send(200, {{"content-type", "text/plain"}}, "short");
+  handle->send(200, {{"content-type", "image/png"}}, std::string(8192, 'a'));
+  io_ctx.run();
+
+  EXPECT_EQ(offloaded, 0);
+  EXPECT_EQ(captured_body.size(), 8192u);
+}
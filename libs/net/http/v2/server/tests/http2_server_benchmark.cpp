@@ -5,8 +5,11 @@
 #include "Router.h"
 
 #include <benchmark/benchmark.h>
+#include <iterator>
 #include <memory>
+#include <string>
 #include <thread>
+#include <utility>
 
 using namespace astra::http2;
 using namespace astra::router;
@@ -64,4 +67,39 @@ static void BM_ServerConstruction(benchmark::State &state) {
 }
 BENCHMARK(BM_ServerConstruction);
 
+// Mirrors the per-stream work in NgHttp2Server: pack a typical header block,
+// build the request, then read a few headers and a query parameter
+static void BM_RequestHeaderAndQueryAccess(benchmark::State &state) {
+  const std::pair<std::string, std::string> headers[] = {
+      {":authority", "api.example.com"},
+      {"accept", "application/json"},
+      {"accept-encoding", "gzip, deflate, br"},
+      {"content-type", "application/json"},
+      {"traceparent",
+       "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01"},
+      {"user-agent", "astra-bench/1.0"},
+      {"x-request-id", "f3a1c2d4-5b6e-4f70-8a91-b2c3d4e5f607"},
+      {"x-forwarded-for", "203.0.113.7"},
+  };
+
+  for (auto _ : state) {
+    size_t bytes = 0;
+    for (const auto &h : headers) {
+      bytes += h.first.size() + h.second.size();
+    }
+    HeaderBlock block;
+    block.reserve(std::size(headers), bytes);
+    for (const auto &h : headers) {
+      block.add(h.first, h.second);
+    }
+
+    Http2Request request("GET", "/users/12345", std::move(block), {},
+                         "fields=name%2Cemail&page=2");
+    benchmark::DoNotOptimize(request.header("content-type"));
+    benchmark::DoNotOptimize(request.header("traceparent"));
+    benchmark::DoNotOptimize(request.query_param("fields"));
+  }
+}
+BENCHMARK(BM_RequestHeaderAndQueryAccess);
+
 BENCHMARK_MAIN();
@@ -3,11 +3,23 @@
 #include "Http2Server.h"
 #include "Router.h"
 
+#include <Backpressure.h>
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <boost/asio.hpp>
 #include <chrono>
+#include <cstring>
+#include <future>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <map>
+#include <mutex>
+#include <nghttp2/nghttp2.h>
+#include <set>
+#include <sys/stat.h>
 #include <thread>
+#include <vector>
 
 using namespace testing;
 using namespace std::chrono_literals;
@@ -60,6 +72,20 @@ TEST(Http2ServerTest, BindToAllInterfaces) {
   EXPECT_NE(server, nullptr);
 }
 
+TEST(Http2ServerTest, HttpsWithoutCertificateFailsToStart) {
+  astra::router::Router router;
+  auto config = make_config();
+  config.set_uri("https://127.0.0.1:9001");
+  config.mutable_tls()->set_cert_file("/nonexistent/cert.pem");
+  config.mutable_tls()->set_key_file("/nonexistent/key.pem");
+  astra::http2::Http2Server server(config, router);
+
+  auto result = server.start();
+
+  ASSERT_TRUE(result.is_err());
+  EXPECT_EQ(result.error(), astra::http2::Http2ServerError::TlsSetupFailed);
+}
+
 TEST(Http2ServerTest, HandlerRegistration) {
   astra::router::Router router;
   auto server = std::make_unique<astra::http2::Http2Server>(
@@ -74,6 +100,31 @@ TEST(Http2ServerTest, HandlerRegistration) {
   SUCCEED();
 }
 
+TEST(Http2ServerTest, StreamHandlerRegistration) {
+  astra::router::Router router;
+  auto config = make_config_port(9010);
+  config.set_max_request_body_bytes(1024);
+  auto server = std::make_unique<astra::http2::Http2Server>(config, router);
+
+  server->handle_stream(
+      "POST", "/upload",
+      [](std::shared_ptr<astra::http2::Http2Request>,
+         std::shared_ptr<astra::http2::Http2Response> res) {
+        auto received = std::make_shared<size_t>(0);
+        return astra::http2::RequestBodyHandler{
+            [received](std::string_view chunk) {
+              *received += chunk.size();
+            },
+            [received, res] {
+              res->set_status(200);
+              res->write(std::to_string(*received));
+              res->close();
+            }};
+      });
+
+  SUCCEED();
+}
+
 TEST(Http2ServerTest, MultipleHandlers) {
   astra::router::Router router;
   auto server = std::make_unique<astra::http2::Http2Server>(
@@ -283,6 +334,29 @@ TEST_F(Http2ServerRuntimeTest, DoubleStartReturnsError) {
   server_->stop();
 }
 
+TEST_F(Http2ServerRuntimeTest, StreamHandlerRegistrationBeforeStart) {
+  server_->handle_stream("PUT", "/blob", [](auto, auto res) {
+    astra::http2::RequestBodyHandler body;
+    body.on_end = [res] {
+      res->set_status(204);
+      res->close();
+    };
+    return body;
+  });
+
+  auto start_result = server_->start();
+  ASSERT_TRUE(start_result.is_ok());
+
+  server_thread_ = std::thread([this] {
+    server_->join();
+  });
+
+  server_->stop();
+  server_thread_.join();
+
+  SUCCEED();
+}
+
 TEST_F(Http2ServerRuntimeTest, HandlerRegistrationBeforeStart) {
   server_->handle("GET", "/test", [](auto, auto res) {
     res->set_status(200);
@@ -302,3 +376,600 @@ TEST_F(Http2ServerRuntimeTest, HandlerRegistrationBeforeStart) {
 
   SUCCEED();
 }
+
+TEST(Http2ServerTuningTest, IdleConnectionClosedAfterReadTimeout) {
+  auto config = make_config_port(9015);
+  config.set_listen_backlog(16);
+  config.set_read_timeout_ms(200);
+  astra::router::Router router;
+  astra::http2::Http2Server server(config, router);
+  ASSERT_TRUE(server.start().is_ok());
+  std::thread server_thread([&server] {
+    server.join();
+  });
+
+  boost::asio::io_context ioc;
+  boost::asio::ip::tcp::socket socket(ioc);
+  socket.connect({boost::asio::ip::make_address("127.0.0.1"), 9015});
+
+  // The server's SETTINGS arrive first, then EOF once the timeout fires
+  auto started = std::chrono::steady_clock::now();
+  std::array<char, 256> buf;
+  boost::system::error_code ec;
+  while (!ec) {
+    socket.read_some(boost::asio::buffer(buf), ec);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - started;
+
+  EXPECT_EQ(ec, boost::asio::error::eof);
+  EXPECT_GE(elapsed, 150ms);
+  EXPECT_LT(elapsed, 5s);
+
+  server.stop();
+  server_thread.join();
+}
+
+namespace {
+
+::http2::ServerConfig make_unix_config(const std::string &path) {
+  ::http2::ServerConfig config;
+  config.set_uri("unix://" + path);
+  config.set_thread_count(1);
+  return config;
+}
+
+bool is_socket(const std::string &path) {
+  struct stat st {};
+  return ::stat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode);
+}
+
+} // namespace
+
+TEST(Http2ServerUnixSocketTest, SocketFileExistsWhileServing) {
+  const std::string path = "/tmp/astra_http2_server_test.sock";
+  astra::router::Router router;
+  astra::http2::Http2Server server(make_unix_config(path), router);
+  ASSERT_TRUE(server.start().is_ok());
+  EXPECT_TRUE(is_socket(path));
+  EXPECT_EQ(server.io_contexts().size(), 1u);
+
+  ASSERT_TRUE(server.stop().is_ok());
+  ASSERT_TRUE(server.join().is_ok());
+  EXPECT_FALSE(is_socket(path));
+}
+
+TEST(Http2ServerUnixSocketTest, StaleSocketFileIsReplaced) {
+  const std::string path = "/tmp/astra_http2_server_stale.sock";
+  {
+    // Bound and never unlinked, as a crashed process leaves it
+    boost::asio::io_context ioc;
+    boost::asio::local::stream_protocol::acceptor acceptor(
+        ioc, boost::asio::local::stream_protocol::endpoint(path));
+  }
+  ASSERT_TRUE(is_socket(path));
+
+  astra::router::Router router;
+  astra::http2::Http2Server server(make_unix_config(path), router);
+  ASSERT_TRUE(server.start().is_ok());
+  server.stop();
+  server.join();
+}
+
+TEST(Http2ServerUnixSocketTest, IdleConnectionClosedAfterReadTimeout) {
+  const std::string path = "/tmp/astra_http2_server_idle.sock";
+  auto config = make_unix_config(path);
+  config.set_read_timeout_ms(200);
+  astra::router::Router router;
+  astra::http2::Http2Server server(config, router);
+  ASSERT_TRUE(server.start().is_ok());
+
+  boost::asio::io_context ioc;
+  boost::asio::local::stream_protocol::socket socket(ioc);
+  socket.connect(boost::asio::local::stream_protocol::endpoint(path));
+
+  auto started = std::chrono::steady_clock::now();
+  std::array<char, 256> buf;
+  boost::system::error_code ec;
+  while (!ec) {
+    socket.read_some(boost::asio::buffer(buf), ec);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - started;
+
+  EXPECT_EQ(ec, boost::asio::error::eof);
+  EXPECT_GE(elapsed, 150ms);
+  EXPECT_LT(elapsed, 5s);
+
+  server.stop();
+  server.join();
+}
+
+namespace {
+
+// Blocking HTTP/2 client for one request at a time, over a Unix or TCP
+// socket
+template <typename Socket> class H2SocketClient {
+public:
+  struct Result {
+    int status = 0;
+    std::string body;
+  };
+
+  explicit H2SocketClient(const typename Socket::endpoint_type &endpoint)
+      : m_socket(m_ioc) {
+    m_socket.connect(endpoint);
+    nghttp2_session_callbacks *callbacks;
+    nghttp2_session_callbacks_new(&callbacks);
+    nghttp2_session_callbacks_set_on_header_callback(callbacks, &on_header);
+    nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks,
+                                                              &on_data);
+    nghttp2_session_callbacks_set_on_stream_close_callback(callbacks,
+                                                           &on_close);
+    nghttp2_session_client_new(&m_session, callbacks, this);
+    nghttp2_session_callbacks_del(callbacks);
+    nghttp2_submit_settings(m_session, NGHTTP2_FLAG_NONE, nullptr, 0);
+  }
+
+  ~H2SocketClient() {
+    nghttp2_session_del(m_session);
+  }
+
+  // Sends `body` in DATA frames of at most 16 KiB, with a content-length
+  // header only when `declare_length` is set
+  Result post(const std::string &path, std::string body,
+              bool declare_length) {
+    std::string method = "POST", scheme = "http", authority = "localhost";
+    std::string length = std::to_string(body.size());
+    std::vector<nghttp2_nv> nva = {nv(":method", method), nv(":scheme", scheme),
+                                   nv(":authority", authority),
+                                   nv(":path", path)};
+    if (declare_length) {
+      nva.push_back(nv("content-length", length));
+    }
+    m_upload = std::move(body);
+    m_upload_offset = 0;
+    nghttp2_data_provider provider{};
+    provider.read_callback = &read_upload;
+    int32_t id = nghttp2_submit_request(m_session, nullptr, nva.data(),
+                                        nva.size(), &provider, nullptr);
+    return wait_for(id);
+  }
+
+  // What the server announced; settled once a request has been answered
+  uint32_t remote_setting(nghttp2_settings_id id) const {
+    return nghttp2_session_get_remote_settings(m_session, id);
+  }
+
+  // What this client may still send on the connection
+  int32_t remote_window() const {
+    return nghttp2_session_get_remote_window_size(m_session);
+  }
+
+private:
+  static nghttp2_nv nv(const char *name, const std::string &value) {
+    return {reinterpret_cast<uint8_t *>(const_cast<char *>(name)),
+            reinterpret_cast<uint8_t *>(const_cast<char *>(value.data())),
+            std::strlen(name), value.size(), NGHTTP2_NV_FLAG_NONE};
+  }
+
+  Result wait_for(int32_t id) {
+    while (m_closed.count(id) == 0) {
+      const uint8_t *data;
+      ssize_t n;
+      while ((n = nghttp2_session_mem_send(m_session, &data)) > 0) {
+        boost::asio::write(m_socket,
+                           boost::asio::buffer(data, static_cast<size_t>(n)));
+      }
+      std::array<uint8_t, 4096> buf;
+      boost::system::error_code ec;
+      size_t got = m_socket.read_some(boost::asio::buffer(buf), ec);
+      if (ec) {
+        break;
+      }
+      nghttp2_session_mem_recv(m_session, buf.data(), got);
+    }
+    return m_results[id];
+  }
+
+  static ssize_t read_upload(nghttp2_session *, int32_t, uint8_t *buf,
+                             size_t length, uint32_t *data_flags,
+                             nghttp2_data_source *, void *user_data) {
+    auto *self = static_cast<H2SocketClient *>(user_data);
+    size_t n = std::min(length, self->m_upload.size() - self->m_upload_offset);
+    std::memcpy(buf, self->m_upload.data() + self->m_upload_offset, n);
+    self->m_upload_offset += n;
+    if (self->m_upload_offset == self->m_upload.size()) {
+      *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+    }
+    return static_cast<ssize_t>(n);
+  }
+
+  static int on_header(nghttp2_session *, const nghttp2_frame *frame,
+                       const uint8_t *name, size_t namelen,
+                       const uint8_t *value, size_t valuelen, uint8_t,
+                       void *user_data) {
+    auto *self = static_cast<H2SocketClient *>(user_data);
+    if (std::string_view(reinterpret_cast<const char *>(name), namelen) ==
+        ":status") {
+      self->m_results[frame->hd.stream_id].status = std::stoi(
+          std::string(reinterpret_cast<const char *>(value), valuelen));
+    }
+    return 0;
+  }
+
+  static int on_data(nghttp2_session *, uint8_t, int32_t stream_id,
+                     const uint8_t *data, size_t len, void *user_data) {
+    auto *self = static_cast<H2SocketClient *>(user_data);
+    self->m_results[stream_id].body.append(
+        reinterpret_cast<const char *>(data), len);
+    return 0;
+  }
+
+  static int on_close(nghttp2_session *, int32_t stream_id, uint32_t,
+                      void *user_data) {
+    static_cast<H2SocketClient *>(user_data)->m_closed.insert(stream_id);
+    return 0;
+  }
+
+  boost::asio::io_context m_ioc;
+  Socket m_socket;
+  nghttp2_session *m_session{nullptr};
+  std::string m_upload;
+  size_t m_upload_offset = 0;
+  std::map<int32_t, Result> m_results;
+  std::set<int32_t> m_closed;
+};
+
+using H2UnixClient = H2SocketClient<boost::asio::local::stream_protocol::socket>;
+using H2TcpClient = H2SocketClient<boost::asio::ip::tcp::socket>;
+
+// Serves POST /upload as a streaming route over a Unix socket, recording
+// the chunks it was given
+class Http2ServerUploadTest : public Test {
+protected:
+  static constexpr const char *PATH = "/tmp/astra_http2_server_upload.sock";
+
+  void SetUp() override {
+    auto config = make_unix_config(PATH);
+    config.set_max_request_body_bytes(32 * 1024);
+    m_server = std::make_unique<astra::http2::Http2Server>(config, m_router);
+    m_server->handle_stream("POST", "/upload", [this](auto, auto res) {
+      m_opened.fetch_add(1);
+      auto body = std::make_shared<std::string>();
+      astra::http2::RequestBodyHandler handler;
+      handler.on_data = [this, body](std::string_view chunk) {
+        m_chunks.fetch_add(1);
+        m_bytes.fetch_add(chunk.size());
+        body->append(chunk);
+      };
+      handler.on_end = [body, res] {
+        res->set_status(200);
+        res->write(*body);
+        res->close();
+      };
+      return handler;
+    });
+    ASSERT_TRUE(m_server->start().is_ok());
+  }
+
+  void TearDown() override {
+    m_server->stop();
+    m_server->join();
+  }
+
+  astra::router::Router m_router;
+  std::unique_ptr<astra::http2::Http2Server> m_server;
+  std::atomic<int> m_opened{0};
+  std::atomic<int> m_chunks{0};
+  std::atomic<size_t> m_bytes{0};
+};
+
+std::string upload_body(size_t size) {
+  std::string body(size, '\0');
+  for (size_t i = 0; i < size; ++i) {
+    body[i] = static_cast<char>('a' + i % 26);
+  }
+  return body;
+}
+
+} // namespace
+
+TEST_F(Http2ServerUploadTest, BodyIsDeliveredInChunks) {
+  H2UnixClient client(PATH);
+  auto body = upload_body(30000);
+
+  auto res = client.post("/upload", body, true);
+
+  EXPECT_EQ(res.status, 200);
+  EXPECT_TRUE(res.body == body);
+  // Sent as two DATA frames; each reaches on_data on its own at least
+  EXPECT_GE(m_chunks.load(), 2);
+}
+
+TEST_F(Http2ServerUploadTest, DeclaredLengthOverLimitIsRejected) {
+  H2UnixClient client(PATH);
+
+  auto res = client.post("/upload", upload_body(32 * 1024 + 1), true);
+
+  EXPECT_EQ(res.status, 413);
+  // Rejected from the headers alone, before the handler runs
+  EXPECT_EQ(m_opened.load(), 0);
+  EXPECT_EQ(m_bytes.load(), 0u);
+}
+
+TEST_F(Http2ServerUploadTest, StreamedBodyOverLimitIsRejected) {
+  H2UnixClient client(PATH);
+
+  // Larger than the limit but within the peer's window, so it is all sent
+  auto res = client.post("/upload", upload_body(48000), false);
+
+  EXPECT_EQ(res.status, 413);
+  EXPECT_EQ(m_opened.load(), 1);
+  // Nothing past the limit is handed on
+  EXPECT_LE(m_bytes.load(), 32u * 1024);
+
+  // The connection still serves the next request
+  res = client.post("/upload", "small", false);
+  EXPECT_EQ(res.status, 200);
+  EXPECT_EQ(res.body, "small");
+}
+
+TEST(Http2ServerFlowControlTest, DeferredConsumptionHoldsThePeerBack) {
+  const std::string path = "/tmp/astra_http2_server_flow_control.sock";
+  std::mutex mutex;
+  size_t received = 0;
+  bool release = false;
+  std::vector<astra::http2::ConsumeCallback> held;
+  astra::router::Router router;
+  astra::http2::Http2Server server(make_unix_config(path), router);
+  server.handle_stream("POST", "/upload", [&](auto, auto res) {
+    astra::http2::RequestBodyHandler handler;
+    handler.on_data_deferred = [&](std::string_view chunk, auto consumed) {
+      std::lock_guard<std::mutex> lock(mutex);
+      received += chunk.size();
+      if (release) {
+        consumed();
+      } else {
+        held.push_back(std::move(consumed));
+      }
+    };
+    handler.on_end = [&, res] {
+      std::lock_guard<std::mutex> lock(mutex);
+      res->set_status(200);
+      res->write(std::to_string(received));
+      res->close();
+    };
+    return handler;
+  });
+  ASSERT_TRUE(server.start().is_ok());
+
+  auto upload = std::async(std::launch::async, [&path] {
+    H2UnixClient client(path);
+    return client.post("/upload", upload_body(200000), true);
+  });
+  auto received_bytes = [&] {
+    std::lock_guard<std::mutex> lock(mutex);
+    return received;
+  };
+
+  // Nothing is credited back, so the peer stops at the initial window
+  auto deadline = std::chrono::steady_clock::now() + 2s;
+  while (received_bytes() < 65535 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(1ms);
+  }
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(received_bytes(), 65535u);
+
+  std::vector<astra::http2::ConsumeCallback> taken;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    release = true;
+    taken.swap(held);
+  }
+  for (auto &consumed : taken) {
+    consumed();
+  }
+
+  ASSERT_EQ(upload.wait_for(5s), std::future_status::ready);
+  auto res = upload.get();
+  EXPECT_EQ(res.status, 200);
+  EXPECT_EQ(res.body, "200000");
+
+  server.stop();
+  server.join();
+}
+
+namespace {
+
+::http2::ServerConfig make_reuse_port_config(const std::string &uri) {
+  ::http2::ServerConfig config;
+  config.set_uri(uri);
+  config.set_thread_count(2);
+  config.set_reuse_port(true);
+  return config;
+}
+
+int64_t total_connections(const astra::http2::Http2Server &server) {
+  int64_t total = 0;
+  for (size_t i = 0; i < server.io_contexts().size(); ++i) {
+    total += server.connection_count(i);
+  }
+  return total;
+}
+
+} // namespace
+
+TEST(Http2ServerReusePortTest, ServesAndCountsConnectionsPerThread) {
+  constexpr uint16_t PORT = 19421;
+  astra::router::Router router;
+  astra::http2::Http2Server server(
+      make_reuse_port_config("http://127.0.0.1:" + std::to_string(PORT)),
+      router);
+  server.handle("POST", "/echo", [](auto req, auto res) {
+    res->set_status(200);
+    res->write(std::string(req->body()));
+    res->close();
+  });
+  ASSERT_TRUE(server.start().is_ok());
+  ASSERT_EQ(server.io_contexts().size(), 2u);
+
+  {
+    const boost::asio::ip::tcp::endpoint endpoint(
+        boost::asio::ip::make_address("127.0.0.1"), PORT);
+    std::vector<std::unique_ptr<H2TcpClient>> clients;
+    for (int i = 0; i < 6; ++i) {
+      clients.push_back(std::make_unique<H2TcpClient>(endpoint));
+      auto res = clients.back()->post("/echo", "ping", true);
+      EXPECT_EQ(res.status, 200);
+      EXPECT_EQ(res.body, "ping");
+    }
+    // Every connection has been served, so each is counted on the io
+    // thread whose listener accepted it
+    EXPECT_EQ(total_connections(server), 6);
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + 2s;
+  while (total_connections(server) != 0 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(5ms);
+  }
+  EXPECT_EQ(total_connections(server), 0);
+
+  server.stop();
+  server.join();
+}
+
+TEST(Http2ServerReusePortTest, HttpsIsRejected) {
+  astra::router::Router router;
+  astra::http2::Http2Server server(
+      make_reuse_port_config("https://127.0.0.1:19422"), router);
+
+  auto result = server.start();
+
+  ASSERT_TRUE(result.is_err());
+  EXPECT_EQ(result.error(), astra::http2::Http2ServerError::BindFailed);
+}
+
+TEST(Http2ServerSettingsTest, SessionSettingsReachThePeer) {
+  const std::string path = "/tmp/astra_http2_server_settings.sock";
+  auto config = make_unix_config(path);
+  config.set_max_concurrent_streams(7);
+  config.set_initial_stream_window_bytes(1 << 20);
+  config.set_connection_window_bytes(4 << 20);
+  config.set_header_table_size(8192);
+  config.set_socket_receive_buffer_bytes(256 * 1024);
+  config.set_socket_send_buffer_bytes(256 * 1024);
+  astra::router::Router router;
+  astra::http2::Http2Server server(config, router);
+  server.handle("POST", "/echo", [](auto req, auto res) {
+    res->set_status(200);
+    res->write(std::string(req->body()));
+    res->close();
+  });
+  ASSERT_TRUE(server.start().is_ok());
+
+  H2UnixClient client(path);
+  auto res = client.post("/echo", "ping", true);
+
+  EXPECT_EQ(res.status, 200);
+  EXPECT_EQ(client.remote_setting(NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS),
+            7u);
+  EXPECT_EQ(client.remote_setting(NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE),
+            1u << 20);
+  EXPECT_EQ(client.remote_setting(NGHTTP2_SETTINGS_HEADER_TABLE_SIZE), 8192u);
+  // The connection window was raised, less the four body bytes just sent
+  EXPECT_EQ(client.remote_window(), (4 << 20) - 4);
+
+  server.stop();
+  server.join();
+}
+
+TEST(Http2ServerSettingsTest, TcpListenerAppliesSessionSettings) {
+  constexpr uint16_t PORT = 19423;
+  ::http2::ServerConfig config;
+  config.set_uri("http://127.0.0.1:" + std::to_string(PORT));
+  config.set_max_concurrent_streams(7);
+  config.set_initial_stream_window_bytes(1 << 20);
+  astra::router::Router router;
+  astra::http2::Http2Server server(config, router);
+  server.handle("POST", "/echo", [](auto, auto res) {
+    res->set_status(200);
+    res->close();
+  });
+  ASSERT_TRUE(server.start().is_ok());
+
+  H2TcpClient client(boost::asio::ip::tcp::endpoint(
+      boost::asio::ip::make_address("127.0.0.1"), PORT));
+  EXPECT_EQ(client.post("/echo", "", true).status, 200);
+
+  EXPECT_EQ(client.remote_setting(NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS),
+            7u);
+  EXPECT_EQ(client.remote_setting(NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE),
+            1u << 20);
+  // Served by the server's own sessions, which count their connections
+  EXPECT_EQ(total_connections(server), 1);
+
+  server.stop();
+  server.join();
+}
+
+TEST(Http2ServerSettingsTest, DefaultsAnnounceOneHundredStreams) {
+  const std::string path = "/tmp/astra_http2_server_defaults.sock";
+  astra::router::Router router;
+  astra::http2::Http2Server server(make_unix_config(path), router);
+  server.handle("POST", "/echo", [](auto, auto res) {
+    res->set_status(200);
+    res->close();
+  });
+  ASSERT_TRUE(server.start().is_ok());
+
+  H2UnixClient client(path);
+  EXPECT_EQ(client.post("/echo", "", true).status, 200);
+
+  EXPECT_EQ(client.remote_setting(NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS),
+            100u);
+  EXPECT_EQ(client.remote_setting(NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE),
+            65535u);
+  EXPECT_EQ(client.remote_window(), 65535);
+
+  server.stop();
+  server.join();
+}
+
+TEST(Http2ServerBackpressureTest, ReadsPauseWhileOnAndResumeAfter) {
+  const std::string path = "/tmp/astra_http2_server_backpressure.sock";
+  auto backpressure = std::make_shared<astra::execution::Backpressure>(2, 0);
+  astra::router::Router router;
+  astra::http2::Http2Server server(make_unix_config(path), router);
+  std::atomic<int> handled{0};
+  server.handle("POST", "/echo", [&handled](auto req, auto res) {
+    handled.fetch_add(1);
+    res->set_status(200);
+    res->write(std::string(req->body()));
+    res->close();
+  });
+  server.set_backpressure(backpressure);
+  ASSERT_TRUE(server.start().is_ok());
+
+  backpressure->update(2);
+  ASSERT_TRUE(backpressure->is_paused());
+
+  H2UnixClient client(path);
+  auto pending = std::async(std::launch::async, [&client] {
+    return client.post("/echo", "held", true);
+  });
+
+  // The connection does not read the request while the gate is closed
+  EXPECT_EQ(pending.wait_for(200ms), std::future_status::timeout);
+  EXPECT_EQ(handled.load(), 0);
+
+  backpressure->update(0);
+  ASSERT_EQ(pending.wait_for(2s), std::future_status::ready);
+  auto res = pending.get();
+  EXPECT_EQ(res.status, 200);
+  EXPECT_EQ(res.body, "held");
+  EXPECT_EQ(handled.load(), 1);
+
+  server.stop();
+  server.join();
+}
@@ -11,7 +11,7 @@ protected:
     return Http2Request(
         "POST", "/api/shorten",
         {{"content-type", "application/json"}, {"accept", "application/json"}},
-        R"({"url":"https://example.com"})", {{"page", "1"}});
+        R"({"url":"https://example.com"})", "page=1");
   }
 };
 
@@ -65,15 +65,55 @@ TEST_F(Http2RequestTest, QueryParamReturnsEmptyForMissingKey) {
   EXPECT_EQ(req.query_param("nonexistent"), "");
 }
 
+TEST_F(Http2RequestTest, QueryParamsAreDecodedOnLookup) {
+  Http2Request req("GET", "/search", {}, {},
+                   "q=hello%20world&flag&page=1&page=2&bad=%zz");
+
+  EXPECT_EQ(req.query_param("q"), "hello world");
+  EXPECT_EQ(req.query_param("flag"), "");
+  EXPECT_EQ(req.query_param("page"), "2");
+  EXPECT_EQ(req.query_param("bad"), "%zz");
+}
+
+TEST_F(Http2RequestTest, HeaderViewsFollowCopyAndMove) {
+  auto req = std::make_unique<Http2Request>(make_request());
+  (void)req->query_param("page");
+
+  Http2Request copied(*req);
+  Http2Request moved(std::move(*req));
+  req.reset();
+
+  EXPECT_EQ(copied.header("accept"), "application/json");
+  EXPECT_EQ(moved.header("content-type"), "application/json");
+  EXPECT_EQ(copied.query_param("page"), "1");
+  EXPECT_EQ(moved.query_param("page"), "1");
+}
+
 TEST_F(Http2RequestTest, SetPathParamsWorks) {
-  auto req = make_request();
+  Http2Request req("GET", "/users/abc123/xyz");
+  std::string_view path = req.path();
 
-  req.set_path_params({{"id", "abc123"}, {"code", "xyz"}});
+  req.set_path_params(
+      {path, {{"id", path.substr(7, 6)}, {"code", path.substr(14)}}});
 
   EXPECT_EQ(req.path_param("id"), "abc123");
   EXPECT_EQ(req.path_param("code"), "xyz");
 }
 
+TEST_F(Http2RequestTest, PathParamsFollowPathOnCopyAndMove) {
+  // Short path stays in the SSO buffer, so its copies live elsewhere
+  auto req = std::make_unique<Http2Request>("GET", "/u/42");
+  std::string_view path = req->path();
+  req->set_path_params({path, {{"id", path.substr(3)}}});
+
+  Http2Request copied(*req);
+  Http2Request moved(std::move(*req));
+  req.reset();
+
+  EXPECT_EQ(copied.path_param("id"), "42");
+  EXPECT_EQ(moved.path_param("id"), "42");
+}
+
 TEST_F(Http2RequestTest, PathParamReturnsEmptyForMissingKey) {
   auto req = make_request();
 
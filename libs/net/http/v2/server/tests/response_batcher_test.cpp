@@ -0,0 +1,186 @@
+#include "ResponseBatcher.h"
+
+#include <atomic>
+#include <boost/asio.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace astra::http2;
+
+TEST(ResponseBatcherTest, RunsWorkInSubmissionOrder) {
+  boost::asio::io_context ioc;
+  auto &batcher = ResponseBatcher::of(ioc);
+
+  std::vector<int> order;
+  for (int i = 0; i < 5; ++i) {
+    batcher.post([&order, i] {
+      order.push_back(i);
+    });
+  }
+  ioc.run();
+
+  EXPECT_EQ(order, (std::vector<int>{0, 1, 2, 3, 4}));
+}
+
+TEST(ResponseBatcherTest, WorkQueuedInOneTickRunsInOneHandler) {
+  boost::asio::io_context ioc;
+  auto &batcher = ResponseBatcher::of(ioc);
+
+  int done = 0;
+  for (int i = 0; i < 100; ++i) {
+    batcher.post([&done] {
+      ++done;
+    });
+  }
+
+  EXPECT_EQ(ioc.run(), 1u);
+  EXPECT_EQ(done, 100);
+}
+
+TEST(ResponseBatcherTest, WorkPostedWhileDrainingRunsInNextBatch) {
+  boost::asio::io_context ioc;
+  auto &batcher = ResponseBatcher::of(ioc);
+
+  std::vector<int> order;
+  batcher.post([&] {
+    order.push_back(1);
+    batcher.post([&] {
+      order.push_back(3);
+    });
+  });
+  batcher.post([&] {
+    order.push_back(2);
+  });
+
+  EXPECT_EQ(ioc.run(), 2u);
+  EXPECT_EQ(order, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(ResponseBatcherTest, ConcurrentProducersKeepPerThreadOrder) {
+  constexpr int PRODUCERS = 4;
+  constexpr int PER_PRODUCER = 2000;
+
+  boost::asio::io_context ioc;
+  auto work = boost::asio::make_work_guard(ioc);
+  auto &batcher = ResponseBatcher::of(ioc);
+  std::thread io_thread([&ioc] {
+    ioc.run();
+  });
+
+  // Only the io thread touches `last` and `done`
+  std::vector<int> last(PRODUCERS, -1);
+  bool in_order = true;
+  int done = 0;
+  std::atomic<bool> finished{false};
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < PRODUCERS; ++p) {
+    producers.emplace_back([&, p] {
+      for (int i = 0; i < PER_PRODUCER; ++i) {
+        batcher.post([&, p, i] {
+          in_order = in_order && last[p] == i - 1;
+          last[p] = i;
+          if (++done == PRODUCERS * PER_PRODUCER) {
+            finished = true;
+          }
+        });
+      }
+    });
+  }
+  for (auto &t : producers) {
+    t.join();
+  }
+  while (!finished) {
+    std::this_thread::yield();
+  }
+  work.reset();
+  io_thread.join();
+
+  EXPECT_TRUE(in_order);
+  EXPECT_EQ(done, PRODUCERS * PER_PRODUCER);
+}
+
+TEST(ResponseBatcherTest, QueuedWorkIsDroppedWithTheIoContext) {
+  auto token = std::make_shared<int>(0);
+  std::weak_ptr<int> weak = token;
+  bool ran = false;
+  {
+    boost::asio::io_context ioc;
+    ResponseBatcher::of(ioc).post([token = std::move(token), &ran] {
+      ran = true;
+    });
+  }
+
+  EXPECT_FALSE(ran);
+  EXPECT_TRUE(weak.expired());
+}
+
+TEST(ResponseBatcherTest, DispatchOnIoThreadRunsInline) {
+  boost::asio::io_context ioc;
+  auto &batcher = ResponseBatcher::of(ioc);
+
+  std::vector<int> order;
+  boost::asio::post(ioc, [&] {
+    batcher.dispatch([&] {
+      order.push_back(1);
+    });
+    order.push_back(2);
+  });
+  batcher.dispatch([&] {
+    order.push_back(3);
+  });
+
+  EXPECT_TRUE(order.empty());
+  ioc.run();
+  EXPECT_EQ(order, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(ResponseBatcherTest, WorkAfterAThrowRunsOnTheNextRun) {
+  boost::asio::io_context ioc;
+  auto &batcher = ResponseBatcher::of(ioc);
+
+  auto token = std::make_shared<int>(0);
+  std::weak_ptr<int> weak = token;
+  std::vector<int> order;
+  batcher.post([&order] {
+    order.push_back(1);
+  });
+  batcher.post([] {
+    throw std::runtime_error("handler failed");
+  });
+  batcher.post([&order, token = std::move(token)] {
+    order.push_back(2);
+  });
+
+  EXPECT_THROW(ioc.run(), std::runtime_error);
+  EXPECT_EQ(order, std::vector<int>{1});
+
+  // Newer work waits behind the rest of the failed batch
+  batcher.post([&order] {
+    order.push_back(3);
+  });
+  ioc.restart();
+  ioc.run();
+  EXPECT_EQ(order, (std::vector<int>{1, 2, 3}));
+  EXPECT_TRUE(weak.expired());
+}
+
+TEST(ResponseBatcherTest, UnfinishedWorkIsDroppedWithTheIoContext) {
+  auto token = std::make_shared<int>(0);
+  std::weak_ptr<int> weak = token;
+  {
+    boost::asio::io_context ioc;
+    auto &batcher = ResponseBatcher::of(ioc);
+    batcher.post([] {
+      throw std::runtime_error("handler failed");
+    });
+    batcher.post([token = std::move(token)] {
+    });
+    EXPECT_THROW(ioc.run(), std::runtime_error);
+  }
+
+  EXPECT_TRUE(weak.expired());
+}
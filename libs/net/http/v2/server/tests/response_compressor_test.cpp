@@ -0,0 +1,254 @@
+#include "ResponseCompressor.h"
+
+#include <atomic>
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+using namespace astra::http2;
+
+namespace {
+
+using Headers = std::map<std::string, std::string>;
+
+::http2::CompressionConfig gzip_only() {
+  ::http2::CompressionConfig config;
+  config.set_enabled(true);
+  config.add_encodings("gzip");
+  return config;
+}
+
+std::string json_body(size_t size) {
+  std::string body = "{\"items\":[";
+  while (body.size() < size) {
+    body += "{\"id\":1,\"name\":\"astra\"},";
+  }
+  body += "{}]}";
+  return body;
+}
+
+std::string gunzip(const std::string &data) {
+  z_stream stream{};
+  EXPECT_EQ(inflateInit2(&stream, 16 + 15), Z_OK);
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+  stream.avail_in = static_cast<uInt>(data.size());
+  std::string out;
+  char buffer[4096];
+  int rc = Z_OK;
+  while (rc == Z_OK) {
+    stream.next_out = reinterpret_cast<Bytef *>(buffer);
+    stream.avail_out = sizeof(buffer);
+    rc = inflate(&stream, Z_NO_FLUSH);
+    out.append(buffer, sizeof(buffer) - stream.avail_out);
+  }
+  EXPECT_EQ(rc, Z_STREAM_END);
+  inflateEnd(&stream);
+  return out;
+}
+
+} // namespace
+
+TEST(ResponseCompressorTest, NegotiatesHighestQuality) {
+  ::http2::CompressionConfig config;
+  config.add_encodings("gzip");
+  config.add_encodings("br");
+  config.add_encodings("zstd");
+  ResponseCompressor compressor(config);
+
+  EXPECT_EQ(compressor.negotiate("gzip"), ContentEncoding::Gzip);
+  EXPECT_EQ(compressor.negotiate(" GZIP ; q=0.5"), ContentEncoding::Gzip);
+  EXPECT_EQ(compressor.negotiate("gzip;q=0"), std::nullopt);
+  EXPECT_EQ(compressor.negotiate("identity"), std::nullopt);
+  EXPECT_EQ(compressor.negotiate(""), std::nullopt);
+  EXPECT_EQ(compressor.negotiate("*"), ContentEncoding::Gzip);
+  EXPECT_EQ(compressor.negotiate("identity, *;q=0"), std::nullopt);
+
+  if (ResponseCompressor::is_available(ContentEncoding::Brotli)) {
+    // The client's ranking wins, then the server's preference
+    EXPECT_EQ(compressor.negotiate("gzip;q=0.5, br"), ContentEncoding::Brotli);
+    EXPECT_EQ(compressor.negotiate("br, gzip"), ContentEncoding::Gzip);
+  } else {
+    EXPECT_EQ(compressor.negotiate("br"), std::nullopt);
+  }
+}
+
+TEST(ResponseCompressorTest, DefaultPreferenceSkipsMissingCodecs) {
+  ResponseCompressor compressor(::http2::CompressionConfig{});
+
+  auto expected = ResponseCompressor::is_available(ContentEncoding::Zstd)
+                      ? ContentEncoding::Zstd
+                      : ContentEncoding::Gzip;
+  EXPECT_EQ(compressor.negotiate("gzip, zstd"), expected);
+  EXPECT_EQ(compressor.negotiate("gzip, deflate"), ContentEncoding::Gzip);
+}
+
+TEST(ResponseCompressorTest, GzipRoundTrips) {
+  ResponseCompressor compressor(gzip_only());
+  std::string original = json_body(8 * 1024);
+  Headers headers{{"content-type", "application/json"},
+                  {"content-length", std::to_string(original.size())}};
+  std::string body = original;
+
+  compressor.apply(ContentEncoding::Gzip, headers, body);
+
+  EXPECT_EQ(headers["content-encoding"], "gzip");
+  EXPECT_EQ(headers["vary"], "accept-encoding");
+  EXPECT_EQ(headers.count("content-length"), 0u);
+  EXPECT_LT(body.size(), original.size());
+  EXPECT_EQ(gunzip(body), original);
+}
+
+TEST(ResponseCompressorTest, LeavesSmallBodiesAlone) {
+  ResponseCompressor compressor(gzip_only());
+  std::string body = json_body(100);
+  std::string original = body;
+  Headers headers{{"content-type", "application/json"}};
+
+  compressor.apply(ContentEncoding::Gzip, headers, body);
+
+  EXPECT_EQ(body, original);
+  EXPECT_EQ(headers.size(), 1u);
+}
+
+TEST(ResponseCompressorTest, LeavesOtherContentTypesAlone) {
+  ResponseCompressor compressor(gzip_only());
+  for (const char *type : {"image/png", "application/octet-stream"}) {
+    std::string body(4096, 'a');
+    Headers headers{{"content-type", type}};
+    compressor.apply(ContentEncoding::Gzip, headers, body);
+    EXPECT_EQ(body.size(), 4096u) << type;
+    EXPECT_EQ(headers.count("content-encoding"), 0u) << type;
+  }
+
+  std::string body(4096, 'a');
+  Headers untyped;
+  compressor.apply(ContentEncoding::Gzip, untyped, body);
+  EXPECT_EQ(body.size(), 4096u);
+
+  Headers encoded{{"content-type", "text/plain"}, {"content-encoding", "br"}};
+  compressor.apply(ContentEncoding::Gzip, encoded, body);
+  EXPECT_EQ(body.size(), 4096u);
+  EXPECT_EQ(encoded["content-encoding"], "br");
+}
+
+TEST(ResponseCompressorTest, VaryIsSetWithoutACoding) {
+  ResponseCompressor compressor(gzip_only());
+  std::string body(4096, 'a');
+  Headers headers{{"content-type", "text/plain; charset=utf-8"},
+                  {"Vary", "origin"}};
+
+  compressor.apply(std::nullopt, headers, body);
+
+  EXPECT_EQ(body.size(), 4096u);
+  EXPECT_EQ(headers["Vary"], "origin, accept-encoding");
+  EXPECT_EQ(headers.count("content-encoding"), 0u);
+}
+
+TEST(ResponseCompressorTest, IncompressibleBodyIsSentAsIs) {
+  ResponseCompressor compressor(gzip_only());
+  std::string body;
+  uint32_t state = 12345;
+  for (int i = 0; i < 4096; ++i) {
+    state = state * 1103515245 + 12345;
+    body.push_back(static_cast<char>(state >> 24));
+  }
+  std::string original = body;
+  Headers headers{{"content-type", "text/plain"}};
+
+  compressor.apply(ContentEncoding::Gzip, headers, body);
+
+  EXPECT_EQ(body, original);
+  EXPECT_EQ(headers.count("content-encoding"), 0u);
+}
+
+TEST(ResponseCompressorTest, CachesBodiesSeenTwice) {
+  ResponseCompressor compressor(gzip_only());
+  std::string body = json_body(4096);
+
+  auto first = compressor.compress(ContentEncoding::Gzip, body);
+  EXPECT_EQ(compressor.cached_bodies(), 0u);
+  auto second = compressor.compress(ContentEncoding::Gzip, body);
+  EXPECT_EQ(compressor.cached_bodies(), 1u);
+  auto third = compressor.compress(ContentEncoding::Gzip, body);
+
+  ASSERT_TRUE(first && second && third);
+  EXPECT_EQ(*first, *second);
+  EXPECT_EQ(*second, *third);
+  EXPECT_EQ(gunzip(*third), body);
+}
+
+TEST(ResponseCompressorTest, CacheEvictsLeastRecentlyUsed) {
+  auto config = gzip_only();
+  config.set_cache_entries(2);
+  ResponseCompressor compressor(config);
+  std::string a = json_body(2048) + "a";
+  std::string b = json_body(2048) + "b";
+  std::string c = json_body(2048) + "c";
+
+  for (const auto *body : {&a, &a, &b, &b, &a, &c, &c}) {
+    compressor.compress(ContentEncoding::Gzip, *body);
+  }
+
+  EXPECT_EQ(compressor.cached_bodies(), 2u);
+}
+
+TEST(ResponseCompressorTest, DisabledCacheKeepsNothing) {
+  auto config = gzip_only();
+  config.set_disable_cache(true);
+  ResponseCompressor compressor(config);
+  std::string body = json_body(4096);
+
+  for (int i = 0; i < 3; ++i) {
+    auto compressed = compressor.compress(ContentEncoding::Gzip, body);
+    ASSERT_TRUE(compressed);
+    EXPECT_EQ(gunzip(*compressed), body);
+  }
+  EXPECT_EQ(compressor.cached_bodies(), 0u);
+}
+
+TEST(ResponseCompressorTest, OptionalCodecsShrinkText) {
+  ::http2::CompressionConfig config;
+  ResponseCompressor compressor(config);
+  std::string body = json_body(8 * 1024);
+  for (auto encoding : {ContentEncoding::Zstd, ContentEncoding::Brotli}) {
+    if (!ResponseCompressor::is_available(encoding)) {
+      continue;
+    }
+    auto compressed = compressor.compress(encoding, body);
+    ASSERT_TRUE(compressed) << ResponseCompressor::name(encoding);
+    EXPECT_LT(compressed->size(), body.size() / 4);
+  }
+}
+
+TEST(ResponseCompressorTest, ConcurrentCompressionAcrossStripes) {
+  ResponseCompressor compressor(gzip_only());
+  std::vector<std::string> bodies;
+  for (int i = 0; i < 64; ++i) {
+    bodies.push_back(json_body(2048) + std::to_string(i));
+  }
+
+  std::vector<std::thread> threads;
+  std::atomic<int> wrong{0};
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&] {
+      for (int round = 0; round < 3; ++round) {
+        for (const auto &body : bodies) {
+          auto compressed = compressor.compress(ContentEncoding::Gzip, body);
+          if (!compressed || gunzip(*compressed) != body) {
+            ++wrong;
+          }
+        }
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(wrong.load(), 0);
+  // The default 256 entries have room for every body
+  EXPECT_EQ(compressor.cached_bodies(), bodies.size());
+}
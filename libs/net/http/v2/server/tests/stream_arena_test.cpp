@@ -0,0 +1,77 @@
+#include "HeaderBlock.h"
+#include "Http2Request.h"
+#include "StreamArena.h"
+
+#include <array>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace astra::http2;
+
+TEST(StreamArenaTest, ObjectsKeepArenaAlive) {
+  auto arena = StreamArena::create();
+  std::weak_ptr<StreamArena> weak_arena = arena;
+
+  auto value = make_in_arena<std::string>(arena, "allocated in the arena");
+  arena.reset();
+
+  EXPECT_FALSE(weak_arena.expired());
+  EXPECT_EQ(*value, "allocated in the arena");
+
+  value.reset();
+  EXPECT_TRUE(weak_arena.expired());
+}
+
+TEST(StreamArenaTest, ObjectsAreCarvedFromInlineStorage) {
+  auto arena = StreamArena::create();
+
+  auto first = make_in_arena<int>(arena, 1);
+  auto second = make_in_arena<int>(arena, 2);
+
+  auto *begin = reinterpret_cast<const std::byte *>(arena.get());
+  auto *end = begin + sizeof(StreamArena);
+  auto *p = reinterpret_cast<const std::byte *>(second.get());
+  EXPECT_TRUE(p >= begin && p < end);
+  EXPECT_EQ(*first + *second, 3);
+}
+
+TEST(StreamArenaTest, OverflowFallsBackToUpstream) {
+  auto arena = StreamArena::create();
+
+  std::vector<std::shared_ptr<std::array<char, 512>>> blocks;
+  for (size_t i = 0; i < 2 * StreamArena::INLINE_BYTES / 512; ++i) {
+    blocks.push_back(make_in_arena<std::array<char, 512>>(arena));
+    blocks.back()->fill(static_cast<char>(i));
+  }
+
+  EXPECT_EQ((*blocks.back())[0], static_cast<char>(blocks.size() - 1));
+}
+
+TEST(StreamArenaTest, HeaderBlockCopyLeavesArena) {
+  auto arena = StreamArena::create();
+  std::weak_ptr<StreamArena> weak_arena = arena;
+
+  HeaderBlock block(arena);
+  block.add("content-type", "application/json");
+  arena.reset();
+
+  HeaderBlock copy = block;
+  block = HeaderBlock();
+
+  EXPECT_TRUE(weak_arena.expired());
+  EXPECT_EQ(copy.find("content-type"), "application/json");
+}
+
+TEST(StreamArenaTest, RequestOutlivesArenaHandle) {
+  auto arena = StreamArena::create();
+  HeaderBlock headers(arena);
+  headers.add("accept", "text/plain");
+  auto request = make_in_arena<Http2Request>(arena, "GET", "/items",
+                                             std::move(headers), "", "id=7");
+  arena.reset();
+
+  EXPECT_EQ(request->header("accept"), "text/plain");
+  EXPECT_EQ(request->query_param("id"), "7");
+}
@@ -0,0 +1,86 @@
+#include "StreamMetrics.h"
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace astra::http2;
+
+TEST(StreamMetricsTest, TotalsAccumulatePerIoContext) {
+  boost::asio::io_context first;
+  boost::asio::io_context second;
+  auto &a = StreamMetrics::of(first);
+  auto &b = StreamMetrics::of(second);
+
+  EXPECT_EQ(&a, &StreamMetrics::of(first));
+  EXPECT_NE(&a, &b);
+
+  a.stream_opened();
+  a.bytes_in(100);
+  a.bytes_out(250);
+  a.response_started(std::chrono::microseconds(300));
+  a.stream_closed(0);
+  b.stream_opened();
+
+  EXPECT_EQ(a.totals().opened, 1u);
+  EXPECT_EQ(a.totals().closed, 1u);
+  EXPECT_EQ(a.totals().bytes_in, 100u);
+  EXPECT_EQ(a.totals().bytes_out, 250u);
+  EXPECT_EQ(b.totals().opened, 1u);
+  EXPECT_EQ(b.totals().closed, 0u);
+}
+
+TEST(StreamMetricsTest, ErrorCodeCountsAsReset) {
+  boost::asio::io_context ioc;
+  auto &metrics = StreamMetrics::of(ioc);
+
+  metrics.stream_opened();
+  metrics.stream_opened();
+  metrics.stream_closed(0);
+  // NGHTTP2_CANCEL
+  metrics.stream_closed(0x8);
+
+  EXPECT_EQ(metrics.totals().closed, 2u);
+  EXPECT_EQ(metrics.totals().reset, 1u);
+}
+
+TEST(StreamMetricsTest, DroppedResponsesCountFromAnyThread) {
+  uint64_t before = StreamMetrics::responses_dropped();
+
+  std::thread worker([] {
+    StreamMetrics::response_dropped();
+  });
+  StreamMetrics::response_dropped();
+  worker.join();
+
+  EXPECT_EQ(StreamMetrics::responses_dropped(), before + 2);
+}
+
+TEST(StreamMetricsTest, TimerFlushesAnIdleIoContext) {
+  boost::asio::io_context ioc;
+  auto &metrics = StreamMetrics::of(ioc);
+
+  metrics.connection_opened();
+  metrics.stream_opened();
+  metrics.bytes_in(64);
+  metrics.stream_closed(0);
+  EXPECT_EQ(metrics.flushed().opened, 0u);
+
+  // Nothing else happens; only the timer is left to run
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(ioc.run(), 1u);
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            StreamMetrics::FLUSH_INTERVAL);
+
+  EXPECT_EQ(metrics.flushed().opened, 1u);
+  EXPECT_EQ(metrics.flushed().closed, 1u);
+  EXPECT_EQ(metrics.flushed().bytes_in, 64u);
+  EXPECT_EQ(metrics.flushed().connections_opened, 1u);
+  EXPECT_EQ(metrics.flushed().connections_closed, 0u);
+
+  metrics.connection_closed();
+  ioc.restart();
+  EXPECT_EQ(ioc.run(), 1u);
+  EXPECT_EQ(metrics.flushed().connections_closed, 1u);
+}
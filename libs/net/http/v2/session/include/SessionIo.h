@@ -0,0 +1,244 @@
+#pragma once
+
+#include <array>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <nghttp2/nghttp2.h>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace astra::http2 {
+
+// Drives one libnghttp2 session over an asio stream socket, for the
+// transports that own their sockets instead of going through nghttp2-asio.
+// Received bytes are fed to nghttp2_session_mem_recv; output is gathered
+// from nghttp2_session_mem_send and written in batches.
+//
+// Derived (CRTP) creates the nghttp2 session with its own callbacks,
+// derives from std::enable_shared_from_this<Derived> and provides
+//   nghttp2_session *nghttp2() const;
+//   void on_io_closed(const boost::system::error_code &ec);
+// Pending reads, writes and timers hold it alive. Use only on the socket's
+// executor.
+template <typename Derived, typename Socket>
+class SessionIo {
+public:
+  static constexpr size_t READ_BUFFER_BYTES = 16 * 1024;
+  // Output gathered from the session before one socket write
+  static constexpr size_t WRITE_BATCH_BYTES = 64 * 1024;
+  // How soon reads held back by the read gate check it again
+  static constexpr std::chrono::milliseconds READ_GATE_RECHECK{5};
+
+  SessionIo(const SessionIo &) = delete;
+  SessionIo &operator=(const SessionIo &) = delete;
+
+  Socket &socket() noexcept {
+    return m_socket;
+  }
+
+  [[nodiscard]] bool is_closed() const noexcept {
+    return m_closed;
+  }
+
+  // Writes now, unless called from inside mem_recv or while a write is in
+  // progress; those pick the output up when they finish
+  void signal_write() {
+    if (!m_in_recv) {
+      do_write();
+    }
+  }
+
+  // Closes the socket; on_io_closed() runs once, with the first `ec`
+  void close_io(const boost::system::error_code &ec) {
+    if (m_closed) {
+      return;
+    }
+    m_closed = true;
+    m_timer.cancel();
+    boost::system::error_code ignored;
+    m_socket.close(ignored);
+    derived().on_io_closed(ec);
+  }
+
+protected:
+  explicit SessionIo(Socket socket)
+      : m_socket(std::move(socket)), m_timer(m_socket.get_executor()) {
+  }
+  ~SessionIo() = default;
+
+  // A connection that receives nothing for this long is closed; zero
+  // disables the timeout
+  void set_read_timeout(std::chrono::milliseconds timeout) {
+    m_read_timeout = timeout;
+  }
+
+  // While `gate` returns false no further read is issued, so the peer is
+  // held back by flow control and the socket buffers. The gate is checked
+  // again every READ_GATE_RECHECK; after `max_hold` one read goes ahead
+  // regardless, so a gate left closed by mistake cannot stall the
+  // connection for good.
+  void set_read_gate(std::function<bool()> gate,
+                     std::chrono::milliseconds max_hold) {
+    m_read_gate = std::move(gate);
+    m_max_gate_hold = max_hold;
+  }
+
+  // Hands `preread`, bytes already taken off the socket, to the session,
+  // then starts reading and writing
+  void start_io(std::string_view preread = {}) {
+    m_started = true;
+    if (!preread.empty() && !receive(preread.data(), preread.size())) {
+      close_io(boost::asio::error::connection_aborted);
+      return;
+    }
+    do_write();
+    do_read();
+  }
+
+private:
+  Derived &derived() {
+    return static_cast<Derived &>(*this);
+  }
+
+  bool receive(const void *data, size_t size) {
+    m_in_recv = true;
+    ssize_t rv = nghttp2_session_mem_recv(
+        derived().nghttp2(), static_cast<const uint8_t *>(data), size);
+    m_in_recv = false;
+    return rv >= 0;
+  }
+
+  void do_read() {
+    if (m_closed || m_reading) {
+      return;
+    }
+    m_reading = true;
+    auto self = derived().shared_from_this();
+
+    if (held_by_gate()) {
+      m_timer.expires_after(READ_GATE_RECHECK);
+      m_timer.async_wait([this, self](const boost::system::error_code &ec) {
+        m_reading = false;
+        if (!ec) {
+          do_read();
+        }
+      });
+      return;
+    }
+
+    m_held_since.reset();
+    if (m_read_timeout.count() > 0) {
+      m_timer.expires_after(m_read_timeout);
+      m_timer.async_wait([this, self](const boost::system::error_code &ec) {
+        if (ec || m_timer.expiry() >
+                      boost::asio::steady_timer::clock_type::now()) {
+          return;
+        }
+        close_io(boost::asio::error::timed_out);
+      });
+    }
+
+    m_socket.async_read_some(
+        boost::asio::buffer(m_read_buffer),
+        [this, self](const boost::system::error_code &ec, size_t n) {
+          m_reading = false;
+          m_timer.cancel();
+          if (m_closed) {
+            return;
+          }
+          if (ec) {
+            close_io(ec);
+            return;
+          }
+          if (!receive(m_read_buffer.data(), n)) {
+            close_io(boost::asio::error::connection_aborted);
+            return;
+          }
+          do_write();
+          do_read();
+        });
+  }
+
+  bool held_by_gate() {
+    if (!m_read_gate || m_read_gate()) {
+      return false;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (!m_held_since) {
+      m_held_since = now;
+    }
+    return now - *m_held_since < m_max_gate_hold;
+  }
+
+  void do_write() {
+    if (m_writing || m_closed || !m_started) {
+      return;
+    }
+    // Set while gathering too, so a stream resumed from a session callback
+    // does not re-enter mem_send; the loop picks its data up
+    m_writing = true;
+    m_out.clear();
+    nghttp2_session *session = derived().nghttp2();
+    while (m_out.size() < WRITE_BATCH_BYTES) {
+      const uint8_t *data;
+      ssize_t n = nghttp2_session_mem_send(session, &data);
+      if (n < 0) {
+        m_writing = false;
+        close_io(boost::asio::error::connection_aborted);
+        return;
+      }
+      if (n == 0) {
+        break;
+      }
+      m_out.append(reinterpret_cast<const char *>(data),
+                   static_cast<size_t>(n));
+    }
+
+    if (m_out.empty()) {
+      m_writing = false;
+      if (nghttp2_session_want_read(session) == 0 &&
+          nghttp2_session_want_write(session) == 0) {
+        close_io(boost::asio::error::eof);
+      }
+      return;
+    }
+
+    boost::asio::async_write(
+        m_socket, boost::asio::buffer(m_out),
+        [this, self = derived().shared_from_this()](
+            const boost::system::error_code &ec, size_t) {
+          m_writing = false;
+          if (m_closed) {
+            return;
+          }
+          if (ec) {
+            close_io(ec);
+            return;
+          }
+          do_write();
+        });
+  }
+
+  Socket m_socket;
+  // The read timeout, or the wait of a read held back by the gate
+  boost::asio::steady_timer m_timer;
+  std::chrono::milliseconds m_read_timeout{0};
+  std::function<bool()> m_read_gate;
+  std::chrono::milliseconds m_max_gate_hold{0};
+  // When the gate started holding back the next read
+  std::optional<std::chrono::steady_clock::time_point> m_held_since;
+  std::array<uint8_t, READ_BUFFER_BYTES> m_read_buffer;
+  std::string m_out;
+  bool m_started{false};
+  bool m_in_recv{false};
+  bool m_reading{false};
+  bool m_writing{false};
+  bool m_closed{false};
+};
+
+} // namespace astra::http2
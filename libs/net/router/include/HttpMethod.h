@@ -1,11 +1,20 @@
 #pragma once
 
+#include <cstddef>
+#include <optional>
 #include <string>
+#include <string_view>
 
 namespace astra::router {
 
 enum class HttpMethod { GET, POST, PUT, DELETE };
 
+inline constexpr size_t HTTP_METHOD_COUNT = 4;
+
 std::string to_string(HttpMethod method);
 
+// Parses an upper-case method token; nullopt for methods the router does not
+// route
+std::optional<HttpMethod> from_string(std::string_view method);
+
 } // namespace astra::router
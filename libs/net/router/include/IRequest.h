@@ -1,7 +1,9 @@
 #pragma once
 
+#include "PathParams.h"
+
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 namespace astra::router {
 
@@ -11,16 +13,20 @@ public:
 
   [[nodiscard]] virtual const std::string &method() const = 0;
   [[nodiscard]] virtual const std::string &path() const = 0;
-  [[nodiscard]] virtual std::string header(const std::string &key) const = 0;
   [[nodiscard]] virtual const std::string &body() const = 0;
 
-  [[nodiscard]] virtual std::string
-  path_param(const std::string &key) const = 0;
-  [[nodiscard]] virtual std::string
-  query_param(const std::string &key) const = 0;
+  // Lookups return views into the request's own storage that stay valid for
+  // the lifetime of the request; missing keys yield an empty view
+  [[nodiscard]] virtual std::string_view
+  header(std::string_view key) const = 0;
+  [[nodiscard]] virtual std::string_view
+  path_param(std::string_view key) const = 0;
+  [[nodiscard]] virtual std::string_view
+  query_param(std::string_view key) const = 0;
 
-  virtual void
-  set_path_params(std::unordered_map<std::string, std::string> params) = 0;
+  // Values view into path(); implementations must keep them valid for the
+  // lifetime of the request
+  virtual void set_path_params(PathParams params) = 0;
 };
 
 } // namespace astra::router
@@ -1,11 +1,34 @@
 #pragma once
 
+#include <cstddef>
+#include <functional>
 #include <string>
+#include <utility>
 
 namespace astra::router {
 
 class IResponse {
 public:
+  // Runs once when the response is done, with the status sent or 0 when the
+  // handler set none. Observers use it to time requests without wrapping the
+  // response.
+  using CloseHook = std::function<void(int status)>;
+
+  IResponse() = default;
+  // A copy is a different response and starts without a hook; a move takes
+  // the hook along
+  IResponse(const IResponse &) noexcept {
+  }
+  IResponse &operator=(const IResponse &) noexcept {
+    return *this;
+  }
+  IResponse(IResponse &&other) noexcept
+      : m_close_hook(std::exchange(other.m_close_hook, nullptr)) {
+  }
+  IResponse &operator=(IResponse &&other) noexcept {
+    m_close_hook = std::exchange(other.m_close_hook, nullptr);
+    return *this;
+  }
   virtual ~IResponse() = default;
 
   virtual void set_status(int code) noexcept = 0;
@@ -14,6 +37,35 @@ public:
   virtual void close() = 0;
 
   [[nodiscard]] virtual bool is_alive() const noexcept = 0;
+
+  // Streaming: send_headers() commits the status and headers, after which
+  // each write() goes to the peer as it is produced and close() ends the
+  // body. Transports that cannot stream keep buffering until close().
+  virtual void send_headers() {
+  }
+
+  // Body bytes written but not yet taken by the transport; producers of
+  // large streamed bodies can pause while this is high
+  [[nodiscard]] virtual size_t pending_bytes() const noexcept {
+    return 0;
+  }
+
+  void set_close_hook(CloseHook hook) noexcept {
+    m_close_hook = std::move(hook);
+  }
+
+protected:
+  // Transports call this from close(), and from their destructor for
+  // responses dropped without a close
+  void run_close_hook(int status) noexcept {
+    if (m_close_hook) {
+      auto hook = std::exchange(m_close_hook, nullptr);
+      hook(status);
+    }
+  }
+
+private:
+  CloseHook m_close_hook;
 };
 
 } // namespace astra::router
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "HttpMethod.h"
+#include "IResponse.h"
+
+#include <cstdint>
+#include <string>
+
+namespace astra::router {
+
+// Hook for per-route instrumentation.
+// on_route_added() runs once per route template at registration, so the
+// per-request callbacks only carry the id it returned and never see the raw
+// path.
+class IRouteObserver {
+public:
+  virtual ~IRouteObserver() = default;
+
+  virtual uint32_t on_route_added(HttpMethod method,
+                                  const std::string &path_template) = 0;
+
+  // Run before the handler; observers that need completion set a close hook
+  // on `res`
+  virtual void on_request(uint32_t route_id, IResponse &res) = 0;
+  virtual void on_unmatched(IResponse &res) = 0;
+};
+
+} // namespace astra::router
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string_view>
+
+namespace astra::router {
+
+struct PathParam {
+  std::string_view name;
+  std::string_view value;
+};
+
+// Fixed-capacity set of path parameters captured by Router::match.
+// Names view into the router's route table; values are kept as offset and
+// length into the matched path, so nothing is allocated while matching.
+// get() and at() read values from the path matched; an owner that keeps
+// the path in storage of its own, such as a request that may be copied or
+// moved, passes that copy instead.
+class PathParams {
+public:
+  static constexpr size_t MAX_PARAMS = 8;
+
+  PathParams() = default;
+  explicit PathParams(std::string_view source) : m_source(source) {
+  }
+  // Every value must view into `source`
+  PathParams(std::string_view source, std::initializer_list<PathParam> params)
+      : m_source(source) {
+    for (const auto &p : params) {
+      push_back(p.name, p.value);
+    }
+  }
+
+  // `value` must view into source(); throws std::invalid_argument otherwise
+  void push_back(std::string_view name, std::string_view value) {
+    if (m_size == MAX_PARAMS) {
+      throw std::length_error("too many path parameters");
+    }
+    auto begin = reinterpret_cast<std::uintptr_t>(m_source.data());
+    auto data = reinterpret_cast<std::uintptr_t>(value.data());
+    if (data < begin || data - begin + value.size() > m_source.size()) {
+      throw std::invalid_argument("path parameter outside the path");
+    }
+    m_params[m_size++] =
+        Param{name, static_cast<uint32_t>(data - begin),
+              static_cast<uint32_t>(value.size())};
+  }
+
+  [[nodiscard]] bool contains(std::string_view name) const noexcept {
+    return find(name) != nullptr;
+  }
+
+  // Returns an empty view when the parameter is absent
+  [[nodiscard]] std::string_view get(std::string_view name) const noexcept {
+    return get(name, m_source);
+  }
+  // The value in `path`, a copy of the path matched
+  [[nodiscard]] std::string_view get(std::string_view name,
+                                     std::string_view path) const noexcept {
+    const Param *param = find(name);
+    return param ? value_in(*param, path) : std::string_view{};
+  }
+
+  [[nodiscard]] std::string_view at(std::string_view name) const {
+    const Param *param = find(name);
+    if (!param) {
+      throw std::out_of_range("path parameter not found");
+    }
+    return value_in(*param, m_source);
+  }
+
+  // The path the values were captured from
+  [[nodiscard]] std::string_view source() const noexcept {
+    return m_source;
+  }
+  [[nodiscard]] size_t size() const noexcept {
+    return m_size;
+  }
+  [[nodiscard]] bool empty() const noexcept {
+    return m_size == 0;
+  }
+
+private:
+  struct Param {
+    std::string_view name;
+    uint32_t offset;
+    uint32_t size;
+  };
+
+  [[nodiscard]] const Param *find(std::string_view name) const noexcept {
+    for (size_t i = 0; i < m_size; ++i) {
+      if (m_params[i].name == name) {
+        return &m_params[i];
+      }
+    }
+    return nullptr;
+  }
+
+  // Empty when `path` is too short to be a copy of the source
+  static std::string_view value_in(const Param &param,
+                                   std::string_view path) noexcept {
+    if (param.offset + static_cast<size_t>(param.size) > path.size()) {
+      return {};
+    }
+    return path.substr(param.offset, param.size);
+  }
+
+  std::string_view m_source;
+  std::array<Param, MAX_PARAMS> m_params{};
+  size_t m_size{0};
+};
+
+} // namespace astra::router
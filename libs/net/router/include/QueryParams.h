@@ -0,0 +1,187 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace astra::router {
+
+// Query string that is only split and percent-decoded on first lookup.
+// Fields are stored as offsets, so copies and moves need no fix-up. The
+// first lookup parses under a lock, so concurrent lookups are safe.
+class QueryParams {
+public:
+  QueryParams() = default;
+  explicit QueryParams(std::string raw) : m_raw(std::move(raw)) {
+  }
+
+  // A copy of a parsed query starts out parsed, one of an unparsed query
+  // parses on its own first lookup
+  QueryParams(const QueryParams &other) : m_raw(other.m_raw) {
+    adopt(other);
+  }
+  QueryParams(QueryParams &&other) noexcept : m_raw(std::move(other.m_raw)) {
+    adopt(std::move(other));
+  }
+  QueryParams &operator=(const QueryParams &other) {
+    if (this != &other) {
+      m_raw = other.m_raw;
+      adopt(other);
+    }
+    return *this;
+  }
+  QueryParams &operator=(QueryParams &&other) noexcept {
+    if (this != &other) {
+      m_raw = std::move(other.m_raw);
+      adopt(std::move(other));
+    }
+    return *this;
+  }
+
+  [[nodiscard]] const std::string &raw() const noexcept {
+    return m_raw;
+  }
+
+  // Returns an empty view when the parameter is absent; the last occurrence
+  // wins for repeated names
+  [[nodiscard]] std::string_view get(std::string_view name) const {
+    ensure_parsed();
+    for (auto it = m_fields.rbegin(); it != m_fields.rend(); ++it) {
+      if (view(it->name_offset, it->name_size) == name) {
+        return view(it->value_offset, it->value_size);
+      }
+    }
+    return {};
+  }
+
+private:
+  struct Field {
+    uint32_t name_offset;
+    uint32_t name_size;
+    uint32_t value_offset;
+    uint32_t value_size;
+  };
+
+  [[nodiscard]] std::string_view view(uint32_t offset, uint32_t size) const {
+    const std::string &source = m_decoded_used ? m_decoded : m_raw;
+    return std::string_view(source).substr(offset, size);
+  }
+
+  static int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+      return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+      return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+      return c - 'A' + 10;
+    }
+    return -1;
+  }
+
+  // Appends `component` to m_decoded; malformed escapes are kept verbatim
+  void append_decoded(std::string_view component) const {
+    for (size_t i = 0; i < component.size(); ++i) {
+      if (component[i] == '%' && i + 2 < component.size() &&
+          hex_value(component[i + 1]) >= 0 &&
+          hex_value(component[i + 2]) >= 0) {
+        m_decoded.push_back(static_cast<char>(
+            hex_value(component[i + 1]) * 16 + hex_value(component[i + 2])));
+        i += 2;
+      } else {
+        m_decoded.push_back(component[i]);
+      }
+    }
+  }
+
+  void ensure_parsed() const {
+    if (m_parsed.load(std::memory_order_acquire)) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(m_parse_mutex);
+    if (!m_parsed.load(std::memory_order_relaxed)) {
+      parse();
+      m_parsed.store(true, std::memory_order_release);
+    }
+  }
+
+  // Takes the parse state of `other`, whose raw string this now holds
+  template <typename Other> void adopt(Other &&other) {
+    if (other.m_parsed.load(std::memory_order_acquire)) {
+      m_decoded = std::forward<Other>(other).m_decoded;
+      m_fields = std::forward<Other>(other).m_fields;
+      m_decoded_used = other.m_decoded_used;
+      m_parsed.store(true, std::memory_order_release);
+    } else {
+      m_decoded.clear();
+      m_fields.clear();
+      m_decoded_used = false;
+      m_parsed.store(false, std::memory_order_release);
+    }
+  }
+
+  void parse() const {
+    std::string_view raw(m_raw);
+    if (raw.empty()) {
+      return;
+    }
+
+    // Only escaped queries need a second buffer; otherwise fields point
+    // straight into m_raw
+    m_decoded_used = raw.find('%') != std::string_view::npos;
+    if (m_decoded_used) {
+      m_decoded.reserve(raw.size());
+    }
+
+    size_t pos = 0;
+    while (pos <= raw.size()) {
+      size_t end = raw.find('&', pos);
+      if (end == std::string_view::npos) {
+        end = raw.size();
+      }
+      std::string_view pair = raw.substr(pos, end - pos);
+      pos = end + 1;
+      if (pair.empty()) {
+        continue;
+      }
+
+      size_t eq = pair.find('=');
+      std::string_view name = pair.substr(0, eq);
+      // A bare name gets an empty value positioned at the end of the pair
+      std::string_view value = eq == std::string_view::npos
+                                   ? pair.substr(pair.size())
+                                   : pair.substr(eq + 1);
+
+      Field field{};
+      if (m_decoded_used) {
+        field.name_offset = static_cast<uint32_t>(m_decoded.size());
+        append_decoded(name);
+        field.name_size =
+            static_cast<uint32_t>(m_decoded.size() - field.name_offset);
+        field.value_offset = static_cast<uint32_t>(m_decoded.size());
+        append_decoded(value);
+        field.value_size =
+            static_cast<uint32_t>(m_decoded.size() - field.value_offset);
+      } else {
+        field.name_offset = static_cast<uint32_t>(name.data() - raw.data());
+        field.name_size = static_cast<uint32_t>(name.size());
+        field.value_offset = static_cast<uint32_t>(value.data() - raw.data());
+        field.value_size = static_cast<uint32_t>(value.size());
+      }
+      m_fields.push_back(field);
+    }
+  }
+
+  std::string m_raw;
+  mutable std::string m_decoded;
+  mutable std::vector<Field> m_fields;
+  mutable bool m_decoded_used{false};
+  mutable std::mutex m_parse_mutex;
+  mutable std::atomic<bool> m_parsed{false};
+};
+
+} // namespace astra::router
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "IRouteObserver.h"
+
+#include <Metrics.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace astra::router {
+
+// Per-route request counters and latency histograms.
+// Handles are registered once per route template when the route is added,
+// e.g. GET "/:code" with prefix "http.server.route" yields
+//   http.server.route.get._code.requests.2xx
+//   http.server.route.get._code.latency
+// Cardinality is bounded by the number of templates, never by raw paths.
+// Distinct templates always get distinct names: a literal '_' is written
+// "__", '.' "-d" and '-' "--", and "/" is "-root".
+//
+// Usage: router.set_observer(std::make_shared<RouteMetrics>()) before add().
+class RouteMetrics : public IRouteObserver {
+public:
+  explicit RouteMetrics(std::string prefix = "http.server.route");
+
+  uint32_t on_route_added(HttpMethod method,
+                          const std::string &path_template) override;
+  void on_request(uint32_t route_id, IResponse &res) override;
+  void on_unmatched(IResponse &res) override;
+
+  // Metric name fragment for a route, e.g. "get.users._id"; different
+  // templates never share one
+  [[nodiscard]] static std::string route_key(HttpMethod method,
+                                             const std::string &path_template);
+
+  // Indexed by status / 100; slot 0 is unused
+  static constexpr size_t STATUS_CLASSES = 6;
+
+  struct RouteHandles {
+    std::array<obs::Counter, STATUS_CLASSES> requests;
+    obs::DurationHistogram latency;
+  };
+
+private:
+  // Handles never move once registered, so close hooks may point at them,
+  // and on_request() finds them without the lock even while routes are
+  // still being added. Segment k holds FIRST_SEGMENT_SIZE << k routes and
+  // is allocated when the first of them is added.
+  static constexpr size_t FIRST_SEGMENT_SIZE = 64;
+  static constexpr size_t SEGMENT_COUNT = 27;
+
+  RouteHandles register_handles(const std::string &key);
+  const RouteHandles *find(uint32_t route_id) const;
+
+  std::string m_prefix;
+  std::mutex m_mutex;
+  // Guarded by m_mutex
+  std::unordered_map<std::string, uint32_t> m_ids;
+  std::array<std::unique_ptr<RouteHandles[]>, SEGMENT_COUNT> m_segments;
+  uint32_t m_route_count{0};
+  // Segments already filled in up to the routes handed out
+  std::array<std::atomic<const RouteHandles *>, SEGMENT_COUNT> m_published{};
+  RouteHandles m_unmatched;
+};
+
+} // namespace astra::router
@@ -1,9 +1,14 @@
 #pragma once
 
+#include "IRouteObserver.h"
 #include "IRouter.h"
+#include "PathParams.h"
 
+#include <array>
+#include <cstdint>
+#include <map>
 #include <optional>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
 namespace astra::router {
@@ -18,26 +23,79 @@ public:
   void dispatch(std::shared_ptr<IRequest> req,
                 std::shared_ptr<IResponse> res) override;
 
+  // `handler` points into the route table and `params` view into both the
+  // route table and `path`, so the result must not outlive either.
   struct MatchResult {
-    Handler handler;
-    std::unordered_map<std::string, std::string> params;
+    const Handler *handler;
+    PathParams params;
+    uint32_t route_id;
   };
 
-  [[nodiscard]] std::optional<MatchResult> match(const std::string &method,
-                                                 const std::string &path) const;
+  [[nodiscard]] std::optional<MatchResult> match(std::string_view method,
+                                                 std::string_view path) const;
+  [[nodiscard]] std::optional<MatchResult> match(HttpMethod method,
+                                                 std::string_view path) const;
+
+  // Compiles the route trie into a contiguous, breadth-first node array with
+  // a perfect hash over each node's static segments, then releases the trie.
+  // Call once after all routes are registered; add() throws afterwards.
+  void freeze();
+  [[nodiscard]] bool frozen() const noexcept {
+    return m_frozen;
+  }
+
+  // Must be set before any route is added; throws std::logic_error otherwise
+  void set_observer(std::shared_ptr<IRouteObserver> observer);
 
 private:
+  static constexpr uint32_t NO_INDEX = UINT32_MAX;
+
   struct Node {
-    std::unordered_map<std::string, std::unique_ptr<Node>> children;
+    std::map<std::string, std::unique_ptr<Node>, std::less<>> children;
     std::unique_ptr<Node> wildcard_child;
     std::string param_name;
     Handler handler;
+    uint32_t route_id{NO_INDEX};
   };
 
-  std::unordered_map<std::string, std::unique_ptr<Node>> m_roots;
+  // Slot in a node's static-segment table; empty slots have node == NO_INDEX
+  struct FlatEdge {
+    uint32_t segment_offset;
+    uint32_t segment_size;
+    uint32_t node;
+  };
+
+  // Static children live in m_flat_edges[edges_begin, edges_begin + mask + 1]
+  // and are located with a hash-and-displace perfect hash: the segment hash
+  // picks a displacement from m_flat_displacements, which in turn picks the
+  // slot.
+  struct FlatNode {
+    uint32_t edges_begin{0};
+    uint32_t edge_mask{0};
+    uint32_t displacements_begin{0};
+    uint32_t displacement_mask{0};
+    uint32_t edge_count{0};
+    uint32_t wildcard{NO_INDEX};
+    uint32_t param_offset{0};
+    uint32_t param_size{0};
+    uint32_t handler{NO_INDEX};
+    uint32_t route_id{NO_INDEX};
+  };
+
+  [[nodiscard]] std::optional<MatchResult>
+  match_frozen(HttpMethod method, std::string_view path) const;
+
+  std::array<std::unique_ptr<Node>, HTTP_METHOD_COUNT> m_roots;
+  std::shared_ptr<IRouteObserver> m_observer;
+  bool m_has_routes{false};
 
-  void add_route(const std::string &method, const std::string &path,
-                 Handler handler);
+  bool m_frozen{false};
+  std::array<uint32_t, HTTP_METHOD_COUNT> m_flat_roots{};
+  std::vector<FlatNode> m_flat_nodes;
+  std::vector<FlatEdge> m_flat_edges;
+  std::vector<uint32_t> m_flat_displacements;
+  std::vector<Handler> m_flat_handlers;
+  std::string m_flat_strings;
 };
 
 } // namespace astra::router
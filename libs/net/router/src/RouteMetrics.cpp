@@ -0,0 +1,158 @@
+#include "RouteMetrics.h"
+
+#include <chrono>
+#include <stdexcept>
+
+namespace astra::router {
+
+namespace {
+
+size_t status_class(int status) {
+  // Closed without a status is sent as 500 by the transports
+  if (status == 0) {
+    return 5;
+  }
+  size_t cls = static_cast<size_t>(status / 100);
+  return cls >= 1 && cls < RouteMetrics::STATUS_CLASSES ? cls : 5;
+}
+
+// Escapes the characters that would make two templates share a key: '.'
+// separates name fragments, '_' marks a parameter and '-' starts an escape
+void append_escaped(std::string &key, char c) {
+  switch (c) {
+  case '_':
+    key += "__";
+    break;
+  case '.':
+    key += "-d";
+    break;
+  case '-':
+    key += "--";
+    break;
+  default:
+    key += c;
+  }
+}
+
+// Segment k starts at FIRST_SEGMENT_SIZE * (2^k - 1)
+template <size_t FIRST_SEGMENT_SIZE>
+std::pair<size_t, size_t> locate(size_t route_id) {
+  size_t n = route_id / FIRST_SEGMENT_SIZE + 1;
+  size_t segment = 0;
+  while (n >>= 1) {
+    ++segment;
+  }
+  return {segment,
+          route_id - FIRST_SEGMENT_SIZE * ((size_t{1} << segment) - 1)};
+}
+
+// Captures only a pointer and a time point, so std::function keeps it
+// inline and a request costs no allocation
+void record_on_close(IResponse &res, const RouteMetrics::RouteHandles &route) {
+  res.set_close_hook(
+      [handles = &route, start = std::chrono::steady_clock::now()](int status) {
+        handles->requests[status_class(status)].inc();
+        handles->latency.record(std::chrono::steady_clock::now() - start);
+      });
+}
+
+} // namespace
+
+RouteMetrics::RouteMetrics(std::string prefix)
+    : m_prefix(std::move(prefix)),
+      m_unmatched(register_handles("unmatched")) {
+}
+
+std::string RouteMetrics::route_key(HttpMethod method,
+                                    const std::string &path_template) {
+  std::string key = to_string(method);
+  for (auto &c : key) {
+    c = static_cast<char>(c - 'A' + 'a');
+  }
+
+  // A parameter becomes one '_' before its escaped name, so a segment key
+  // starting with an odd number of '_' is a parameter; literal segments
+  // only produce pairs
+  bool empty = true;
+  bool at_segment_start = true;
+  for (char c : path_template) {
+    if (c == '/') {
+      at_segment_start = true;
+      continue;
+    }
+    if (at_segment_start) {
+      key += '.';
+      at_segment_start = false;
+      empty = false;
+      if (c == ':') {
+        key += '_';
+        continue;
+      }
+    }
+    append_escaped(key, c);
+  }
+  if (empty) {
+    // A lone '-' never comes out of a literal segment
+    key += ".-root";
+  }
+  return key;
+}
+
+RouteMetrics::RouteHandles
+RouteMetrics::register_handles(const std::string &key) {
+  RouteHandles handles;
+  std::string base = m_prefix + "." + key;
+  for (size_t cls = 1; cls < STATUS_CLASSES; ++cls) {
+    handles.requests[cls] = obs::register_counter(
+        base + ".requests." + std::to_string(cls) + "xx");
+  }
+  handles.latency = obs::register_duration_histogram(base + ".latency");
+  return handles;
+}
+
+uint32_t RouteMetrics::on_route_added(HttpMethod method,
+                                      const std::string &path_template) {
+  std::string key = route_key(method, path_template);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_ids.find(key);
+  if (it != m_ids.end()) {
+    return it->second;
+  }
+  uint32_t id = m_route_count;
+  auto [segment, offset] = locate<FIRST_SEGMENT_SIZE>(id);
+  if (segment >= SEGMENT_COUNT) {
+    throw std::length_error("too many routes for RouteMetrics");
+  }
+  if (!m_segments[segment]) {
+    m_segments[segment] =
+        std::make_unique<RouteHandles[]>(FIRST_SEGMENT_SIZE << segment);
+  }
+  m_segments[segment][offset] = register_handles(key);
+  m_published[segment].store(m_segments[segment].get(),
+                             std::memory_order_release);
+  m_ids.emplace(std::move(key), id);
+  ++m_route_count;
+  return id;
+}
+
+const RouteMetrics::RouteHandles *RouteMetrics::find(uint32_t route_id) const {
+  auto [segment, offset] = locate<FIRST_SEGMENT_SIZE>(route_id);
+  if (segment >= SEGMENT_COUNT) {
+    return nullptr;
+  }
+  const auto *handles = m_published[segment].load(std::memory_order_acquire);
+  return handles ? handles + offset : nullptr;
+}
+
+void RouteMetrics::on_request(uint32_t route_id, IResponse &res) {
+  if (const auto *handles = find(route_id)) {
+    record_on_close(res, *handles);
+  }
+}
+
+void RouteMetrics::on_unmatched(IResponse &res) {
+  record_on_close(res, m_unmatched);
+}
+
+} // namespace astra::router
@@ -1,10 +1,67 @@
 #include "Router.h"
 
 #include "HttpMethod.h"
-#include "StringUtils.h"
+
+#include <algorithm>
+#include <stdexcept>
 
 namespace astra::router {
 
+namespace {
+
+// Yields the non-empty '/'-separated segments of `path` without copying
+class SegmentCursor {
+public:
+  explicit SegmentCursor(std::string_view path) : m_rest(path) {
+  }
+
+  bool next(std::string_view &segment) {
+    while (!m_rest.empty()) {
+      auto pos = m_rest.find('/');
+      segment = m_rest.substr(0, pos);
+      m_rest = pos == std::string_view::npos ? std::string_view{}
+                                             : m_rest.substr(pos + 1);
+      if (!segment.empty()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  std::string_view m_rest;
+};
+
+uint64_t hash_segment(std::string_view segment) {
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : segment) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+uint64_t mix(uint64_t hash, uint32_t displacement) {
+  hash ^= displacement * 0x9E3779B97F4A7C15ULL;
+  hash ^= hash >> 33;
+  hash *= 0xFF51AFD7ED558CCDULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+uint32_t next_pow2(size_t n) {
+  uint32_t result = 1;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+
+constexpr uint32_t MAX_DISPLACEMENT = 1U << 16;
+
+} // namespace
+
 std::string to_string(HttpMethod method) {
   switch (method) {
   case HttpMethod::GET:
@@ -19,63 +76,104 @@ std::string to_string(HttpMethod method) {
   return "GET";
 }
 
-void Router::add(HttpMethod method, const std::string &path, Handler handler) {
-  add_route(to_string(method), path, std::move(handler));
+std::optional<HttpMethod> from_string(std::string_view method) {
+  if (method == "GET") {
+    return HttpMethod::GET;
+  }
+  if (method == "POST") {
+    return HttpMethod::POST;
+  }
+  if (method == "PUT") {
+    return HttpMethod::PUT;
+  }
+  if (method == "DELETE") {
+    return HttpMethod::DELETE;
+  }
+  return std::nullopt;
 }
 
-void Router::add_route(const std::string &method, const std::string &path,
-                       Handler handler) {
-  if (m_roots.find(method) == m_roots.end()) {
-    m_roots[method] = std::make_unique<Node>();
+void Router::add(HttpMethod method, const std::string &path, Handler handler) {
+  if (m_frozen) {
+    throw std::logic_error("cannot add route to a frozen router: " + path);
   }
 
-  Node *current = m_roots[method].get();
-  auto segments = utils::split(path, '/');
+  auto &root = m_roots[static_cast<size_t>(method)];
+  if (!root) {
+    root = std::make_unique<Node>();
+  }
 
-  for (const auto &segment : segments) {
-    if (segment.empty()) {
-      continue;
-    }
+  Node *current = root.get();
+  size_t param_count = 0;
+  SegmentCursor cursor(path);
+  std::string_view segment;
 
+  while (cursor.next(segment)) {
     if (segment[0] == ':') {
+      if (++param_count > PathParams::MAX_PARAMS) {
+        throw std::invalid_argument("route has too many path parameters: " +
+                                    path);
+      }
       if (!current->wildcard_child) {
         current->wildcard_child = std::make_unique<Node>();
-        current->wildcard_child->param_name = segment.substr(1);
+        current->wildcard_child->param_name = std::string(segment.substr(1));
       }
       current = current->wildcard_child.get();
     } else {
-      if (current->children.find(segment) == current->children.end()) {
-        current->children[segment] = std::make_unique<Node>();
+      auto it = current->children.find(segment);
+      if (it == current->children.end()) {
+        it = current->children
+                 .emplace(std::string(segment), std::make_unique<Node>())
+                 .first;
       }
-      current = current->children[segment].get();
+      current = it->second.get();
     }
   }
 
   current->handler = std::move(handler);
+  if (m_observer && current->route_id == NO_INDEX) {
+    current->route_id = m_observer->on_route_added(method, path);
+  }
+  m_has_routes = true;
+}
+
+void Router::set_observer(std::shared_ptr<IRouteObserver> observer) {
+  if (m_has_routes) {
+    throw std::logic_error("route observer must be set before adding routes");
+  }
+  m_observer = std::move(observer);
 }
 
 std::optional<Router::MatchResult>
-Router::match(const std::string &method, const std::string &path) const {
-  auto it = m_roots.find(method);
-  if (it == m_roots.end()) {
+Router::match(std::string_view method, std::string_view path) const {
+  auto parsed = from_string(method);
+  if (!parsed) {
     return std::nullopt;
   }
+  return match(*parsed, path);
+}
 
-  Node *current = it->second.get();
-  std::unordered_map<std::string, std::string> params;
-  auto segments = utils::split(path, '/');
+std::optional<Router::MatchResult> Router::match(HttpMethod method,
+                                                 std::string_view path) const {
+  if (m_frozen) {
+    return match_frozen(method, path);
+  }
 
-  for (const auto &segment : segments) {
-    if (segment.empty()) {
-      continue;
-    }
+  const Node *current = m_roots[static_cast<size_t>(method)].get();
+  if (!current) {
+    return std::nullopt;
+  }
+
+  PathParams params(path);
+  SegmentCursor cursor(path);
+  std::string_view segment;
 
+  while (cursor.next(segment)) {
     auto child_it = current->children.find(segment);
     if (child_it != current->children.end()) {
       current = child_it->second.get();
     } else if (current->wildcard_child) {
-      params[current->wildcard_child->param_name] = segment;
       current = current->wildcard_child.get();
+      params.push_back(current->param_name, segment);
     } else {
       return std::nullopt;
     }
@@ -85,7 +183,241 @@ Router::match(const std::string &method, const std::string &path) const {
     return std::nullopt;
   }
 
-  return MatchResult{current->handler, std::move(params)};
+  return MatchResult{&current->handler, params, current->route_id};
+}
+
+std::optional<Router::MatchResult>
+Router::match_frozen(HttpMethod method, std::string_view path) const {
+  uint32_t index = m_flat_roots[static_cast<size_t>(method)];
+  if (index == NO_INDEX) {
+    return std::nullopt;
+  }
+
+  std::string_view strings = m_flat_strings;
+  PathParams params(path);
+  SegmentCursor cursor(path);
+  std::string_view segment;
+
+  while (cursor.next(segment)) {
+    const FlatNode &node = m_flat_nodes[index];
+    uint32_t next = NO_INDEX;
+
+    if (node.edge_count != 0) {
+      uint64_t hash = hash_segment(segment);
+      uint32_t displacement =
+          m_flat_displacements[node.displacements_begin +
+                               (mix(hash, 0) & node.displacement_mask)];
+      const FlatEdge &edge =
+          m_flat_edges[node.edges_begin +
+                       (mix(hash, displacement) & node.edge_mask)];
+      if (edge.node != NO_INDEX &&
+          strings.substr(edge.segment_offset, edge.segment_size) == segment) {
+        next = edge.node;
+      }
+    }
+
+    if (next == NO_INDEX) {
+      if (node.wildcard == NO_INDEX) {
+        return std::nullopt;
+      }
+      next = node.wildcard;
+      const FlatNode &wildcard = m_flat_nodes[next];
+      params.push_back(
+          strings.substr(wildcard.param_offset, wildcard.param_size), segment);
+    }
+    index = next;
+  }
+
+  const FlatNode &node = m_flat_nodes[index];
+  if (node.handler == NO_INDEX) {
+    return std::nullopt;
+  }
+  return MatchResult{&m_flat_handlers[node.handler], params, node.route_id};
+}
+
+void Router::freeze() {
+  if (m_frozen) {
+    return;
+  }
+
+  // Built aside and swapped in at the end, so a throw leaves the router
+  // as it was and freeze() can be retried
+  std::array<uint32_t, HTTP_METHOD_COUNT> flat_roots;
+  std::vector<FlatNode> flat_nodes;
+  std::vector<FlatEdge> flat_edges;
+  std::vector<uint32_t> flat_displacements;
+  std::string flat_strings;
+  std::vector<Node *> handler_nodes;
+
+  auto intern = [&flat_strings](std::string_view str) {
+    auto offset = static_cast<uint32_t>(flat_strings.size());
+    flat_strings.append(str);
+    return offset;
+  };
+
+  struct Key {
+    std::string_view segment;
+    uint64_t hash;
+    uint32_t node;
+  };
+
+  // Hash-and-displace: place the largest buckets first, trying successive
+  // displacements until every key in the bucket lands in a free slot. Grow
+  // the slot table if some bucket cannot be placed.
+  auto build_edges = [&](FlatNode &flat,
+                         const std::vector<Key> &keys) {
+    flat.edge_count = static_cast<uint32_t>(keys.size());
+    if (keys.empty()) {
+      return;
+    }
+
+    uint32_t bucket_count = next_pow2((keys.size() + 3) / 4);
+    uint32_t slot_count = next_pow2(keys.size());
+    if (slot_count * 3 < keys.size() * 4) {
+      slot_count <<= 1;
+    }
+
+    std::vector<std::vector<const Key *>> buckets(bucket_count);
+    for (const auto &key : keys) {
+      buckets[mix(key.hash, 0) & (bucket_count - 1)].push_back(&key);
+    }
+    std::vector<uint32_t> order(bucket_count);
+    for (uint32_t i = 0; i < bucket_count; ++i) {
+      order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+      return buckets[a].size() > buckets[b].size();
+    });
+
+    std::vector<uint32_t> displacements;
+    std::vector<uint32_t> slots;
+    for (;;) {
+      displacements.assign(bucket_count, 0);
+      slots.assign(slot_count, NO_INDEX);
+      bool placed_all = true;
+
+      for (uint32_t bucket : order) {
+        const auto &members = buckets[bucket];
+        if (members.empty()) {
+          break;
+        }
+
+        bool placed = false;
+        for (uint32_t d = 1; d < MAX_DISPLACEMENT && !placed; ++d) {
+          placed = true;
+          for (size_t i = 0; i < members.size() && placed; ++i) {
+            uint32_t slot = mix(members[i]->hash, d) & (slot_count - 1);
+            if (slots[slot] != NO_INDEX) {
+              placed = false;
+            }
+            for (size_t j = 0; j < i && placed; ++j) {
+              placed = (mix(members[j]->hash, d) & (slot_count - 1)) != slot;
+            }
+          }
+          if (placed) {
+            displacements[bucket] = d;
+            for (const Key *key : members) {
+              slots[mix(key->hash, d) & (slot_count - 1)] =
+                  static_cast<uint32_t>(key - keys.data());
+            }
+          }
+        }
+
+        if (!placed) {
+          placed_all = false;
+          break;
+        }
+      }
+
+      if (placed_all) {
+        break;
+      }
+      if (slot_count >= keys.size() * 64) {
+        throw std::runtime_error("failed to build route table hash");
+      }
+      slot_count <<= 1;
+    }
+
+    flat.displacements_begin =
+        static_cast<uint32_t>(flat_displacements.size());
+    flat.displacement_mask = bucket_count - 1;
+    flat_displacements.insert(flat_displacements.end(), displacements.begin(),
+                              displacements.end());
+
+    flat.edges_begin = static_cast<uint32_t>(flat_edges.size());
+    flat.edge_mask = slot_count - 1;
+    for (uint32_t key_index : slots) {
+      if (key_index == NO_INDEX) {
+        flat_edges.push_back(FlatEdge{0, 0, NO_INDEX});
+        continue;
+      }
+      const Key &key = keys[key_index];
+      flat_edges.push_back(
+          FlatEdge{intern(key.segment),
+                   static_cast<uint32_t>(key.segment.size()), key.node});
+    }
+  };
+
+  // Breadth-first numbering keeps siblings adjacent in m_flat_nodes
+  std::vector<Node *> order;
+  flat_roots.fill(NO_INDEX);
+  for (size_t m = 0; m < m_roots.size(); ++m) {
+    if (m_roots[m]) {
+      flat_roots[m] = static_cast<uint32_t>(order.size());
+      order.push_back(m_roots[m].get());
+    }
+  }
+
+  std::vector<Key> keys;
+  for (size_t i = 0; i < order.size(); ++i) {
+    Node *node = order[i];
+    FlatNode flat;
+
+    flat.param_offset = intern(node->param_name);
+    flat.param_size = static_cast<uint32_t>(node->param_name.size());
+
+    if (node->handler) {
+      flat.handler = static_cast<uint32_t>(handler_nodes.size());
+      handler_nodes.push_back(node);
+    }
+    flat.route_id = node->route_id;
+
+    keys.clear();
+    for (auto &[segment, child] : node->children) {
+      keys.push_back(Key{segment, hash_segment(segment),
+                         static_cast<uint32_t>(order.size())});
+      order.push_back(child.get());
+    }
+    if (node->wildcard_child) {
+      flat.wildcard = static_cast<uint32_t>(order.size());
+      order.push_back(node->wildcard_child.get());
+    }
+
+    build_edges(flat, keys);
+    flat_nodes.push_back(flat);
+  }
+
+  flat_nodes.shrink_to_fit();
+  flat_edges.shrink_to_fit();
+  flat_displacements.shrink_to_fit();
+  flat_strings.shrink_to_fit();
+  std::vector<Handler> flat_handlers;
+  flat_handlers.reserve(handler_nodes.size());
+
+  // Nothing below throws
+  for (Node *node : handler_nodes) {
+    flat_handlers.push_back(std::move(node->handler));
+  }
+  m_flat_roots = flat_roots;
+  m_flat_nodes.swap(flat_nodes);
+  m_flat_edges.swap(flat_edges);
+  m_flat_displacements.swap(flat_displacements);
+  m_flat_handlers.swap(flat_handlers);
+  m_flat_strings.swap(flat_strings);
+  for (auto &root : m_roots) {
+    root.reset();
+  }
+  m_frozen = true;
 }
 
 void Router::dispatch(std::shared_ptr<IRequest> req,
@@ -93,9 +425,15 @@ void Router::dispatch(std::shared_ptr<IRequest> req,
   auto result = match(req->method(), req->path());
 
   if (result) {
-    req->set_path_params(std::move(result->params));
-    result->handler(req, res);
+    req->set_path_params(result->params);
+    if (m_observer) {
+      m_observer->on_request(result->route_id, *res);
+    }
+    (*result->handler)(std::move(req), std::move(res));
   } else {
+    if (m_observer) {
+      m_observer->on_unmatched(*res);
+    }
     res->set_status(404);
     res->write("Not Found");
     res->close();
@@ -0,0 +1,182 @@
+#include "RouteMetrics.h"
+#include "Router.h"
+
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace astra::router;
+
+namespace {
+
+class RecordingResponse : public IResponse {
+public:
+  void set_status(int code) noexcept override {
+    status = code;
+  }
+  void set_header(const std::string &, const std::string &) override {
+  }
+  void write(const std::string &data) override {
+    body += data;
+  }
+  void close() override {
+    ++closes;
+    run_close_hook(status);
+  }
+  bool is_alive() const noexcept override {
+    return true;
+  }
+
+  int status = 0;
+  std::string body;
+  int closes = 0;
+};
+
+} // namespace
+
+TEST(RouteMetricsTest, RouteKeyUsesTemplateSegments) {
+  EXPECT_EQ(RouteMetrics::route_key(HttpMethod::GET, "/:code"), "get._code");
+  EXPECT_EQ(RouteMetrics::route_key(HttpMethod::POST, "/shorten"),
+            "post.shorten");
+  EXPECT_EQ(RouteMetrics::route_key(HttpMethod::DELETE, "/users/:id/posts"),
+            "delete.users._id.posts");
+  EXPECT_EQ(RouteMetrics::route_key(HttpMethod::GET, "/"), "get.-root");
+}
+
+TEST(RouteMetricsTest, DistinctTemplatesGetDistinctKeys) {
+  auto key = [](const std::string &path) {
+    return RouteMetrics::route_key(HttpMethod::GET, path);
+  };
+
+  EXPECT_NE(key("/"), key("/root"));
+  EXPECT_NE(key("/"), key("/-root"));
+  EXPECT_NE(key("/a.b"), key("/a/b"));
+  EXPECT_NE(key("/a.b"), key("/a-db"));
+  EXPECT_NE(key("/:code"), key("/_code"));
+  EXPECT_NE(key("/:_x"), key("/__x"));
+  EXPECT_EQ(key("/_code"), "get.__code");
+  EXPECT_EQ(key("/a.b"), "get.a-db");
+}
+
+TEST(RouteMetricsTest, HandlesSurviveLaterRoutes) {
+  RouteMetrics metrics("test.route");
+  auto id = metrics.on_route_added(HttpMethod::GET, "/first");
+  RecordingResponse res;
+  metrics.on_request(id, res);
+
+  // Enough routes to fill several segments while the response is open
+  for (int i = 0; i < 1000; ++i) {
+    metrics.on_route_added(HttpMethod::GET, "/r" + std::to_string(i));
+  }
+  res.set_status(200);
+  res.close();
+
+  EXPECT_EQ(res.closes, 1);
+  EXPECT_EQ(metrics.on_route_added(HttpMethod::GET, "/first"), id);
+}
+
+TEST(RouteMetricsTest, SameTemplateSharesRouteId) {
+  RouteMetrics metrics("test.route");
+
+  auto first = metrics.on_route_added(HttpMethod::GET, "/:code");
+  auto second = metrics.on_route_added(HttpMethod::DELETE, "/:code");
+  auto again = metrics.on_route_added(HttpMethod::GET, "/:code");
+
+  EXPECT_NE(first, second);
+  EXPECT_EQ(first, again);
+}
+
+TEST(RouteMetricsTest, CloseHookRunsOnce) {
+  RecordingResponse res;
+  std::vector<int> seen;
+  res.set_close_hook([&seen](int status) { seen.push_back(status); });
+
+  res.set_status(302);
+  res.close();
+  res.close();
+
+  EXPECT_EQ(seen, std::vector<int>{302});
+  EXPECT_EQ(res.closes, 2);
+}
+
+TEST(RouteMetricsTest, CloseHookMovesButIsNotCopied) {
+  std::vector<int> seen;
+  RecordingResponse original;
+  original.set_close_hook([&seen](int status) { seen.push_back(status); });
+
+  RecordingResponse copy = original;
+  copy.close();
+  EXPECT_TRUE(seen.empty());
+
+  RecordingResponse moved = std::move(original);
+  original.close();
+  EXPECT_TRUE(seen.empty());
+  moved.set_status(204);
+  moved.close();
+  EXPECT_EQ(seen, std::vector<int>{204});
+}
+
+TEST(RouteMetricsTest, ObserverSetsHookOnTheResponseItself) {
+  RouteMetrics metrics("test.route");
+  auto id = metrics.on_route_added(HttpMethod::GET, "/:code");
+  RecordingResponse res;
+  std::vector<int> seen;
+  res.set_close_hook([&seen](int status) { seen.push_back(status); });
+
+  // The metrics hook replaces the one set above
+  metrics.on_request(id, res);
+  res.set_status(200);
+  res.close();
+  metrics.on_unmatched(res);
+  res.close();
+
+  EXPECT_TRUE(seen.empty());
+  EXPECT_EQ(res.closes, 2);
+}
+
+TEST(RouteMetricsTest, RouterDispatchesThroughMetrics) {
+  Router router;
+  router.set_observer(std::make_shared<RouteMetrics>("test.route"));
+  std::shared_ptr<IResponse> seen;
+  router.add(HttpMethod::GET, "/:code", [&seen](auto, auto res) {
+    seen = res;
+    res->set_status(200);
+    res->close();
+  });
+  router.freeze();
+
+  class Request : public IRequest {
+  public:
+    const std::string &method() const override {
+      return m_method;
+    }
+    const std::string &path() const override {
+      return m_path;
+    }
+    std::string_view header(std::string_view) const override {
+      return {};
+    }
+    const std::string &body() const override {
+      return m_body;
+    }
+    std::string_view path_param(std::string_view) const override {
+      return {};
+    }
+    std::string_view query_param(std::string_view) const override {
+      return {};
+    }
+    void set_path_params(PathParams) override {
+    }
+
+  private:
+    std::string m_method = "GET";
+    std::string m_path = "/abc";
+    std::string m_body;
+  };
+
+  auto inner = std::make_shared<RecordingResponse>();
+  router.dispatch(std::make_shared<Request>(), inner);
+
+  EXPECT_EQ(seen, inner);
+  EXPECT_EQ(inner->status, 200);
+  EXPECT_EQ(inner->closes, 1);
+}
@@ -0,0 +1,128 @@
+#include "Router.h"
+
+#include <AllocationCounter.h>
+#include <benchmark/benchmark.h>
+#include <string>
+
+// Variant of router_benchmark that counts heap allocations made by match()
+// and dispatch(). Every benchmark reports `allocs_per_iter`, which should be 0.
+
+using namespace astra::router;
+using astra::utils::run_counted;
+
+namespace {
+
+class BenchRequest : public IRequest {
+public:
+  BenchRequest(std::string method, std::string path)
+      : m_method(std::move(method)), m_path(std::move(path)) {
+  }
+
+  const std::string &method() const override {
+    return m_method;
+  }
+  const std::string &path() const override {
+    return m_path;
+  }
+  const std::string &body() const override {
+    return m_empty;
+  }
+  std::string_view header(std::string_view) const override {
+    return {};
+  }
+  std::string_view path_param(std::string_view key) const override {
+    return m_params.get(key);
+  }
+  std::string_view query_param(std::string_view) const override {
+    return {};
+  }
+  void set_path_params(PathParams params) override {
+    m_params = params;
+  }
+
+private:
+  std::string m_method;
+  std::string m_path;
+  std::string m_empty;
+  PathParams m_params;
+};
+
+class BenchResponse : public IResponse {
+public:
+  void set_status(int) noexcept override {
+  }
+  void set_header(const std::string &, const std::string &) override {
+  }
+  void write(const std::string &) override {
+  }
+  void close() override {
+  }
+  bool is_alive() const noexcept override {
+    return true;
+  }
+};
+
+} // namespace
+
+static void BM_AllocMatchStatic(benchmark::State &state) {
+  Router router;
+  router.add(HttpMethod::GET, "/users", [](auto, auto) {});
+
+  run_counted(state, "allocs_per_iter", [&] {
+    auto result = router.match("GET", "/users");
+    benchmark::DoNotOptimize(result);
+  });
+}
+BENCHMARK(BM_AllocMatchStatic);
+
+static void BM_AllocMatchMultiParam(benchmark::State &state) {
+  Router router;
+  router.add(HttpMethod::GET,
+             "/users/:userId/posts/:postId/comments/:commentId",
+             [](auto, auto) {});
+
+  run_counted(state, "allocs_per_iter", [&] {
+    auto result = router.match("GET", "/users/123/posts/456/comments/789");
+    benchmark::DoNotOptimize(result);
+  });
+}
+BENCHMARK(BM_AllocMatchMultiParam);
+
+static void BM_AllocMatchLongSegment(benchmark::State &state) {
+  // Segments longer than the SSO buffer used to force a heap copy
+  Router router;
+  router.add(HttpMethod::GET, "/organizations/:organizationId/repositories",
+             [](auto, auto) {});
+
+  run_counted(state, "allocs_per_iter", [&] {
+    auto result = router.match(
+        "GET", "/organizations/0123456789abcdef0123456789/repositories");
+    benchmark::DoNotOptimize(result);
+  });
+}
+BENCHMARK(BM_AllocMatchLongSegment);
+
+static void BM_AllocDispatch(benchmark::State &state) {
+  Router router;
+  router.add(HttpMethod::GET, "/users/:id",
+             [](auto req, auto res) { res->set_status(200); });
+
+  auto req = std::make_shared<BenchRequest>("GET", "/users/12345");
+  auto res = std::make_shared<BenchResponse>();
+
+  run_counted(state, "allocs_per_iter", [&] { router.dispatch(req, res); });
+}
+BENCHMARK(BM_AllocDispatch);
+
+static void BM_AllocDispatchNotFound(benchmark::State &state) {
+  Router router;
+  router.add(HttpMethod::GET, "/users/:id", [](auto, auto) {});
+
+  auto req = std::make_shared<BenchRequest>("GET", "/posts/12345");
+  auto res = std::make_shared<BenchResponse>();
+
+  run_counted(state, "allocs_per_iter", [&] { router.dispatch(req, res); });
+}
+BENCHMARK(BM_AllocDispatchNotFound);
+
+BENCHMARK_MAIN();
@@ -1,7 +1,9 @@
 #include "Router.h"
 
+#include <AllocationCounter.h>
 #include <benchmark/benchmark.h>
 #include <string>
+#include <vector>
 
 using namespace astra::router;
 
@@ -73,6 +75,124 @@ static void BM_MatchNotFound(benchmark::State &state) {
 }
 BENCHMARK(BM_MatchNotFound);
 
+// =============================================================================
+// Large Route Table Benchmarks
+// =============================================================================
+//
+// Multi-tenant gateway shape: every tenant has a handful of routes under its
+// own prefix. Arg is the total number of routes; the second arg selects the
+// trie (0) or the frozen flat table (1).
+
+namespace {
+
+std::vector<std::string> tenant_routes(int count) {
+  static const char *suffixes[] = {"/users", "/users/:id", "/orders/:id",
+                                   "/orders/:id/items/:item", "/health"};
+  std::vector<std::string> routes;
+  for (int i = 0; static_cast<int>(routes.size()) < count; ++i) {
+    for (const char *suffix : suffixes) {
+      if (static_cast<int>(routes.size()) == count) {
+        break;
+      }
+      routes.push_back("/api/v1/tenant" + std::to_string(i) + suffix);
+    }
+  }
+  return routes;
+}
+
+std::vector<std::string> tenant_paths(const std::vector<std::string> &routes) {
+  std::vector<std::string> paths;
+  paths.reserve(routes.size());
+  for (const auto &route : routes) {
+    std::string path;
+    for (size_t i = 0; i < route.size(); ++i) {
+      if (route[i] == ':') {
+        path += "12345";
+        while (i + 1 < route.size() && route[i + 1] != '/') {
+          ++i;
+        }
+      } else {
+        path += route[i];
+      }
+    }
+    paths.push_back(std::move(path));
+  }
+  return paths;
+}
+
+} // namespace
+
+static void BM_MatchLargeTable(benchmark::State &state) {
+  auto routes = tenant_routes(static_cast<int>(state.range(0)));
+  auto paths = tenant_paths(routes);
+
+  size_t before = astra::utils::live_bytes();
+  auto router = std::make_unique<Router>();
+  for (const auto &route : routes) {
+    router->add(HttpMethod::GET, route, [](auto, auto) {});
+  }
+  if (state.range(1) != 0) {
+    router->freeze();
+  }
+  size_t table_bytes = astra::utils::live_bytes() - before;
+
+  size_t i = 0;
+  for (auto _ : state) {
+    auto result = router->match(HttpMethod::GET, paths[i]);
+    benchmark::DoNotOptimize(result);
+    if (++i == paths.size()) {
+      i = 0;
+    }
+  }
+
+  state.counters["table_bytes"] = static_cast<double>(table_bytes);
+  state.counters["bytes_per_route"] =
+      static_cast<double>(table_bytes) / static_cast<double>(routes.size());
+}
+BENCHMARK(BM_MatchLargeTable)
+    ->Args({1000, 0})
+    ->Args({1000, 1})
+    ->Args({10000, 0})
+    ->Args({10000, 1});
+
+static void BM_MatchLargeTableMiss(benchmark::State &state) {
+  auto routes = tenant_routes(static_cast<int>(state.range(0)));
+
+  Router router;
+  for (const auto &route : routes) {
+    router.add(HttpMethod::GET, route, [](auto, auto) {});
+  }
+  if (state.range(1) != 0) {
+    router.freeze();
+  }
+
+  for (auto _ : state) {
+    auto result = router.match(HttpMethod::GET, "/api/v1/unknown/users");
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_MatchLargeTableMiss)
+    ->Args({1000, 0})
+    ->Args({1000, 1})
+    ->Args({10000, 0})
+    ->Args({10000, 1});
+
+static void BM_Freeze(benchmark::State &state) {
+  auto routes = tenant_routes(static_cast<int>(state.range(0)));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    Router router;
+    for (const auto &route : routes) {
+      router.add(HttpMethod::GET, route, [](auto, auto) {});
+    }
+    state.ResumeTiming();
+    router.freeze();
+    benchmark::DoNotOptimize(router);
+  }
+}
+BENCHMARK(BM_Freeze)->Arg(1000)->Arg(10000);
+
 // =============================================================================
 // Add Route Benchmarks
 // =============================================================================
@@ -50,10 +50,10 @@ void MatchWithParams(const std::string &userId, const std::string &action) {
   // If matched, params should be extracted
   if (result && result->handler) {
     // Access params - should never crash
-    auto it1 = result->params.find("userId");
-    auto it2 = result->params.find("action");
-    (void)it1;
-    (void)it2;
+    auto user_id = result->params.get("userId");
+    auto action_param = result->params.get("action");
+    (void)user_id;
+    (void)action_param;
   }
 }
 FUZZ_TEST(RouterFuzzTest, MatchWithParams);
@@ -1,6 +1,8 @@
 #include "HttpMethod.h"
+#include "QueryParams.h"
 #include "Router.h"
 
+#include <atomic>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <thread>
@@ -30,22 +32,28 @@ public:
   const std::string &body() const override {
     return m_empty;
   }
-  std::string header(const std::string &) const override {
-    return "";
+  std::string_view header(std::string_view) const override {
+    return {};
   }
-  std::string path_param(const std::string &) const override {
-    return "";
+  std::string_view path_param(std::string_view) const override {
+    return {};
   }
-  std::string query_param(const std::string &) const override {
-    return "";
+  std::string_view query_param(std::string_view) const override {
+    return {};
   }
-  void set_path_params(std::unordered_map<std::string, std::string>) override {
+  void set_path_params(PathParams params) override {
+    m_params = params;
+  }
+
+  const PathParams &params() const {
+    return m_params;
   }
 
 private:
   std::string m_path;
   std::string m_method;
   std::string m_empty;
+  PathParams m_params;
 };
 
 class MockResponse : public IResponse {
@@ -133,6 +141,104 @@ TEST_F(RouterTest, NoMatch) {
   EXPECT_FALSE(result_method);
 }
 
+TEST_F(RouterTest, MatchByMethodEnum) {
+  m_router.add(HttpMethod::PUT, "/users/:id", [](auto, auto) {});
+
+  auto result = m_router.match(HttpMethod::PUT, "/users/7");
+  ASSERT_TRUE(result);
+  EXPECT_EQ(result->params.at("id"), "7");
+  EXPECT_FALSE(m_router.match(HttpMethod::GET, "/users/7"));
+}
+
+TEST_F(RouterTest, UnknownMethodDoesNotMatch) {
+  m_router.add(HttpMethod::GET, "/users", [](auto, auto) {});
+
+  EXPECT_FALSE(m_router.match("PATCH", "/users"));
+  EXPECT_FALSE(m_router.match("get", "/users"));
+}
+
+TEST_F(RouterTest, ParamsViewIntoMatchedPath) {
+  m_router.add(HttpMethod::GET, "/users/:id", [](auto, auto) {});
+
+  std::string path = "/users/12345";
+  auto result = m_router.match("GET", path);
+  ASSERT_TRUE(result);
+
+  auto id = result->params.at("id");
+  EXPECT_EQ(id.data(), path.data() + 7);
+  EXPECT_EQ(result->params.get("missing"), "");
+  EXPECT_THROW((void)result->params.at("missing"), std::out_of_range);
+}
+
+TEST(QueryParamsTest, SplitsWithoutEscapes) {
+  QueryParams params("a=1&b=&c&&d=x=y");
+
+  EXPECT_EQ(params.get("a"), "1");
+  EXPECT_EQ(params.get("b"), "");
+  EXPECT_EQ(params.get("c"), "");
+  EXPECT_EQ(params.get("d"), "x=y");
+  EXPECT_EQ(params.get("missing"), "");
+  EXPECT_EQ(params.get("a").data(), params.raw().data() + 2);
+}
+
+TEST(QueryParamsTest, DecodesEscapes) {
+  QueryParams params("na%6De=a%2Fb&tail=%4");
+
+  EXPECT_EQ(params.get("name"), "a/b");
+  EXPECT_EQ(params.get("tail"), "%4");
+}
+
+TEST(QueryParamsTest, CopyAfterParseKeepsValues) {
+  QueryParams original("k=some-long-value-that-is-not-in-sso");
+  (void)original.get("k");
+
+  QueryParams copy = original;
+  original = QueryParams();
+
+  EXPECT_EQ(copy.get("k"), "some-long-value-that-is-not-in-sso");
+  EXPECT_EQ(original.get("k"), "");
+}
+
+TEST(QueryParamsTest, ConcurrentFirstLookupsAgree) {
+  QueryParams params("a=1&b=x%20y&c=3");
+
+  std::vector<std::thread> threads;
+  std::atomic<int> matches{0};
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&] {
+      if (params.get("b") == "x y" && params.get("c") == "3") {
+        ++matches;
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  EXPECT_EQ(matches.load(), 8);
+}
+
+TEST(QueryParamsTest, AssignmentResetsParseState) {
+  QueryParams params("a=1");
+  EXPECT_EQ(params.get("a"), "1");
+
+  params = QueryParams("a=%32");
+  EXPECT_EQ(params.get("a"), "2");
+
+  QueryParams moved(std::move(params));
+  EXPECT_EQ(moved.get("a"), "2");
+}
+
+TEST_F(RouterTest, RouteWithTooManyParamsThrows) {
+  std::string path;
+  for (size_t i = 0; i <= PathParams::MAX_PARAMS; ++i) {
+    path += "/:p" + std::to_string(i);
+  }
+
+  EXPECT_THROW(m_router.add(HttpMethod::GET, path, [](auto, auto) {}),
+               std::invalid_argument);
+}
+
 // =============================================================================
 // Path Edge Cases
 // =============================================================================
@@ -336,6 +442,146 @@ TEST_F(RouterTest, ConcurrentMatching) {
   EXPECT_EQ(success_count.load(), 10000);
 }
 
+// =============================================================================
+// Frozen Route Table Tests
+// =============================================================================
+
+TEST_F(RouterTest, FrozenMatchesStaticAndParamRoutes) {
+  m_router.add(HttpMethod::GET, "/users/profile", [](auto, auto) {});
+  m_router.add(HttpMethod::GET, "/users/:id", [](auto, auto) {});
+  m_router.add(HttpMethod::GET, "/users/:id/posts/:postId", [](auto, auto) {});
+  m_router.add(HttpMethod::POST, "/users", [](auto, auto) {});
+  m_router.add(HttpMethod::GET, "/", [](auto, auto) {});
+  m_router.freeze();
+
+  EXPECT_TRUE(m_router.frozen());
+  EXPECT_TRUE(m_router.match("GET", "/"));
+  EXPECT_TRUE(m_router.match("POST", "/users"));
+  EXPECT_FALSE(m_router.match("GET", "/users"));
+  EXPECT_FALSE(m_router.match("PUT", "/users"));
+  EXPECT_FALSE(m_router.match("GET", "/unknown"));
+
+  auto profile = m_router.match("GET", "/users/profile");
+  ASSERT_TRUE(profile);
+  EXPECT_TRUE(profile->params.empty());
+
+  auto post = m_router.match("GET", "/users/42/posts/7");
+  ASSERT_TRUE(post);
+  EXPECT_EQ(post->params.at("id"), "42");
+  EXPECT_EQ(post->params.at("postId"), "7");
+}
+
+TEST_F(RouterTest, FrozenAgreesWithTrieOnLargeTable) {
+  Router trie;
+  for (int i = 0; i < 2000; ++i) {
+    std::string path = "/tenant" + std::to_string(i) + "/items/:id";
+    trie.add(HttpMethod::GET, path, [](auto, auto) {});
+    m_router.add(HttpMethod::GET, path, [](auto, auto) {});
+  }
+  m_router.freeze();
+
+  for (int i = 0; i < 2100; ++i) {
+    std::string path = "/tenant" + std::to_string(i) + "/items/x" +
+                       std::to_string(i);
+    auto expected = trie.match("GET", path);
+    auto actual = m_router.match("GET", path);
+    ASSERT_EQ(static_cast<bool>(expected), static_cast<bool>(actual)) << path;
+    if (actual) {
+      EXPECT_EQ(actual->params.at("id"), expected->params.at("id"));
+    }
+  }
+}
+
+TEST_F(RouterTest, FrozenDispatchCallsHandler) {
+  int calls = 0;
+  m_router.add(HttpMethod::GET, "/users/:id", [&calls](auto, auto) {
+    ++calls;
+  });
+  m_router.freeze();
+
+  auto req = std::make_shared<MockRequest>("/users/abc", "GET");
+  m_router.dispatch(req, std::make_shared<MockResponse>());
+
+  EXPECT_EQ(calls, 1);
+  EXPECT_EQ(req->params().get("id"), "abc");
+}
+
+TEST_F(RouterTest, AddAfterFreezeThrows) {
+  m_router.add(HttpMethod::GET, "/users", [](auto, auto) {});
+  m_router.freeze();
+
+  EXPECT_THROW(m_router.add(HttpMethod::GET, "/posts", [](auto, auto) {}),
+               std::logic_error);
+}
+
+TEST_F(RouterTest, FreezeEmptyRouter) {
+  m_router.freeze();
+
+  EXPECT_FALSE(m_router.match("GET", "/"));
+}
+
+// =============================================================================
+// Route Observer Tests
+// =============================================================================
+
+class RecordingObserver : public IRouteObserver {
+public:
+  uint32_t on_route_added(HttpMethod method,
+                          const std::string &path_template) override {
+    templates.push_back(to_string(method) + " " + path_template);
+    return static_cast<uint32_t>(templates.size() - 1);
+  }
+  void on_request(uint32_t route_id, IResponse &) override {
+    requests.push_back(route_id);
+  }
+  void on_unmatched(IResponse &) override {
+    ++unmatched;
+  }
+
+  std::vector<std::string> templates;
+  std::vector<uint32_t> requests;
+  int unmatched = 0;
+};
+
+TEST_F(RouterTest, ObserverSeesTemplatesNotPaths) {
+  auto observer = std::make_shared<RecordingObserver>();
+  m_router.set_observer(observer);
+  m_router.add(HttpMethod::GET, "/users/:id", [](auto, auto) {});
+  m_router.add(HttpMethod::POST, "/users", [](auto, auto) {});
+
+  auto res = std::make_shared<MockResponse>();
+  m_router.dispatch(std::make_shared<MockRequest>("/users/1", "GET"), res);
+  m_router.dispatch(std::make_shared<MockRequest>("/users/2", "GET"), res);
+  m_router.dispatch(std::make_shared<MockRequest>("/users", "POST"), res);
+  m_router.dispatch(std::make_shared<MockRequest>("/nope", "GET"), res);
+
+  EXPECT_THAT(observer->templates,
+              ElementsAre("GET /users/:id", "POST /users"));
+  EXPECT_THAT(observer->requests, ElementsAre(0, 0, 1));
+  EXPECT_EQ(observer->unmatched, 1);
+}
+
+TEST_F(RouterTest, ObserverRouteIdsSurviveFreeze) {
+  auto observer = std::make_shared<RecordingObserver>();
+  m_router.set_observer(observer);
+  m_router.add(HttpMethod::GET, "/a", [](auto, auto) {});
+  m_router.add(HttpMethod::GET, "/b/:id", [](auto, auto) {});
+  m_router.freeze();
+
+  auto res = std::make_shared<MockResponse>();
+  m_router.dispatch(std::make_shared<MockRequest>("/b/9", "GET"), res);
+  m_router.dispatch(std::make_shared<MockRequest>("/a", "GET"), res);
+
+  EXPECT_THAT(observer->requests, ElementsAre(1, 0));
+}
+
+TEST_F(RouterTest, SetObserverAfterAddThrows) {
+  m_router.add(HttpMethod::GET, "/a", [](auto, auto) {});
+
+  EXPECT_THROW(m_router.set_observer(std::make_shared<RecordingObserver>()),
+               std::logic_error);
+}
+
 // =============================================================================
 // Dispatch Tests
 // =============================================================================
@@ -353,6 +599,16 @@ TEST_F(RouterTest, DispatchCallsHandler) {
   EXPECT_TRUE(handler_called);
 }
 
+TEST_F(RouterTest, DispatchSetsPathParams) {
+  m_router.add(HttpMethod::GET, "/users/:id", [](auto, auto) {});
+
+  auto req = std::make_shared<MockRequest>("/users/abc", "GET");
+  auto res = std::make_shared<MockResponse>();
+
+  m_router.dispatch(req, res);
+  EXPECT_EQ(req->params().get("id"), "abc");
+}
+
 TEST_F(RouterTest, DispatchNoMatchDoesNotCrash) {
   auto req = std::make_shared<MockRequest>("/nonexistent", "GET");
   auto res = std::make_shared<MockResponse>();